@@ -1,14 +1,14 @@
+#include "p2.h"
 #include <math.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <time.h>
 
-// we use -O2 optimization flag
-#pragma GCC optimize("O2")
+// This benchmark is linked against the library sources: the legacy kernel
+// below is then built with the same flags as the library one (p2_quantile)
 
-double const PI = 0x1.921fb54442d18p+1;
-double const _NAN = 0.0 / 0.0;
-double const DMAX = RAND_MAX;
+static double const PI = 0x1.921fb54442d18p+1;
+static double const DMAX = RAND_MAX;
 
 // U(0, 1)
 double runif() { return (double)rand() / DMAX; }
@@ -27,8 +27,11 @@ void fill_rgauss(double *data, unsigned long size) {
     }
 }
 
+typedef void (*Filler)(double *, unsigned long);
+
+// Legacy kernel (linear search of the cell + separate loops)
 // See aakinshin.net/posts/p2-quantile-estimator/
-struct P2 {
+struct LegacyP2 {
     double q[5];
     double n[5];
     double np[5];
@@ -41,13 +44,13 @@ static void swap(double *a, double *b) {
     *b = temp;
 }
 
-static void sort5(double a[static 5]) {
-    if (a[1] > a[0]) // Compare 1st and 2nd element #1
+static void sort5(double a[5]) {
+    if (a[1] < a[0]) // Compare 1st and 2nd element #1
         swap(&a[0], &a[1]);
-    if (a[3] > a[2]) // Compare 3rd and 4th element #2
+    if (a[3] < a[2]) // Compare 3rd and 4th element #2
         swap(&a[3], &a[2]);
-    if (a[0] > a[2]) { // Compare 1st and 3rd element #3
-        // run this if 1st element > 3rd element
+    if (a[0] < a[2]) { // Compare 1st and 3rd element #3
+        // run this if 1st element < 3rd element
         swap(&a[1], &a[2]);
         swap(&a[2], &a[3]);
     } else {
@@ -56,8 +59,8 @@ static void sort5(double a[static 5]) {
     }
     // Now 1st, 2nd and 3rd elements are sorted
     // Sort 5th element into 1st, 2nd and 3rd elements
-    if (a[4] > a[1]) {     // #4
-        if (a[4] > a[0]) { // #5
+    if (a[4] < a[1]) {     // #4
+        if (a[4] < a[0]) { // #5
             swap(&a[4], &a[3]);
             swap(&a[3], &a[2]);
             swap(&a[2], &a[1]);
@@ -68,7 +71,7 @@ static void sort5(double a[static 5]) {
             swap(&a[2], &a[1]);
         }
     } else {
-        if (a[4] > a[2]) { // #5
+        if (a[4] < a[2]) { // #5
             swap(&a[4], &a[3]);
             swap(&a[3], &a[2]);
         } else {
@@ -76,8 +79,8 @@ static void sort5(double a[static 5]) {
         }
     }
     // Sort new 5th element into 2nd, 3rd and 4th
-    if (a[4] > a[2]) {     // #6
-        if (a[4] > a[1]) { // #7
+    if (a[4] < a[2]) {     // #6
+        if (a[4] < a[1]) { // #7
             swap(&a[4], &a[3]);
             swap(&a[3], &a[2]);
             swap(&a[2], &a[1]);
@@ -86,13 +89,13 @@ static void sort5(double a[static 5]) {
             swap(&a[3], &a[2]);
         }
     } else {
-        if (a[4] > a[3]) { // #7
+        if (a[4] < a[3]) { // #7
             swap(&a[4], &a[3]);
         }
     }
 }
 
-static void init_p2(struct P2 *p2, double p) {
+static void init_p2(struct LegacyP2 *p2, double p) {
     for (unsigned i = 0; i < 5; i++) {
         p2->q[i] = 0.0;
         p2->n[i] = (double)i;
@@ -113,20 +116,20 @@ static void init_p2(struct P2 *p2, double p) {
 
 static double sign(double d) {
     if (d > 0) {
-        return 1;
+        return 1.0;
     }
     if (d < 0) {
-        return -1;
+        return -1.0;
     }
-    return 0;
+    return 0.0;
 }
 
-static double linear(struct P2 *p2, unsigned int i, int d) {
+static double linear(struct LegacyP2 *p2, unsigned int i, int d) {
     return p2->q[i] +
            d * (p2->q[i + d] - p2->q[i]) / (p2->n[i + d] - p2->n[i]);
 }
 
-static double parabolic(struct P2 *p2, unsigned int i, int d) {
+static double parabolic(struct LegacyP2 *p2, unsigned int i, int d) {
     return p2->q[i] +
            (d / (p2->n[i + 1] - p2->n[i - 1])) *
                ((p2->n[i] - p2->n[i - 1] + d) * (p2->q[i + 1] - p2->q[i]) /
@@ -135,15 +138,15 @@ static double parabolic(struct P2 *p2, unsigned int i, int d) {
                     (p2->n[i] - p2->n[i - 1]));
 }
 
-static double p2_quantile(struct P2 *p2, double *x, unsigned long size) {
-    double xj = 0.0;
-    unsigned int k = 0;
-    unsigned int i = 0;
-    double d = 0.0;
-    double qp = 0.0;
+static double legacy_p2_quantile(struct LegacyP2 *p2, double const *x,
+                                 unsigned long size) {
+    unsigned int k;
+    unsigned int i;
+    // double d = 0.0;
+    double qp;
 
     if (size < 5) {
-        return _NAN;
+        return 0.0;
     }
     // init q with the 5 first values
     for (i = 0; i < 5; i++) {
@@ -153,12 +156,12 @@ static double p2_quantile(struct P2 *p2, double *x, unsigned long size) {
     sort5(p2->q);
     // now treat the other values
     for (unsigned long j = 5; j < size; j++) {
-        xj = x[j];
+        double xj = x[j];
         if (xj < p2->q[0]) {
-            k = 0;
+            // k = 0;
             p2->q[0] = xj;
         } else if (xj > p2->q[4]) {
-            k = 3;
+            // k = 3;
             p2->q[4] = xj;
         } else {
             k = 0;
@@ -176,7 +179,7 @@ static double p2_quantile(struct P2 *p2, double *x, unsigned long size) {
 
             // update other markers
             for (i = 1; i < 4; i++) {
-                d = p2->np[i] - p2->n[i];
+                double d = p2->np[i] - p2->n[i];
                 if ((d >= 1 && (p2->n[i + 1] - p2->n[i]) > 1) ||
                     (d <= -1 && (p2->n[i - 1] - p2->n[i]) < -1)) {
                     d = sign(d);
@@ -193,10 +196,10 @@ static double p2_quantile(struct P2 *p2, double *x, unsigned long size) {
     return p2->q[2];
 }
 
-double quantile(double p, double *data, unsigned long size) {
-    struct P2 p2;
+static double legacy_quantile(double p, double *data, unsigned long size) {
+    struct LegacyP2 p2;
     init_p2(&p2, p);
-    double q = p2_quantile(&p2, data, size);
+    double q = legacy_p2_quantile(&p2, data, size);
     return q;
 }
 
@@ -221,7 +224,7 @@ unsigned int const seeds[] = {
     86, 87, 88, 89, 90, 91, 92, 93, 94, 95, 96, 97, 98, 99, 100};
 size_t const m = sizeof(seeds) / sizeof(unsigned int);
 
-void accuracy(double target) {
+void accuracy(double target, Filler fill) {
     double *data = NULL;
 
     // target
@@ -242,9 +245,13 @@ void accuracy(double target) {
         maxi = 0.0;
         for (size_t j = 0; j < m; j++) {
             srand(seeds[j]);
-            fill_rgauss(data, sizes[i]);
+            fill(data, sizes[i]);
 
-            q_p2 = quantile(p, data, sizes[i]);
+            q_p2 = p2_quantile(p, data, sizes[i]);
+            if (q_p2 != legacy_quantile(p, data, sizes[i])) {
+                printf("kernels mismatch (size=%zu, seed=%u)\n", sizes[i],
+                       seeds[j]);
+            }
 
             qsort(data, sizes[i], sizeof(double), cmp);
             q_ref = data[(int)(p * sizes[i])];
@@ -256,61 +263,74 @@ void accuracy(double target) {
             mean += rerr;
         }
         mean /= m;
-        printf("%6d |%19.2f%% |%18.2f%% \n", sizes[i], 100 * mean, 100 * maxi);
+        printf("%6zu |%19.2f%% |%18.2f%% \n", sizes[i], 100 * mean,
+               100 * maxi);
         free(data);
     }
 }
 
-void speed(double target) {
+void speed(double target, Filler fill) {
     double *data = NULL;
     clock_t start;
     unsigned long long reference = 0;
+    unsigned long long legacy = 0;
     unsigned long long custom = 0;
 
     // target
     double const p = target;
 
-    double q_p2 = 0.0;
-    double q_ref = 0.0;
+    // avoid the quantile computations to be optimized out
+    volatile double q = 0.0;
 
-    double mean = 0.0;
-    double maxi = 0.0;
-    double rerr = 0.0;
-
-    printf("  size |    sort |      p2 | speed factor \n");
-    printf("-------|---------|---------|--------------\n");
+    printf("  size |    sort |  legacy |      p2 | sort/p2 | legacy/p2 \n");
+    printf("-------|---------|---------|---------|---------|-----------\n");
     for (size_t i = 0; i < n; i++) {
         data = malloc(sizes[i] * sizeof(double));
         reference = 0;
+        legacy = 0;
         custom = 0;
 
         for (size_t j = 0; j < m; j++) {
             srand(seeds[j]);
-            fill_rgauss(data, sizes[i]);
+            fill(data, sizes[i]);
 
             start = clock();
             qsort(data, sizes[i], sizeof(double), cmp);
-            q_ref = data[(int)(p * sizes[i])];
+            q = data[(int)(p * sizes[i])];
             reference += clock() - start;
         }
 
         for (size_t j = 0; j < m; j++) {
             srand(seeds[j]);
-            fill_rgauss(data, sizes[i]);
+            fill(data, sizes[i]);
             start = clock();
-            q_p2 = quantile(p, data, sizes[i]);
+            q = legacy_quantile(p, data, sizes[i]);
+            legacy += clock() - start;
+        }
+
+        for (size_t j = 0; j < m; j++) {
+            srand(seeds[j]);
+            fill(data, sizes[i]);
+            start = clock();
+            q = p2_quantile(p, data, sizes[i]);
             custom += clock() - start;
         }
 
-        printf("%6d |%8d |%8d |%13.1f\n", sizes[i], reference, custom,
-               (double)reference / (double)custom);
+        printf("%6zu |%8llu |%8llu |%8llu |%8.1f |%10.2f\n", sizes[i],
+               reference, legacy, custom, (double)reference / (double)custom,
+               (double)legacy / (double)custom);
         free(data);
     }
+    (void)q;
 }
 
-int main(int argc, const char *argv[]) {
+int main(void) {
     double p = 0.99;
-    speed(p);
-    accuracy(p);
+    printf("# Uniform\n\n");
+    speed(p, fill_runif);
+    accuracy(p, fill_runif);
+    printf("\n# Gaussian\n\n");
+    speed(p, fill_rgauss);
+    accuracy(p, fill_rgauss);
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,93 @@
+// Speed of the text parser (spot_parse_column) against strtod on metric
+// files (timestamp,value lines)
+#include "spot_parse.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define LINES 2000000
+#define RUNS 5
+
+static double const CPS = CLOCKS_PER_SEC;
+
+static double values[LINES];
+static double expected[LINES];
+
+typedef int (*Formatter)(char *, size_t, unsigned long, double);
+
+// U(0, 1)
+static double runif(void) { return (double)rand() / (double)RAND_MAX; }
+
+// gauge (fixed precision)
+static int format_gauge(char *buffer, size_t size, unsigned long i, double x) {
+    return snprintf(buffer, size, "%lu,%.3f\n", 1700000000UL + i, 100.0 * x);
+}
+
+// counter (integers)
+static int format_counter(char *buffer, size_t size, unsigned long i,
+                          double x) {
+    return snprintf(buffer, size, "%lu,%lu\n", 1700000000UL + i,
+                    (unsigned long)(1e6 * x));
+}
+
+// full precision (like a %.17g export)
+static int format_full(char *buffer, size_t size, unsigned long i, double x) {
+    return snprintf(buffer, size, "%lu,%.17g\n", 1700000000UL + i, x * 1e-3);
+}
+
+// baseline: split the lines and call strtod on the second field
+static unsigned long baseline(char const *begin, char const *end) {
+    unsigned long n = 0;
+    char const *p = begin;
+    while (p < end) {
+        char const *eol = memchr(p, '\n', (size_t)(end - p));
+        char const *comma = memchr(p, ',', (size_t)(eol - p));
+        char *stop;
+        // the text is null-terminated, strtod stops at the newline
+        expected[n++] = strtod(comma + 1, &stop);
+        p = eol + 1;
+    }
+    return n;
+}
+
+static void bench(char const *name, Formatter format) {
+    // generate the file
+    size_t const capacity = 48 * LINES;
+    char *text = malloc(capacity);
+    size_t size = 0;
+    for (unsigned long i = 0; i < LINES; ++i) {
+        size += (size_t)format(text + size, capacity - size, i, runif());
+    }
+    double const mb = (double)size / 1e6;
+
+    double t_baseline = 0.0;
+    double t_parse = 0.0;
+    unsigned long n = 0;
+    unsigned long count = 0;
+    for (int r = 0; r < RUNS; ++r) {
+        clock_t start = clock();
+        n = baseline(text, text + size);
+        t_baseline += (double)(clock() - start) / CPS;
+
+        start = clock();
+        spot_parse_column(text, text + size, 1, ',', 1, values, LINES, &count);
+        t_parse += (double)(clock() - start) / CPS;
+    }
+
+    int mismatch = (n != count) || memcmp(values, expected, n * sizeof(double));
+    printf("| %-8s | %8.1f | %10.1f | %10.1f | %8s |\n", name, mb,
+           RUNS * mb / t_baseline, RUNS * mb / t_parse,
+           mismatch ? "MISMATCH" : "ok");
+    free(text);
+}
+
+int main(void) {
+    srand(0);
+    printf("| format   | size(MB) | strtod MB/s | parse MB/s | values   |\n");
+    printf("| -------- | -------- | ----------- | ---------- | -------- |\n");
+    bench("gauge", format_gauge);
+    bench("counter", format_counter);
+    bench("full", format_full);
+    return 0;
+}
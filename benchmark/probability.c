@@ -0,0 +1,119 @@
+#include "spot.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// This benchmark is linked against the library sources: the scalar functions
+// (spot_probability, spot_quantile) and the batch ones are built with the same
+// flags
+
+static double const PI = 0x1.921fb54442d18p+1;
+static double const DMAX = RAND_MAX;
+
+// U(0, 1)
+double runif() { return (double)rand() / DMAX; }
+
+double rgauss() { return sqrt(-2 * log(runif())) * cos(2 * PI * runif()); }
+
+size_t const sizes[] = {16, 64, 256, 1000, 4096, 10000, 100000};
+size_t const n = sizeof(sizes) / sizeof(size_t);
+
+static unsigned long const ROUNDS = 10000000;
+
+typedef void (*Scorer)(struct Spot const *, double const *, unsigned long,
+                       double *);
+
+static void probability_loop(struct Spot const *spot, double const *z,
+                             unsigned long size, double *out) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = spot_probability(spot, z[i]);
+    }
+}
+
+static void quantile_loop(struct Spot const *spot, double const *q,
+                          unsigned long size, double *out) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = spot_quantile(spot, q[i]);
+    }
+}
+
+/**
+ * @brief Return the throughput of a scorer (millions of values per second)
+ */
+static double throughput(Scorer scorer, struct Spot const *spot,
+                         double const *input, unsigned long size,
+                         double *out) {
+    unsigned long const rounds = ROUNDS / size + 1;
+    clock_t const start = clock();
+    for (unsigned long r = 0; r < rounds; ++r) {
+        scorer(spot, input, size, out);
+    }
+    double const elapsed = (double)(clock() - start) / CLOCKS_PER_SEC;
+    return (double)(rounds * size) / elapsed / 1e6;
+}
+
+static void compare(char const *name, Scorer loop, Scorer batch,
+                    struct Spot const *spot, double const *input) {
+    size_t const size = sizes[n - 1];
+    double *expected = malloc(size * sizeof(double));
+    double *out = malloc(size * sizeof(double));
+
+    loop(spot, input, size, expected);
+    batch(spot, input, size, out);
+    unsigned long mismatches = 0;
+    for (size_t i = 0; i < size; ++i) {
+        mismatches += (expected[i] != out[i]);
+    }
+    printf("%s: %lu mismatches over %zu values\n\n", name, mismatches, size);
+
+    printf("   size |   loop (Mv/s) |  batch (Mv/s) | speedup \n");
+    printf("--------|---------------|---------------|---------\n");
+    for (size_t i = 0; i < n; i++) {
+        double const scalar = throughput(loop, spot, input, sizes[i], out);
+        double const vector = throughput(batch, spot, input, sizes[i], out);
+        printf("%7zu |%14.1f |%14.1f |%8.2f \n", sizes[i], scalar, vector,
+               vector / scalar);
+    }
+    printf("\n");
+    free(expected);
+    free(out);
+}
+
+int main(void) {
+    set_allocators(malloc, free);
+    srand(1);
+
+    unsigned long const training = 100000;
+    size_t const size = sizes[n - 1];
+    double *data = malloc(training * sizeof(double));
+    double *z = malloc(size * sizeof(double));
+    double *q = malloc(size * sizeof(double));
+    for (unsigned long i = 0; i < training; ++i) {
+        data[i] = rgauss();
+    }
+
+    struct Spot spot;
+    spot_init(&spot, 1e-4, 0, 1, 0.98, 2000);
+    if (spot_fit(&spot, data, training) < 0) {
+        printf("fit failed\n");
+        return 1;
+    }
+    printf("gamma = %g, sigma = %g\n\n", spot.tail.gamma, spot.tail.sigma);
+
+    // values and probabilities within the tail
+    for (size_t i = 0; i < size; ++i) {
+        z[i] = spot.excess_threshold + 2 * runif();
+        q[i] = 1e-6 + 1e-2 * runif();
+    }
+
+    compare("spot_probability", probability_loop, spot_probability_batch,
+            &spot, z);
+    compare("spot_quantile", quantile_loop, spot_quantile_batch, &spot, q);
+
+    spot_free(&spot);
+    free(data);
+    free(z);
+    free(q);
+    return 0;
+}
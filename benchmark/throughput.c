@@ -0,0 +1,113 @@
+#include "spot.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// Fit/step throughput of the library. make benchmark_amalgamation builds it
+// twice: against the modules compiled separately (split build) and against
+// the amalgamation (dist/libspot.c), so the two can be compared
+
+#if defined(LIBSPOT_BENCHMARK_AMALGAMATION)
+#define BUILD "amalgamation"
+#else
+#define BUILD "split"
+#endif
+
+static double const PI = 0x1.921fb54442d18p+1;
+static double const DMAX = RAND_MAX;
+
+// U(0, 1)
+double runif() { return (double)rand() / DMAX; }
+
+double rgauss() { return sqrt(-2 * log(runif())) * cos(2 * PI * runif()); }
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+int main(int argc, char const *argv[]) {
+    unsigned long const size =
+        (argc > 1) ? strtoul(argv[1], NULL, 10) : 1000000;
+    unsigned long const training = 50000;
+    unsigned long const fits = 20;
+    // passes over the normal values (a single one is too short to time)
+    unsigned long const passes = 20;
+
+    set_allocators(malloc, free);
+    srand(1);
+
+    double *data = malloc((fits * training + size) * sizeof(double));
+    int *results = malloc(size * sizeof(int));
+    for (unsigned long i = 0; i < fits * training + size; ++i) {
+        data[i] = rgauss();
+    }
+    double const *stream = data + fits * training;
+
+    struct Spot spot;
+
+    // fit (grimshaw)
+    clock_t start = clock();
+    for (unsigned long k = 0; k < fits; ++k) {
+        spot_init(&spot, 1e-4, 0, 1, 0.98, 500);
+        spot_fit(&spot, data + k * training, training);
+        spot_free(&spot);
+    }
+    double const fit = elapsed(start);
+
+    // step
+    spot_init(&spot, 1e-4, 0, 1, 0.98, 500);
+    spot_fit(&spot, data, training);
+    unsigned long anomalies = 0;
+    start = clock();
+    for (unsigned long i = 0; i < size; ++i) {
+        anomalies += (spot_step(&spot, stream[i]) == ANOMALY);
+    }
+    double const step = elapsed(start);
+    spot_free(&spot);
+
+    // step_batch
+    spot_init(&spot, 1e-4, 0, 1, 0.98, 500);
+    spot_fit(&spot, data, training);
+    start = clock();
+    spot_step_batch(&spot, stream, size, results);
+    double const batch = elapsed(start);
+    spot_free(&spot);
+
+    // normal path: the values below the excess threshold do not change the
+    // model, so there is no refit in the timings
+    spot_init(&spot, 1e-4, 0, 1, 0.98, 500);
+    spot_fit(&spot, data, training);
+    double *normal = malloc(size * sizeof(double));
+    for (unsigned long i = 0; i < size; ++i) {
+        double x = stream[i];
+        while (x >= spot.excess_threshold) {
+            x = rgauss();
+        }
+        normal[i] = x;
+    }
+    start = clock();
+    for (unsigned long k = 0; k < passes; ++k) {
+        for (unsigned long i = 0; i < size; ++i) {
+            spot_step(&spot, normal[i]);
+        }
+    }
+    double const step_normal = elapsed(start) / passes;
+    start = clock();
+    for (unsigned long k = 0; k < passes; ++k) {
+        spot_step_batch(&spot, normal, size, results);
+    }
+    double const batch_normal = elapsed(start) / passes;
+    spot_free(&spot);
+
+    printf("%-13s| fit %8.3f ms | step %7.2f Mv/s | step_batch %7.2f Mv/s "
+           "| normal step %7.2f Mv/s | normal step_batch %7.2f Mv/s "
+           "| anomalies %lu\n",
+           BUILD, 1e3 * fit / fits, size / step / 1e6, size / batch / 1e6,
+           size / step_normal / 1e6, size / batch_normal / 1e6, anomalies);
+
+    free(data);
+    free(normal);
+    free(results);
+    return 0;
+}
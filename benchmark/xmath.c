@@ -0,0 +1,186 @@
+#include "spot.h"
+#include "xmath.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// This benchmark is linked against the library sources, so it measures the
+// math backend selected at build time (make benchmark_xmath builds and runs
+// all of them)
+
+#if defined(LIBSPOT_MATH_LIBMVEC)
+#define BACKEND "libmvec"
+#elif defined(LIBSPOT_MATH_LIBM)
+#define BACKEND "libm"
+#else
+#define BACKEND "xmath"
+#endif
+
+#define SEED 0
+
+static double const PI = 0x1.921fb54442d18p+1;
+static double const DMAX = RAND_MAX;
+
+// number of values of the accuracy/speed runs
+static unsigned long const N = 1000000;
+
+// U(0, 1)
+double runif() { return (double)rand() / DMAX; }
+
+double rgauss() { return sqrt(-2 * log(runif())) * cos(2 * PI * runif()); }
+
+typedef union {
+    double d;
+    long long i;
+} double_cast;
+
+/**
+ * @brief Distance in ulps between two (finite, same sign) doubles
+ */
+static long long ulps(double a, double b) {
+    double_cast const x = {.d = a};
+    double_cast const y = {.d = b};
+    long long const d = x.i - y.i;
+    return d < 0 ? -d : d;
+}
+
+struct accuracy {
+    long long ulps;
+    double relative;
+};
+
+static void check(struct accuracy *acc, double value, long double reference) {
+    double const ref = (double)reference;
+    long long const u = ulps(value, ref);
+    if (u > acc->ulps) {
+        acc->ulps = u;
+    }
+    double const r = fabs((value - ref) / ref);
+    if (r > acc->relative) {
+        acc->relative = r;
+    }
+}
+
+static double elapsed(clock_t start) {
+    return (double)(clock() - start) / CLOCKS_PER_SEC;
+}
+
+/**
+ * @brief Scalar and batch throughputs of a function (millions of values per
+ * second)
+ */
+static void speed(char const *name, double const *x, double *out) {
+    double const alpha = -0.3;
+    double scalar = 0.0;
+    double batch = 0.0;
+    clock_t start;
+
+    start = clock();
+    if (name[0] == 'l') {
+        for (unsigned long i = 0; i < N; ++i) {
+            out[i] = xlog(x[i]);
+        }
+    } else if (name[0] == 'e') {
+        for (unsigned long i = 0; i < N; ++i) {
+            out[i] = xexp(x[i]);
+        }
+    } else {
+        for (unsigned long i = 0; i < N; ++i) {
+            out[i] = xpow(x[i], alpha);
+        }
+    }
+    scalar = elapsed(start);
+
+    start = clock();
+    if (name[0] == 'l') {
+        xlog_batch(x, out, N);
+    } else if (name[0] == 'e') {
+        xexp_batch(x, out, N);
+    } else {
+        xpow_batch(x, alpha, out, N);
+    }
+    batch = elapsed(start);
+
+    printf("%-9s|%14.1f |%14.1f \n", name, N / scalar / 1e6, N / batch / 1e6);
+}
+
+int main() {
+    double *x = malloc(N * sizeof(double));
+    double *e = malloc(N * sizeof(double));
+    double *out = malloc(N * sizeof(double));
+    struct accuracy acc[6] = {{0, 0.0}};
+
+    srand(SEED);
+    for (unsigned long i = 0; i < N; ++i) {
+        // log/pow inputs over 20 decades, exp inputs in [-20, 20]
+        x[i] = pow(10., 20. * runif() - 10.);
+        e[i] = 40. * runif() - 20.;
+    }
+
+    printf("BACKEND %s\n\n", BACKEND);
+
+    printf("ACCURACY ===\n");
+    printf("function | max ulp error | max relative error\n");
+    printf("---------|---------------|-------------------\n");
+    xlog_batch(x, out, N);
+    for (unsigned long i = 0; i < N; ++i) {
+        check(&acc[0], xlog(x[i]), logl(x[i]));
+        check(&acc[1], out[i], logl(x[i]));
+    }
+    xexp_batch(e, out, N);
+    for (unsigned long i = 0; i < N; ++i) {
+        check(&acc[2], xexp(e[i]), expl(e[i]));
+        check(&acc[3], out[i], expl(e[i]));
+    }
+    xpow_batch(x, -0.3, out, N);
+    for (unsigned long i = 0; i < N; ++i) {
+        check(&acc[4], xpow(x[i], -0.3), powl(x[i], -0.3L));
+        check(&acc[5], out[i], powl(x[i], -0.3L));
+    }
+    char const *names[] = {"log",       "log_batch", "exp",
+                           "exp_batch", "pow",       "pow_batch"};
+    for (int k = 0; k < 6; ++k) {
+        printf("%-9s|%14lld |%19E\n", names[k], acc[k].ulps, acc[k].relative);
+    }
+
+    printf("\nSPEED ===\n");
+    printf("function | scalar (Mv/s) |  batch (Mv/s) \n");
+    printf("---------|---------------|---------------\n");
+    speed("log", x, out);
+    speed("exp", e, out);
+    speed("pow", x, out);
+
+    // end-to-end: fit (grimshaw) and step
+    for (unsigned long i = 0; i < N; ++i) {
+        x[i] = rgauss();
+    }
+    set_allocators(malloc, free);
+    struct Spot spot;
+    unsigned long const fits = 20;
+    unsigned long const training = 50000;
+    clock_t start = clock();
+    for (unsigned long k = 0; k < fits; ++k) {
+        spot_init(&spot, 1e-4, 0, 1, 0.98, 2000);
+        spot_fit(&spot, x + k * training, training);
+        spot_free(&spot);
+    }
+    double const fit = elapsed(start);
+
+    spot_init(&spot, 1e-4, 0, 1, 0.98, 2000);
+    spot_fit(&spot, x, training);
+    start = clock();
+    for (unsigned long i = training; i < N; ++i) {
+        spot_step(&spot, x[i]);
+    }
+    double const step = elapsed(start);
+    spot_free(&spot);
+
+    printf("\nSPOT ===\n");
+    printf("fit  %9.2f ms (%lu values)\n", 1e3 * fit / fits, training);
+    printf("step %9.1f Mv/s\n", (N - training) / step / 1e6);
+
+    free(x);
+    free(e);
+    free(out);
+}
@@ -0,0 +1,3215 @@
+/**
+ * @file libspot.h
+ * @brief libspot 2.0b4 amalgamation (generated by make amalgamation)
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+#ifndef LIBSPOT_H
+#define LIBSPOT_H
+
+// internal symbols get internal linkage (see structs.h)
+#define LIBSPOT_AMALGAMATION
+
+// include/structs.h
+
+#ifndef STRUCTS_H
+#define STRUCTS_H
+
+/**
+ * @brief Linkage of the internal symbols (the ones that are not part of the
+ * API). They are shared between the modules of the library, but they get
+ * internal linkage in the amalgamation (dist/libspot.c) so that the compiler
+ * can inline them across modules.
+ */
+#if defined(LIBSPOT_AMALGAMATION) && defined(__GNUC__)
+// a few of them are only used by the tests
+#define LIBSPOT_INTERNAL static __attribute__((unused))
+#define LIBSPOT_INTERNAL_EXTERN static __attribute__((unused))
+#elif defined(LIBSPOT_AMALGAMATION)
+#define LIBSPOT_INTERNAL static
+#define LIBSPOT_INTERNAL_EXTERN static
+#else
+#define LIBSPOT_INTERNAL
+#define LIBSPOT_INTERNAL_EXTERN extern
+#endif
+
+/**
+ * @brief \`malloc_fn\` is a pointer to a malloc-type function
+ * i.e. with prototype:
+ * \`void * malloc(size_t)\`
+ *
+ * \`__SIZE_TYPE__\` define the size_t type. This type is notably used
+ * for malloc but it depends on the architecture. As we assume we receive
+ * malloc-like functions we have to be compliant with their prototypes.
+ */
+typedef void *(*malloc_fn)(__SIZE_TYPE__);
+
+/**
+ * @brief \`free_fn\` is a pointer to a free-type function
+ * i.e. with prototype:
+ * \`void free(void*)\`
+ */
+typedef void (*free_fn)(void *);
+
+/**
+ * @brief \`frexp_fn\` is a pointer to a frexp-type function
+ * i.e. with prototype:
+ * \`double frexp_fn(double, int*)\`
+ *
+ * This function decomposes a floating point value
+ * into a normalized fraction and an integral power of 2.
+ * See https://en.cppreference.com/w/c/numeric/math/frexp
+ */
+typedef double (*frexp_fn)(double, int *);
+
+/**
+ * @brief \`ldexp_fn\` is a pointer to a ldexp-type function
+ * i.e. with prototype:
+ * \`double ldexp_fn(double, int*)\`
+ *
+ * This function multiplies a floating point value
+ * by the number 2 raised to the exp power.
+ * See https://en.cppreference.com/w/c/numeric/math/ldexp
+ */
+typedef double (*ldexp_fn)(double, int);
+
+/**
+ * @brief \`real_function\` defines a pointer to a univariate function that
+ * can require extra paramaters (second argument)
+ */
+typedef double (*real_function)(double, void *);
+
+/**
+ * @brief Constants to store libspot errors
+ *
+ */
+enum LibspotError {
+    /// Allocation of the backing array failed
+    ERR_MEMORY_ALLOCATION_FAILED = 1000,
+    /// The level parameter must between 0 and 1
+    ERR_LEVEL_OUT_OF_BOUNDS,
+    /// The q parameter must be between 0 and 1-level
+    ERR_Q_OUT_OF_BOUNDS,
+    /// The excess threshold has not been initialized
+    ERR_EXCESS_THRESHOLD_IS_NAN,
+    /// The anomaly threshold has not been initialized
+    ERR_ANOMALY_THRESHOLD_IS_NAN,
+    /// The input data is NaN
+    ERR_DATA_IS_NAN,
+    /// No chunked fit is in progress
+    ERR_FIT_NOT_STARTED,
+    /// The buffer is too small
+    ERR_BUFFER_TOO_SMALL,
+    /// The buffer is not a valid Spot snapshot
+    ERR_INVALID_SNAPSHOT,
+};
+
+/**
+ * @brief Possible outputs of a Spot step
+ *
+ */
+enum SpotResult {
+    /// @brief Data is normal
+    NORMAL = 0,
+    /// @brief Data is in the tail (so the model has been updated)
+    EXCESS = 1,
+    /// @brief Data is beyond the anomaly threshold
+    ANOMALY = 2,
+};
+
+/**
+ *  @brief This container is a kind of circular vector.
+ *
+ * First it is empty. Then we feed it with data until its max capacity is
+ * reached (transitory state). When it is full, the earlier data erase the
+ * older one (cruise state).
+ */
+struct Ubend {
+    /// @brief Current position inside the container
+    unsigned long cursor;
+    /// @brief Max storage
+    unsigned long capacity;
+    /// @brief Last erased value (i.e. replaced by a new one)
+    double last_erased_data;
+    /// @brief Container fill status (1 = filled, 0 = not filled)
+    int filled;
+    /// @brief Data container
+    double *data;
+};
+
+/**
+ * @brief Stucture that computes stats about the peaks
+ *
+ */
+struct Peaks {
+    /// @brief Sum of the elements
+    double e;
+    /// @brief Sum of the square of the elements
+    double e2;
+    /// @brief Minimum of the elements
+    double min;
+    /// @brief Maximum of the elements
+    double max;
+    /// @brief Underlying data container
+    struct Ubend container;
+};
+
+/**
+ * @brief Stucture that embeds GPD parameter (GPD tail actually)
+ *
+ */
+struct Tail {
+    /// @brief GPD gamma parameter
+    double gamma;
+    /// @brief GPD sigma parameter
+    double sigma;
+    /// @brief Underlyning Peaks structure
+    struct Peaks peaks;
+};
+
+/**
+ * @brief Structure that estimates a quantile online with the P2 algorithm
+ *
+ * The state is a structure of arrays: every per-sample update of the marker
+ * positions is an element-wise operation over the 5 markers.
+ * See aakinshin.net/posts/p2-quantile-estimator/
+ */
+struct P2 {
+    /// @brief Marker heights
+    double q[5];
+    /// @brief Marker positions
+    double n[5];
+    /// @brief Desired marker positions
+    double np[5];
+    /// @brief Increments of the desired marker positions
+    double dn[5];
+    /// @brief Number of inserted values
+    unsigned long count;
+};
+
+/**
+ * @struct Spot
+ * @brief Main structure to run the SPOT algorithm
+ *
+ */
+struct Spot {
+    /// @brief Probability of an anomaly
+    double q;
+    /// @brief Location of the tail (high quantile)
+    double level;
+    /// @brief Flag anomalies (1 = flag, 0 = don't flag)
+    int discard_anomalies;
+    /// @brief Upper/Lower tail choice (1 = lower tail, 0 = upper tail)
+    int low;
+    /// @brief Internal constant (+/- 1.0)
+    double __up_down;
+    /// @brief  Normal/abnormal threshold
+    double anomaly_threshold;
+    /// @brief  Tail threshold
+    double excess_threshold;
+    /// @brief Total number of excesses
+    unsigned long Nt;
+    /// @brief Total number of seen data
+    unsigned long n;
+    /// @brief GPD Tail
+    struct Tail tail;
+    /// @brief Drift of the excess threshold that triggers a recalibration
+    /// (NaN = no recalibration)
+    double rebase_tolerance;
+    /// @brief Online estimator of the excess threshold
+    struct P2 tracker;
+    /// @brief Candidate excesses of a chunked fit (empty otherwise)
+    struct Ubend candidates;
+};
+
+/**
+ * @struct SpotFrozen
+ * @brief Inference-only model exported from a trained Spot (see
+ * spot_freeze)
+ *
+ */
+struct SpotFrozen {
+    /// @brief Probability of an anomaly
+    double q;
+    /// @brief Internal constant (+/- 1.0)
+    double __up_down;
+    /// @brief  Normal/abnormal threshold
+    double anomaly_threshold;
+    /// @brief  Tail threshold
+    double excess_threshold;
+    /// @brief Ratio of excesses (Nt/n)
+    double s;
+    /// @brief GPD gamma parameter
+    double gamma;
+    /// @brief GPD sigma parameter
+    double sigma;
+    /// @brief Flag anomalies (like a Spot that discards them)
+    int discard_anomalies;
+};
+
+#endif // STRUCTS_H
+
+// include/spot.h
+
+#ifndef SPOT_H
+#define SPOT_H
+
+
+
+
+// Spot API ------------------------------------------------------------------
+
+/**
+ * @brief Initialize the Spot structure
+ *
+ * @param spot Spot instance
+ * @param q Decision probability (Spot will flag extreme events that will have
+ * a probability lower than q)
+ * @param low Lower tail mode (0 by defaut for upper tail and 1 for lower tail)
+ * @param discard_anomalies Do not include anomalies in the model (default: 1,
+ * 0 otherwise)
+ * @param level Excess level (it is a high quantile that delimits the tail)
+ * @param max_excess Maximum number of data that are kept to analyze the tail
+ * @retval 0 OK
+ * @retval -ERR_LEVEL_OUT_OF_BOUNDS the level parameter is not between 0 and 1
+ * @retval -ERR_Q_OUT_OF_BOUNDS the q parameter is not between 0 and 1-level
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the tail data allocation failed
+ */
+int spot_init(struct Spot *spot, double q, int low, int discard_anomalies,
+              double level, unsigned long max_excess);
+
+/**
+ * @brief Free the tail data
+ *
+ * @param spot Spot instance
+ */
+void spot_free(struct Spot *spot);
+
+/**
+ * @brief Compute the first excess and anomaly thresholds based on training
+ * data
+ *
+ * The data are read once, like a chunked fit (see spot_fit_begin) with a
+ * candidate buffer of 4 * max_excess values. It is allocated for the time of
+ * the fit (twice this size, with the sample of the evicted candidates).
+ * When size <= 4 * max_excess, the fit is exact. Otherwise the tail still
+ * gets the last max_excess excesses over the final excess threshold, but
+ * the number of excesses Nt is an estimate (within a few percents on
+ * stationary data).
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @retval 0 OK
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the candidate buffer allocation
+ * failed
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NA the anomaly threshold is nan
+ */
+int spot_fit(struct Spot *spot, double const *data, unsigned long size);
+
+/**
+ * @brief Start a chunked fit
+ *
+ * The training data are then passed by chunks to spot_fit_feed and the fit
+ * is completed by spot_fit_end. The data are read once and kept in a bounded
+ * buffer: when it can hold all of them, the fit is exact (every excess over
+ * the final excess threshold is counted). Otherwise, once it is full, only
+ * the candidate excesses (the data above a lower bound of the current
+ * estimate of the excess threshold) are kept and the oldest candidates are
+ * evicted. As the tail keeps the last max_excess excesses, a capacity of a
+ * few times max_excess is enough (about half of the candidates are real
+ * excesses).
+ *
+ * The number of excesses Nt is then an estimate: the evicted candidates are
+ * sampled uniformly over time (in a second buffer of the same capacity) and
+ * the excesses of the sample over the final threshold are scaled. It remains
+ * close to the exact count under a drift. However the data below the lower
+ * bound are dropped: the fit assumes that the final excess threshold is not
+ * far below this bound, i.e. that the training data are roughly stationary
+ * (a strong decreasing drift loses excesses).
+ *
+ * @param spot Spot instance
+ * @param candidates Capacity of the candidate buffer
+ * @retval 0 OK
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the buffer allocation failed
+ */
+int spot_fit_begin(struct Spot *spot, unsigned long candidates);
+
+/**
+ * @brief Pass a chunk of training data
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @retval 0 OK
+ * @retval -ERR_FIT_NOT_STARTED spot_fit_begin has not been called
+ */
+int spot_fit_feed(struct Spot *spot, double const *data, unsigned long size);
+
+/**
+ * @brief Complete a chunked fit: compute the first excess and anomaly
+ * thresholds and release the candidate buffer
+ *
+ * @param spot Spot instance
+ * @retval 0 OK
+ * @retval -ERR_FIT_NOT_STARTED spot_fit_begin has not been called
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NA the anomaly threshold is nan
+ */
+int spot_fit_end(struct Spot *spot);
+
+/**
+ * @brief fit-predict step
+ *
+ * @param spot Spot instance
+ * @param x new value
+ * @retval -ERR_DATA_IS_NAN input data is nan
+ * @retval NORMAL data is normal
+ * @retval EXCESS data lives in the tail
+ * @retval ANOMALY data is out of the threshold
+ */
+int spot_step(struct Spot *spot, double x);
+
+/**
+ * @brief fit-predict steps over a buffer of values
+ *
+ * It is equivalent to calling spot_step on every value, but the normal
+ * values (the most common case) are processed inline.
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @param[out] results Output of spot_step for every value (it can be NULL)
+ * @return the number of anomalies (ANOMALY results)
+ */
+unsigned long spot_step_batch(struct Spot *spot, double const *data,
+                              unsigned long size, int *results);
+
+/**
+ * @brief Enable the online recalibration of the excess threshold
+ *
+ * The excess threshold is then re-estimated at every step (P2 algorithm).
+ * When it has drifted from the current one by more than the tolerance, it
+ * replaces it: the stored excesses are shifted accordingly and the tail is
+ * refitted. It keeps the excess rate close to 1-level under slow drifts.
+ *
+ * @param spot Spot instance
+ * @param tolerance Maximum drift of the excess threshold (in data unit).
+ * A NaN or a negative value disables the recalibration (default).
+ */
+void spot_set_rebase_tolerance(struct Spot *spot, double tolerance);
+
+/**
+ * @brief Return the size of the snapshot of a Spot instance (in bytes)
+ *
+ * @param spot Spot instance
+ * @return the size of the buffer to pass to spot_serialize
+ */
+unsigned long spot_serialized_size(struct Spot const *spot);
+
+/**
+ * @brief Write a snapshot of a Spot instance
+ *
+ * The snapshot is a versioned binary format (little-endian, 8-byte words)
+ * that stores the parameters, the thresholds, the counters, the GPD
+ * parameters, the threshold tracker and the excesses (from the oldest). It
+ * does not depend on the host. The candidates of an unfinished chunked fit
+ * are not stored.
+ *
+ * @param spot Spot instance
+ * @param[out] buffer output buffer
+ * @param size size of the output buffer
+ * @retval 0 OK
+ * @retval -ERR_BUFFER_TOO_SMALL the buffer is smaller than
+ * spot_serialized_size
+ */
+int spot_serialize(struct Spot const *spot, void *buffer, unsigned long size);
+
+/**
+ * @brief Restore a Spot instance from a snapshot (see spot_serialize)
+ *
+ * The model is not refitted: the excesses are copied back and the stats of
+ * the tail are recomputed. The instance must not be initialized (or it must
+ * have been freed). It is left freed when the restore fails.
+ *
+ * @param spot Spot instance
+ * @param buffer snapshot
+ * @param size size of the snapshot
+ * @retval 0 OK
+ * @retval -ERR_BUFFER_TOO_SMALL the snapshot is truncated
+ * @retval -ERR_INVALID_SNAPSHOT the buffer is not a valid snapshot
+ * @retval -ERR_LEVEL_OUT_OF_BOUNDS the stored level is not between 0 and 1
+ * @retval -ERR_Q_OUT_OF_BOUNDS the stored q is not between 0 and 1-level
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the tail data allocation failed
+ */
+int spot_deserialize(struct Spot *spot, void const *buffer,
+                     unsigned long size);
+
+/**
+ * @brief Compute the value zq such that P(X>zq) = q
+ *
+ * @param spot Spot instance
+ * @param q Low probability (it must be within the tail)
+ * @return the desired quantile
+ */
+double spot_quantile(struct Spot const *spot, double q);
+
+/**
+ * @brief Compute the probability p such that P(X>z) = p
+ *
+ * @param spot Spot instance
+ * @param z High quantile (it must be within the tail)
+ * @return the desired probability
+ */
+double spot_probability(struct Spot const *spot, double z);
+
+/**
+ * @brief Compute the quantiles of a buffer of probabilities (see
+ * spot_quantile)
+ *
+ * The model constants are computed once and the logarithms/powers run over
+ * the whole buffer (vectorizable loops), so it is faster than calling
+ * spot_quantile in a loop. The results are the same. The output buffer can
+ * be the input one.
+ *
+ * @param spot Spot instance
+ * @param q Buffer of low probabilities (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] quantiles Output quantiles
+ */
+void spot_quantile_batch(struct Spot const *spot, double const *q,
+                         unsigned long size, double *quantiles);
+
+/**
+ * @brief Compute the probabilities of a buffer of values (see
+ * spot_probability)
+ *
+ * Like spot_quantile_batch, it gives the same results as spot_probability
+ * (except at the end of the support of the tail, where the batch returns 0
+ * instead of NaN). The output buffer can be the input one.
+ *
+ * @param spot Spot instance
+ * @param z Buffer of high quantiles (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] probabilities Output probabilities
+ */
+void spot_probability_batch(struct Spot const *spot, double const *z,
+                            unsigned long size, double *probabilities);
+
+/**
+ * @brief Export the inference-only model of a trained Spot instance
+ *
+ * The frozen model only keeps the thresholds and the GPD parameters (a few
+ * dozen bytes, no allocation). It classifies and scores data like the
+ * detector at the time of the export, without learning from them.
+ *
+ * @param spot Spot instance (fitted)
+ * @param[out] frozen frozen model
+ * @retval 0 OK
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NAN the anomaly threshold is nan
+ */
+int spot_freeze(struct Spot const *spot, struct SpotFrozen *frozen);
+
+/**
+ * @brief Classify a buffer of values with a frozen model
+ *
+ * @param frozen frozen model
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @param[out] results NORMAL, EXCESS or ANOMALY for every value (see
+ * spot_step), -ERR_DATA_IS_NAN for the NaN values. Like spot_step, when the
+ * exported Spot keeps its anomalies (discard_anomalies = 0), the values
+ * beyond the anomaly threshold are EXCESS
+ * @return the number of anomalies (ANOMALY results)
+ */
+unsigned long spot_frozen_classify(struct SpotFrozen const *frozen,
+                                   double const *data, unsigned long size,
+                                   int *results);
+
+/**
+ * @brief Compute the probabilities P(X>z) of a buffer of values with a
+ * frozen model (see spot_probability)
+ *
+ * @param frozen frozen model
+ * @param data Buffer of values z (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] probabilities Output probabilities (see
+ * spot_probability_batch)
+ */
+void spot_frozen_probability(struct SpotFrozen const *frozen,
+                             double const *data, unsigned long size,
+                             double *probabilities);
+
+/**
+ * @brief Compute the value zq such that P(X>zq) = q with a frozen model
+ * (see spot_quantile)
+ *
+ * @param frozen frozen model
+ * @param q Low probability (it must be within the tail)
+ * @return the desired quantile
+ */
+double spot_frozen_quantile(struct SpotFrozen const *frozen, double q);
+
+/* Extra functions */
+
+/**
+ * @brief Set the allocators object (malloc and free)
+ *
+ * @param m pointer to a "malloc" function
+ * @param f pointer to a "free" function
+ */
+void set_allocators(malloc_fn m, free_fn f);
+
+/**
+ * @brief Set the ldexp/frexp functions
+ *
+ * By default these functions are provided but the API
+ * allows to change them.
+ *
+ * @param l pointer to a "ldexp" function
+ * @param f pointer to a "frexp" function
+ */
+void set_float_utils(ldexp_fn l, frexp_fn f);
+
+/**
+ * @brief Return the version of libspot
+ *
+ * @param[out] buffer input buffer to fill with
+ * @param size size of the input buffer
+ */
+void libspot_version(char *buffer, unsigned long size);
+
+/**
+ * @brief Return the license of the library
+ *
+ * @param[out] buffer input buffer to fill with
+ * @param size size of the input buffer
+ */
+void libspot_license(char *buffer, unsigned long size);
+
+/**
+ * @brief Return a string related to an error code
+ *
+ * @param err error code
+ * @param[out] buffer input buffer to fill with
+ * @param size size of the input buffer
+ */
+void libspot_error(enum LibspotError err, char *buffer, unsigned long size);
+
+#endif // SPOT_H
+
+#endif // LIBSPOT_H
+
+#if defined(LIBSPOT_IMPLEMENTATION) && !defined(LIBSPOT_IMPLEMENTED)
+#define LIBSPOT_IMPLEMENTED
+
+#ifndef VERSION
+#define VERSION "2.0b4"
+#endif
+
+// include/xmath.h
+
+
+
+#ifndef XMATH_H
+#define XMATH_H
+
+LIBSPOT_INTERNAL_EXTERN double const _NAN;
+LIBSPOT_INTERNAL_EXTERN double const _INFINITY;
+
+/**
+ * @brief Internal function to set the frexp/ldexp functions
+ * @details By default these functions are provided but the API
+ * allows to change them
+ * @param l pointer to a "ldexp" function
+ * @param f pointer to a "frexp" function
+ */
+LIBSPOT_INTERNAL void internal_set_float_utils(ldexp_fn l, frexp_fn f);
+
+#ifdef LIBSPOT_MATH_LIBM
+
+// libm backend (make MATH=libm): the entry points are inlined calls to the
+// libm, so the library is no longer freestanding (link with -lm). frexp/ldexp
+// (see internal_set_float_utils) are not used.
+#include <math.h>
+
+/**
+ * @brief Compute natural logarithm (libm)
+ * @param x input value
+ * @return double
+ */
+static inline double xlog(double x) { return log(x); }
+
+/**
+ * @brief Compute exponential (libm)
+ * @param x input value
+ * @return double
+ */
+static inline double xexp(double x) { return exp(x); }
+
+/**
+ * @brief Compute a^x (libm)
+ * @param a
+ * @param x
+ * @return double
+ */
+static inline double xpow(double a, double x) { return pow(a, x); }
+
+#else
+
+/**
+ * @brief Compute natural logarithm with Shank's algorithm
+ * @details It returns -oo for x=0 and NaN for x<0
+ * @param x input value
+ * @return double
+ */
+LIBSPOT_INTERNAL double xlog(double x);
+
+/**
+ * @brief Compute exponential with continuous fraction
+ * @details It uses the formula of Khovanskii:
+ * Khovanskii, A. N. (1963). The application of continued fractions and their
+ * generalizations to problems in approximation theory (p. 144). Groningen:
+ * Noordhoff.
+ * Formula (5.5) p.114
+ * @param x
+ * @return double
+ */
+LIBSPOT_INTERNAL double xexp(double x);
+
+/**
+ * @brief Compute a^x with log and exp :)
+ *
+ * @param a
+ * @param x
+ * @return double
+ */
+LIBSPOT_INTERNAL double xpow(double a, double x);
+
+#endif // LIBSPOT_MATH_LIBM
+
+/**
+ * @brief Compute xlog over a buffer of values
+ * @details Same results as xlog, with a loop that the compiler can
+ * vectorize. The output buffer can be the input one.
+ * @param x input values
+ * @param[out] out output values
+ * @param size number of values
+ */
+LIBSPOT_INTERNAL void xlog_batch(double const *x, double *out,
+                                 unsigned long size);
+
+/**
+ * @brief Compute xexp over a buffer of values
+ * @details Same results as xexp for finite values (the infinities give
+ * their limits), with a loop that the compiler can vectorize. The output
+ * buffer can be the input one.
+ * @param x input values
+ * @param[out] out output values
+ * @param size number of values
+ */
+LIBSPOT_INTERNAL void xexp_batch(double const *x, double *out,
+                                 unsigned long size);
+
+/**
+ * @brief Compute a[i]^x over a buffer of values (see xpow)
+ * @details The output buffer can be the input one.
+ * @param a input values
+ * @param x exponent
+ * @param[out] out output values
+ * @param size number of values
+ */
+LIBSPOT_INTERNAL void xpow_batch(double const *a, double x, double *out,
+                                 unsigned long size);
+
+/**
+ * @brief Return the minimum of two values
+ *
+ * @param a input value
+ * @param b input value
+ * @return the minimum of a and b
+ */
+LIBSPOT_INTERNAL double xmin(double a, double b);
+
+/**
+ * @brief Check if a double is NAN
+ *
+ * @param x input value to check
+ * @retval 1 when x is nan
+ * @retval 0 otherwise
+ */
+LIBSPOT_INTERNAL int is_nan(double x);
+
+#endif // XMATH_H
+
+// include/p2.h
+
+
+
+#ifndef P2_H
+#define P2_H
+
+/**
+ * @brief Initialize the P2 estimator
+ *
+ * @param p2 P2 instance
+ * @param p probability of the quantile to estimate
+ */
+LIBSPOT_INTERNAL void p2_init(struct P2 *p2, double p);
+
+/**
+ * @brief Insert a new value into the estimator
+ *
+ * @param p2 P2 instance
+ * @param x new value
+ */
+LIBSPOT_INTERNAL void p2_push(struct P2 *p2, double x);
+
+/**
+ * @brief Insert a buffer of values into the estimator
+ *
+ * @param p2 P2 instance
+ * @param data buffer of values
+ * @param size size of the buffer
+ */
+LIBSPOT_INTERNAL void p2_feed(struct P2 *p2, double const *data,
+                              unsigned long size);
+
+/**
+ * @brief Scale the marker positions
+ *
+ * With 0 < factor < 1, the estimator behaves as if it had seen fewer values:
+ * the next ones weigh more. Scaling regularly makes the estimator forget the
+ * past and follow a drifting quantile.
+ *
+ * @param p2 P2 instance
+ * @param factor scale of the marker positions
+ */
+LIBSPOT_INTERNAL void p2_scale(struct P2 *p2, double factor);
+
+/**
+ * @brief Return the current estimate of the quantile
+ *
+ * @param p2 P2 instance
+ * @return the quantile estimate (NaN if less than 5 values have been
+ * inserted)
+ */
+LIBSPOT_INTERNAL double p2_value(struct P2 const *p2);
+
+/**
+ * @brief Estimate a quantile of a buffer in a single pass
+ *
+ * @param p probability of the quantile to estimate
+ * @param data buffer of values
+ * @param size size of the buffer
+ * @return the quantile estimate (0 if size is lower than 5)
+ */
+LIBSPOT_INTERNAL double p2_quantile(double p, double const *data,
+                                    unsigned long size);
+
+#endif // P2_H
+
+// include/brent.h
+
+#ifndef BRENT_H
+#define BRENT_H
+
+
+
+LIBSPOT_INTERNAL_EXTERN double const BRENT_DEFAULT_EPSILON;
+
+LIBSPOT_INTERNAL_EXTERN unsigned long const BRENT_ITMAX;
+
+/**
+    \brief Root search of a scalar function with the Brent's method. It uses
+   the code from "Numerical Recipes: The Art of Scientific Computing".
+    \param[out] found pointer to retrieve the success of the method
+    \param[in] a left bound of the interval
+    \param[in] b right bound of the interval
+    \param[in] f function of interest
+    \param[in] extra function extra parameters
+    \param[in] epsilon extra parameter (1e-6)
+    \return root
+*/
+LIBSPOT_INTERNAL double brent(int *found, double a, double b, real_function f,
+                              void *extra, double epsilon);
+
+#endif // BRENT_H
+
+// include/allocator.h
+
+
+#ifndef ALLOCATOR_H
+#define ALLOCATOR_H
+
+/**
+ * @brief Internal function to set the allocators object (malloc and free)
+ *
+ * @param m pointer to a "malloc" function
+ * @param f pointer to a "free" function
+ */
+LIBSPOT_INTERNAL void internal_set_allocators(malloc_fn m, free_fn f);
+
+/**
+ * @brief
+ *
+ * @param size
+ * @return void*
+ */
+LIBSPOT_INTERNAL void *xmalloc(unsigned long size);
+
+/**
+ * @brief
+ *
+ * @param p
+ */
+LIBSPOT_INTERNAL void xfree(void *p);
+
+#endif // ALLOCATOR_H
+
+// include/ubend.h
+
+
+
+
+#ifndef UBEND_H
+#define UBEND_H
+
+/**
+ * @brief Ubend structure initializer
+ *
+ * @param ubend structure to init
+ * @param capacity number of double to allocate
+ * @return 0 is allocation is successful
+ */
+LIBSPOT_INTERNAL int ubend_init(struct Ubend *ubend, unsigned long capacity);
+
+/**
+ * @param ubend
+ */
+LIBSPOT_INTERNAL void ubend_free(struct Ubend *ubend);
+
+/**
+ * @brief Return the current size of the container
+ *
+ * @param ubend
+ * @return unsigned long
+ */
+LIBSPOT_INTERNAL unsigned long ubend_size(struct Ubend const *ubend);
+
+/**
+ * @brief Insert a new value in the container
+ *
+ * @param ubend
+ * @param x
+ * @return the erased data or NaN
+ */
+LIBSPOT_INTERNAL double ubend_push(struct Ubend *ubend, double x);
+
+/**
+ * @brief Remove the values lower than or equal to a bound
+ *
+ * The other values are kept in their insertion order, so that the next
+ * pushes erase them in the same order as before.
+ *
+ * @param ubend
+ * @param bound values lower than or equal to it are removed
+ * @return the new size of the container
+ */
+LIBSPOT_INTERNAL unsigned long ubend_filter(struct Ubend *ubend, double bound);
+
+#endif // UBEND_H
+
+// include/peaks.h
+
+
+
+
+
+#ifndef PEAKS_H
+#define PEAKS_H
+
+/**
+ * @brief Number of peaks processed at once by the loops over the excesses
+ * (their logarithms are computed by xlog_batch in a stack buffer)
+ */
+#define PEAKS_BLOCK 64
+
+/**
+ * @brief Initialize the Peaks structure
+ *
+ * @param peaks Peaks instance
+ * @param size Maximum number of peaks to store
+ */
+LIBSPOT_INTERNAL int peaks_init(struct Peaks *peaks, unsigned long size);
+
+/**
+ * @brief Free the peaks structure
+ *
+ * @param peaks Peaks instance
+ */
+LIBSPOT_INTERNAL void peaks_free(struct Peaks *peaks);
+
+/**
+ * @brief Insert a new peak
+ *
+ * @param peaks Peaks instance
+ * @param x new peak
+ */
+LIBSPOT_INTERNAL void peaks_push(struct Peaks *peaks, double x);
+
+/**
+ * @brief Subtract a value to all the peaks and remove the non-positive ones
+ *
+ * @param peaks Peaks instance
+ * @param delta value to subtract
+ */
+LIBSPOT_INTERNAL void peaks_shift(struct Peaks *peaks, double delta);
+
+/**
+ * @brief Get the mean of the peaks
+ *
+ * @param peaks Peaks instance
+ * @return the peaks mean
+ */
+LIBSPOT_INTERNAL double peaks_mean(struct Peaks const *peaks);
+
+/**
+ * @brief Get the variance of the peaks
+ *
+ * @param peaks Peaks instance
+ * @return the peaks variance
+ */
+LIBSPOT_INTERNAL double peaks_var(struct Peaks const *peaks);
+
+/**
+ * @brief Return the number of peaks
+ *
+ * @param peaks Peaks instance
+ * @return the number of peaks
+ */
+LIBSPOT_INTERNAL unsigned long peaks_size(struct Peaks const *peaks);
+
+/**
+ * @brief Compute the GPD log-likelihood function
+ *
+ * @param[in] peaks Peaks instance
+ * @param gamma GPD gamma parameter
+ * @param sigma GPD sigma parameter
+ * @return the log likelihood
+ */
+LIBSPOT_INTERNAL double log_likelihood(struct Peaks const *peaks, double gamma,
+                                       double sigma);
+
+#endif // PEAKS_H
+
+// include/estimator.h
+
+
+
+#ifndef ESTIMATOR_H
+#define ESTIMATOR_H
+
+/**
+ * @brief
+ *
+ * @param peaks Peaks instance
+ * @param[out] gamma computed GPD gamma parameter
+ * @param[out] sigma computed GPD sigma parameter
+ * @return the log-likelihood of the estimation
+ */
+LIBSPOT_INTERNAL double mom_estimator(struct Peaks const *peaks, double *gamma,
+                                      double *sigma);
+
+/**
+ * @brief
+ *
+ * @param peaks Peaks instance
+ * @param[out] gamma computed GPD gamma parameter
+ * @param[out] sigma computed GPD sigma parameter
+ * @return the log-likelihood of the estimation
+ */
+LIBSPOT_INTERNAL double grimshaw_estimator(struct Peaks const *peaks,
+                                           double *gamma, double *sigma);
+
+#endif // ESTIMATOR_H
+
+// include/tail.h
+
+
+
+#ifndef TAIL_H
+#define TAIL_H
+
+/**
+ * @brief Stucture that embeds GPD parameter (GPD tail actually)
+ *
+ */
+// PUBLIC_API struct Tail {
+//     double gamma;       /**< GPD gamma parameter */
+//     double sigma;       /**< GPD sigma parameter */
+//     struct Peaks peaks; /**< underlying Peaks structure */
+// };
+
+/**
+ * @brief Initialize the tail structure
+ *
+ * @param tail Tail instance
+ * @param size Tail size
+ * @return 0 if the initialization is ok
+ */
+LIBSPOT_INTERNAL int tail_init(struct Tail *tail, unsigned long size);
+
+/**
+ * @brief Free the tail structure
+ *
+ * @param tail Tail instance
+ */
+LIBSPOT_INTERNAL void tail_free(struct Tail *tail);
+
+/**
+ * @brief Add a new data into the tail
+ *
+ * @param tail Tail instance
+ * @param x new data
+ */
+LIBSPOT_INTERNAL void tail_push(struct Tail *tail, double x);
+
+/**
+ * @brief Move the origin of the tail data (the excess threshold)
+ *
+ * @param tail Tail instance
+ * @param delta shift of the threshold (the data lower than delta are
+ * removed)
+ */
+LIBSPOT_INTERNAL void tail_shift(struct Tail *tail, double delta);
+
+/**
+ * @brief Compute the probability to be higher a given value z
+ *
+ * @param tail Tail instance
+ * @param s the ratio Nt/n (an estimator of P(X>t) = 1-F(t))
+ * @param d the local quantile (z_q - t)
+ * @return the desired probability
+ */
+LIBSPOT_INTERNAL double tail_probability(struct Tail const *tail, double s,
+                                         double d);
+
+/**
+ * @brief Compute the extreme quantile related to the input probability
+ *
+ * @param tail Tail instance
+ * @param s the ratio Nt/n (an estimator of P(X>t) = 1-F(t))
+ * @param q the desired [low] probability
+ * @return The desired quantile
+ */
+LIBSPOT_INTERNAL double tail_quantile(struct Tail const *tail, double s,
+                                      double q);
+
+/**
+ * @brief Defines gamma and sigma for the underlying peaks structure
+ *
+ * The estimators are compared on their log-likelihood. When the peaks are
+ * truncated (the anomalies are discarded, so no peak lies above the anomaly
+ * threshold), the method of moments is left out: it fits a short tail
+ * (gamma < 0) to the truncated peaks, which lowers the anomaly threshold,
+ * which truncates the next peaks even more.
+ *
+ * @param tail Tail instance
+ * @param truncated whether the peaks are truncated at the anomaly threshold
+ * @return The related log-likelihood
+ */
+LIBSPOT_INTERNAL double tail_fit(struct Tail *tail, int truncated);
+
+#endif // TAIL_H
+
+// src/structs.c
+
+
+// src/xmath.c
+
+
+#ifndef LIBSPOT_MATH_LIBM
+static double const LOG2 = 0x1.62e42fefa39efp-1;
+#endif
+LIBSPOT_INTERNAL double const _NAN = 0.0 / 0.0;
+LIBSPOT_INTERNAL double const _INFINITY = +1.0 / 0.0;
+
+// static const double pow2[] = {
+//     0x1.0p+0,  0x1.0p+1,  0x1.0p+2,  0x1.0p+3,  0x1.0p+4,  0x1.0p+5,
+//     0x1.0p+6,  0x1.0p+7,  0x1.0p+8,  0x1.0p+9,  0x1.0p+10, 0x1.0p+11,
+//     0x1.0p+12, 0x1.0p+13, 0x1.0p+14, 0x1.0p+15, 0x1.0p+16, 0x1.0p+17,
+//     0x1.0p+18, 0x1.0p+19, 0x1.0p+20, 0x1.0p+21, 0x1.0p+22, 0x1.0p+23,
+//     0x1.0p+24, 0x1.0p+25, 0x1.0p+26, 0x1.0p+27, 0x1.0p+28, 0x1.0p+29,
+//     0x1.0p+30, 0x1.0p+31, 0x1.0p+32, 0x1.0p+33, 0x1.0p+34, 0x1.0p+35,
+//     0x1.0p+36, 0x1.0p+37, 0x1.0p+38, 0x1.0p+39, 0x1.0p+40, 0x1.0p+41,
+//     0x1.0p+42, 0x1.0p+43, 0x1.0p+44, 0x1.0p+45, 0x1.0p+46, 0x1.0p+47,
+//     0x1.0p+48, 0x1.0p+49, 0x1.0p+50, 0x1.0p+51, 0x1.0p+52, 0x1.0p+53,
+//     0x1.0p+54, 0x1.0p+55, 0x1.0p+56, 0x1.0p+57, 0x1.0p+58, 0x1.0p+59,
+//     0x1.0p+60, 0x1.0p+61, 0x1.0p+62, 0x1.0p+63, 0x1.0p+64};
+
+// static const int EXP_MAX = sizeof(pow2) / sizeof(double);
+
+// int find_log2_positive_double(double target) {
+//     int i = 0;
+//     int j = EXP_MAX - 1;
+
+//     if (target < pow2[i] || target > pow2[j]) {
+//         // out of bounds
+//         return -1;
+//     }
+
+//     int m = (i + j) / 2;
+
+//     while ((j - i) > 1) {
+//         if (target < pow2[m]) {
+//             j = m;
+//         } else {
+//             i = m;
+//         }
+//         m = (i + j) / 2;
+//     }
+
+//     return i;
+// }
+
+// static double _frexp(double x, int *e) {
+//     if (x < 0) {
+//         return -_frexp(-x, e);
+//     }
+//     if (x < 1) {
+//         int inv_exp = find_log2_positive_double(1.0 / x);
+//         *e = -inv_exp + 1;
+//         return x * pow2[inv_exp];
+//     }
+//     int exp = find_log2_positive_double(x);
+//     *e = exp;
+//     return x / pow2[exp];
+// }
+
+// static double ldexp(double x, int n) {
+//     if (n < 0 && n > -EXP_MAX) {
+//         return x / pow2[-n];
+//     }
+//     if (n >= 0 && n < EXP_MAX) {
+//         return x * pow2[n];
+//     }
+//     return _NAN;
+// }
+
+#if __SIZEOF_DOUBLE__ == 8
+
+typedef union {
+    double d;
+    __UINT64_TYPE__ i;
+} double_cast;
+
+/**
+ * @brief frexp implem of musl libc
+ * @details see https://git.musl-libc.org/cgit/musl/tree/src/math/frexp.c
+ *
+ */
+static double musl_frexp(double x, int *e) {
+    double_cast y = {x};
+
+    int ee = y.i >> 52 & 0x7ff;
+
+    if (!ee) {
+        if (x) {
+            x = musl_frexp(x * 0x1p64, e);
+            *e -= 64;
+        } else
+            *e = 0;
+        return x;
+    } else if (ee == 0x7ff) {
+        return x;
+    }
+
+    *e = ee - 0x3fe;
+    y.i &= 0x800fffffffffffffull;
+    y.i |= 0x3fe0000000000000ull;
+    return y.d;
+}
+
+/**
+ * @brief ldexp implem of musl libc
+ * @details see https://git.musl-libc.org/cgit/musl/tree/src/math/scalbn.c
+ * (https://git.musl-libc.org/cgit/musl/tree/src/math/ldexp.c)
+ *
+ * @param x
+ * @param n
+ * @return double
+ */
+static double musl_ldexp(double x, int n) {
+    double_cast u = {x};
+
+    // in musl libc, it uses double_t to make aithmetic operations. However it
+    // is the same as double once FLT_EVAL_METHOD is 0 (defazult generally) or
+    // 1 see https://en.cppreference.com/w/c/numeric/math/float_t double_t y =
+    // x;
+    double y = x;
+
+    if (n > 1023) {
+        y *= 0x1p1023;
+        n -= 1023;
+        if (n > 1023) {
+            y *= 0x1p1023;
+            n -= 1023;
+            if (n > 1023)
+                n = 1023;
+        }
+    } else if (n < -1022) {
+        /* make sure final n < -53 to avoid double
+           rounding in the subnormal range */
+        y *= 0x1p-1022 * 0x1p53;
+        n += 1022 - 53;
+        if (n < -1022) {
+            y *= 0x1p-1022 * 0x1p53;
+            n += 1022 - 53;
+            if (n < -1022)
+                n = -1022;
+        }
+    }
+    u.i = (__UINT64_TYPE__)(0x3ff + n) << 52;
+    x = y * u.d;
+    return x;
+}
+
+#elif __SIZEOF_DOUBLE__ == 4
+
+typedef union {
+    double d;
+    __UINT32_TYPE__ i;
+} double_cast;
+
+/**
+ * @brief frexp implem of musl libc
+ * @details see https://git.musl-libc.org/cgit/musl/tree/src/math/frexpf.c
+ *
+ */
+double musl_frexp(double x, int *e) {
+    union {
+        float f;
+        __UINT32_TYPE__ i;
+    } y = {x};
+
+    int ee = y.i >> 23 & 0xff;
+
+    if (!ee) {
+        if (x) {
+            x = frexp(x * 0x1p64, e);
+            *e -= 64;
+        } else
+            *e = 0;
+        return x;
+    } else if (ee == 0xff) {
+        return x;
+    }
+
+    *e = ee - 0x7e;
+    y.i &= 0x807ffffful;
+    y.i |= 0x3f000000ul;
+    return y.f;
+}
+
+/**
+ * @brief frexp implem of musl libc
+ * @details see https://git.musl-libc.org/cgit/musl/tree/src/math/scalbnf.c
+ *
+ */
+static double musl_ldexp(double x, int n) {
+    double_cast u = {x};
+
+    double y = x;
+    // float_t y = x;
+
+    if (n > 127) {
+        y *= 0x1p127f;
+        n -= 127;
+        if (n > 127) {
+            y *= 0x1p127f;
+            n -= 127;
+            if (n > 127)
+                n = 127;
+        }
+    } else if (n < -126) {
+        y *= 0x1p-126f * 0x1p24f;
+        n += 126 - 24;
+        if (n < -126) {
+            y *= 0x1p-126f * 0x1p24f;
+            n += 126 - 24;
+            if (n < -126)
+                n = -126;
+        }
+    }
+    u.i = (__UINT32_TYPE__)(0x7f + n) << 23;
+    x = y * u.f;
+    return x;
+}
+
+#elif !defined(USE_CUSTOM_FLOAT_UTILS)
+#error                                                                        \
+    "Cannot provide ldexp/frexp functions: sizeof(double) is neither 8 nor 4."\
+    "You must provide your own functions (-DUSE_CUSTOM_FLOAT_UTILS)"
+#endif
+
+/**
+ * @brief Default ot musl code
+ */
+static frexp_fn libspot_frexp = musl_frexp;
+
+/**
+ * @brief Default to musl code
+ */
+static ldexp_fn libspot_ldexp = musl_ldexp;
+
+void internal_set_float_utils(ldexp_fn l, frexp_fn f) {
+    if (l) {
+        libspot_ldexp = l;
+    }
+    if (f) {
+        libspot_frexp = f;
+    }
+}
+
+/*
+ * See https://en.wikipedia.org/wiki/Double-precision_floating-point_format
+ */
+// typedef union {
+//     double d;
+
+//     struct {
+//         unsigned int : 32; // mantissa1
+//         unsigned int : 20; // mantissa0
+//         unsigned int exponent : 11;
+//         unsigned int : 1; // sign
+//     } bits;
+// } double_cast;
+
+int is_nan(double x) { return x != x; }
+
+#ifndef LIBSPOT_MATH_LIBM
+
+static inline double _log_cf_11(double z) {
+    double x = z - 1;
+    double xx = x + 2;
+    double x2 = x * x;
+
+    double xx2 = xx + xx;
+    double xx3 = xx + xx2;
+    double xx5 = xx3 + xx2;
+    double xx7 = xx5 + xx2;
+    double xx9 = xx7 + xx2;
+    double xx11 = xx9 + xx2;
+    double xx13 = xx11 + xx2;
+    double xx15 = xx13 + xx2;
+    double xx17 = xx15 + xx2;
+    double xx19 = xx17 + xx2;
+    double xx21 = xx19 + xx2;
+
+    return 2 * x /
+           (-x2 / (-4 * x2 /
+                       (-9 * x2 /
+                            (-16 * x2 /
+                                 (-25 * x2 /
+                                      (-36 * x2 /
+                                           (-49 * x2 /
+                                                (-64 * x2 /
+                                                     (-81 * x2 /
+                                                          (-100 * x2 / xx21 +
+                                                           xx19) +
+                                                      xx17) +
+                                                 xx15) +
+                                            xx13) +
+                                       xx11) +
+                                  xx9) +
+                             xx7) +
+                        xx5) +
+                   xx3) +
+            xx);
+}
+
+static inline double _exp_cf_6(double z) {
+    double z2 = z * z;
+
+    return 2 * z /
+               (2 * z2 /
+                    (12 * z2 /
+                         (60 * z2 / (140 * z2 / (7 * z2 / 11 + 252) + 140) +
+                          60) +
+                     12) -
+                z + 2) +
+           1;
+}
+
+double xexp(double x) {
+    if (is_nan(x)) {
+        return _NAN;
+    }
+    if (x < 0) {
+        return 1.0 / xexp(-x);
+    }
+    if (x > LOG2) {
+        unsigned int k = x / LOG2;
+        double r = x - LOG2 * (double)k;
+        return libspot_ldexp(_exp_cf_6(r), k);
+        // double_cast w = {.d = _exp_cf_6(r)};
+        // w.bits.exponent += k;
+        // return w.d;
+    }
+
+    return _exp_cf_6(x);
+}
+
+double xlog(double x) {
+    if (x < 0 || is_nan(x)) {
+        return _NAN;
+    }
+    if (x == 0) {
+        return -_INFINITY;
+    }
+    // double_cast casted = {.d = x};
+    // if (casted.bits.exponent == 1022 || casted.bits.exponent == 1023) {
+    //     // 1/2 < x < 1
+    //     // when x is close to 1 (but <1)., it is better
+    //     // to call the function directly instead of setting exponent to
+    //     // 1023
+    //     return _log_cf_11(x);
+    // }
+    int exponent = 0;
+    double mantissa = libspot_frexp(x, &exponent);
+    if (exponent == 0 || exponent == -1) {
+        return _log_cf_11(x);
+    }
+    return _log_cf_11(mantissa) + LOG2 * exponent;
+
+    // double exponent = casted.bits.exponent;
+    // casted.bits.exponent = 1023;
+    // when exponent is 1023, 1 <= casted.d <= 2
+    // return logd(casted.d, depth) + (exponent - 1023.0) * LOG2;
+    // return _log_cf_11(casted.d) + (exponent - 1023.0) * LOG2;
+}
+
+double xpow(double a, double x) { return xexp(x * xlog(a)); }
+
+#endif // LIBSPOT_MATH_LIBM
+
+// Batch kernels -------------------------------------------------------------
+//
+// They compute the same values as xlog/xexp/xpow but without calls nor
+// branches in the main loops (frexp/ldexp are done on the bits), so that the
+// compiler can vectorize them. The values that need the special cases of
+// xlog (zero, negative, subnormal, infinite or NaN) are computed again by the
+// scalar function. With the libm backend, they are plain loops over the
+// libm functions.
+
+#if defined(LIBSPOT_MATH_LIBM)
+
+#if defined(LIBSPOT_MATH_LIBMVEC)
+// libmvec backend (make MATH=libmvec): the vector variants of the glibc are
+// declared so that the compiler vectorizes the loops below (-fopenmp-simd).
+// They are a few ulps away from the scalar functions.
+#pragma omp declare simd notinbranch
+double log(double);
+#pragma omp declare simd notinbranch
+double exp(double);
+#pragma omp declare simd notinbranch
+double pow(double, double);
+#endif
+
+void xlog_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = log(x[i]);
+    }
+}
+
+void xexp_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = exp(x[i]);
+    }
+}
+
+void xpow_batch(double const *a, double x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = pow(a[i], x);
+    }
+}
+
+#elif (__SIZEOF_DOUBLE__ == 8) && !defined(USE_CUSTOM_FLOAT_UTILS)
+
+/// @brief Number of values of the blocks of the batch kernels (stack arrays)
+#define XMATH_BLOCK 64
+
+void xlog_batch(double const *x, double *out, unsigned long size) {
+    double m[XMATH_BLOCK];
+    double e[XMATH_BLOCK];
+    for (unsigned long start = 0; start < size; start += XMATH_BLOCK) {
+        unsigned long const n =
+            (size - start < XMATH_BLOCK) ? size - start : XMATH_BLOCK;
+        double const *v = x + start;
+        // frexp on the bits: x = m * 2^e with 0.5 <= m < 1 (normal numbers)
+        for (unsigned long i = 0; i < n; ++i) {
+            double_cast c = {v[i]};
+            int const exponent = (int)((c.i >> 52) & 0x7ff) - 0x3fe;
+            c.i = (c.i & 0x800fffffffffffffull) | 0x3fe0000000000000ull;
+            // like xlog, x is passed directly when 1/4 <= x < 1
+            int const direct = (exponent == 0) | (exponent == -1);
+            m[i] = direct ? v[i] : c.d;
+            e[i] = direct ? 0. : (double)exponent;
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            m[i] = _log_cf_11(m[i]) + LOG2 * e[i];
+        }
+        // zero, negative, subnormal, infinite or NaN
+        for (unsigned long i = 0; i < n; ++i) {
+            double_cast const c = {v[i]};
+            __UINT64_TYPE__ const biased = (c.i >> 52) & 0x7ff;
+            if ((c.i >> 63) || (biased == 0) || (biased == 0x7ff)) {
+                m[i] = xlog(v[i]);
+            }
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            out[start + i] = m[i];
+        }
+    }
+}
+
+void xexp_batch(double const *x, double *out, unsigned long size) {
+    double r[XMATH_BLOCK];
+    double p1[XMATH_BLOCK];
+    double p2[XMATH_BLOCK];
+    for (unsigned long start = 0; start < size; start += XMATH_BLOCK) {
+        unsigned long const n =
+            (size - start < XMATH_BLOCK) ? size - start : XMATH_BLOCK;
+        double const *v = x + start;
+        // range reduction: |x| = r + k * log(2) with 0 <= r < log(2)
+        for (unsigned long i = 0; i < n; ++i) {
+            double a = (v[i] < 0) ? -v[i] : v[i];
+            // exp(1000) is already infinite (NaN is restored at the end)
+            a = (a <= 1000.) ? a : 1000.;
+            int const k = (a > LOG2) ? (int)(a / LOG2) : 0;
+            r[i] = a - LOG2 * (double)k;
+            // ldexp on the bits: 2^k in two exact factors (k < 2046)
+            int const k1 = k >> 1;
+            double_cast const f1 = {.i = (__UINT64_TYPE__)(0x3ff + k1) << 52};
+            double_cast const f2 = {.i = (__UINT64_TYPE__)(0x3ff + k - k1)
+                                         << 52};
+            p1[i] = f1.d;
+            p2[i] = f2.d;
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            r[i] = _exp_cf_6(r[i]) * p1[i] * p2[i];
+            // every inverse is computed (a conditional division cannot be
+            // vectorized)
+            p1[i] = 1.0 / r[i];
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            double const result = (v[i] < 0) ? p1[i] : r[i];
+            out[start + i] = (v[i] == v[i]) ? result : v[i];
+        }
+    }
+}
+
+#else
+
+void xlog_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = xlog(x[i]);
+    }
+}
+
+void xexp_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = xexp(x[i]);
+    }
+}
+
+#endif
+
+#ifndef LIBSPOT_MATH_LIBM
+
+void xpow_batch(double const *a, double x, double *out, unsigned long size) {
+    xlog_batch(a, out, size);
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] *= x;
+    }
+    xexp_batch(out, out, size);
+}
+
+#endif
+
+double xmin(double a, double b) {
+    if (is_nan(a) || is_nan(b)) {
+        return _NAN;
+    }
+    if (a < b) {
+        return a;
+    }
+    return b;
+}
+
+// src/p2.c
+
+
+
+static void swap(double *a, double *b) {
+    double temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+LIBSPOT_INTERNAL void sort5(double a[5]) {
+    if (a[1] < a[0]) // Compare 1st and 2nd element #1
+        swap(&a[0], &a[1]);
+    if (a[3] < a[2]) // Compare 3rd and 4th element #2
+        swap(&a[3], &a[2]);
+    if (a[0] < a[2]) { // Compare 1st and 3rd element #3
+        // run this if 1st element < 3rd element
+        swap(&a[1], &a[2]);
+        swap(&a[2], &a[3]);
+    } else {
+        swap(&a[1], &a[2]);
+        swap(&a[0], &a[1]);
+    }
+    // Now 1st, 2nd and 3rd elements are sorted
+    // Sort 5th element into 1st, 2nd and 3rd elements
+    if (a[4] < a[1]) {     // #4
+        if (a[4] < a[0]) { // #5
+            swap(&a[4], &a[3]);
+            swap(&a[3], &a[2]);
+            swap(&a[2], &a[1]);
+            swap(&a[1], &a[0]);
+        } else {
+            swap(&a[4], &a[3]);
+            swap(&a[3], &a[2]);
+            swap(&a[2], &a[1]);
+        }
+    } else {
+        if (a[4] < a[2]) { // #5
+            swap(&a[4], &a[3]);
+            swap(&a[3], &a[2]);
+        } else {
+            swap(&a[4], &a[3]);
+        }
+    }
+    // Sort new 5th element into 2nd, 3rd and 4th
+    if (a[4] < a[2]) {     // #6
+        if (a[4] < a[1]) { // #7
+            swap(&a[4], &a[3]);
+            swap(&a[3], &a[2]);
+            swap(&a[2], &a[1]);
+        } else {
+            swap(&a[4], &a[3]);
+            swap(&a[3], &a[2]);
+        }
+    } else {
+        if (a[4] < a[3]) { // #7
+            swap(&a[4], &a[3]);
+        }
+    }
+}
+
+void p2_init(struct P2 *p2, double p) {
+    for (unsigned i = 0; i < 5; i++) {
+        p2->q[i] = 0.0;
+        p2->n[i] = (double)i;
+        p2->np[i] = 0.0;
+        p2->dn[i] = 0.0;
+    }
+
+    p2->np[1] = 2 * p;
+    p2->np[2] = 4 * p;
+    p2->np[3] = 2 + 2 * p;
+    p2->np[4] = 4;
+
+    p2->dn[1] = p / 2;
+    p2->dn[2] = p;
+    p2->dn[3] = (p + 1) / 2;
+    p2->dn[4] = 1;
+
+    p2->count = 0;
+}
+
+static double sign(double d) {
+    if (d > 0) {
+        return 1.0;
+    }
+    if (d < 0) {
+        return -1.0;
+    }
+    return 0.0;
+}
+
+static double linear(struct P2 const *p2, unsigned int i, int d) {
+    return p2->q[i] +
+           d * (p2->q[i + d] - p2->q[i]) / (p2->n[i + d] - p2->n[i]);
+}
+
+static double parabolic(struct P2 const *p2, unsigned int i, int d) {
+    return p2->q[i] +
+           (d / (p2->n[i + 1] - p2->n[i - 1])) *
+               ((p2->n[i] - p2->n[i - 1] + d) * (p2->q[i + 1] - p2->q[i]) /
+                    (p2->n[i + 1] - p2->n[i]) +
+                (p2->n[i + 1] - p2->n[i] - d) * (p2->q[i] - p2->q[i - 1]) /
+                    (p2->n[i] - p2->n[i - 1]));
+}
+
+/**
+ * @brief Insert a new value into the P2 estimator
+ *
+ * Instead of searching the cell of x (q[k] <= x < q[k + 1]) and looping from
+ * k + 1, we use the fact that the markers are sorted: the positions to
+ * increment are exactly those such that x <= q[i]. So the update is a masked
+ * add over the 5 markers, without data-dependent branches.
+ */
+static void update(struct P2 *p2, double x) {
+    unsigned int i;
+    double qp;
+
+    if (x < p2->q[0]) {
+        p2->q[0] = x;
+        return;
+    }
+    if (x > p2->q[4]) {
+        p2->q[4] = x;
+        return;
+    }
+
+    for (i = 0; i < 5; i++) {
+        p2->n[i] += (double)(x <= p2->q[i]);
+        p2->np[i] += p2->dn[i];
+    }
+
+    // update other markers
+    for (i = 1; i < 4; i++) {
+        double d = p2->np[i] - p2->n[i];
+        if ((d >= 1 && (p2->n[i + 1] - p2->n[i]) > 1) ||
+            (d <= -1 && (p2->n[i - 1] - p2->n[i]) < -1)) {
+            d = sign(d);
+            qp = parabolic(p2, i, (int)d);
+            if (!(p2->q[i - 1] < qp && qp < p2->q[i + 1])) {
+                qp = linear(p2, i, (int)d);
+            }
+            p2->q[i] = qp;
+            p2->n[i] += d;
+        }
+    }
+}
+
+void p2_feed(struct P2 *p2, double const *data, unsigned long size) {
+    unsigned long j = 0;
+    // init q with the 5 first values
+    for (; (j < size) && (p2->count < 5); j++) {
+        p2->q[p2->count++] = data[j];
+        if (p2->count == 5) {
+            sort5(p2->q);
+        }
+    }
+    // now treat the other values
+    p2->count += size - j;
+    for (; j < size; j++) {
+        update(p2, data[j]);
+    }
+}
+
+void p2_push(struct P2 *p2, double x) { p2_feed(p2, &x, 1); }
+
+void p2_scale(struct P2 *p2, double factor) {
+    for (unsigned int i = 0; i < 5; i++) {
+        p2->n[i] *= factor;
+        p2->np[i] *= factor;
+    }
+}
+
+double p2_value(struct P2 const *p2) {
+    if (p2->count < 5) {
+        return _NAN;
+    }
+    return p2->q[2];
+}
+
+double p2_quantile(double p, double const *data, unsigned long size) {
+    struct P2 p2;
+    if (size < 5) {
+        return 0.0;
+    }
+    p2_init(&p2, p);
+    p2_feed(&p2, data, size);
+    return p2_value(&p2);
+}
+
+// src/brent.c
+
+
+LIBSPOT_INTERNAL double const BRENT_DEFAULT_EPSILON = 2.0e-8;
+
+LIBSPOT_INTERNAL unsigned long const BRENT_ITMAX = 200;
+
+// fabs is reserved on windows
+static double _fabs(double a) {
+    if (a < 0) {
+        return -a;
+    }
+    return a;
+}
+
+double brent(int *found, double x1, double x2, real_function func, void *extra,
+             double tol) {
+    // we assume we found the root
+    // it will be set to zero in error cases
+    *found = 1;
+
+    double a = x1;
+    double b = x2;
+    double c = x2;
+    double d = 0.0;
+    double e = 0.0;
+    // double min1 = 0.0;
+    // double min2 = 0.0;
+
+    double fa = func(a, extra);
+    double fb = func(b, extra);
+    double fc = 0.0;
+    // double p = 0.0;
+    // double q = 0.0;
+    // double r = 0.0;
+    // double s = 0.0;
+    // double tol1 = 0.0;
+    // double xm = 0.0;
+
+    if ((fa > 0.0 && fb > 0.0) || (fa < 0.0 && fb < 0.0)) {
+        *found = 0;
+        return 0.0;
+    }
+
+    fc = fb;
+    for (unsigned long iter = 0; iter < BRENT_ITMAX; iter++) {
+        if ((fb > 0.0 && fc > 0.0) || (fb < 0.0 && fc < 0.0)) {
+            c = a; // Rename a, b, c and adjust bounding interval
+            fc = fa;
+            e = d = b - a;
+        }
+        if (_fabs(fc) < _fabs(fb)) {
+            a = b;
+            b = c;
+            c = a;
+            fa = fb;
+            fb = fc;
+            fc = fa;
+        }
+        double tol1 = 2.0 * BRENT_DEFAULT_EPSILON * _fabs(b) +
+                      0.5 * tol; // Convergence check.
+        double xm = 0.5 * (c - b);
+        if (_fabs(xm) <= tol1 || fb == 0.0)
+            return b;
+        if (_fabs(e) >= tol1 && _fabs(fa) > _fabs(fb)) {
+            double s = fb / fa; // Attempt inverse quadratic interpolation.
+            double p;
+            double q;
+
+            if (a == c) {
+                p = 2.0 * xm * s;
+                q = 1.0 - s;
+            } else {
+                q = fa / fc;
+                double r = fb / fc;
+                p = s * (2.0 * xm * q * (q - r) - (b - a) * (r - 1.0));
+                q = (q - 1.0) * (r - 1.0) * (s - 1.0);
+            }
+            if (p > 0.0)
+                q = -q; // Check whether in bounds.
+            p = _fabs(p);
+            double min1 = 3.0 * xm * q - _fabs(tol1 * q);
+            double min2 = _fabs(e * q);
+            if (2.0 * p < (min1 < min2 ? min1 : min2)) {
+                e = d; // Accept interpolation.
+                d = p / q;
+            } else {
+                d = xm; // Interpolation failed, use bisection.
+                e = d;
+            }
+        } else { // Bounds decreasing too slowly, use bisection.
+            d = xm;
+            e = d;
+        }
+        a = b; // Move last best guess to a.
+        fa = fb;
+        if (_fabs(d) > tol1) // Evaluate new trial root.
+            b += d;
+        else
+            b += ((xm) >= 0.0 ? _fabs(tol1) : -_fabs(tol1));
+        fb = func(b, extra);
+    }
+    // Maximum number of iterations exceeded
+    *found = 0;
+    return 0.0;
+}
+
+// src/allocator.c
+
+
+/**
+ * @brief Global allocator
+ *
+ */
+static malloc_fn libspot_malloc;
+
+/**
+ * @brief Global free
+ *
+ */
+static free_fn libspot_free;
+
+void internal_set_allocators(malloc_fn m, free_fn f) {
+    libspot_malloc = m;
+    libspot_free = f;
+}
+
+void *xmalloc(unsigned long size) {
+    if (!libspot_malloc) {
+        return 0x0;
+    }
+    // here is a cast from 'unsigned long' to 'size_t'
+    // In general it does not create issue because size_t
+    // is bigger than 'unsigned long'. In some case this is
+    // not the case (like arduino).
+    // See https://stackoverflow.com/a/131833
+    if (size > __SIZE_MAX__) {
+        return 0x0;
+    }
+    return libspot_malloc(size);
+}
+
+void xfree(void *p) {
+    if (!libspot_free) {
+        return;
+    }
+    libspot_free(p);
+}
+
+// src/ubend.c
+
+
+int ubend_init(struct Ubend *ubend, unsigned long capacity) {
+    ubend->cursor = 0;
+    ubend->filled = 0;
+    ubend->capacity = capacity;
+    ubend->last_erased_data = _NAN;
+    ubend->data = (double *)xmalloc(capacity * __SIZEOF_DOUBLE__);
+    if (ubend->data) {
+        return 0;
+    }
+    return -ERR_MEMORY_ALLOCATION_FAILED;
+}
+
+void ubend_free(struct Ubend *ubend) {
+    ubend->cursor = 0;
+    ubend->capacity = 0;
+    ubend->filled = -1;
+    ubend->last_erased_data = _NAN;
+    if (ubend->data) {
+        xfree(ubend->data);
+        ubend->data = 0x0;
+    }
+}
+
+unsigned long ubend_size(struct Ubend const *ubend) {
+    if (ubend->filled) {
+        return ubend->capacity;
+    }
+    return ubend->cursor;
+}
+
+double ubend_push(struct Ubend *ubend, double x) {
+    // if the container has already been filled
+    // we must keep in memory the data we will
+    // erase
+    if (ubend->filled) {
+        ubend->last_erased_data = ubend->data[ubend->cursor];
+    }
+
+    // assign to value at cursor
+    ubend->data[ubend->cursor] = x;
+
+    // increment cursor
+    if (ubend->cursor == (ubend->capacity - 1)) {
+        ubend->cursor = 0;
+        ubend->filled = 1;
+    } else {
+        ubend->cursor += 1;
+    }
+
+    return ubend->last_erased_data;
+}
+
+static void reverse(double *data, unsigned long i, unsigned long j) {
+    while (i + 1 < j) {
+        double tmp = data[i];
+        data[i++] = data[--j];
+        data[j] = tmp;
+    }
+}
+
+unsigned long ubend_filter(struct Ubend *ubend, double bound) {
+    unsigned long const size = ubend_size(ubend);
+    unsigned long k = 0;
+
+    // when the container is filled, the oldest value is at the cursor. We
+    // rotate the data (in place) so that it starts at index 0
+    if (ubend->filled && ubend->cursor > 0) {
+        reverse(ubend->data, 0, ubend->cursor);
+        reverse(ubend->data, ubend->cursor, size);
+        reverse(ubend->data, 0, size);
+    }
+
+    for (unsigned long i = 0; i < size; ++i) {
+        if (ubend->data[i] > bound) {
+            ubend->data[k++] = ubend->data[i];
+        }
+    }
+
+    if (k == ubend->capacity) {
+        ubend->cursor = 0;
+        ubend->filled = 1;
+    } else {
+        ubend->cursor = k;
+        ubend->filled = 0;
+        // nothing will be erased at the next push
+        ubend->last_erased_data = _NAN;
+    }
+    return k;
+}
+
+// src/peaks.c
+
+
+int peaks_init(struct Peaks *peaks, unsigned long size) {
+    peaks->e = 0.0;
+    peaks->e2 = 0.0;
+    peaks->min = _NAN;
+    peaks->max = _NAN;
+    return ubend_init(&peaks->container, size);
+}
+
+void peaks_free(struct Peaks *peaks) {
+    peaks->e = _NAN;
+    peaks->e2 = _NAN;
+    peaks->min = _NAN;
+    peaks->max = _NAN;
+    // free container
+    ubend_free(&(peaks->container));
+}
+
+static unsigned long peaks_update_stats(struct Peaks *peaks) {
+    unsigned long max_iteration;
+
+    /* reset min and max */
+    peaks->min = _NAN;
+    peaks->max = _NAN;
+    /* reset accumulators */
+    peaks->e = 0.0;
+    peaks->e2 = 0.0;
+
+    max_iteration = ubend_size(&(peaks->container));
+
+    for (unsigned long i = 0; i < max_iteration; ++i) {
+        // value = *iterator;
+        double value = peaks->container.data[i];
+        peaks->e += value;
+        peaks->e2 += value * value;
+        if (is_nan(peaks->min) || (value < peaks->min)) {
+            peaks->min = value;
+        }
+        if (is_nan(peaks->max) || (value > peaks->max)) {
+            peaks->max = value;
+        }
+    }
+    return max_iteration;
+}
+
+unsigned long peaks_size(struct Peaks const *peaks) {
+    return ubend_size(&(peaks->container));
+}
+
+void peaks_push(struct Peaks *peaks, double x) {
+    double const erased = ubend_push(&(peaks->container), x);
+    unsigned long const size = peaks_size(peaks);
+    /* increment the stats */
+    peaks->e += x;
+    peaks->e2 += x * x;
+
+    // first we update the stats with the value of x
+    if ((size == 1) || (x < peaks->min)) {
+        peaks->min = x;
+    }
+    if ((size == 1) || (x > peaks->max)) {
+        peaks->max = x;
+    }
+
+    // then we treat the case where a data has been erased
+    // In this case we must update the accumulators and possibly
+    // update the min/max
+    if (!is_nan(erased)) {
+        peaks->e -= erased;
+        peaks->e2 -= erased * erased;
+        if ((erased <= peaks->min) || (erased >= peaks->max)) {
+            /* here we have to loop in the container to ensure having
+            the right stats (in particular min and max). However, we
+            also update e and e2 (the in/decrements may create precision
+            errors) */
+            peaks_update_stats(peaks);
+        }
+    }
+}
+
+void peaks_shift(struct Peaks *peaks, double delta) {
+    struct Ubend *container = &(peaks->container);
+    unsigned long const size = ubend_size(container);
+    for (unsigned long i = 0; i < size; ++i) {
+        container->data[i] -= delta;
+    }
+    // only the positive peaks remain
+    ubend_filter(container, 0.0);
+    peaks_update_stats(peaks);
+}
+
+double peaks_mean(struct Peaks const *peaks) {
+    return peaks->e / (double)peaks_size(peaks);
+}
+
+double peaks_var(struct Peaks const *peaks) {
+    double const size = (double)peaks_size(peaks);
+    double mean = peaks->e / size;
+    return (peaks->e2 / size) - (mean * mean);
+}
+
+double log_likelihood(struct Peaks const *peaks, double gamma, double sigma) {
+    unsigned long Nt_local = ubend_size(&(peaks->container));
+    double Nt = (double)Nt_local;
+    if (gamma == 0.) {
+        return -Nt * xlog(sigma) - peaks->e / sigma;
+    }
+
+    double r = -Nt * xlog(sigma);
+    const double c = 1. + 1. / gamma;
+    const double x = gamma / sigma;
+    double logs[PEAKS_BLOCK];
+    for (unsigned long i = 0; i < Nt_local; i += PEAKS_BLOCK) {
+        unsigned long const n =
+            (Nt_local - i < PEAKS_BLOCK) ? (Nt_local - i) : PEAKS_BLOCK;
+        for (unsigned long j = 0; j < n; ++j) {
+            logs[j] = 1 + x * peaks->container.data[i + j];
+        }
+        xlog_batch(logs, logs, n);
+        for (unsigned long j = 0; j < n; ++j) {
+            r += -c * logs[j];
+        }
+    }
+    return r;
+}
+
+// src/estimator.c
+
+
+double mom_estimator(struct Peaks const *peaks, double *gamma, double *sigma) {
+    const double E = peaks_mean(peaks);
+    const double V = peaks_var(peaks);
+    const double R = E * E / V;
+
+    *gamma = 0.5 * (1.0 - R);
+    *sigma = 0.5 * E * (1.0 + R);
+    return log_likelihood(peaks, *gamma, *sigma);
+}
+
+static double grimshaw_w(double x, void *peaks_as_void) {
+    struct Peaks *peaks = (struct Peaks *)peaks_as_void;
+    unsigned long Nt_local = peaks_size(peaks);
+    double u = 0.0;
+    double v = 0.0;
+    double s[PEAKS_BLOCK];
+    double logs[PEAKS_BLOCK];
+
+    for (unsigned long i = 0; i < Nt_local; i += PEAKS_BLOCK) {
+        unsigned long const n =
+            (Nt_local - i < PEAKS_BLOCK) ? (Nt_local - i) : PEAKS_BLOCK;
+        for (unsigned long j = 0; j < n; ++j) {
+            s[j] = 1. + x * peaks->container.data[i + j];
+        }
+        xlog_batch(s, logs, n);
+        // same order as the scalar sums
+        for (unsigned long j = 0; j < n; ++j) {
+            u += 1 / s[j];
+            v += logs[j];
+        }
+    }
+    return (u / Nt_local) * (1.0 + v / Nt_local) - 1.0;
+}
+
+static double grimshaw_v(double x, struct Peaks const *peaks) {
+    double v = 0.0;
+    unsigned long Nt_local = peaks_size(peaks);
+    double logs[PEAKS_BLOCK];
+    for (unsigned long i = 0; i < Nt_local; i += PEAKS_BLOCK) {
+        unsigned long const n =
+            (Nt_local - i < PEAKS_BLOCK) ? (Nt_local - i) : PEAKS_BLOCK;
+        for (unsigned long j = 0; j < n; ++j) {
+            logs[j] = 1.0 + x * peaks->container.data[i + j];
+        }
+        xlog_batch(logs, logs, n);
+        for (unsigned long j = 0; j < n; ++j) {
+            v += logs[j];
+        }
+    }
+    return 1.0 + v / Nt_local;
+}
+
+static double grimshaw_simplified_log_likelihood(double x_star,
+                                                 struct Peaks const *peaks,
+                                                 double *gamma,
+                                                 double *sigma) {
+    if (x_star == 0) {
+        *gamma = 0.0;
+        *sigma = peaks_mean(peaks);
+    } else {
+        *gamma = grimshaw_v(x_star, peaks) - 1;
+        *sigma = *gamma / x_star;
+    }
+    return log_likelihood(peaks, *gamma, *sigma);
+}
+
+double grimshaw_estimator(struct Peaks const *peaks, double *gamma,
+                          double *sigma) {
+    double mini = peaks->min;
+    double maxi = peaks->max;
+    double mean = peaks_mean(peaks);
+
+    double epsilon = xmin(BRENT_DEFAULT_EPSILON, 0.5 / maxi);
+    double r;
+    double a, b;
+
+    int found[] = {1, 0, 0};       // true, false, false
+    double roots[] = {0., 0., 0.}; // 0., ?, ?
+    unsigned int const left = 1;   // left root index
+    unsigned int const right = 2;  // right root index
+
+    double tmp_gamma, tmp_sigma;
+    double llhood, max_llhood;
+    // left root -------------------------------------------------------------
+    a = -1.0 / maxi + epsilon;
+    b = -epsilon;
+    r = brent(&found[left], a, b, grimshaw_w, (void *)peaks,
+              BRENT_DEFAULT_EPSILON);
+    if (found[left]) {
+        roots[left] = r;
+    }
+
+    // right root -------------------------------------------------------------
+    a = epsilon;
+    b = 2.0 * (mean - mini) / (mini * mini);
+    r = brent(&found[right], a, b, grimshaw_w, (void *)peaks,
+              BRENT_DEFAULT_EPSILON);
+    if (found[right]) {
+        roots[right] = r;
+    }
+
+    // compare all roots
+    // first start with zero (it also assign gamma and sigma)
+    max_llhood =
+        grimshaw_simplified_log_likelihood(roots[0], peaks, gamma, sigma);
+    // now check for the roots
+    for (unsigned int k = 1; k < 3; ++k) {
+        // if a root has been found
+        if (found[k]) {
+            // compute the log likelihood
+            llhood = grimshaw_simplified_log_likelihood(
+                roots[k], peaks, &tmp_gamma, &tmp_sigma);
+            // assign values if we have a better result
+            if (llhood > max_llhood) {
+                max_llhood = llhood;
+                *gamma = tmp_gamma;
+                *sigma = tmp_sigma;
+            }
+        }
+    }
+    return max_llhood;
+}
+
+// src/tail.c
+
+
+typedef double (*estimator)(struct Peaks const *, double *, double *);
+
+LIBSPOT_INTERNAL estimator ESTIMATORS[] = {mom_estimator, grimshaw_estimator};
+
+LIBSPOT_INTERNAL unsigned int const NB_ESTIMATORS =
+    sizeof(ESTIMATORS) / sizeof(estimator);
+
+int tail_init(struct Tail *tail, unsigned long size) {
+    tail->gamma = _NAN;
+    tail->sigma = _NAN;
+    return peaks_init(&(tail->peaks), size);
+}
+
+void tail_free(struct Tail *tail) {
+    tail->gamma = _NAN;
+    tail->sigma = _NAN;
+    // free peaks
+    peaks_free(&(tail->peaks));
+}
+
+void tail_push(struct Tail *tail, double x) {
+    // push the data into the container
+    peaks_push(&(tail->peaks), x);
+}
+
+void tail_shift(struct Tail *tail, double delta) {
+    peaks_shift(&(tail->peaks), delta);
+}
+
+double tail_probability(struct Tail const *tail, double s, double d) {
+    // d = zq - t
+    if (tail->gamma == 0.0) {
+        return s * xexp(-d / tail->sigma);
+    } else {
+        double r = d * (tail->gamma / tail->sigma);
+        return s * xpow(1.0 + r, -1.0 / tail->gamma);
+    }
+}
+
+double tail_quantile(struct Tail const *tail, double s, double q) {
+    double r = q / s;
+    if (tail->gamma == 0.0) {
+        return -tail->sigma * xlog(r);
+    }
+    return (tail->sigma / tail->gamma) * (xpow(r, -tail->gamma) - 1);
+}
+
+double tail_fit(struct Tail *tail, int truncated) {
+    struct Peaks const *peaks = &(tail->peaks);
+    double tmp_gamma = _NAN;
+    double tmp_sigma = _NAN;
+
+    double max_llhood = _NAN;
+
+    for (unsigned int i = 0; i < NB_ESTIMATORS; ++i) {
+        if (truncated && (ESTIMATORS[i] == mom_estimator)) {
+            // the moments of truncated peaks underestimate the tail
+            continue;
+        }
+        // compare estimators based on their log likelihood
+        double llhood = ESTIMATORS[i](peaks, &tmp_gamma, &tmp_sigma);
+        if (is_nan(max_llhood) || (llhood > max_llhood)) {
+            max_llhood = llhood;
+            // update GPD parameters
+            tail->gamma = tmp_gamma;
+            tail->sigma = tmp_sigma;
+        }
+    }
+
+    return max_llhood;
+}
+
+// src/spot.c
+
+
+#ifndef VERSION
+#define VERSION "UNDEFINED"
+#endif
+
+#ifndef LICENSE
+#define LICENSE "LGPL-3.0-or-later"
+#endif
+
+// store version and license in strings
+static const char *version = VERSION;
+static const char *license = LICENSE;
+
+// number of data processed at once during a chunked fit: they remain in
+// cache between the update of the threshold estimate and the scan of the
+// candidates
+static unsigned long const FIT_BLOCK_SIZE = 1024;
+
+// first word of a snapshot: "SPOT" followed by the format version
+static __UINT32_TYPE__ const SNAPSHOT_MAGIC = 0x544f5053;
+static __UINT32_TYPE__ const SNAPSHOT_VERSION = 1;
+// number of words before the excesses (see spot_serialize)
+static unsigned long const SNAPSHOT_HEADER_WORDS = 35;
+
+int spot_init(struct Spot *spot, double q, int low, int discard_anomalies,
+              double level, unsigned long max_excess) {
+    if ((level < 0.) || (level >= 1.)) {
+        return -ERR_LEVEL_OUT_OF_BOUNDS;
+    }
+    if ((q >= (1. - level)) || (q <= 0.0)) {
+        return -ERR_Q_OUT_OF_BOUNDS;
+    }
+    spot->q = q;
+    spot->level = level;
+
+    if (low) {
+        spot->low = 1;
+        spot->__up_down = -1.0;
+    } else {
+        spot->low = 0;
+        spot->__up_down = 1.0;
+    }
+
+    if (discard_anomalies) {
+        spot->discard_anomalies = 1;
+    } else {
+        spot->discard_anomalies = 0;
+    }
+
+    // no values yet
+    spot->n = 0;
+    spot->Nt = 0;
+
+    // in all cases, tail is init to
+    // ensure the struct is fully initialized
+    if (tail_init(&(spot->tail), max_excess) < 0) {
+        return -ERR_MEMORY_ALLOCATION_FAILED;
+    }
+
+    spot->anomaly_threshold = _NAN;
+    spot->excess_threshold = _NAN;
+
+    // no recalibration by default
+    spot->rebase_tolerance = _NAN;
+    if (spot->low) {
+        p2_init(&(spot->tracker), 1. - level);
+    } else {
+        p2_init(&(spot->tracker), level);
+    }
+
+    // no chunked fit in progress (nothing is allocated)
+    spot->candidates.cursor = 0;
+    spot->candidates.capacity = 0;
+    spot->candidates.last_erased_data = _NAN;
+    spot->candidates.filled = 0;
+    spot->candidates.data = 0x0;
+
+    return 0;
+}
+
+void spot_free(struct Spot *spot) {
+    // put everything to NAN or
+    spot->q = _NAN;
+    spot->level = _NAN;
+    spot->discard_anomalies = -1;
+    spot->low = -1;
+    spot->__up_down = _NAN;
+    spot->anomaly_threshold = _NAN;
+    spot->excess_threshold = _NAN;
+    spot->Nt = 0;
+    spot->n = 0;
+    spot->rebase_tolerance = _NAN;
+    // free tail
+    tail_free(&(spot->tail));
+    // free the candidates of an unfinished chunked fit
+    if (spot->candidates.data) {
+        ubend_free(&(spot->candidates));
+    }
+}
+
+int spot_fit(struct Spot *spot, double const *data, unsigned long size) {
+    // the data are read once: a bounded buffer keeps the candidate excesses
+    // (see spot_fit_begin)
+    unsigned long candidates = 4 * spot->tail.peaks.container.capacity;
+    if (candidates > size) {
+        candidates = (size > 0) ? size : 1;
+    }
+
+    int status = spot_fit_begin(spot, candidates);
+    if (status < 0) {
+        return status;
+    }
+    spot_fit_feed(spot, data, size);
+    return spot_fit_end(spot);
+}
+
+/**
+ * @brief Update the online estimate of the excess threshold and move the
+ * excess threshold when it has drifted beyond the tolerance
+ *
+ * @param spot Spot instance
+ * @param x new value
+ * @retval 1 the excess threshold has been moved (the tail must be refitted)
+ * @retval 0 otherwise
+ */
+static int spot_rebase(struct Spot *spot, double x) {
+    // the tracker forgets the data that the tail has forgotten, i.e. older
+    // than max_excess excesses (max_excess / (1 - level) data)
+    double const memory =
+        (double)spot->tail.peaks.container.capacity / (1. - spot->level);
+    if (spot->tracker.np[4] > memory) {
+        p2_scale(&(spot->tracker), 0.5);
+    }
+    p2_push(&(spot->tracker), x);
+    double const t = p2_value(&(spot->tracker));
+    double const delta = spot->__up_down * (t - spot->excess_threshold);
+    if (!(delta > spot->rebase_tolerance) &&
+        !(-delta > spot->rebase_tolerance)) {
+        // also the case when t or the threshold is NaN
+        return 0;
+    }
+
+    // the stored excesses are relative to the former threshold
+    tail_shift(&(spot->tail), delta);
+    spot->excess_threshold = t;
+    // by definition of the new threshold, P(X>t) = 1 - level
+    spot->Nt = (unsigned long)((1. - spot->level) * (double)spot->n);
+    return 1;
+}
+
+/**
+ * @brief Return the size of the sample of the evicted candidates (even)
+ *
+ * @param candidates capacity of the candidate buffer
+ * @return the size of the sample
+ */
+static unsigned long spot_fit_sample_size(unsigned long candidates) {
+    return candidates + (candidates & 1);
+}
+
+int spot_fit_begin(struct Spot *spot, unsigned long candidates) {
+    spot->Nt = 0;
+    spot->n = 0;
+
+    if (spot->low) {
+        // take the low quantile (1 - level)
+        p2_init(&(spot->tracker), 1. - spot->level);
+    } else {
+        p2_init(&(spot->tracker), spot->level);
+    }
+
+    if (spot->candidates.data) {
+        ubend_free(&(spot->candidates));
+    }
+    // the same allocation also holds the sample of the evicted candidates
+    // (see spot_fit_evict), right after the ring
+    if (ubend_init(&(spot->candidates),
+                   candidates + spot_fit_sample_size(candidates)) < 0) {
+        return -ERR_MEMORY_ALLOCATION_FAILED;
+    }
+    spot->candidates.capacity = candidates;
+    return 0;
+}
+
+/**
+ * @brief Return the weight of the evicted candidates sample, i.e. the
+ * sampling period of the evicted candidates (a power of 2)
+ *
+ * @param evicted number of evicted candidates
+ * @param sample_size size of the sample
+ * @return the weight of every sampled candidate
+ */
+static unsigned long spot_fit_sample_weight(unsigned long evicted,
+                                            unsigned long sample_size) {
+    unsigned long weight = 1;
+    while (evicted / weight >= sample_size) {
+        weight <<= 1;
+    }
+    return weight;
+}
+
+/**
+ * @brief Store an evicted candidate in the sample of the evicted candidates
+ *
+ * @details Every evicted candidate is kept until the sample is full. Then
+ * every other sampled candidate is dropped and the sampling period is
+ * doubled, so that the sample remains uniform over time. At the end of the
+ * fit, the excesses of the sample (over the final excess threshold) are
+ * scaled to estimate the number of evicted excesses, so that Nt does not
+ * depend on the drift of the estimate of the excess threshold during the
+ * fit. Nt counts the evicted candidates until the end of the fit.
+ *
+ * @param spot Spot instance
+ * @param x evicted candidate
+ */
+static void spot_fit_evict(struct Spot *spot, double x) {
+    struct Ubend const *candidates = &(spot->candidates);
+    unsigned long const size = spot_fit_sample_size(candidates->capacity);
+    double *sample = candidates->data + candidates->capacity;
+    unsigned long const evicted = spot->Nt++;
+    unsigned long const weight = spot_fit_sample_weight(evicted, size);
+
+    if (evicted % weight) {
+        return;
+    }
+    // the sample is full: keep the even positions
+    if ((weight > 1) && (evicted / weight == size / 2)) {
+        for (unsigned long k = 0; k < size / 2; ++k) {
+            sample[k] = sample[2 * k];
+        }
+    }
+    sample[evicted / weight] = x;
+}
+
+/**
+ * @brief Return the lowest excess (relative to the current estimate of the
+ * excess threshold) that can become a real excess at the end of the fit
+ *
+ * @details We use the distance between the estimate of the excess threshold
+ * and the next P2 marker within the tail. For an exponential tail, the guard
+ * is then the quantile that delimits twice as many data as the tail.
+ *
+ * @param spot Spot instance
+ * @return the guard (NaN when the estimate is not available yet)
+ */
+static double spot_fit_guard(struct Spot const *spot) {
+    double const *q = spot->tracker.q;
+    if (spot->tracker.count < 5) {
+        return _NAN;
+    }
+    if (spot->low) {
+        return q[1] - q[2];
+    }
+    return q[2] - q[3];
+}
+
+int spot_fit_feed(struct Spot *spot, double const *data, unsigned long size) {
+    struct Ubend *candidates = &(spot->candidates);
+    if (!candidates->data) {
+        return -ERR_FIT_NOT_STARTED;
+    }
+
+    for (unsigned long i = 0; i < size; i += FIT_BLOCK_SIZE) {
+        unsigned long const end =
+            (size - i > FIT_BLOCK_SIZE) ? (i + FIT_BLOCK_SIZE) : size;
+        p2_feed(&(spot->tracker), data + i, end - i);
+
+        // the candidates are stored as __up_down * x, so the values that
+        // cannot become excesses are below the bound (NaN without estimate)
+        double const bound = spot->__up_down * p2_value(&(spot->tracker)) +
+                             spot_fit_guard(spot);
+        int filtered = 0;
+        for (unsigned long j = i; j < end; ++j) {
+            double const x = spot->__up_down * data[j];
+            // all the data are kept until the buffer is full. Then only the
+            // candidates are kept: the buffer is filtered (once per block)
+            // when a new candidate would evict an older one
+            if (spot->n + j >= candidates->capacity) {
+                if (x <= bound) {
+                    continue;
+                }
+                if (candidates->filled && !filtered) {
+                    ubend_filter(candidates, bound);
+                    filtered = 1;
+                }
+            }
+            int const evict = candidates->filled;
+            double const erased = ubend_push(candidates, x);
+            if (evict) {
+                spot_fit_evict(spot, erased);
+            }
+        }
+    }
+    spot->n += size;
+    return 0;
+}
+
+int spot_fit_end(struct Spot *spot) {
+    struct Ubend *candidates = &(spot->candidates);
+    if (!candidates->data) {
+        return -ERR_FIT_NOT_STARTED;
+    }
+
+    double const et = p2_value(&(spot->tracker));
+    if (is_nan(et)) {
+        ubend_free(candidates);
+        return -ERR_EXCESS_THRESHOLD_IS_NAN;
+    }
+    // here we know that et is not NaN
+    spot->excess_threshold = et;
+
+    // estimate the evicted excesses with their sample
+    unsigned long const evicted = spot->Nt;
+    spot->Nt = 0;
+    if (evicted > 0) {
+        unsigned long const size = spot_fit_sample_size(candidates->capacity);
+        unsigned long const weight =
+            spot_fit_sample_weight(evicted - 1, size);
+        unsigned long const sampled = (evicted - 1) / weight + 1;
+        double const *sample = candidates->data + candidates->capacity;
+        unsigned long excesses = 0;
+        for (unsigned long k = 0; k < sampled; ++k) {
+            excesses += (sample[k] - spot->__up_down * et > 0);
+        }
+        spot->Nt = (unsigned long)(0.5 + (double)excesses * (double)evicted /
+                                             (double)sampled);
+    }
+
+    // fill the tail with the candidates (from the oldest)
+    unsigned long const kept = ubend_size(candidates);
+    unsigned long j = candidates->filled ? candidates->cursor : 0;
+    for (unsigned long i = 0; i < kept; ++i, ++j) {
+        if (j == kept) {
+            j = 0;
+        }
+        // positive excess (the candidates are stored as __up_down * x)
+        double excess = candidates->data[j] - spot->__up_down * et;
+        if (excess > 0) {
+            // it is a real excess
+            spot->Nt++;
+            tail_push(&(spot->tail), excess);
+        }
+    }
+    ubend_free(candidates);
+
+    // fit with the pushed data (no anomaly has been discarded yet)
+    tail_fit(&(spot->tail), 0);
+
+    // compute a first anomaly threshold
+    spot->anomaly_threshold = spot_quantile(spot, spot->q);
+    if (is_nan(spot->anomaly_threshold)) {
+        return -ERR_ANOMALY_THRESHOLD_IS_NAN;
+    }
+
+    return 0;
+}
+
+int spot_step(struct Spot *spot, double x) {
+    if (is_nan(x)) {
+        return -ERR_DATA_IS_NAN;
+    }
+
+    if ((spot->discard_anomalies) &&
+        (spot->__up_down * (x - spot->anomaly_threshold) > 0)) {
+        return ANOMALY;
+    }
+
+    // increment number of data (without the anomalies)
+    spot->n++;
+
+    int rebased = 0;
+    if (!is_nan(spot->rebase_tolerance)) {
+        rebased = spot_rebase(spot, x);
+    }
+
+    double ex = spot->__up_down * (x - spot->excess_threshold);
+    if (ex >= 0.0) {
+        // increment number of excesses
+        spot->Nt++;
+        tail_push(&(spot->tail), ex);
+        tail_fit(&(spot->tail), spot->discard_anomalies);
+        // update threshold
+        spot->anomaly_threshold = spot_quantile(spot, spot->q);
+        return EXCESS;
+    }
+
+    if (rebased && (peaks_size(&(spot->tail.peaks)) > 0)) {
+        tail_fit(&(spot->tail), spot->discard_anomalies);
+        spot->anomaly_threshold = spot_quantile(spot, spot->q);
+    }
+
+    return NORMAL;
+}
+
+unsigned long spot_step_batch(struct Spot *spot, double const *data,
+                              unsigned long size, int *results) {
+    unsigned long anomalies = 0;
+    // with the recalibration, every value updates the threshold tracker
+    int const inline_normal = is_nan(spot->rebase_tolerance);
+
+    for (unsigned long i = 0; i < size; ++i) {
+        double const x = data[i];
+        int result;
+        // same tests as spot_step (false when x or the thresholds are NaN)
+        if (inline_normal &&
+            (spot->__up_down * (x - spot->excess_threshold) < 0) &&
+            !(spot->discard_anomalies &&
+              (spot->__up_down * (x - spot->anomaly_threshold) > 0))) {
+            spot->n++;
+            result = NORMAL;
+        } else {
+            result = spot_step(spot, x);
+            anomalies += (result == ANOMALY);
+        }
+        if (results) {
+            results[i] = result;
+        }
+    }
+    return anomalies;
+}
+
+void spot_set_rebase_tolerance(struct Spot *spot, double tolerance) {
+    if (tolerance < 0.) {
+        spot->rebase_tolerance = _NAN;
+    } else {
+        spot->rebase_tolerance = tolerance;
+    }
+}
+
+// Snapshot ------------------------------------------------------------------
+
+typedef union {
+    double d;
+    __UINT64_TYPE__ i;
+} word;
+
+/**
+ * @brief Write a 64-bit word (little-endian)
+ *
+ * @param p output buffer
+ * @param v value
+ * @return the position after the word
+ */
+static unsigned char *put_u64(unsigned char *p, __UINT64_TYPE__ v) {
+    for (int k = 0; k < 8; ++k) {
+        p[k] = (unsigned char)(v >> (8 * k));
+    }
+    return p + 8;
+}
+
+static unsigned char *put_double(unsigned char *p, double x) {
+    word w;
+    w.d = x;
+    return put_u64(p, w.i);
+}
+
+/**
+ * @brief Read a 64-bit word (little-endian)
+ *
+ * @param p input buffer (it is moved after the word)
+ * @return the value
+ */
+static __UINT64_TYPE__ get_u64(unsigned char const **p) {
+    __UINT64_TYPE__ v = 0;
+    for (int k = 0; k < 8; ++k) {
+        v |= (__UINT64_TYPE__)((*p)[k]) << (8 * k);
+    }
+    *p += 8;
+    return v;
+}
+
+static double get_double(unsigned char const **p) {
+    word w;
+    w.i = get_u64(p);
+    return w.d;
+}
+
+unsigned long spot_serialized_size(struct Spot const *spot) {
+    return 8 * (SNAPSHOT_HEADER_WORDS + peaks_size(&(spot->tail.peaks)));
+}
+
+int spot_serialize(struct Spot const *spot, void *buffer, unsigned long size) {
+    struct Ubend const *container = &(spot->tail.peaks.container);
+    struct P2 const *tracker = &(spot->tracker);
+    unsigned long const count = ubend_size(container);
+    if (size < spot_serialized_size(spot)) {
+        return -ERR_BUFFER_TOO_SMALL;
+    }
+
+    unsigned char *p = (unsigned char *)buffer;
+    p = put_u64(p, SNAPSHOT_MAGIC |
+                       ((__UINT64_TYPE__)SNAPSHOT_VERSION << 32));
+    // parameters
+    p = put_double(p, spot->q);
+    p = put_double(p, spot->level);
+    p = put_u64(p, (__UINT64_TYPE__)(spot->low) |
+                       ((__UINT64_TYPE__)(spot->discard_anomalies) << 1));
+    // state
+    p = put_double(p, spot->anomaly_threshold);
+    p = put_double(p, spot->excess_threshold);
+    p = put_u64(p, spot->Nt);
+    p = put_u64(p, spot->n);
+    p = put_double(p, spot->rebase_tolerance);
+    p = put_double(p, spot->tail.gamma);
+    p = put_double(p, spot->tail.sigma);
+    for (int i = 0; i < 5; ++i) {
+        p = put_double(p, tracker->q[i]);
+        p = put_double(p, tracker->n[i]);
+        p = put_double(p, tracker->np[i]);
+        p = put_double(p, tracker->dn[i]);
+    }
+    p = put_u64(p, tracker->count);
+    // excesses (from the oldest)
+    p = put_u64(p, container->capacity);
+    p = put_u64(p, count);
+    p = put_double(p, container->last_erased_data);
+    unsigned long j = container->filled ? container->cursor : 0;
+    for (unsigned long i = 0; i < count; ++i, ++j) {
+        if (j == count) {
+            j = 0;
+        }
+        p = put_double(p, container->data[j]);
+    }
+    return 0;
+}
+
+int spot_deserialize(struct Spot *spot, void const *buffer,
+                     unsigned long size) {
+    unsigned char const *p = (unsigned char const *)buffer;
+    if (size < 8 * SNAPSHOT_HEADER_WORDS) {
+        return -ERR_BUFFER_TOO_SMALL;
+    }
+
+    __UINT64_TYPE__ const header = get_u64(&p);
+    if (((header & 0xffffffff) != SNAPSHOT_MAGIC) ||
+        ((header >> 32) != SNAPSHOT_VERSION)) {
+        return -ERR_INVALID_SNAPSHOT;
+    }
+
+    double const q = get_double(&p);
+    double const level = get_double(&p);
+    __UINT64_TYPE__ const flags = get_u64(&p);
+    double const anomaly_threshold = get_double(&p);
+    double const excess_threshold = get_double(&p);
+    __UINT64_TYPE__ const Nt = get_u64(&p);
+    __UINT64_TYPE__ const n = get_u64(&p);
+    double const rebase_tolerance = get_double(&p);
+    double const gamma = get_double(&p);
+    double const sigma = get_double(&p);
+    struct P2 tracker;
+    for (int i = 0; i < 5; ++i) {
+        tracker.q[i] = get_double(&p);
+        tracker.n[i] = get_double(&p);
+        tracker.np[i] = get_double(&p);
+        tracker.dn[i] = get_double(&p);
+    }
+    __UINT64_TYPE__ const tracker_count = get_u64(&p);
+    __UINT64_TYPE__ const capacity = get_u64(&p);
+    __UINT64_TYPE__ const count = get_u64(&p);
+    double const last_erased_data = get_double(&p);
+
+    // the counters must fit in an unsigned long (32 bits on some hosts)
+    if ((flags > 3) || ((unsigned long)Nt != Nt) || ((unsigned long)n != n) ||
+        ((unsigned long)tracker_count != tracker_count) ||
+        ((unsigned long)capacity != capacity) || (count > capacity)) {
+        return -ERR_INVALID_SNAPSHOT;
+    }
+    if ((size - 8 * SNAPSHOT_HEADER_WORDS) / 8 < count) {
+        return -ERR_BUFFER_TOO_SMALL;
+    }
+
+    int status = spot_init(spot, q, (int)(flags & 1), (int)(flags >> 1), level,
+                           (unsigned long)capacity);
+    if (status < 0) {
+        return status;
+    }
+
+    // copy the excesses back (it also recomputes the stats of the peaks)
+    for (unsigned long i = 0; i < count; ++i) {
+        double const excess = get_double(&p);
+        if (!(excess >= 0.)) {
+            spot_free(spot);
+            return -ERR_INVALID_SNAPSHOT;
+        }
+        tail_push(&(spot->tail), excess);
+    }
+    spot->tail.peaks.container.last_erased_data = last_erased_data;
+
+    spot->anomaly_threshold = anomaly_threshold;
+    spot->excess_threshold = excess_threshold;
+    spot->Nt = (unsigned long)Nt;
+    spot->n = (unsigned long)n;
+    spot->rebase_tolerance = rebase_tolerance;
+    spot->tail.gamma = gamma;
+    spot->tail.sigma = sigma;
+    tracker.count = (unsigned long)tracker_count;
+    spot->tracker = tracker;
+    return 0;
+}
+
+double spot_quantile(struct Spot const *spot, double q) {
+    double s = (double)(spot->Nt) / (double)(spot->n);
+    return spot->excess_threshold +
+           spot->__up_down * tail_quantile(&spot->tail, s, q);
+}
+
+double spot_probability(struct Spot const *spot, double z) {
+    double s = (double)(spot->Nt) / (double)(spot->n);
+    return tail_probability(&(spot->tail), s,
+                            spot->__up_down * (z - spot->excess_threshold));
+}
+
+/**
+ * @brief Batch version of tail_probability over the values z (the output
+ * buffer holds the intermediate results)
+ */
+static void probability_batch(double up_down, double et, double s,
+                              double gamma, double sigma, double const *z,
+                              unsigned long size, double *probabilities) {
+    if (gamma == 0.0) {
+        for (unsigned long i = 0; i < size; ++i) {
+            double const d = up_down * (z[i] - et);
+            probabilities[i] = -d / sigma;
+        }
+        xexp_batch(probabilities, probabilities, size);
+    } else {
+        double const ratio = gamma / sigma;
+        for (unsigned long i = 0; i < size; ++i) {
+            double const d = up_down * (z[i] - et);
+            probabilities[i] = 1.0 + d * ratio;
+        }
+        xpow_batch(probabilities, -1.0 / gamma, probabilities, size);
+    }
+    for (unsigned long i = 0; i < size; ++i) {
+        probabilities[i] *= s;
+    }
+}
+
+/**
+ * @brief Batch version of tail_quantile over the probabilities q (the output
+ * buffer holds the intermediate results)
+ */
+static void quantile_batch(double up_down, double et, double s, double gamma,
+                           double sigma, double const *q, unsigned long size,
+                           double *quantiles) {
+    for (unsigned long i = 0; i < size; ++i) {
+        quantiles[i] = q[i] / s;
+    }
+    if (gamma == 0.0) {
+        xlog_batch(quantiles, quantiles, size);
+        for (unsigned long i = 0; i < size; ++i) {
+            quantiles[i] = et + up_down * (-sigma * quantiles[i]);
+        }
+    } else {
+        double const scale = sigma / gamma;
+        xpow_batch(quantiles, -gamma, quantiles, size);
+        for (unsigned long i = 0; i < size; ++i) {
+            quantiles[i] = et + up_down * (scale * (quantiles[i] - 1));
+        }
+    }
+}
+
+void spot_quantile_batch(struct Spot const *spot, double const *q,
+                         unsigned long size, double *quantiles) {
+    double s = (double)(spot->Nt) / (double)(spot->n);
+    quantile_batch(spot->__up_down, spot->excess_threshold, s,
+                   spot->tail.gamma, spot->tail.sigma, q, size, quantiles);
+}
+
+void spot_probability_batch(struct Spot const *spot, double const *z,
+                            unsigned long size, double *probabilities) {
+    double s = (double)(spot->Nt) / (double)(spot->n);
+    probability_batch(spot->__up_down, spot->excess_threshold, s,
+                      spot->tail.gamma, spot->tail.sigma, z, size,
+                      probabilities);
+}
+
+// Frozen model --------------------------------------------------------------
+
+int spot_freeze(struct Spot const *spot, struct SpotFrozen *frozen) {
+    if (is_nan(spot->excess_threshold)) {
+        return -ERR_EXCESS_THRESHOLD_IS_NAN;
+    }
+    if (is_nan(spot->anomaly_threshold)) {
+        return -ERR_ANOMALY_THRESHOLD_IS_NAN;
+    }
+    frozen->q = spot->q;
+    frozen->__up_down = spot->__up_down;
+    frozen->anomaly_threshold = spot->anomaly_threshold;
+    frozen->excess_threshold = spot->excess_threshold;
+    frozen->s = (double)(spot->Nt) / (double)(spot->n);
+    frozen->gamma = spot->tail.gamma;
+    frozen->sigma = spot->tail.sigma;
+    frozen->discard_anomalies = spot->discard_anomalies;
+    return 0;
+}
+
+unsigned long spot_frozen_classify(struct SpotFrozen const *frozen,
+                                   double const *data, unsigned long size,
+                                   int *results) {
+    double const up_down = frozen->__up_down;
+    double const at = frozen->anomaly_threshold;
+    double const et = frozen->excess_threshold;
+    // like spot_step, a Spot that keeps the anomalies returns EXCESS
+    int const discard = frozen->discard_anomalies;
+    unsigned long anomalies = 0;
+
+    for (unsigned long i = 0; i < size; ++i) {
+        double const x = data[i];
+        // the anomaly threshold is beyond the excess threshold, so
+        // NORMAL = 0, EXCESS = 1 and ANOMALY = 2 (branchless)
+        int const result =
+            (up_down * (x - et) >= 0) + discard * (up_down * (x - at) > 0);
+        anomalies += (result == ANOMALY);
+        results[i] = is_nan(x) ? -ERR_DATA_IS_NAN : result;
+    }
+    return anomalies;
+}
+
+void spot_frozen_probability(struct SpotFrozen const *frozen,
+                             double const *data, unsigned long size,
+                             double *probabilities) {
+    probability_batch(frozen->__up_down, frozen->excess_threshold, frozen->s,
+                      frozen->gamma, frozen->sigma, data, size,
+                      probabilities);
+}
+
+double spot_frozen_quantile(struct SpotFrozen const *frozen, double q) {
+    // see tail_quantile
+    double const r = q / frozen->s;
+    double d;
+    if (frozen->gamma == 0.0) {
+        d = -frozen->sigma * xlog(r);
+    } else {
+        d = (frozen->sigma / frozen->gamma) * (xpow(r, -frozen->gamma) - 1);
+    }
+    return frozen->excess_threshold + frozen->__up_down * d;
+}
+
+// Extra functions -----------------------------------------------------------
+
+void set_allocators(malloc_fn m, free_fn f) { internal_set_allocators(m, f); }
+
+/**
+ * @brief Copy at most size-1 byte from src to dst (fill dst with zeros until
+ * size-1)
+ *
+ * @param dst output buffer
+ * @param src input buffer
+ * @param size size of the output buffer
+ * @return char* pointer to the output buffer
+ */
+static char *strncpy(char *dst, const char *src, unsigned long size) {
+    if (dst) {
+        unsigned long i = 0;
+        for (; (i < size) && (src[i] != '\0'); i++) {
+            dst[i] = src[i];
+        }
+        for (; i < size; i++) {
+            dst[i] = '\0';
+        }
+        dst[size - 1] = '\0';
+    }
+    return dst;
+}
+
+void set_float_utils(ldexp_fn l, frexp_fn f) {
+    internal_set_float_utils(l, f);
+}
+
+// clang-format off
+static const char *errors[] = {
+    "Memory allocation failed", // ERR_MEMORY_ALLOCATION_FAILED
+    "The level parameter is out of bounds (it must be between 0 and 1, but close to 1)", // ERR_LEVEL_OUT_OF_BOUNDS
+    "The q parameter must between 0 and 1-level", // ERR_Q_OUT_OF_BOUNDS
+    "The excess threshold has not been initialized", // ERR_EXCESS_THRESHOLD_IS_NAN
+    "The anomaly threshold has not been initialized", // ERR_ANOMALY_THRESHOLD_IS_NAN
+    "The input data is NaN",                          // ERR_DATA_IS_NAN
+    "No chunked fit is in progress (spot_fit_begin has not been called)", // ERR_FIT_NOT_STARTED
+    "The buffer is too small",                        // ERR_BUFFER_TOO_SMALL
+    "The buffer is not a valid Spot snapshot",        // ERR_INVALID_SNAPSHOT
+}; // clang-format on
+
+void libspot_error(enum LibspotError err, char *buffer, unsigned long size) {
+    if ((err >= ERR_MEMORY_ALLOCATION_FAILED) &&
+        (err <= ERR_INVALID_SNAPSHOT)) {
+        int index = err - ERR_MEMORY_ALLOCATION_FAILED;
+        strncpy(buffer, errors[index], size);
+    }
+}
+
+void libspot_version(char *buffer, unsigned long size) {
+    strncpy(buffer, version, size);
+}
+
+void libspot_license(char *buffer, unsigned long size) {
+    strncpy(buffer, license, size);
+}
+
+#endif // LIBSPOT_IMPLEMENTATION
@@ -0,0 +1,552 @@
+
+/**
+ * @brief Linkage of the internal symbols (the ones that are not part of the
+ * API). They are shared between the modules of the library, but they get
+ * internal linkage in the amalgamation (dist/libspot.c) so that the compiler
+ * can inline them across modules.
+ */
+
+// a few of them are only used by the tests
+
+/**
+ * @brief \`malloc_fn\` is a pointer to a malloc-type function
+ * i.e. with prototype:
+ * \`void * malloc(size_t)\`
+ *
+ * \`__SIZE_TYPE__\` define the size_t type. This type is notably used
+ * for malloc but it depends on the architecture. As we assume we receive
+ * malloc-like functions we have to be compliant with their prototypes.
+ */
+typedef void *(*malloc_fn)(__SIZE_TYPE__);
+
+/**
+ * @brief \`free_fn\` is a pointer to a free-type function
+ * i.e. with prototype:
+ * \`void free(void*)\`
+ */
+typedef void (*free_fn)(void *);
+
+/**
+ * @brief \`frexp_fn\` is a pointer to a frexp-type function
+ * i.e. with prototype:
+ * \`double frexp_fn(double, int*)\`
+ *
+ * This function decomposes a floating point value
+ * into a normalized fraction and an integral power of 2.
+ * See https://en.cppreference.com/w/c/numeric/math/frexp
+ */
+typedef double (*frexp_fn)(double, int *);
+
+/**
+ * @brief \`ldexp_fn\` is a pointer to a ldexp-type function
+ * i.e. with prototype:
+ * \`double ldexp_fn(double, int*)\`
+ *
+ * This function multiplies a floating point value
+ * by the number 2 raised to the exp power.
+ * See https://en.cppreference.com/w/c/numeric/math/ldexp
+ */
+typedef double (*ldexp_fn)(double, int);
+
+/**
+ * @brief \`real_function\` defines a pointer to a univariate function that
+ * can require extra paramaters (second argument)
+ */
+typedef double (*real_function)(double, void *);
+
+/**
+ * @brief Constants to store libspot errors
+ *
+ */
+enum LibspotError {
+    /// Allocation of the backing array failed
+    ERR_MEMORY_ALLOCATION_FAILED = 1000,
+    /// The level parameter must between 0 and 1
+    ERR_LEVEL_OUT_OF_BOUNDS,
+    /// The q parameter must be between 0 and 1-level
+    ERR_Q_OUT_OF_BOUNDS,
+    /// The excess threshold has not been initialized
+    ERR_EXCESS_THRESHOLD_IS_NAN,
+    /// The anomaly threshold has not been initialized
+    ERR_ANOMALY_THRESHOLD_IS_NAN,
+    /// The input data is NaN
+    ERR_DATA_IS_NAN,
+    /// No chunked fit is in progress
+    ERR_FIT_NOT_STARTED,
+    /// The buffer is too small
+    ERR_BUFFER_TOO_SMALL,
+    /// The buffer is not a valid Spot snapshot
+    ERR_INVALID_SNAPSHOT,
+};
+
+/**
+ * @brief Possible outputs of a Spot step
+ *
+ */
+enum SpotResult {
+    /// @brief Data is normal
+    NORMAL = 0,
+    /// @brief Data is in the tail (so the model has been updated)
+    EXCESS = 1,
+    /// @brief Data is beyond the anomaly threshold
+    ANOMALY = 2,
+};
+
+/**
+ *  @brief This container is a kind of circular vector.
+ *
+ * First it is empty. Then we feed it with data until its max capacity is
+ * reached (transitory state). When it is full, the earlier data erase the
+ * older one (cruise state).
+ */
+struct Ubend {
+    /// @brief Current position inside the container
+    unsigned long cursor;
+    /// @brief Max storage
+    unsigned long capacity;
+    /// @brief Last erased value (i.e. replaced by a new one)
+    double last_erased_data;
+    /// @brief Container fill status (1 = filled, 0 = not filled)
+    int filled;
+    /// @brief Data container
+    double *data;
+};
+
+/**
+ * @brief Stucture that computes stats about the peaks
+ *
+ */
+struct Peaks {
+    /// @brief Sum of the elements
+    double e;
+    /// @brief Sum of the square of the elements
+    double e2;
+    /// @brief Minimum of the elements
+    double min;
+    /// @brief Maximum of the elements
+    double max;
+    /// @brief Underlying data container
+    struct Ubend container;
+};
+
+/**
+ * @brief Stucture that embeds GPD parameter (GPD tail actually)
+ *
+ */
+struct Tail {
+    /// @brief GPD gamma parameter
+    double gamma;
+    /// @brief GPD sigma parameter
+    double sigma;
+    /// @brief Underlyning Peaks structure
+    struct Peaks peaks;
+};
+
+/**
+ * @brief Structure that estimates a quantile online with the P2 algorithm
+ *
+ * The state is a structure of arrays: every per-sample update of the marker
+ * positions is an element-wise operation over the 5 markers.
+ * See aakinshin.net/posts/p2-quantile-estimator/
+ */
+struct P2 {
+    /// @brief Marker heights
+    double q[5];
+    /// @brief Marker positions
+    double n[5];
+    /// @brief Desired marker positions
+    double np[5];
+    /// @brief Increments of the desired marker positions
+    double dn[5];
+    /// @brief Number of inserted values
+    unsigned long count;
+};
+
+/**
+ * @struct Spot
+ * @brief Main structure to run the SPOT algorithm
+ *
+ */
+struct Spot {
+    /// @brief Probability of an anomaly
+    double q;
+    /// @brief Location of the tail (high quantile)
+    double level;
+    /// @brief Flag anomalies (1 = flag, 0 = don't flag)
+    int discard_anomalies;
+    /// @brief Upper/Lower tail choice (1 = lower tail, 0 = upper tail)
+    int low;
+    /// @brief Internal constant (+/- 1.0)
+    double __up_down;
+    /// @brief  Normal/abnormal threshold
+    double anomaly_threshold;
+    /// @brief  Tail threshold
+    double excess_threshold;
+    /// @brief Total number of excesses
+    unsigned long Nt;
+    /// @brief Total number of seen data
+    unsigned long n;
+    /// @brief GPD Tail
+    struct Tail tail;
+    /// @brief Drift of the excess threshold that triggers a recalibration
+    /// (NaN = no recalibration)
+    double rebase_tolerance;
+    /// @brief Online estimator of the excess threshold
+    struct P2 tracker;
+    /// @brief Candidate excesses of a chunked fit (empty otherwise)
+    struct Ubend candidates;
+};
+
+/**
+ * @struct SpotFrozen
+ * @brief Inference-only model exported from a trained Spot (see
+ * spot_freeze)
+ *
+ */
+struct SpotFrozen {
+    /// @brief Probability of an anomaly
+    double q;
+    /// @brief Internal constant (+/- 1.0)
+    double __up_down;
+    /// @brief  Normal/abnormal threshold
+    double anomaly_threshold;
+    /// @brief  Tail threshold
+    double excess_threshold;
+    /// @brief Ratio of excesses (Nt/n)
+    double s;
+    /// @brief GPD gamma parameter
+    double gamma;
+    /// @brief GPD sigma parameter
+    double sigma;
+};
+
+
+// Spot API ------------------------------------------------------------------
+
+/**
+ * @brief Initialize the Spot structure
+ *
+ * @param spot Spot instance
+ * @param q Decision probability (Spot will flag extreme events that will have
+ * a probability lower than q)
+ * @param low Lower tail mode (0 by defaut for upper tail and 1 for lower tail)
+ * @param discard_anomalies Do not include anomalies in the model (default: 1,
+ * 0 otherwise)
+ * @param level Excess level (it is a high quantile that delimits the tail)
+ * @param max_excess Maximum number of data that are kept to analyze the tail
+ * @retval 0 OK
+ * @retval -ERR_LEVEL_OUT_OF_BOUNDS the level parameter is not between 0 and 1
+ * @retval -ERR_Q_OUT_OF_BOUNDS the q parameter is not between 0 and 1-level
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the tail data allocation failed
+ */
+int spot_init(struct Spot *spot, double q, int low, int discard_anomalies,
+              double level, unsigned long max_excess);
+
+/**
+ * @brief Free the tail data
+ *
+ * @param spot Spot instance
+ */
+void spot_free(struct Spot *spot);
+
+/**
+ * @brief Compute the first excess and anomaly thresholds based on training
+ * data
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @retval 0 OK
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NA the anomaly threshold is nan
+ */
+int spot_fit(struct Spot *spot, double const *data, unsigned long size);
+
+/**
+ * @brief Start a chunked fit
+ *
+ * The training data are then passed by chunks to spot_fit_feed and the fit
+ * is completed by spot_fit_end. The data are read once and kept in a bounded
+ * buffer: when it can hold all of them, the fit is exact (every excess over
+ * the final excess threshold is counted). Otherwise, once it is full, only
+ * the candidate excesses (the data above a lower bound of the current
+ * estimate of the excess threshold) are kept and the oldest candidates are
+ * evicted. As the tail keeps the last max_excess excesses, a capacity of a
+ * few times max_excess is enough (about half of the candidates are real
+ * excesses).
+ *
+ * The number of excesses Nt is then an estimate: the evicted candidates are
+ * sampled uniformly over time (in a second buffer of the same capacity) and
+ * the excesses of the sample over the final threshold are scaled. It remains
+ * close to the exact count under a drift. However the data below the lower
+ * bound are dropped: the fit assumes that the final excess threshold is not
+ * far below this bound, i.e. that the training data are roughly stationary
+ * (a strong decreasing drift loses excesses).
+ *
+ * @param spot Spot instance
+ * @param candidates Capacity of the candidate buffer
+ * @retval 0 OK
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the buffer allocation failed
+ */
+int spot_fit_begin(struct Spot *spot, unsigned long candidates);
+
+/**
+ * @brief Pass a chunk of training data
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @retval 0 OK
+ * @retval -ERR_FIT_NOT_STARTED spot_fit_begin has not been called
+ */
+int spot_fit_feed(struct Spot *spot, double const *data, unsigned long size);
+
+/**
+ * @brief Complete a chunked fit: compute the first excess and anomaly
+ * thresholds and release the candidate buffer
+ *
+ * @param spot Spot instance
+ * @retval 0 OK
+ * @retval -ERR_FIT_NOT_STARTED spot_fit_begin has not been called
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NA the anomaly threshold is nan
+ */
+int spot_fit_end(struct Spot *spot);
+
+/**
+ * @brief fit-predict step
+ *
+ * @param spot Spot instance
+ * @param x new value
+ * @retval -ERR_DATA_IS_NAN input data is nan
+ * @retval NORMAL data is normal
+ * @retval EXCESS data lives in the tail
+ * @retval ANOMALY data is out of the threshold
+ */
+int spot_step(struct Spot *spot, double x);
+
+/**
+ * @brief fit-predict steps over a buffer of values
+ *
+ * It is equivalent to calling spot_step on every value, but the normal
+ * values (the most common case) are processed inline.
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @param[out] results Output of spot_step for every value (it can be NULL)
+ * @return the number of anomalies (ANOMALY results)
+ */
+unsigned long spot_step_batch(struct Spot *spot, double const *data,
+                              unsigned long size, int *results);
+
+/**
+ * @brief Enable the online recalibration of the excess threshold
+ *
+ * The excess threshold is then re-estimated at every step (P2 algorithm).
+ * When it has drifted from the current one by more than the tolerance, it
+ * replaces it: the stored excesses are shifted accordingly and the tail is
+ * refitted. It keeps the excess rate close to 1-level under slow drifts.
+ *
+ * @param spot Spot instance
+ * @param tolerance Maximum drift of the excess threshold (in data unit).
+ * A NaN or a negative value disables the recalibration (default).
+ */
+void spot_set_rebase_tolerance(struct Spot *spot, double tolerance);
+
+/**
+ * @brief Return the size of the snapshot of a Spot instance (in bytes)
+ *
+ * @param spot Spot instance
+ * @return the size of the buffer to pass to spot_serialize
+ */
+unsigned long spot_serialized_size(struct Spot const *spot);
+
+/**
+ * @brief Write a snapshot of a Spot instance
+ *
+ * The snapshot is a versioned binary format (little-endian, 8-byte words)
+ * that stores the parameters, the thresholds, the counters, the GPD
+ * parameters, the threshold tracker and the excesses (from the oldest). It
+ * does not depend on the host. The candidates of an unfinished chunked fit
+ * are not stored.
+ *
+ * @param spot Spot instance
+ * @param[out] buffer output buffer
+ * @param size size of the output buffer
+ * @retval 0 OK
+ * @retval -ERR_BUFFER_TOO_SMALL the buffer is smaller than
+ * spot_serialized_size
+ */
+int spot_serialize(struct Spot const *spot, void *buffer, unsigned long size);
+
+/**
+ * @brief Restore a Spot instance from a snapshot (see spot_serialize)
+ *
+ * The model is not refitted: the excesses are copied back and the stats of
+ * the tail are recomputed. The instance must not be initialized (or it must
+ * have been freed). It is left freed when the restore fails.
+ *
+ * @param spot Spot instance
+ * @param buffer snapshot
+ * @param size size of the snapshot
+ * @retval 0 OK
+ * @retval -ERR_BUFFER_TOO_SMALL the snapshot is truncated
+ * @retval -ERR_INVALID_SNAPSHOT the buffer is not a valid snapshot
+ * @retval -ERR_LEVEL_OUT_OF_BOUNDS the stored level is not between 0 and 1
+ * @retval -ERR_Q_OUT_OF_BOUNDS the stored q is not between 0 and 1-level
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the tail data allocation failed
+ */
+int spot_deserialize(struct Spot *spot, void const *buffer,
+                     unsigned long size);
+
+/**
+ * @brief Compute the value zq such that P(X>zq) = q
+ *
+ * @param spot Spot instance
+ * @param q Low probability (it must be within the tail)
+ * @return the desired quantile
+ */
+double spot_quantile(struct Spot const *spot, double q);
+
+/**
+ * @brief Compute the probability p such that P(X>z) = p
+ *
+ * @param spot Spot instance
+ * @param z High quantile (it must be within the tail)
+ * @return the desired probability
+ */
+double spot_probability(struct Spot const *spot, double z);
+
+/**
+ * @brief Compute the quantiles of a buffer of probabilities (see
+ * spot_quantile)
+ *
+ * The model constants are computed once and the logarithms/powers run over
+ * the whole buffer (vectorizable loops), so it is faster than calling
+ * spot_quantile in a loop. The results are the same. The output buffer can
+ * be the input one.
+ *
+ * @param spot Spot instance
+ * @param q Buffer of low probabilities (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] quantiles Output quantiles
+ */
+void spot_quantile_batch(struct Spot const *spot, double const *q,
+                         unsigned long size, double *quantiles);
+
+/**
+ * @brief Compute the probabilities of a buffer of values (see
+ * spot_probability)
+ *
+ * Like spot_quantile_batch, it gives the same results as spot_probability
+ * (except at the end of the support of the tail, where the batch returns 0
+ * instead of NaN). The output buffer can be the input one.
+ *
+ * @param spot Spot instance
+ * @param z Buffer of high quantiles (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] probabilities Output probabilities
+ */
+void spot_probability_batch(struct Spot const *spot, double const *z,
+                            unsigned long size, double *probabilities);
+
+/**
+ * @brief Export the inference-only model of a trained Spot instance
+ *
+ * The frozen model only keeps the thresholds and the GPD parameters (a few
+ * dozen bytes, no allocation). It classifies and scores data like the
+ * detector at the time of the export, without learning from them.
+ *
+ * @param spot Spot instance (fitted)
+ * @param[out] frozen frozen model
+ * @retval 0 OK
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NAN the anomaly threshold is nan
+ */
+int spot_freeze(struct Spot const *spot, struct SpotFrozen *frozen);
+
+/**
+ * @brief Classify a buffer of values with a frozen model
+ *
+ * @param frozen frozen model
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @param[out] results NORMAL, EXCESS or ANOMALY for every value (see
+ * spot_step), -ERR_DATA_IS_NAN for the NaN values
+ * @return the number of anomalies (ANOMALY results)
+ */
+unsigned long spot_frozen_classify(struct SpotFrozen const *frozen,
+                                   double const *data, unsigned long size,
+                                   int *results);
+
+/**
+ * @brief Compute the probabilities P(X>z) of a buffer of values with a
+ * frozen model (see spot_probability)
+ *
+ * @param frozen frozen model
+ * @param data Buffer of values z (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] probabilities Output probabilities (see
+ * spot_probability_batch)
+ */
+void spot_frozen_probability(struct SpotFrozen const *frozen,
+                             double const *data, unsigned long size,
+                             double *probabilities);
+
+/**
+ * @brief Compute the value zq such that P(X>zq) = q with a frozen model
+ * (see spot_quantile)
+ *
+ * @param frozen frozen model
+ * @param q Low probability (it must be within the tail)
+ * @return the desired quantile
+ */
+double spot_frozen_quantile(struct SpotFrozen const *frozen, double q);
+
+/* Extra functions */
+
+/**
+ * @brief Set the allocators object (malloc and free)
+ *
+ * @param m pointer to a "malloc" function
+ * @param f pointer to a "free" function
+ */
+void set_allocators(malloc_fn m, free_fn f);
+
+/**
+ * @brief Set the ldexp/frexp functions
+ *
+ * By default these functions are provided but the API
+ * allows to change them.
+ *
+ * @param l pointer to a "ldexp" function
+ * @param f pointer to a "frexp" function
+ */
+void set_float_utils(ldexp_fn l, frexp_fn f);
+
+/**
+ * @brief Return the version of libspot
+ *
+ * @param[out] buffer input buffer to fill with
+ * @param size size of the input buffer
+ */
+void libspot_version(char *buffer, unsigned long size);
+
+/**
+ * @brief Return the license of the library
+ *
+ * @param[out] buffer input buffer to fill with
+ * @param size size of the input buffer
+ */
+void libspot_license(char *buffer, unsigned long size);
+
+/**
+ * @brief Return a string related to an error code
+ *
+ * @param err error code
+ * @param[out] buffer input buffer to fill with
+ * @param size size of the input buffer
+ */
+void libspot_error(enum LibspotError err, char *buffer, unsigned long size);
+
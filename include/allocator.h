@@ -18,7 +18,7 @@
  * @param m pointer to a "malloc" function
  * @param f pointer to a "free" function
  */
-void internal_set_allocators(malloc_fn m, free_fn f);
+LIBSPOT_INTERNAL void internal_set_allocators(malloc_fn m, free_fn f);
 
 /**
  * @brief
@@ -26,13 +26,13 @@ void internal_set_allocators(malloc_fn m, free_fn f);
  * @param size
  * @return void*
  */
-void *xmalloc(unsigned long size);
+LIBSPOT_INTERNAL void *xmalloc(unsigned long size);
 
 /**
  * @brief
  *
  * @param p
  */
-void xfree(void *p);
+LIBSPOT_INTERNAL void xfree(void *p);
 
 #endif // ALLOCATOR_H
@@ -13,9 +13,9 @@
 
 #include "structs.h"
 
-extern double const BRENT_DEFAULT_EPSILON;
+LIBSPOT_INTERNAL_EXTERN double const BRENT_DEFAULT_EPSILON;
 
-extern unsigned long const BRENT_ITMAX;
+LIBSPOT_INTERNAL_EXTERN unsigned long const BRENT_ITMAX;
 
 /**
     \brief Root search of a scalar function with the Brent's method. It uses
@@ -28,7 +28,7 @@ extern unsigned long const BRENT_ITMAX;
     \param[in] epsilon extra parameter (1e-6)
     \return root
 */
-double brent(int *found, double a, double b, real_function f, void *extra,
-             double epsilon);
+LIBSPOT_INTERNAL double brent(int *found, double a, double b, real_function f,
+                              void *extra, double epsilon);
 
 #endif // BRENT_H
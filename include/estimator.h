@@ -21,7 +21,8 @@
  * @param[out] sigma computed GPD sigma parameter
  * @return the log-likelihood of the estimation
  */
-double mom_estimator(struct Peaks const *peaks, double *gamma, double *sigma);
+LIBSPOT_INTERNAL double mom_estimator(struct Peaks const *peaks, double *gamma,
+                                      double *sigma);
 
 /**
  * @brief
@@ -31,7 +32,7 @@ double mom_estimator(struct Peaks const *peaks, double *gamma, double *sigma);
  * @param[out] sigma computed GPD sigma parameter
  * @return the log-likelihood of the estimation
  */
-double grimshaw_estimator(struct Peaks const *peaks, double *gamma,
-                          double *sigma);
+LIBSPOT_INTERNAL double grimshaw_estimator(struct Peaks const *peaks,
+                                           double *gamma, double *sigma);
 
 #endif // ESTIMATOR_H
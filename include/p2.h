@@ -8,9 +8,67 @@
  *
  */
 
+#include "xmath.h"
+
 #ifndef P2_H
 #define P2_H
 
-double p2_quantile(double p, double const *data, unsigned long size);
+/**
+ * @brief Initialize the P2 estimator
+ *
+ * @param p2 P2 instance
+ * @param p probability of the quantile to estimate
+ */
+LIBSPOT_INTERNAL void p2_init(struct P2 *p2, double p);
+
+/**
+ * @brief Insert a new value into the estimator
+ *
+ * @param p2 P2 instance
+ * @param x new value
+ */
+LIBSPOT_INTERNAL void p2_push(struct P2 *p2, double x);
+
+/**
+ * @brief Insert a buffer of values into the estimator
+ *
+ * @param p2 P2 instance
+ * @param data buffer of values
+ * @param size size of the buffer
+ */
+LIBSPOT_INTERNAL void p2_feed(struct P2 *p2, double const *data,
+                              unsigned long size);
+
+/**
+ * @brief Scale the marker positions
+ *
+ * With 0 < factor < 1, the estimator behaves as if it had seen fewer values:
+ * the next ones weigh more. Scaling regularly makes the estimator forget the
+ * past and follow a drifting quantile.
+ *
+ * @param p2 P2 instance
+ * @param factor scale of the marker positions
+ */
+LIBSPOT_INTERNAL void p2_scale(struct P2 *p2, double factor);
+
+/**
+ * @brief Return the current estimate of the quantile
+ *
+ * @param p2 P2 instance
+ * @return the quantile estimate (NaN if less than 5 values have been
+ * inserted)
+ */
+LIBSPOT_INTERNAL double p2_value(struct P2 const *p2);
+
+/**
+ * @brief Estimate a quantile of a buffer in a single pass
+ *
+ * @param p probability of the quantile to estimate
+ * @param data buffer of values
+ * @param size size of the buffer
+ * @return the quantile estimate (0 if size is lower than 5)
+ */
+LIBSPOT_INTERNAL double p2_quantile(double p, double const *data,
+                                    unsigned long size);
 
 #endif // P2_H
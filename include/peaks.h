@@ -15,20 +15,26 @@
 #ifndef PEAKS_H
 #define PEAKS_H
 
+/**
+ * @brief Number of peaks processed at once by the loops over the excesses
+ * (their logarithms are computed by xlog_batch in a stack buffer)
+ */
+#define PEAKS_BLOCK 64
+
 /**
  * @brief Initialize the Peaks structure
  *
  * @param peaks Peaks instance
  * @param size Maximum number of peaks to store
  */
-int peaks_init(struct Peaks *peaks, unsigned long size);
+LIBSPOT_INTERNAL int peaks_init(struct Peaks *peaks, unsigned long size);
 
 /**
  * @brief Free the peaks structure
  *
  * @param peaks Peaks instance
  */
-void peaks_free(struct Peaks *peaks);
+LIBSPOT_INTERNAL void peaks_free(struct Peaks *peaks);
 
 /**
  * @brief Insert a new peak
@@ -36,7 +42,15 @@ void peaks_free(struct Peaks *peaks);
  * @param peaks Peaks instance
  * @param x new peak
  */
-void peaks_push(struct Peaks *peaks, double x);
+LIBSPOT_INTERNAL void peaks_push(struct Peaks *peaks, double x);
+
+/**
+ * @brief Subtract a value to all the peaks and remove the non-positive ones
+ *
+ * @param peaks Peaks instance
+ * @param delta value to subtract
+ */
+LIBSPOT_INTERNAL void peaks_shift(struct Peaks *peaks, double delta);
 
 /**
  * @brief Get the mean of the peaks
@@ -44,7 +58,7 @@ void peaks_push(struct Peaks *peaks, double x);
  * @param peaks Peaks instance
  * @return the peaks mean
  */
-double peaks_mean(struct Peaks const *peaks);
+LIBSPOT_INTERNAL double peaks_mean(struct Peaks const *peaks);
 
 /**
  * @brief Get the variance of the peaks
@@ -52,7 +66,7 @@ double peaks_mean(struct Peaks const *peaks);
  * @param peaks Peaks instance
  * @return the peaks variance
  */
-double peaks_var(struct Peaks const *peaks);
+LIBSPOT_INTERNAL double peaks_var(struct Peaks const *peaks);
 
 /**
  * @brief Return the number of peaks
@@ -60,7 +74,7 @@ double peaks_var(struct Peaks const *peaks);
  * @param peaks Peaks instance
  * @return the number of peaks
  */
-unsigned long peaks_size(struct Peaks const *peaks);
+LIBSPOT_INTERNAL unsigned long peaks_size(struct Peaks const *peaks);
 
 /**
  * @brief Compute the GPD log-likelihood function
@@ -70,6 +84,7 @@ unsigned long peaks_size(struct Peaks const *peaks);
  * @param sigma GPD sigma parameter
  * @return the log likelihood
  */
-double log_likelihood(struct Peaks const *peaks, double gamma, double sigma);
+LIBSPOT_INTERNAL double log_likelihood(struct Peaks const *peaks, double gamma,
+                                       double sigma);
 
 #endif // PEAKS_H
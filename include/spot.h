@@ -46,15 +46,76 @@ void spot_free(struct Spot *spot);
  * @brief Compute the first excess and anomaly thresholds based on training
  * data
  *
+ * The data are read once, like a chunked fit (see spot_fit_begin) with a
+ * candidate buffer of 4 * max_excess values. It is allocated for the time of
+ * the fit (twice this size, with the sample of the evicted candidates).
+ * When size <= 4 * max_excess, the fit is exact. Otherwise the tail still
+ * gets the last max_excess excesses over the final excess threshold, but
+ * the number of excesses Nt is an estimate (within a few percents on
+ * stationary data).
+ *
  * @param spot Spot instance
  * @param data Buffer of input data
  * @param size Size of the buffer
  * @retval 0 OK
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the candidate buffer allocation
+ * failed
  * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
  * @retval -ERR_ANOMALY_THRESHOLD_IS_NA the anomaly threshold is nan
  */
 int spot_fit(struct Spot *spot, double const *data, unsigned long size);
 
+/**
+ * @brief Start a chunked fit
+ *
+ * The training data are then passed by chunks to spot_fit_feed and the fit
+ * is completed by spot_fit_end. The data are read once and kept in a bounded
+ * buffer: when it can hold all of them, the fit is exact (every excess over
+ * the final excess threshold is counted). Otherwise, once it is full, only
+ * the candidate excesses (the data above a lower bound of the current
+ * estimate of the excess threshold) are kept and the oldest candidates are
+ * evicted. As the tail keeps the last max_excess excesses, a capacity of a
+ * few times max_excess is enough (about half of the candidates are real
+ * excesses).
+ *
+ * The number of excesses Nt is then an estimate: the evicted candidates are
+ * sampled uniformly over time (in a second buffer of the same capacity) and
+ * the excesses of the sample over the final threshold are scaled. It remains
+ * close to the exact count under a drift. However the data below the lower
+ * bound are dropped: the fit assumes that the final excess threshold is not
+ * far below this bound, i.e. that the training data are roughly stationary
+ * (a strong decreasing drift loses excesses).
+ *
+ * @param spot Spot instance
+ * @param candidates Capacity of the candidate buffer
+ * @retval 0 OK
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the buffer allocation failed
+ */
+int spot_fit_begin(struct Spot *spot, unsigned long candidates);
+
+/**
+ * @brief Pass a chunk of training data
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @retval 0 OK
+ * @retval -ERR_FIT_NOT_STARTED spot_fit_begin has not been called
+ */
+int spot_fit_feed(struct Spot *spot, double const *data, unsigned long size);
+
+/**
+ * @brief Complete a chunked fit: compute the first excess and anomaly
+ * thresholds and release the candidate buffer
+ *
+ * @param spot Spot instance
+ * @retval 0 OK
+ * @retval -ERR_FIT_NOT_STARTED spot_fit_begin has not been called
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NA the anomaly threshold is nan
+ */
+int spot_fit_end(struct Spot *spot);
+
 /**
  * @brief fit-predict step
  *
@@ -67,6 +128,81 @@ int spot_fit(struct Spot *spot, double const *data, unsigned long size);
  */
 int spot_step(struct Spot *spot, double x);
 
+/**
+ * @brief fit-predict steps over a buffer of values
+ *
+ * It is equivalent to calling spot_step on every value, but the normal
+ * values (the most common case) are processed inline.
+ *
+ * @param spot Spot instance
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @param[out] results Output of spot_step for every value (it can be NULL)
+ * @return the number of anomalies (ANOMALY results)
+ */
+unsigned long spot_step_batch(struct Spot *spot, double const *data,
+                              unsigned long size, int *results);
+
+/**
+ * @brief Enable the online recalibration of the excess threshold
+ *
+ * The excess threshold is then re-estimated at every step (P2 algorithm).
+ * When it has drifted from the current one by more than the tolerance, it
+ * replaces it: the stored excesses are shifted accordingly and the tail is
+ * refitted. It keeps the excess rate close to 1-level under slow drifts.
+ *
+ * @param spot Spot instance
+ * @param tolerance Maximum drift of the excess threshold (in data unit).
+ * A NaN or a negative value disables the recalibration (default).
+ */
+void spot_set_rebase_tolerance(struct Spot *spot, double tolerance);
+
+/**
+ * @brief Return the size of the snapshot of a Spot instance (in bytes)
+ *
+ * @param spot Spot instance
+ * @return the size of the buffer to pass to spot_serialize
+ */
+unsigned long spot_serialized_size(struct Spot const *spot);
+
+/**
+ * @brief Write a snapshot of a Spot instance
+ *
+ * The snapshot is a versioned binary format (little-endian, 8-byte words)
+ * that stores the parameters, the thresholds, the counters, the GPD
+ * parameters, the threshold tracker and the excesses (from the oldest). It
+ * does not depend on the host. The candidates of an unfinished chunked fit
+ * are not stored.
+ *
+ * @param spot Spot instance
+ * @param[out] buffer output buffer
+ * @param size size of the output buffer
+ * @retval 0 OK
+ * @retval -ERR_BUFFER_TOO_SMALL the buffer is smaller than
+ * spot_serialized_size
+ */
+int spot_serialize(struct Spot const *spot, void *buffer, unsigned long size);
+
+/**
+ * @brief Restore a Spot instance from a snapshot (see spot_serialize)
+ *
+ * The model is not refitted: the excesses are copied back and the stats of
+ * the tail are recomputed. The instance must not be initialized (or it must
+ * have been freed). It is left freed when the restore fails.
+ *
+ * @param spot Spot instance
+ * @param buffer snapshot
+ * @param size size of the snapshot
+ * @retval 0 OK
+ * @retval -ERR_BUFFER_TOO_SMALL the snapshot is truncated
+ * @retval -ERR_INVALID_SNAPSHOT the buffer is not a valid snapshot
+ * @retval -ERR_LEVEL_OUT_OF_BOUNDS the stored level is not between 0 and 1
+ * @retval -ERR_Q_OUT_OF_BOUNDS the stored q is not between 0 and 1-level
+ * @retval -ERR_MEMORY_ALLOCATION_FAILED the tail data allocation failed
+ */
+int spot_deserialize(struct Spot *spot, void const *buffer,
+                     unsigned long size);
+
 /**
  * @brief Compute the value zq such that P(X>zq) = q
  *
@@ -85,6 +221,94 @@ double spot_quantile(struct Spot const *spot, double q);
  */
 double spot_probability(struct Spot const *spot, double z);
 
+/**
+ * @brief Compute the quantiles of a buffer of probabilities (see
+ * spot_quantile)
+ *
+ * The model constants are computed once and the logarithms/powers run over
+ * the whole buffer (vectorizable loops), so it is faster than calling
+ * spot_quantile in a loop. The results are the same. The output buffer can
+ * be the input one.
+ *
+ * @param spot Spot instance
+ * @param q Buffer of low probabilities (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] quantiles Output quantiles
+ */
+void spot_quantile_batch(struct Spot const *spot, double const *q,
+                         unsigned long size, double *quantiles);
+
+/**
+ * @brief Compute the probabilities of a buffer of values (see
+ * spot_probability)
+ *
+ * Like spot_quantile_batch, it gives the same results as spot_probability
+ * (except at the end of the support of the tail, where the batch returns 0
+ * instead of NaN). The output buffer can be the input one.
+ *
+ * @param spot Spot instance
+ * @param z Buffer of high quantiles (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] probabilities Output probabilities
+ */
+void spot_probability_batch(struct Spot const *spot, double const *z,
+                            unsigned long size, double *probabilities);
+
+/**
+ * @brief Export the inference-only model of a trained Spot instance
+ *
+ * The frozen model only keeps the thresholds and the GPD parameters (a few
+ * dozen bytes, no allocation). It classifies and scores data like the
+ * detector at the time of the export, without learning from them.
+ *
+ * @param spot Spot instance (fitted)
+ * @param[out] frozen frozen model
+ * @retval 0 OK
+ * @retval -ERR_EXCESS_THRESHOLD_IS_NAN the excess threshold is nan
+ * @retval -ERR_ANOMALY_THRESHOLD_IS_NAN the anomaly threshold is nan
+ */
+int spot_freeze(struct Spot const *spot, struct SpotFrozen *frozen);
+
+/**
+ * @brief Classify a buffer of values with a frozen model
+ *
+ * @param frozen frozen model
+ * @param data Buffer of input data
+ * @param size Size of the buffer
+ * @param[out] results NORMAL, EXCESS or ANOMALY for every value (see
+ * spot_step), -ERR_DATA_IS_NAN for the NaN values. Like spot_step, when the
+ * exported Spot keeps its anomalies (discard_anomalies = 0), the values
+ * beyond the anomaly threshold are EXCESS
+ * @return the number of anomalies (ANOMALY results)
+ */
+unsigned long spot_frozen_classify(struct SpotFrozen const *frozen,
+                                   double const *data, unsigned long size,
+                                   int *results);
+
+/**
+ * @brief Compute the probabilities P(X>z) of a buffer of values with a
+ * frozen model (see spot_probability)
+ *
+ * @param frozen frozen model
+ * @param data Buffer of values z (they must be within the tail)
+ * @param size Size of the buffer
+ * @param[out] probabilities Output probabilities (see
+ * spot_probability_batch)
+ */
+void spot_frozen_probability(struct SpotFrozen const *frozen,
+                             double const *data, unsigned long size,
+                             double *probabilities);
+
+/**
+ * @brief Compute the value zq such that P(X>zq) = q with a frozen model
+ * (see spot_quantile)
+ *
+ * @param frozen frozen model
+ * @param q Low probability (it must be within the tail)
+ * @return the desired quantile
+ */
+double spot_frozen_quantile(struct SpotFrozen const *frozen, double q);
+
 /* Extra functions */
 
 /**
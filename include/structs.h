@@ -11,6 +11,24 @@
 #ifndef STRUCTS_H
 #define STRUCTS_H
 
+/**
+ * @brief Linkage of the internal symbols (the ones that are not part of the
+ * API). They are shared between the modules of the library, but they get
+ * internal linkage in the amalgamation (dist/libspot.c) so that the compiler
+ * can inline them across modules.
+ */
+#if defined(LIBSPOT_AMALGAMATION) && defined(__GNUC__)
+// a few of them are only used by the tests
+#define LIBSPOT_INTERNAL static __attribute__((unused))
+#define LIBSPOT_INTERNAL_EXTERN static __attribute__((unused))
+#elif defined(LIBSPOT_AMALGAMATION)
+#define LIBSPOT_INTERNAL static
+#define LIBSPOT_INTERNAL_EXTERN static
+#else
+#define LIBSPOT_INTERNAL
+#define LIBSPOT_INTERNAL_EXTERN extern
+#endif
+
 /**
  * @brief \`malloc_fn\` is a pointer to a malloc-type function
  * i.e. with prototype:
@@ -74,6 +92,12 @@ enum LibspotError {
     ERR_ANOMALY_THRESHOLD_IS_NAN,
     /// The input data is NaN
     ERR_DATA_IS_NAN,
+    /// No chunked fit is in progress
+    ERR_FIT_NOT_STARTED,
+    /// The buffer is too small
+    ERR_BUFFER_TOO_SMALL,
+    /// The buffer is not a valid Spot snapshot
+    ERR_INVALID_SNAPSHOT,
 };
 
 /**
@@ -139,6 +163,26 @@ struct Tail {
     struct Peaks peaks;
 };
 
+/**
+ * @brief Structure that estimates a quantile online with the P2 algorithm
+ *
+ * The state is a structure of arrays: every per-sample update of the marker
+ * positions is an element-wise operation over the 5 markers.
+ * See aakinshin.net/posts/p2-quantile-estimator/
+ */
+struct P2 {
+    /// @brief Marker heights
+    double q[5];
+    /// @brief Marker positions
+    double n[5];
+    /// @brief Desired marker positions
+    double np[5];
+    /// @brief Increments of the desired marker positions
+    double dn[5];
+    /// @brief Number of inserted values
+    unsigned long count;
+};
+
 /**
  * @struct Spot
  * @brief Main structure to run the SPOT algorithm
@@ -165,6 +209,38 @@ struct Spot {
     unsigned long n;
     /// @brief GPD Tail
     struct Tail tail;
+    /// @brief Drift of the excess threshold that triggers a recalibration
+    /// (NaN = no recalibration)
+    double rebase_tolerance;
+    /// @brief Online estimator of the excess threshold
+    struct P2 tracker;
+    /// @brief Candidate excesses of a chunked fit (empty otherwise)
+    struct Ubend candidates;
+};
+
+/**
+ * @struct SpotFrozen
+ * @brief Inference-only model exported from a trained Spot (see
+ * spot_freeze)
+ *
+ */
+struct SpotFrozen {
+    /// @brief Probability of an anomaly
+    double q;
+    /// @brief Internal constant (+/- 1.0)
+    double __up_down;
+    /// @brief  Normal/abnormal threshold
+    double anomaly_threshold;
+    /// @brief  Tail threshold
+    double excess_threshold;
+    /// @brief Ratio of excesses (Nt/n)
+    double s;
+    /// @brief GPD gamma parameter
+    double gamma;
+    /// @brief GPD sigma parameter
+    double sigma;
+    /// @brief Flag anomalies (like a Spot that discards them)
+    int discard_anomalies;
 };
 
 #endif // STRUCTS_H
@@ -30,14 +30,14 @@
  * @param size Tail size
  * @return 0 if the initialization is ok
  */
-int tail_init(struct Tail *tail, unsigned long size);
+LIBSPOT_INTERNAL int tail_init(struct Tail *tail, unsigned long size);
 
 /**
  * @brief Free the tail structure
  *
  * @param tail Tail instance
  */
-void tail_free(struct Tail *tail);
+LIBSPOT_INTERNAL void tail_free(struct Tail *tail);
 
 /**
  * @brief Add a new data into the tail
@@ -45,7 +45,16 @@ void tail_free(struct Tail *tail);
  * @param tail Tail instance
  * @param x new data
  */
-void tail_push(struct Tail *tail, double x);
+LIBSPOT_INTERNAL void tail_push(struct Tail *tail, double x);
+
+/**
+ * @brief Move the origin of the tail data (the excess threshold)
+ *
+ * @param tail Tail instance
+ * @param delta shift of the threshold (the data lower than delta are
+ * removed)
+ */
+LIBSPOT_INTERNAL void tail_shift(struct Tail *tail, double delta);
 
 /**
  * @brief Compute the probability to be higher a given value z
@@ -55,7 +64,8 @@ void tail_push(struct Tail *tail, double x);
  * @param d the local quantile (z_q - t)
  * @return the desired probability
  */
-double tail_probability(struct Tail const *tail, double s, double d);
+LIBSPOT_INTERNAL double tail_probability(struct Tail const *tail, double s,
+                                         double d);
 
 /**
  * @brief Compute the extreme quantile related to the input probability
@@ -65,14 +75,22 @@ double tail_probability(struct Tail const *tail, double s, double d);
  * @param q the desired [low] probability
  * @return The desired quantile
  */
-double tail_quantile(struct Tail const *tail, double s, double q);
+LIBSPOT_INTERNAL double tail_quantile(struct Tail const *tail, double s,
+                                      double q);
 
 /**
  * @brief Defines gamma and sigma for the underlying peaks structure
  *
+ * The estimators are compared on their log-likelihood. When the peaks are
+ * truncated (the anomalies are discarded, so no peak lies above the anomaly
+ * threshold), the method of moments is left out: it fits a short tail
+ * (gamma < 0) to the truncated peaks, which lowers the anomaly threshold,
+ * which truncates the next peaks even more.
+ *
  * @param tail Tail instance
+ * @param truncated whether the peaks are truncated at the anomaly threshold
  * @return The related log-likelihood
  */
-double tail_fit(struct Tail *tail);
+LIBSPOT_INTERNAL double tail_fit(struct Tail *tail, int truncated);
 
 #endif // TAIL_H
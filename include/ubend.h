@@ -20,12 +20,12 @@
  * @param capacity number of double to allocate
  * @return 0 is allocation is successful
  */
-int ubend_init(struct Ubend *ubend, unsigned long capacity);
+LIBSPOT_INTERNAL int ubend_init(struct Ubend *ubend, unsigned long capacity);
 
 /**
  * @param ubend
  */
-void ubend_free(struct Ubend *ubend);
+LIBSPOT_INTERNAL void ubend_free(struct Ubend *ubend);
 
 /**
  * @brief Return the current size of the container
@@ -33,7 +33,7 @@ void ubend_free(struct Ubend *ubend);
  * @param ubend
  * @return unsigned long
  */
-unsigned long ubend_size(struct Ubend const *ubend);
+LIBSPOT_INTERNAL unsigned long ubend_size(struct Ubend const *ubend);
 
 /**
  * @brief Insert a new value in the container
@@ -42,6 +42,18 @@ unsigned long ubend_size(struct Ubend const *ubend);
  * @param x
  * @return the erased data or NaN
  */
-double ubend_push(struct Ubend *ubend, double x);
+LIBSPOT_INTERNAL double ubend_push(struct Ubend *ubend, double x);
+
+/**
+ * @brief Remove the values lower than or equal to a bound
+ *
+ * The other values are kept in their insertion order, so that the next
+ * pushes erase them in the same order as before.
+ *
+ * @param ubend
+ * @param bound values lower than or equal to it are removed
+ * @return the new size of the container
+ */
+LIBSPOT_INTERNAL unsigned long ubend_filter(struct Ubend *ubend, double bound);
 
 #endif // UBEND_H
@@ -13,8 +13,8 @@
 #ifndef XMATH_H
 #define XMATH_H
 
-extern double const _NAN;
-extern double const _INFINITY;
+LIBSPOT_INTERNAL_EXTERN double const _NAN;
+LIBSPOT_INTERNAL_EXTERN double const _INFINITY;
 
 /**
  * @brief Internal function to set the frexp/ldexp functions
@@ -23,7 +23,38 @@ extern double const _INFINITY;
  * @param l pointer to a "ldexp" function
  * @param f pointer to a "frexp" function
  */
-void internal_set_float_utils(ldexp_fn l, frexp_fn f);
+LIBSPOT_INTERNAL void internal_set_float_utils(ldexp_fn l, frexp_fn f);
+
+#ifdef LIBSPOT_MATH_LIBM
+
+// libm backend (make MATH=libm): the entry points are inlined calls to the
+// libm, so the library is no longer freestanding (link with -lm). frexp/ldexp
+// (see internal_set_float_utils) are not used.
+#include <math.h>
+
+/**
+ * @brief Compute natural logarithm (libm)
+ * @param x input value
+ * @return double
+ */
+static inline double xlog(double x) { return log(x); }
+
+/**
+ * @brief Compute exponential (libm)
+ * @param x input value
+ * @return double
+ */
+static inline double xexp(double x) { return exp(x); }
+
+/**
+ * @brief Compute a^x (libm)
+ * @param a
+ * @param x
+ * @return double
+ */
+static inline double xpow(double a, double x) { return pow(a, x); }
+
+#else
 
 /**
  * @brief Compute natural logarithm with Shank's algorithm
@@ -31,7 +62,7 @@ void internal_set_float_utils(ldexp_fn l, frexp_fn f);
  * @param x input value
  * @return double
  */
-double xlog(double x);
+LIBSPOT_INTERNAL double xlog(double x);
 
 /**
  * @brief Compute exponential with continuous fraction
@@ -43,7 +74,7 @@ double xlog(double x);
  * @param x
  * @return double
  */
-double xexp(double x);
+LIBSPOT_INTERNAL double xexp(double x);
 
 /**
  * @brief Compute a^x with log and exp :)
@@ -52,7 +83,43 @@ double xexp(double x);
  * @param x
  * @return double
  */
-double xpow(double a, double x);
+LIBSPOT_INTERNAL double xpow(double a, double x);
+
+#endif // LIBSPOT_MATH_LIBM
+
+/**
+ * @brief Compute xlog over a buffer of values
+ * @details Same results as xlog, with a loop that the compiler can
+ * vectorize. The output buffer can be the input one.
+ * @param x input values
+ * @param[out] out output values
+ * @param size number of values
+ */
+LIBSPOT_INTERNAL void xlog_batch(double const *x, double *out,
+                                 unsigned long size);
+
+/**
+ * @brief Compute xexp over a buffer of values
+ * @details Same results as xexp for finite values (the infinities give
+ * their limits), with a loop that the compiler can vectorize. The output
+ * buffer can be the input one.
+ * @param x input values
+ * @param[out] out output values
+ * @param size number of values
+ */
+LIBSPOT_INTERNAL void xexp_batch(double const *x, double *out,
+                                 unsigned long size);
+
+/**
+ * @brief Compute a[i]^x over a buffer of values (see xpow)
+ * @details The output buffer can be the input one.
+ * @param a input values
+ * @param x exponent
+ * @param[out] out output values
+ * @param size number of values
+ */
+LIBSPOT_INTERNAL void xpow_batch(double const *a, double x, double *out,
+                                 unsigned long size);
 
 /**
  * @brief Return the minimum of two values
@@ -61,7 +128,7 @@ double xpow(double a, double x);
  * @param b input value
  * @return the minimum of a and b
  */
-double xmin(double a, double b);
+LIBSPOT_INTERNAL double xmin(double a, double b);
 
 /**
  * @brief Check if a double is NAN
@@ -70,6 +137,6 @@ double xmin(double a, double b);
  * @retval 1 when x is nan
  * @retval 0 otherwise
  */
-int is_nan(double x);
+LIBSPOT_INTERNAL int is_nan(double x);
 
 #endif // XMATH_H
@@ -0,0 +1,33 @@
+/**
+ * @file spot_file.h
+ * @brief Declares file helpers (POSIX companion library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+
+#include "spot.h"
+
+#ifndef SPOT_FILE_H
+#define SPOT_FILE_H
+
+/**
+ * @brief Fit a Spot instance with the training data stored in a file
+ *
+ * The file is a flat array of little-endian doubles. A regular file is
+ * mapped in memory (with sequential access advice) and the fit runs directly
+ * on the mapping, without any copy. Other files (pipes, character devices...)
+ * are read by chunks through spot_fit_begin/spot_fit_feed/spot_fit_end.
+ *
+ * @param spot Spot instance
+ * @param path Path of the file
+ * @retval 0 OK
+ * @retval -errno the file cannot be opened, mapped or read (see errno(3)).
+ * -EINVAL is returned when the file size is not a multiple of 8.
+ * @retval -ERR_* the fit has failed (see spot_fit)
+ */
+int spot_fit_file(struct Spot *spot, char const *path);
+
+#endif // SPOT_FILE_H
@@ -0,0 +1,122 @@
+/**
+ * @file spot_log.h
+ * @brief Declares the checkpoint log of Spot instances (POSIX companion
+ * library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+
+#include "spot.h"
+
+#ifndef SPOT_LOG_H
+#define SPOT_LOG_H
+
+/// @brief Size of the record buffer of a log (in bytes)
+#define SPOT_LOG_BUFFER_SIZE 4096
+
+/**
+ * @brief Append-only log of the state changes of a Spot instance
+ *
+ * A checkpoint is a snapshot (see spot_serialize) followed by the log of the
+ * changes since the snapshot. Every excess, every move of the excess
+ * threshold and every flush appends a small record (with the new counters,
+ * GPD parameters and thresholds), so the I/O is proportional to the number
+ * of excesses, not to the size of the tail. The records are buffered until
+ * spot_log_flush.
+ *
+ * When the records cannot be written, the log is truncated to its former end
+ * and the records remain buffered: the next write retries them. Only the
+ * record of a step that finds the buffer full and cannot write it is lost,
+ * then a checkpoint is required to resume a consistent log.
+ *
+ * The records keep the native byte order: a log must be replayed on the
+ * same architecture.
+ */
+struct SpotLog {
+    /// @brief File descriptor of the log
+    int fd;
+    /// @brief Number of buffered bytes
+    unsigned long used;
+    /// @brief Records not written yet
+    unsigned char buffer[SPOT_LOG_BUFFER_SIZE];
+};
+
+/**
+ * @brief Open a log (it is created if it does not exist)
+ *
+ * @param log log instance
+ * @param path path of the log
+ * @retval 0 OK
+ * @retval -EINVAL the file is not a log
+ * @retval -errno the file cannot be opened (see errno(3))
+ */
+int spot_log_open(struct SpotLog *log, char const *path);
+
+/**
+ * @brief fit-predict step that records the state changes (see spot_step)
+ *
+ * @param log log instance
+ * @param spot Spot instance
+ * @param x new value
+ * @return the output of spot_step, or -errno if the records cannot be
+ * written
+ */
+int spot_log_step(struct SpotLog *log, struct Spot *spot, double x);
+
+/**
+ * @brief Record the counters and write the buffered records
+ *
+ * @param log log instance
+ * @param spot Spot instance
+ * @param wait 1 to wait for the records to reach the disk, 0 otherwise
+ * @retval 0 OK
+ * @retval -errno see write(2) and fsync(2)
+ */
+int spot_log_flush(struct SpotLog *log, struct Spot const *spot, int wait);
+
+/**
+ * @brief Write a snapshot of the instance and empty the log
+ *
+ * The snapshot replaces the former one atomically. A checkpoint is required
+ * after every change that is not made by spot_log_step (fit, parameters...).
+ *
+ * @param log log instance
+ * @param spot Spot instance
+ * @param path path of the snapshot
+ * @retval 0 OK
+ * @retval -errno the snapshot cannot be written (see errno(3))
+ */
+int spot_log_checkpoint(struct SpotLog *log, struct Spot const *spot,
+                        char const *path);
+
+/**
+ * @brief Restore an instance from a snapshot and the log of the changes
+ *
+ * The records are applied to the snapshot without refitting the model. An
+ * incomplete record at the end of the log (interrupted write) is ignored.
+ *
+ * @param spot Spot instance (not initialized, see spot_deserialize)
+ * @param snapshot path of the snapshot
+ * @param path path of the log
+ * @retval 0 OK
+ * @retval -EINVAL the log is invalid
+ * @retval -errno a file cannot be read (see errno(3))
+ * @retval -ERR_* the snapshot is invalid (see spot_deserialize)
+ */
+int spot_log_restore(struct Spot *spot, char const *snapshot,
+                     char const *path);
+
+/**
+ * @brief Write the buffered records and close the log
+ *
+ * @param log log instance
+ * @param spot Spot instance
+ * @retval 0 OK
+ * @retval -errno the records cannot be written
+ */
+int spot_log_close(struct SpotLog *log, struct Spot const *spot);
+
+#endif // SPOT_LOG_H
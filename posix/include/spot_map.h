@@ -0,0 +1,254 @@
+/**
+ * @file spot_map.h
+ * @brief Declares the keyed map of Spot instances (POSIX companion library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+
+#include "spot.h"
+
+#ifndef SPOT_MAP_H
+#define SPOT_MAP_H
+
+/// @brief Result of spot_map_step when the value belongs to the warm-up
+#define SPOT_MAP_WARMUP 3
+
+/**
+ * @brief Entry of a detector (pooled, see spot_map.c)
+ */
+struct SpotMapEntry;
+
+/**
+ * @brief Cached excess ring of the tiered mode (see spot_map.c)
+ */
+struct SpotMapBuffer;
+
+/**
+ * @brief Bucket of an open addressing table (0 = empty)
+ */
+struct SpotMapBucket {
+    /// @brief Series id
+    __UINT64_TYPE__ id;
+    /// @brief Value (entry address or spill slot + 1)
+    unsigned long value;
+};
+
+/**
+ * @brief Open addressing table (linear probing)
+ */
+struct SpotMapTable {
+    /// @brief Buckets (the capacity is a power of 2)
+    struct SpotMapBucket *buckets;
+    /// @brief Number of buckets
+    unsigned long capacity;
+    /// @brief Number of used buckets
+    unsigned long size;
+};
+
+/**
+ * @brief Map of detectors keyed by a 64-bit series id
+ *
+ * A detector is created at the first value of its series. It buffers the
+ * first `warmup` values, then it is fitted on them and stepped with the next
+ * ones. The detectors live in pooled fixed-size entries (the Spot structure
+ * followed by its excess ring), so they do not allocate memory once fitted.
+ *
+ * When the memory cap is reached, the least recently used detector is
+ * evicted. It is dropped (its series warms up again at its next value)
+ * unless a spill file is set (see spot_map_spill): the evicted entries are
+ * then written to the file and read back at the next value of their series.
+ *
+ * In tiered mode (see spot_map_tier), only the Spot structures are
+ * resident: the excess rings live in the spill file and a few of them are
+ * cached. A ring is read back only when a value of its series is an excess.
+ */
+struct SpotMap {
+    /// @brief Probability of an anomaly
+    double q;
+    /// @brief Excess level
+    double level;
+    /// @brief Lower tail mode
+    int low;
+    /// @brief Do not include anomalies in the model
+    int discard_anomalies;
+    /// @brief Capacity of the excess rings
+    unsigned long max_excess;
+    /// @brief Number of values of the warm-up fit
+    unsigned long warmup;
+    /// @brief Memory cap of the entries (0 = no limit)
+    unsigned long memory;
+    /// @brief Size of an entry (in bytes)
+    unsigned long entry_size;
+    /// @brief Size of a slot of the spill file (in bytes)
+    unsigned long slot_size;
+    /// @brief Maximum number of resident entries (0 = no limit)
+    unsigned long max_entries;
+    /// @brief Number of allocated entries
+    unsigned long entries;
+    /// @brief Free entries (singly linked)
+    struct SpotMapEntry *free_entries;
+    /// @brief Most recently used entry
+    struct SpotMapEntry *newest;
+    /// @brief Least recently used entry
+    struct SpotMapEntry *oldest;
+    /// @brief Blocks of entries
+    void **chunks;
+    /// @brief Number of blocks of entries
+    unsigned long chunk_count;
+    /// @brief Resident entries
+    struct SpotMapTable table;
+    /// @brief Fresh detector (copied into an entry at its fit)
+    struct Spot prototype;
+    /// @brief Copy of the warm-up values during a fit
+    double *scratch;
+    /// @brief Spill file (-1 = no spill)
+    int spill_fd;
+    /// @brief Spilled entries (id -> slot of the spill file + 1)
+    struct SpotMapTable spilled;
+    /// @brief Number of slots of the spill file
+    unsigned long spill_slots;
+    /// @brief Free slots of the spill file
+    unsigned long *spill_free;
+    /// @brief Number of free slots of the spill file
+    unsigned long spill_free_count;
+    /// @brief Capacity of the list of free slots
+    unsigned long spill_free_capacity;
+    /// @brief Cached excess rings (tiered mode, NULL otherwise)
+    struct SpotMapBuffer *buffers;
+    /// @brief Number of cached excess rings
+    unsigned long buffer_count;
+    /// @brief Size of a cached excess ring (in bytes)
+    unsigned long buffer_size;
+    /// @brief Next candidate of the cache eviction (clock)
+    unsigned long buffer_hand;
+    /// @brief Number of evictions
+    unsigned long evictions;
+    /// @brief Id of the last evicted series
+    __UINT64_TYPE__ evicted;
+    /// @brief Number of excess rings read back (tiered mode)
+    unsigned long reads;
+};
+
+/**
+ * @brief Initialize an empty map
+ *
+ * @param map map instance
+ * @param q Decision probability (see spot_init)
+ * @param low Lower tail mode
+ * @param discard_anomalies Do not include anomalies in the model
+ * @param level Excess level
+ * @param max_excess Capacity of the excess rings
+ * @param warmup Number of values of the warm-up fit
+ * @param memory Memory cap of the entries in bytes (0 = no limit)
+ * @retval 0 OK
+ * @retval -EINVAL warmup is zero or memory cannot hold a single entry
+ * @retval -ENOMEM the tables cannot be allocated
+ * @retval -ERR_* the parameters are invalid (see spot_init)
+ */
+int spot_map_init(struct SpotMap *map, double q, int low,
+                  int discard_anomalies, double level,
+                  unsigned long max_excess, unsigned long warmup,
+                  unsigned long memory);
+
+/**
+ * @brief Spill the evicted detectors to a file instead of dropping them
+ *
+ * The file is truncated. The entries keep the native layout of struct Spot,
+ * so the file is only a scratch space of the current process.
+ *
+ * @param map map instance
+ * @param path path of the spill file
+ * @retval 0 OK
+ * @retval -EBUSY a spill file is already set
+ * @retval -errno the file cannot be created (see errno(3))
+ */
+int spot_map_spill(struct SpotMap *map, char const *path);
+
+/**
+ * @brief Keep only the Spot structures in memory (tiered mode)
+ *
+ * Every series gets a slot of the spill file for its excess ring (and its
+ * warm-up values). At most `buffers` rings are cached in memory: the others
+ * are read back when a value of their series is an excess, so the detectors
+ * of sparse tails cost the size of a Spot structure. The memory cap then
+ * applies to the resident structures, the cache is allocated once.
+ *
+ * It must be called on an empty map. The file is truncated.
+ *
+ * @param map map instance
+ * @param path path of the spill file
+ * @param buffers number of cached excess rings
+ * @retval 0 OK
+ * @retval -EBUSY the map is not empty or a spill file is already set
+ * @retval -EINVAL buffers is zero or the memory cap cannot hold a single
+ * entry
+ * @retval -ENOMEM the cache cannot be allocated
+ * @retval -errno the file cannot be created (see errno(3))
+ */
+int spot_map_tier(struct SpotMap *map, char const *path,
+                  unsigned long buffers);
+
+/**
+ * @brief Pass a value to the detector of a series
+ *
+ * The detector is created (or read back from the spill file) if needed.
+ * On the hot path (resident detector) it costs a single lookup.
+ *
+ * @param map map instance
+ * @param id series id
+ * @param x new value
+ * @param threshold if not NULL, receives the anomaly threshold before the
+ * step (NaN during the warm-up)
+ * @retval NORMAL, EXCESS, ANOMALY see spot_step
+ * @retval SPOT_MAP_WARMUP the value has been buffered for the warm-up fit
+ * @retval -ERR_DATA_IS_NAN the value is NaN
+ * @retval -ENOMEM no entry can be allocated
+ * @retval -errno the spill file cannot be read or written (see errno(3))
+ */
+int spot_map_step(struct SpotMap *map, __UINT64_TYPE__ id, double x,
+                  double *threshold);
+
+/**
+ * @brief Return the resident detector of a series
+ *
+ * The Spot instance can be passed to the read-only functions of the libspot
+ * API (spot_quantile, spot_probability...). It remains valid until the next
+ * call to spot_map_step or spot_map_remove. In tiered mode, its excess ring
+ * may not be resident (see spot_map_tier).
+ *
+ * @param map map instance
+ * @param id series id
+ * @return the detector, NULL if the series is unknown, not fitted yet or
+ * spilled
+ */
+struct Spot *spot_map_get(struct SpotMap *map, __UINT64_TYPE__ id);
+
+/**
+ * @brief Remove the detector of a series
+ *
+ * @param map map instance
+ * @param id series id
+ * @retval 0 OK
+ * @retval -ENOENT the series is unknown
+ */
+int spot_map_remove(struct SpotMap *map, __UINT64_TYPE__ id);
+
+/**
+ * @brief Return the number of series (resident and spilled)
+ *
+ * @param map map instance
+ * @return the number of series
+ */
+unsigned long spot_map_size(struct SpotMap const *map);
+
+/**
+ * @brief Free the map (the spill file is closed, not removed)
+ *
+ * @param map map instance
+ */
+void spot_map_free(struct SpotMap *map);
+
+#endif // SPOT_MAP_H
@@ -0,0 +1,55 @@
+/**
+ * @file spot_parse.h
+ * @brief Declares the parsers of text streams (POSIX companion library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+
+#ifndef SPOT_PARSE_H
+#define SPOT_PARSE_H
+
+/**
+ * @brief Parse a decimal floating-point number
+ *
+ * The common case (at most 19 significant digits and a small exponent) is
+ * converted exactly with a single floating-point operation. The other
+ * numbers (and nan, inf...) fall back to strtod, so the result is always
+ * the one of strtod.
+ *
+ * @param begin beginning of the text
+ * @param end end of the text (the text does not need to be null-terminated)
+ * @param[out] value parsed number
+ * @return the first character after the number, begin if there is no
+ * number
+ */
+char const *spot_parse_double(char const *begin, char const *end,
+                              double *value);
+
+/**
+ * @brief Extract the numbers of a column from lines of delimited fields
+ *
+ * The lines without a number in the column (header, comments...) are
+ * skipped. The parsing stops at the first incomplete line (no newline,
+ * unless it is the end of the input) or when the output is full.
+ *
+ * @param begin beginning of the text
+ * @param end end of the text
+ * @param last 1 if the text ends the input (the last line may not end with
+ * a newline), 0 otherwise
+ * @param delimiter field delimiter (like ',')
+ * @param column index of the column (from 0)
+ * @param[out] values output buffer
+ * @param capacity size of the output buffer
+ * @param[out] count number of parsed values
+ * @return the first character that has not been consumed (the beginning of
+ * a line)
+ */
+char const *spot_parse_column(char const *begin, char const *end, int last,
+                              char delimiter, unsigned long column,
+                              double *values, unsigned long capacity,
+                              unsigned long *count);
+
+#endif // SPOT_PARSE_H
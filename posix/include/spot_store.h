@@ -0,0 +1,134 @@
+/**
+ * @file spot_store.h
+ * @brief Declares the file-backed store of Spot instances (POSIX companion
+ * library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+
+#include "spot.h"
+
+#ifndef SPOT_STORE_H
+#define SPOT_STORE_H
+
+/**
+ * @brief File-backed store of Spot instances
+ *
+ * The file is mapped in memory. It holds fixed-size slots, one per detector,
+ * each with its Spot structure followed by its excess ring. A Spot of the
+ * store is used in place: stepping it only touches its slot and the kernel
+ * writes the dirty pages back to the file.
+ *
+ * The slots keep the native layout of struct Spot, so a store can only be
+ * opened by the same build on the same architecture (see spot_serialize for
+ * a portable format).
+ *
+ * Crash guarantees: the slots are updated in place, without journal.
+ * - When the process crashes, the kernel still writes every completed
+ *   update back. Only a slot that was being updated (e.g. within spot_step)
+ *   can be torn.
+ * - When the system crashes, the slots updated since the last
+ *   spot_store_sync(store, 1) can be lost or torn (page by page).
+ * A torn slot whose excess ring cannot be used safely (capacity, cursor or
+ * flags out of range) is rejected by spot_store_get. Otherwise, the values
+ * of the detector are not checked: it may resume with a mix of its states
+ * before and after the interrupted update.
+ */
+struct SpotStore {
+    /// @brief Beginning of the mapping
+    unsigned char *map;
+    /// @brief Size of the mapping (in bytes)
+    unsigned long size;
+    /// @brief Number of slots
+    unsigned long slots;
+    /// @brief Capacity of the excess rings
+    unsigned long max_excess;
+    /// @brief Size of a slot (in bytes)
+    unsigned long slot_size;
+    /// @brief Session number (incremented at every opening)
+    unsigned long generation;
+};
+
+/**
+ * @brief Create a store (the file is truncated)
+ *
+ * The file is sparse: the slots use disk space only once initialized.
+ *
+ * @param store store instance
+ * @param path path of the file
+ * @param slots number of slots
+ * @param max_excess capacity of the excess ring of every detector
+ * @retval 0 OK
+ * @retval -errno the file cannot be created or mapped (see errno(3))
+ */
+int spot_store_create(struct SpotStore *store, char const *path,
+                      unsigned long slots, unsigned long max_excess);
+
+/**
+ * @brief Open an existing store
+ *
+ * It only reads the header of the file, whatever the number of slots.
+ *
+ * @param store store instance
+ * @param path path of the file
+ * @retval 0 OK
+ * @retval -EINVAL the file is not a store (or it has been created by
+ * another build of the library)
+ * @retval -errno the file cannot be opened or mapped (see errno(3))
+ */
+int spot_store_open(struct SpotStore *store, char const *path);
+
+/**
+ * @brief Initialize the detector of a slot (see spot_init)
+ *
+ * @param store store instance
+ * @param index slot index
+ * @param q Decision probability
+ * @param low Lower tail mode
+ * @param discard_anomalies Do not include anomalies in the model
+ * @param level Excess level
+ * @retval 0 OK
+ * @retval -ERANGE the index is out of bounds
+ * @retval -ERR_* the parameters are invalid (see spot_init)
+ */
+int spot_store_init(struct SpotStore *store, unsigned long index, double q,
+                    int low, int discard_anomalies, double level);
+
+/**
+ * @brief Return the detector of a slot
+ *
+ * The Spot instance can be passed to the whole libspot API (except
+ * spot_free). It remains valid until the store is closed.
+ *
+ * At the first access since the opening, the slot is checked (see
+ * SpotStore). A rejected slot can be initialized again with
+ * spot_store_init.
+ *
+ * @param store store instance
+ * @param index slot index
+ * @return the detector, NULL if the index is out of bounds, if the slot
+ * has not been initialized or if it is torn
+ */
+struct Spot *spot_store_get(struct SpotStore *store, unsigned long index);
+
+/**
+ * @brief Write the dirty pages back to the file
+ *
+ * @param store store instance
+ * @param wait 1 to wait for the completion of the writes, 0 otherwise
+ * @retval 0 OK
+ * @retval -errno see msync(2)
+ */
+int spot_store_sync(struct SpotStore *store, int wait);
+
+/**
+ * @brief Close the store (the dirty pages are written back by the kernel)
+ *
+ * @param store store instance
+ */
+void spot_store_close(struct SpotStore *store);
+
+#endif // SPOT_STORE_H
@@ -0,0 +1,164 @@
+/**
+ * @file spot_file.c
+ * @brief Implements file helpers (POSIX companion library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+#include "spot_file.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// number of doubles read at once when the file cannot be mapped
+#define READ_CHUNK_SIZE 8192
+
+/**
+ * @brief Convert little-endian doubles to the host order (in place)
+ *
+ * @param data buffer of doubles
+ * @param size size of the buffer
+ */
+static void from_little_endian(double *data, unsigned long size) {
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (unsigned long i = 0; i < size; ++i) {
+        unsigned char *b = (unsigned char *)(data + i);
+        for (int j = 0; j < 4; ++j) {
+            unsigned char tmp = b[j];
+            b[j] = b[7 - j];
+            b[7 - j] = tmp;
+        }
+    }
+#else
+    (void)data;
+    (void)size;
+#endif
+}
+
+/**
+ * @brief Fit by chunks from a file descriptor (until EOF)
+ *
+ * @param spot Spot instance
+ * @param fd file descriptor
+ * @return 0 or a negative error code
+ */
+static int fit_stream(struct Spot *spot, int fd) {
+    double buffer[READ_CHUNK_SIZE];
+    // trailing bytes of an incomplete double
+    unsigned long pending = 0;
+    // the counters and the tracker are restored if the stream cannot be read
+    unsigned long const n = spot->n;
+    unsigned long const Nt = spot->Nt;
+    struct P2 const tracker = spot->tracker;
+
+    int status = spot_fit_begin(spot, 4 * spot->tail.peaks.container.capacity);
+    if (status < 0) {
+        return status;
+    }
+
+    for (;;) {
+        ssize_t r = read(fd, (char *)buffer + pending,
+                         sizeof(buffer) - pending);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = -errno;
+            break;
+        }
+        if (r == 0) {
+            if (pending > 0) {
+                status = -EINVAL;
+            }
+            break;
+        }
+        pending += (unsigned long)r;
+        unsigned long const count = pending / sizeof(double);
+        from_little_endian(buffer, count);
+        spot_fit_feed(spot, buffer, count);
+        // keep the incomplete double for the next read
+        pending -= count * sizeof(double);
+        memmove(buffer, buffer + count, pending);
+    }
+
+    if (status < 0) {
+        // release the candidates without fitting (as a regular file that
+        // cannot be read, the Spot is left untouched)
+        ubend_free(&(spot->candidates));
+        spot->n = n;
+        spot->Nt = Nt;
+        spot->tracker = tracker;
+        return status;
+    }
+    return spot_fit_end(spot);
+}
+
+int spot_fit_file(struct Spot *spot, char const *path) {
+    struct stat st;
+    int status;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (fstat(fd, &st) < 0) {
+        status = -errno;
+        close(fd);
+        return status;
+    }
+
+    if (!S_ISREG(st.st_mode)) {
+        status = fit_stream(spot, fd);
+        close(fd);
+        return status;
+    }
+
+    unsigned long const bytes = (unsigned long)st.st_size;
+    if (bytes % sizeof(double)) {
+        close(fd);
+        return -EINVAL;
+    }
+    if (bytes == 0) {
+        close(fd);
+        return spot_fit(spot, 0x0, 0);
+    }
+
+    void *map = mmap(NULL, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    if (map == MAP_FAILED) {
+        status = -errno;
+        close(fd);
+        return status;
+    }
+    // the mapping remains valid once the file is closed
+    close(fd);
+    madvise(map, bytes, MADV_SEQUENTIAL);
+
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    // the mapping cannot be used directly
+    double buffer[READ_CHUNK_SIZE];
+    double const *data = (double const *)map;
+    unsigned long const size = bytes / sizeof(double);
+    status = spot_fit_begin(spot, 4 * spot->tail.peaks.container.capacity);
+    for (unsigned long i = 0; (status == 0) && (i < size);
+         i += READ_CHUNK_SIZE) {
+        unsigned long n =
+            (size - i > READ_CHUNK_SIZE) ? READ_CHUNK_SIZE : size - i;
+        memcpy(buffer, data + i, n * sizeof(double));
+        from_little_endian(buffer, n);
+        spot_fit_feed(spot, buffer, n);
+    }
+    if (status == 0) {
+        status = spot_fit_end(spot);
+    }
+#else
+    status = spot_fit(spot, (double const *)map, bytes / sizeof(double));
+#endif
+
+    munmap(map, bytes);
+    return status;
+}
@@ -0,0 +1,390 @@
+/**
+ * @file spot_log.c
+ * @brief Implements the checkpoint log of Spot instances (POSIX companion
+ * library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+#include "spot_log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define LOG_MAGIC "SPOTLOG1"
+#define LOG_HEADER_SIZE 8
+
+// number of words after the tag of every record
+#define EXCESS_WORDS 6
+#define REBASE_WORDS 7
+#define STATE_WORDS 23
+#define MAX_RECORD_WORDS (1 + STATE_WORDS)
+
+/**
+ * @brief Types of records (low byte of the tag, the next bytes store the
+ * number of words after the tag)
+ */
+enum RecordType {
+    /// n, Nt, excess, gamma, sigma, anomaly threshold
+    RECORD_EXCESS = 1,
+    /// n, Nt, shift of the excesses, excess threshold, gamma, sigma, anomaly
+    /// threshold
+    RECORD_REBASE = 2,
+    /// n, Nt, threshold tracker
+    RECORD_STATE = 3,
+};
+
+typedef union {
+    double d;
+    __UINT64_TYPE__ i;
+} word;
+
+static int write_all(int fd, void const *buffer, unsigned long size) {
+    unsigned char const *p = (unsigned char const *)buffer;
+    while (size > 0) {
+        ssize_t w = write(fd, p, size);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        p += w;
+        size -= (unsigned long)w;
+    }
+    return 0;
+}
+
+/**
+ * @brief Read a whole file in a new buffer (to free)
+ *
+ * @param path path of the file
+ * @param[out] buffer content of the file
+ * @param[out] size size of the file
+ * @return 0 or -errno
+ */
+static int read_all(char const *path, unsigned char **buffer,
+                    unsigned long *size) {
+    struct stat st;
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return -errno;
+    }
+    if (fstat(fd, &st) < 0) {
+        int status = -errno;
+        close(fd);
+        return status;
+    }
+    *size = (unsigned long)st.st_size;
+    // one more byte to never allocate 0 byte
+    *buffer = malloc(*size + 1);
+    if (*buffer == NULL) {
+        close(fd);
+        return -ENOMEM;
+    }
+    unsigned long done = 0;
+    while (done < *size) {
+        ssize_t r = read(fd, *buffer + done, *size - done);
+        if (r < 0 && errno == EINTR) {
+            continue;
+        }
+        if (r <= 0) {
+            // the file has been truncated meanwhile
+            break;
+        }
+        done += (unsigned long)r;
+    }
+    *size = done;
+    close(fd);
+    return 0;
+}
+
+/**
+ * @brief Write the buffered records
+ *
+ * When the write fails, the records remain buffered (the next write retries
+ * them) and the log is truncated to its former end, so that no partial
+ * record remains before the next ones.
+ */
+static int log_write(struct SpotLog *log) {
+    if (log->used == 0) {
+        return 0;
+    }
+    // the log is opened with O_APPEND: the records go to its end
+    off_t const end = lseek(log->fd, 0, SEEK_END);
+    if (end < 0) {
+        return -errno;
+    }
+    int status = write_all(log->fd, log->buffer, log->used);
+    if (status < 0) {
+        if (ftruncate(log->fd, end) < 0) {
+            // a partial record remains: a checkpoint is required
+            status = -errno;
+        }
+        return status;
+    }
+    log->used = 0;
+    return 0;
+}
+
+static int log_append(struct SpotLog *log, word const *record,
+                      unsigned long words) {
+    unsigned long const bytes = words * sizeof(word);
+    if (log->used + bytes > SPOT_LOG_BUFFER_SIZE) {
+        int status = log_write(log);
+        if (status < 0) {
+            return status;
+        }
+    }
+    memcpy(log->buffer + log->used, record, bytes);
+    log->used += bytes;
+    return 0;
+}
+
+int spot_log_open(struct SpotLog *log, char const *path) {
+    struct stat st;
+    char magic[LOG_HEADER_SIZE];
+    int status = 0;
+
+    log->used = 0;
+    log->fd = open(path, O_RDWR | O_CREAT | O_APPEND, 0644);
+    if (log->fd < 0) {
+        return -errno;
+    }
+    if (fstat(log->fd, &st) < 0) {
+        status = -errno;
+    } else if (st.st_size == 0) {
+        status = write_all(log->fd, LOG_MAGIC, LOG_HEADER_SIZE);
+    } else if ((pread(log->fd, magic, LOG_HEADER_SIZE, 0) != LOG_HEADER_SIZE) ||
+               memcmp(magic, LOG_MAGIC, LOG_HEADER_SIZE)) {
+        status = -EINVAL;
+    }
+
+    if (status < 0) {
+        close(log->fd);
+        log->fd = -1;
+    }
+    return status;
+}
+
+int spot_log_step(struct SpotLog *log, struct Spot *spot, double x) {
+    word record[MAX_RECORD_WORDS];
+    double const et = spot->excess_threshold;
+    int status = 0;
+
+    int const result = spot_step(spot, x);
+    if ((result < 0) || (result == ANOMALY)) {
+        // the state has not changed
+        return result;
+    }
+
+    if (!is_nan(et) && (spot->excess_threshold != et)) {
+        // the excess threshold has been recalibrated
+        record[0].i = RECORD_REBASE | (REBASE_WORDS << 8);
+        record[1].i = spot->n;
+        record[2].i = spot->Nt;
+        record[3].d = spot->__up_down * (spot->excess_threshold - et);
+        record[4].d = spot->excess_threshold;
+        record[5].d = spot->tail.gamma;
+        record[6].d = spot->tail.sigma;
+        record[7].d = spot->anomaly_threshold;
+        status = log_append(log, record, 1 + REBASE_WORDS);
+    }
+
+    if ((status == 0) && (result == EXCESS)) {
+        record[0].i = RECORD_EXCESS | (EXCESS_WORDS << 8);
+        record[1].i = spot->n;
+        record[2].i = spot->Nt;
+        record[3].d = spot->__up_down * (x - spot->excess_threshold);
+        record[4].d = spot->tail.gamma;
+        record[5].d = spot->tail.sigma;
+        record[6].d = spot->anomaly_threshold;
+        status = log_append(log, record, 1 + EXCESS_WORDS);
+    }
+
+    return (status < 0) ? status : result;
+}
+
+int spot_log_flush(struct SpotLog *log, struct Spot const *spot, int wait) {
+    word record[MAX_RECORD_WORDS];
+    record[0].i = RECORD_STATE | (STATE_WORDS << 8);
+    record[1].i = spot->n;
+    record[2].i = spot->Nt;
+    for (int i = 0; i < 5; ++i) {
+        record[3 + i].d = spot->tracker.q[i];
+        record[8 + i].d = spot->tracker.n[i];
+        record[13 + i].d = spot->tracker.np[i];
+        record[18 + i].d = spot->tracker.dn[i];
+    }
+    record[23].i = spot->tracker.count;
+
+    int status = log_append(log, record, 1 + STATE_WORDS);
+    if (status == 0) {
+        status = log_write(log);
+    }
+    if ((status == 0) && wait && (fsync(log->fd) < 0)) {
+        status = -errno;
+    }
+    return status;
+}
+
+int spot_log_checkpoint(struct SpotLog *log, struct Spot const *spot,
+                        char const *path) {
+    // keep the records until the snapshot is written
+    int status = log_write(log);
+    if (status < 0) {
+        return status;
+    }
+
+    unsigned long const size = spot_serialized_size(spot);
+    unsigned long const length = strlen(path);
+    unsigned char *buffer = malloc(size);
+    char *tmp = malloc(length + 5);
+    if ((buffer == NULL) || (tmp == NULL)) {
+        free(buffer);
+        free(tmp);
+        return -ENOMEM;
+    }
+    spot_serialize(spot, buffer, size);
+    snprintf(tmp, length + 5, "%s.tmp", path);
+
+    int fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        status = -errno;
+    } else {
+        status = write_all(fd, buffer, size);
+        if ((status == 0) && (fsync(fd) < 0)) {
+            status = -errno;
+        }
+        close(fd);
+    }
+    // the former snapshot is replaced at once
+    if ((status == 0) && (rename(tmp, path) < 0)) {
+        status = -errno;
+    }
+    if (status < 0) {
+        unlink(tmp);
+    }
+    free(buffer);
+    free(tmp);
+
+    // the log restarts from the snapshot
+    if ((status == 0) && (ftruncate(log->fd, LOG_HEADER_SIZE) < 0)) {
+        status = -errno;
+    }
+    return status;
+}
+
+/**
+ * @brief Apply a record
+ *
+ * @param spot Spot instance
+ * @param type type of the record
+ * @param r words after the tag
+ */
+static void replay(struct Spot *spot, unsigned long type, word const *r) {
+    spot->n = (unsigned long)r[0].i;
+    spot->Nt = (unsigned long)r[1].i;
+    switch (type) {
+    case RECORD_EXCESS:
+        tail_push(&(spot->tail), r[2].d);
+        spot->tail.gamma = r[3].d;
+        spot->tail.sigma = r[4].d;
+        spot->anomaly_threshold = r[5].d;
+        break;
+    case RECORD_REBASE:
+        tail_shift(&(spot->tail), r[2].d);
+        spot->excess_threshold = r[3].d;
+        spot->tail.gamma = r[4].d;
+        spot->tail.sigma = r[5].d;
+        spot->anomaly_threshold = r[6].d;
+        break;
+    case RECORD_STATE:
+        for (int i = 0; i < 5; ++i) {
+            spot->tracker.q[i] = r[2 + i].d;
+            spot->tracker.n[i] = r[7 + i].d;
+            spot->tracker.np[i] = r[12 + i].d;
+            spot->tracker.dn[i] = r[17 + i].d;
+        }
+        spot->tracker.count = (unsigned long)r[22].i;
+        break;
+    }
+}
+
+int spot_log_restore(struct Spot *spot, char const *snapshot,
+                     char const *path) {
+    static unsigned long const words[] = {0, EXCESS_WORDS, REBASE_WORDS,
+                                          STATE_WORDS};
+    unsigned char *buffer;
+    unsigned long size;
+
+    int status = read_all(snapshot, &buffer, &size);
+    if (status < 0) {
+        return status;
+    }
+    status = spot_deserialize(spot, buffer, size);
+    free(buffer);
+    if (status < 0) {
+        return status;
+    }
+
+    status = read_all(path, &buffer, &size);
+    if (status == -ENOENT) {
+        // nothing has been logged
+        return 0;
+    }
+    if (status < 0) {
+        spot_free(spot);
+        return status;
+    }
+    if ((size < LOG_HEADER_SIZE) ||
+        memcmp(buffer, LOG_MAGIC, LOG_HEADER_SIZE)) {
+        free(buffer);
+        spot_free(spot);
+        return -EINVAL;
+    }
+
+    // the records already included in the snapshot are skipped (the log
+    // may not have been emptied after the last snapshot)
+    unsigned long const n = spot->n;
+    word record[MAX_RECORD_WORDS];
+    unsigned long pos = LOG_HEADER_SIZE;
+    while (pos + sizeof(word) <= size) {
+        memcpy(record, buffer + pos, sizeof(word));
+        unsigned long const type = (unsigned long)(record[0].i & 0xff);
+        unsigned long const count = (unsigned long)(record[0].i >> 8);
+        if ((type < RECORD_EXCESS) || (type > RECORD_STATE) ||
+            (count != words[type])) {
+            status = -EINVAL;
+            break;
+        }
+        if (pos + (1 + count) * sizeof(word) > size) {
+            // interrupted write
+            break;
+        }
+        memcpy(record, buffer + pos, (1 + count) * sizeof(word));
+        if (record[1].i > n) {
+            replay(spot, type, record + 1);
+        }
+        pos += (1 + count) * sizeof(word);
+    }
+    free(buffer);
+
+    if (status < 0) {
+        spot_free(spot);
+    }
+    return status;
+}
+
+int spot_log_close(struct SpotLog *log, struct Spot const *spot) {
+    int status = spot_log_flush(log, spot, 0);
+    close(log->fd);
+    log->fd = -1;
+    return status;
+}
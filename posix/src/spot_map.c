@@ -0,0 +1,731 @@
+/**
+ * @file spot_map.c
+ * @brief Implements the keyed map of Spot instances (POSIX companion
+ * library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+#include "spot_map.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// entries are aligned on cache lines
+#define ENTRY_ALIGNMENT 64
+// entries allocated at once
+#define CHUNK_ENTRIES 64
+#define TABLE_CAPACITY 64
+
+/**
+ * @brief Beginning of an entry (it is followed by the warm-up values, then
+ * by the excess ring once fitted, except in tiered mode)
+ *
+ * The slots of the spill file have the same layout.
+ */
+struct SpotMapEntry {
+    __UINT64_TYPE__ id;
+    /// LRU list (older is also the link of the free list)
+    struct SpotMapEntry *newer;
+    struct SpotMapEntry *older;
+    /// number of buffered warm-up values (warmup once fitted)
+    unsigned long count;
+    /// tiered mode: slot of the spill file + 1 (from the creation)
+    unsigned long slot;
+    /// tiered mode: cached excess ring (NULL if not resident)
+    struct SpotMapBuffer *buffer;
+    struct Spot spot;
+};
+
+/**
+ * @brief Beginning of a cached excess ring (it is followed by the values)
+ */
+struct SpotMapBuffer {
+    /// entry of the ring (NULL = free buffer)
+    struct SpotMapEntry *owner;
+    /// the ring must be written back
+    int dirty;
+    /// second chance of the clock
+    int used;
+};
+
+static double *entry_data(struct SpotMapEntry *entry) {
+    return (double *)(entry + 1);
+}
+
+static double *buffer_data(struct SpotMapBuffer *buffer) {
+    return (double *)(buffer + 1);
+}
+
+static struct SpotMapBuffer *buffer_at(struct SpotMap const *map,
+                                       unsigned long index) {
+    return (struct SpotMapBuffer *)((unsigned char *)map->buffers +
+                                    index * map->buffer_size);
+}
+
+/**
+ * @brief Return the number of values of the ring of an entry
+ */
+static unsigned long entry_values(struct SpotMap const *map,
+                                  struct SpotMapEntry const *entry) {
+    return (entry->count < map->warmup) ? entry->count : map->max_excess;
+}
+
+static unsigned long align(unsigned long size) {
+    return (size + ENTRY_ALIGNMENT - 1) & ~(unsigned long)(ENTRY_ALIGNMENT - 1);
+}
+
+static unsigned long mix(__UINT64_TYPE__ id) {
+    // splitmix64 finalizer: sequential ids are spread over the table
+    id ^= id >> 30;
+    id *= 0xbf58476d1ce4e5b9ULL;
+    id ^= id >> 27;
+    id *= 0x94d049bb133111ebULL;
+    id ^= id >> 31;
+    return (unsigned long)id;
+}
+
+// Tables ----------------------------------------------------------------------
+
+static int table_init(struct SpotMapTable *table, unsigned long capacity) {
+    table->buckets = calloc(capacity, sizeof(struct SpotMapBucket));
+    table->capacity = capacity;
+    table->size = 0;
+    return table->buckets ? 0 : -ENOMEM;
+}
+
+/**
+ * @brief Return the bucket of an id, or the empty bucket where it would be
+ * inserted
+ */
+static struct SpotMapBucket *table_probe(struct SpotMapTable const *table,
+                                         __UINT64_TYPE__ id) {
+    unsigned long const mask = table->capacity - 1;
+    unsigned long j = mix(id) & mask;
+    while (table->buckets[j].value && (table->buckets[j].id != id)) {
+        j = (j + 1) & mask;
+    }
+    return table->buckets + j;
+}
+
+static int table_insert(struct SpotMapTable *table, __UINT64_TYPE__ id,
+                        unsigned long value) {
+    // the load factor remains below 1/2
+    if (2 * (table->size + 1) > table->capacity) {
+        struct SpotMapTable grown;
+        if (table_init(&grown, 2 * table->capacity) < 0) {
+            return -ENOMEM;
+        }
+        for (unsigned long i = 0; i < table->capacity; ++i) {
+            if (table->buckets[i].value) {
+                *table_probe(&grown, table->buckets[i].id) =
+                    table->buckets[i];
+            }
+        }
+        grown.size = table->size;
+        free(table->buckets);
+        *table = grown;
+    }
+    struct SpotMapBucket *bucket = table_probe(table, id);
+    bucket->id = id;
+    bucket->value = value;
+    table->size++;
+    return 0;
+}
+
+static void table_erase(struct SpotMapTable *table,
+                        struct SpotMapBucket *bucket) {
+    // backward shift: the next buckets of the cluster fill the hole when
+    // their home is not after it
+    struct SpotMapBucket *buckets = table->buckets;
+    unsigned long const mask = table->capacity - 1;
+    unsigned long i = (unsigned long)(bucket - buckets);
+    for (unsigned long j = (i + 1) & mask; buckets[j].value;
+         j = (j + 1) & mask) {
+        unsigned long const home = mix(buckets[j].id) & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            buckets[i] = buckets[j];
+            i = j;
+        }
+    }
+    buckets[i].value = 0;
+    table->size--;
+}
+
+// LRU list ------------------------------------------------------------------
+
+static void lru_unlink(struct SpotMap *map, struct SpotMapEntry *entry) {
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        map->newest = entry->older;
+    }
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        map->oldest = entry->newer;
+    }
+}
+
+static void lru_push(struct SpotMap *map, struct SpotMapEntry *entry) {
+    entry->newer = NULL;
+    entry->older = map->newest;
+    if (map->newest) {
+        map->newest->newer = entry;
+    } else {
+        map->oldest = entry;
+    }
+    map->newest = entry;
+}
+
+// Spill file ----------------------------------------------------------------
+
+static int write_all(int fd, void const *buffer, unsigned long size,
+                     off_t offset) {
+    unsigned char const *p = (unsigned char const *)buffer;
+    while (size > 0) {
+        ssize_t w = pwrite(fd, p, size, offset);
+        if (w < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        p += w;
+        size -= (unsigned long)w;
+        offset += w;
+    }
+    return 0;
+}
+
+static int read_all(int fd, void *buffer, unsigned long size, off_t offset) {
+    unsigned char *p = (unsigned char *)buffer;
+    while (size > 0) {
+        ssize_t r = pread(fd, p, size, offset);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return -errno;
+        }
+        if (r == 0) {
+            return -EIO;
+        }
+        p += r;
+        size -= (unsigned long)r;
+        offset += r;
+    }
+    return 0;
+}
+
+static off_t slot_offset(struct SpotMap const *map, unsigned long slot) {
+    return (off_t)slot * (off_t)map->slot_size;
+}
+
+static int spill_alloc(struct SpotMap *map, unsigned long *slot) {
+    if (map->spill_free_count > 0) {
+        *slot = map->spill_free[--map->spill_free_count];
+        return 0;
+    }
+    // the list of free slots can hold all the slots of the file
+    if (map->spill_slots == map->spill_free_capacity) {
+        unsigned long const capacity = 2 * map->spill_free_capacity;
+        unsigned long *list =
+            realloc(map->spill_free, capacity * sizeof(unsigned long));
+        if (list == NULL) {
+            return -ENOMEM;
+        }
+        map->spill_free = list;
+        map->spill_free_capacity = capacity;
+    }
+    *slot = map->spill_slots++;
+    return 0;
+}
+
+static void spill_release(struct SpotMap *map, unsigned long slot) {
+    map->spill_free[map->spill_free_count++] = slot;
+}
+
+/**
+ * @brief Write the cached ring of an entry back (if modified) and release
+ * its buffer
+ */
+static int buffer_flush(struct SpotMap *map, struct SpotMapBuffer *buffer) {
+    struct SpotMapEntry *entry = buffer->owner;
+    int status = 0;
+    if (buffer->dirty) {
+        status = write_all(map->spill_fd, buffer_data(buffer),
+                           entry_values(map, entry) * sizeof(double),
+                           slot_offset(map, entry->slot - 1) +
+                               (off_t)sizeof(struct SpotMapEntry));
+    }
+    entry->buffer = NULL;
+    entry->spot.tail.peaks.container.data = 0x0;
+    buffer->owner = NULL;
+    return status;
+}
+
+/**
+ * @brief Make the ring of an entry resident (tiered mode)
+ */
+static int entry_attach(struct SpotMap *map, struct SpotMapEntry *entry) {
+    if (entry->buffer) {
+        entry->buffer->used = 1;
+        return 0;
+    }
+
+    // clock: the recently used buffers get a second chance
+    struct SpotMapBuffer *buffer;
+    for (;;) {
+        buffer = buffer_at(map, map->buffer_hand);
+        map->buffer_hand = (map->buffer_hand + 1) % map->buffer_count;
+        if ((buffer->owner == NULL) || !buffer->used) {
+            break;
+        }
+        buffer->used = 0;
+    }
+    int status = buffer->owner ? buffer_flush(map, buffer) : 0;
+    unsigned long const values = entry_values(map, entry);
+    if ((status == 0) && (values > 0)) {
+        status = read_all(map->spill_fd, buffer_data(buffer),
+                          values * sizeof(double),
+                          slot_offset(map, entry->slot - 1) +
+                              (off_t)sizeof(struct SpotMapEntry));
+        map->reads++;
+    }
+    if (status < 0) {
+        return status;
+    }
+
+    buffer->owner = entry;
+    buffer->dirty = 0;
+    buffer->used = 1;
+    entry->buffer = buffer;
+    entry->spot.tail.peaks.container.data = buffer_data(buffer);
+    return 0;
+}
+
+static int spill_write(struct SpotMap *map, struct SpotMapEntry *entry) {
+    unsigned long slot;
+    int status;
+    if (map->buffers) {
+        // tiered mode: the ring already has its place in the file
+        slot = entry->slot - 1;
+        status = entry->buffer ? buffer_flush(map, entry->buffer) : 0;
+        if (status == 0) {
+            status = write_all(map->spill_fd, entry,
+                               sizeof(struct SpotMapEntry),
+                               slot_offset(map, slot));
+        }
+        if (status == 0) {
+            status = table_insert(&(map->spilled), entry->id, slot + 1);
+        }
+        return status;
+    }
+
+    status = spill_alloc(map, &slot);
+    if (status < 0) {
+        return status;
+    }
+    status = write_all(map->spill_fd, entry, map->entry_size,
+                       slot_offset(map, slot));
+    if (status == 0) {
+        status = table_insert(&(map->spilled), entry->id, slot + 1);
+    }
+    if (status < 0) {
+        spill_release(map, slot);
+    }
+    return status;
+}
+
+// Entries -------------------------------------------------------------------
+
+static int entry_alloc(struct SpotMap *map, struct SpotMapEntry **entry) {
+    if ((map->free_entries == NULL) &&
+        ((map->max_entries == 0) || (map->entries < map->max_entries))) {
+        unsigned long count = CHUNK_ENTRIES;
+        if (map->max_entries && (map->entries + count > map->max_entries)) {
+            count = map->max_entries - map->entries;
+        }
+        void **chunks =
+            realloc(map->chunks, (map->chunk_count + 1) * sizeof(void *));
+        if (chunks == NULL) {
+            return -ENOMEM;
+        }
+        map->chunks = chunks;
+        void *block;
+        if (posix_memalign(&block, ENTRY_ALIGNMENT,
+                           count * map->entry_size) != 0) {
+            return -ENOMEM;
+        }
+        map->chunks[map->chunk_count++] = block;
+        for (unsigned long i = count; i-- > 0;) {
+            struct SpotMapEntry *e =
+                (struct SpotMapEntry *)((unsigned char *)block +
+                                        i * map->entry_size);
+            e->older = map->free_entries;
+            map->free_entries = e;
+        }
+        map->entries += count;
+    }
+
+    if (map->free_entries) {
+        *entry = map->free_entries;
+        map->free_entries = (*entry)->older;
+        return 0;
+    }
+
+    // memory cap: the least recently used entry is evicted
+    struct SpotMapEntry *oldest = map->oldest;
+    if (oldest == NULL) {
+        return -ENOMEM;
+    }
+    if (map->spill_fd >= 0) {
+        int status = spill_write(map, oldest);
+        if (status < 0) {
+            return status;
+        }
+    }
+    table_erase(&(map->table), table_probe(&(map->table), oldest->id));
+    lru_unlink(map, oldest);
+    map->evictions++;
+    map->evicted = oldest->id;
+    *entry = oldest;
+    return 0;
+}
+
+static void entry_release(struct SpotMap *map, struct SpotMapEntry *entry) {
+    if (entry->buffer) {
+        entry->buffer->owner = NULL;
+        entry->buffer = NULL;
+    }
+    if (entry->slot) {
+        spill_release(map, entry->slot - 1);
+        entry->slot = 0;
+    }
+    entry->older = map->free_entries;
+    map->free_entries = entry;
+}
+
+/**
+ * @brief Make a series resident (read back from the spill file or new)
+ */
+static int entry_load(struct SpotMap *map, __UINT64_TYPE__ id,
+                      struct SpotMapEntry **entry) {
+    unsigned long slot = 0;
+    if (map->spill_fd >= 0) {
+        struct SpotMapBucket *bucket = table_probe(&(map->spilled), id);
+        if (bucket->value) {
+            slot = bucket->value;
+            table_erase(&(map->spilled), bucket);
+        }
+    }
+
+    struct SpotMapEntry *e;
+    int status = entry_alloc(map, &e);
+    if (status < 0) {
+        if (slot) {
+            // keep the spilled detector
+            table_insert(&(map->spilled), id, slot);
+        }
+        return status;
+    }
+
+    if (slot) {
+        // in tiered mode, only the Spot structure is read back
+        unsigned long const size =
+            map->buffers ? sizeof(struct SpotMapEntry) : map->entry_size;
+        status = read_all(map->spill_fd, e, size, slot_offset(map, slot - 1));
+        e->buffer = NULL;
+        if (map->buffers) {
+            e->slot = slot;
+            e->spot.tail.peaks.container.data = 0x0;
+        } else {
+            e->slot = 0;
+            e->spot.tail.peaks.container.data = entry_data(e);
+            spill_release(map, slot - 1);
+        }
+    } else {
+        e->id = id;
+        e->count = 0;
+        e->slot = 0;
+        e->buffer = NULL;
+        if (map->buffers && ((status = spill_alloc(map, &slot)) == 0)) {
+            e->slot = slot + 1;
+        }
+    }
+    if (status == 0) {
+        status = table_insert(&(map->table), id, (unsigned long)e);
+    }
+    if (status < 0) {
+        // the detector is lost
+        entry_release(map, e);
+        return status;
+    }
+    lru_push(map, e);
+    *entry = e;
+    return 0;
+}
+
+static void entry_fit(struct SpotMap *map, struct SpotMapEntry *entry,
+                      double *data) {
+    // the excess ring takes the place of the warm-up values
+    memcpy(map->scratch, data, map->warmup * sizeof(double));
+    entry->spot = map->prototype;
+    entry->spot.tail.peaks.container.data = data;
+    if (spot_fit(&(entry->spot), map->scratch, map->warmup) < 0) {
+        // new warm-up
+        entry->count = 0;
+    }
+}
+
+// API -----------------------------------------------------------------------
+
+int spot_map_init(struct SpotMap *map, double q, int low,
+                  int discard_anomalies, double level,
+                  unsigned long max_excess, unsigned long warmup,
+                  unsigned long memory) {
+    int status = spot_init(&(map->prototype), q, low, discard_anomalies,
+                           level, max_excess);
+    if (status < 0) {
+        return status;
+    }
+    // the excess rings live in the entries
+    xfree(map->prototype.tail.peaks.container.data);
+    map->prototype.tail.peaks.container.data = 0x0;
+
+    unsigned long const values = (warmup > max_excess) ? warmup : max_excess;
+    map->entry_size = align(sizeof(struct SpotMapEntry) + values * sizeof(double));
+    map->slot_size = map->entry_size;
+    map->max_entries = memory / map->entry_size;
+    if ((warmup == 0) || (memory && (map->max_entries == 0))) {
+        return -EINVAL;
+    }
+
+    map->q = q;
+    map->level = level;
+    map->low = low;
+    map->discard_anomalies = discard_anomalies;
+    map->max_excess = max_excess;
+    map->warmup = warmup;
+    map->memory = memory;
+    map->entries = 0;
+    map->free_entries = NULL;
+    map->newest = NULL;
+    map->oldest = NULL;
+    map->chunks = NULL;
+    map->chunk_count = 0;
+    map->spill_fd = -1;
+    map->spill_slots = 0;
+    map->spill_free_count = 0;
+    map->spill_free_capacity = TABLE_CAPACITY;
+    map->buffers = NULL;
+    map->buffer_count = 0;
+    map->buffer_size = 0;
+    map->buffer_hand = 0;
+    map->evictions = 0;
+    map->evicted = 0;
+    map->reads = 0;
+
+    map->scratch = malloc(warmup * sizeof(double));
+    map->spill_free = malloc(TABLE_CAPACITY * sizeof(unsigned long));
+    int const t = table_init(&(map->table), TABLE_CAPACITY);
+    int const s = table_init(&(map->spilled), TABLE_CAPACITY);
+    if ((map->scratch == NULL) || (map->spill_free == NULL) || (t < 0) ||
+        (s < 0)) {
+        spot_map_free(map);
+        return -ENOMEM;
+    }
+    return 0;
+}
+
+int spot_map_spill(struct SpotMap *map, char const *path) {
+    if (map->spill_fd >= 0) {
+        return -EBUSY;
+    }
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -errno;
+    }
+    map->spill_fd = fd;
+    return 0;
+}
+
+int spot_map_tier(struct SpotMap *map, char const *path,
+                  unsigned long buffers) {
+    if ((map->spill_fd >= 0) || (map->entries > 0)) {
+        return -EBUSY;
+    }
+    if (buffers == 0) {
+        return -EINVAL;
+    }
+
+    // the slots of the file keep the whole entries
+    unsigned long const values =
+        (map->warmup > map->max_excess) ? map->warmup : map->max_excess;
+    map->entry_size = align(sizeof(struct SpotMapEntry));
+    map->max_entries = map->memory / map->entry_size;
+    map->buffer_size =
+        align(sizeof(struct SpotMapBuffer) + values * sizeof(double));
+    void *cache;
+    if (posix_memalign(&cache, ENTRY_ALIGNMENT, buffers * map->buffer_size) !=
+        0) {
+        return -ENOMEM;
+    }
+    map->buffers = (struct SpotMapBuffer *)cache;
+    map->buffer_count = buffers;
+    for (unsigned long i = 0; i < buffers; ++i) {
+        buffer_at(map, i)->owner = NULL;
+        buffer_at(map, i)->used = 0;
+    }
+
+    int status = spot_map_spill(map, path);
+    if (status < 0) {
+        free(map->buffers);
+        map->buffers = NULL;
+        map->buffer_count = 0;
+    }
+    return status;
+}
+
+/**
+ * @brief Check whether a step reaches the excess ring (see spot_step)
+ */
+static int spot_uses_ring(struct Spot const *spot, double x) {
+    if (!isnan(spot->rebase_tolerance)) {
+        // a recalibration shifts the ring
+        return 1;
+    }
+    if (spot->discard_anomalies &&
+        (spot->__up_down * (x - spot->anomaly_threshold) > 0)) {
+        return 0;
+    }
+    return spot->__up_down * (x - spot->excess_threshold) >= 0.0;
+}
+
+int spot_map_step(struct SpotMap *map, __UINT64_TYPE__ id, double x,
+                  double *threshold) {
+    if (isnan(x)) {
+        return -ERR_DATA_IS_NAN;
+    }
+
+    struct SpotMapEntry *entry;
+    struct SpotMapBucket *bucket = table_probe(&(map->table), id);
+    if (bucket->value) {
+        entry = (struct SpotMapEntry *)bucket->value;
+        if (map->newest != entry) {
+            lru_unlink(map, entry);
+            lru_push(map, entry);
+        }
+    } else {
+        int status = entry_load(map, id, &entry);
+        if (status < 0) {
+            return status;
+        }
+    }
+
+    if (entry->count < map->warmup) {
+        if (threshold) {
+            *threshold = NAN;
+        }
+        double *data = entry_data(entry);
+        if (map->buffers && (entry->buffer == NULL) &&
+            (entry->count + 1 < map->warmup)) {
+            // the value is appended to the file, without reading the others
+            int status = write_all(map->spill_fd, &x, sizeof(double),
+                                   slot_offset(map, entry->slot - 1) +
+                                       (off_t)sizeof(struct SpotMapEntry) +
+                                       (off_t)(entry->count * sizeof(double)));
+            if (status == 0) {
+                entry->count++;
+                status = SPOT_MAP_WARMUP;
+            }
+            return status;
+        }
+        if (map->buffers) {
+            int status = entry_attach(map, entry);
+            if (status < 0) {
+                return status;
+            }
+            data = buffer_data(entry->buffer);
+            entry->buffer->dirty = 1;
+        }
+        data[entry->count++] = x;
+        if (entry->count == map->warmup) {
+            entry_fit(map, entry, data);
+        }
+        return SPOT_MAP_WARMUP;
+    }
+    if (threshold) {
+        *threshold = entry->spot.anomaly_threshold;
+    }
+    if (map->buffers && spot_uses_ring(&(entry->spot), x)) {
+        // the ring is read back only for the excesses
+        int status = entry_attach(map, entry);
+        if (status < 0) {
+            return status;
+        }
+        entry->buffer->dirty = 1;
+    }
+    return spot_step(&(entry->spot), x);
+}
+
+struct Spot *spot_map_get(struct SpotMap *map, __UINT64_TYPE__ id) {
+    struct SpotMapBucket *bucket = table_probe(&(map->table), id);
+    if (bucket->value == 0) {
+        return NULL;
+    }
+    struct SpotMapEntry *entry = (struct SpotMapEntry *)bucket->value;
+    return (entry->count < map->warmup) ? NULL : &(entry->spot);
+}
+
+int spot_map_remove(struct SpotMap *map, __UINT64_TYPE__ id) {
+    struct SpotMapBucket *bucket = table_probe(&(map->table), id);
+    if (bucket->value) {
+        struct SpotMapEntry *entry = (struct SpotMapEntry *)bucket->value;
+        table_erase(&(map->table), bucket);
+        lru_unlink(map, entry);
+        entry_release(map, entry);
+        return 0;
+    }
+    bucket = table_probe(&(map->spilled), id);
+    if (bucket->value) {
+        spill_release(map, bucket->value - 1);
+        table_erase(&(map->spilled), bucket);
+        return 0;
+    }
+    return -ENOENT;
+}
+
+unsigned long spot_map_size(struct SpotMap const *map) {
+    return map->table.size + map->spilled.size;
+}
+
+void spot_map_free(struct SpotMap *map) {
+    for (unsigned long i = 0; i < map->chunk_count; ++i) {
+        free(map->chunks[i]);
+    }
+    free(map->chunks);
+    free(map->table.buckets);
+    free(map->spilled.buckets);
+    free(map->scratch);
+    free(map->spill_free);
+    free(map->buffers);
+    map->chunks = NULL;
+    map->chunk_count = 0;
+    map->table.buckets = NULL;
+    map->spilled.buckets = NULL;
+    map->scratch = NULL;
+    map->spill_free = NULL;
+    map->buffers = NULL;
+    map->buffer_count = 0;
+    if (map->spill_fd >= 0) {
+        close(map->spill_fd);
+        map->spill_fd = -1;
+    }
+}
@@ -0,0 +1,283 @@
+/**
+ * @file spot_parse.c
+ * @brief Implements the parsers of text streams (POSIX companion library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+#include "spot_parse.h"
+#include <float.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// the exact conversion needs double precision arithmetic (no x87)
+#if defined(FLT_EVAL_METHOD) && (FLT_EVAL_METHOD == 0)
+#define FAST_PATH 1
+#else
+#define FAST_PATH 0
+#endif
+
+// powers of 10 that are exactly representable
+static double const POW10[] = {1e0,  1e1,  1e2,  1e3,  1e4,  1e5,
+                               1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                               1e12, 1e13, 1e14, 1e15, 1e16, 1e17,
+                               1e18, 1e19, 1e20, 1e21, 1e22};
+
+// longest number passed to strtod
+#define MAX_TOKEN 128
+
+#if defined(__SIZEOF_INT128__)
+#define WIDE_PATH 1
+__extension__ typedef unsigned __int128 u128;
+
+// highest power of 5 that fits in 64 bits
+#define MAX_POW5 27
+
+/**
+ * @brief Round m * 2^e2 to the nearest double (ties to even)
+ *
+ * @param m non-zero integer
+ * @param e2 binary exponent
+ * @param sticky 1 if m has been truncated (the exact value is a bit larger)
+ * @return the correctly rounded double
+ */
+static double round_to_double(u128 m, int e2, int sticky) {
+    __UINT64_TYPE__ const high = (__UINT64_TYPE__)(m >> 64);
+    int const bits = high ? 128 - __builtin_clzll(high)
+                          : 64 - __builtin_clzll((__UINT64_TYPE__)m);
+    __UINT64_TYPE__ mantissa;
+    if (bits > 53) {
+        int const shift = bits - 53;
+        u128 const rest = m & ((((u128)1) << shift) - 1);
+        u128 const half = ((u128)1) << (shift - 1);
+        mantissa = (__UINT64_TYPE__)(m >> shift);
+        if ((rest > half) || ((rest == half) && (sticky || (mantissa & 1)))) {
+            mantissa++;
+        }
+        e2 += shift;
+        if (mantissa >> 53) {
+            mantissa >>= 1;
+            e2++;
+        }
+    } else {
+        mantissa = (__UINT64_TYPE__)m << (53 - bits);
+        e2 -= 53 - bits;
+    }
+    // the results are normal numbers (|exponent10| <= 27)
+    union {
+        double d;
+        __UINT64_TYPE__ i;
+    } u;
+    u.i = ((__UINT64_TYPE__)(e2 + 52 + 1023) << 52) |
+          (mantissa & ((((__UINT64_TYPE__)1) << 52) - 1));
+    return u.d;
+}
+
+/**
+ * @brief Exact conversion of mantissa * 10^exponent with 128-bit integers
+ * (the mantissa is not zero and |exponent| <= MAX_POW5)
+ */
+static double wide_convert(__UINT64_TYPE__ mantissa, long exponent) {
+    __UINT64_TYPE__ pow5 = 1;
+    for (long k = (exponent < 0) ? -exponent : exponent; k > 0; --k) {
+        pow5 *= 5;
+    }
+    if (exponent >= 0) {
+        // exact product
+        return round_to_double((u128)mantissa * pow5, (int)exponent, 0);
+    }
+    // normalize the mantissa so that the quotient has at least 64 bits
+    int const shift = __builtin_clzll(mantissa);
+    mantissa <<= shift;
+    u128 const numerator = ((u128)mantissa) << 64;
+    u128 const quotient = numerator / pow5;
+    return round_to_double(quotient, (int)exponent - 64 - shift,
+                           (numerator % pow5) != 0);
+}
+#else
+#define WIDE_PATH 0
+#endif
+
+/**
+ * @brief Find the first occurrence of c or of a newline
+ *
+ * @return the position of the character, end if there is none
+ */
+static char const *scan(char const *p, char const *end, char c) {
+#if defined(__SSE2__)
+    __m128i const vc = _mm_set1_epi8(c);
+    __m128i const vn = _mm_set1_epi8('\n');
+    for (; end - p >= 16; p += 16) {
+        __m128i const b = _mm_loadu_si128((__m128i const *)p);
+        int const mask = _mm_movemask_epi8(
+            _mm_or_si128(_mm_cmpeq_epi8(b, vc), _mm_cmpeq_epi8(b, vn)));
+        if (mask) {
+            return p + __builtin_ctz((unsigned int)mask);
+        }
+    }
+#endif
+    for (; p < end; ++p) {
+        if ((*p == c) || (*p == '\n')) {
+            return p;
+        }
+    }
+    return end;
+}
+
+/**
+ * @brief Convert with strtod (the text is copied to be null-terminated)
+ */
+static char const *slow_parse(char const *begin, char const *end,
+                              double *value) {
+    char token[MAX_TOKEN];
+    size_t length = (size_t)(end - begin);
+    if (length >= MAX_TOKEN) {
+        length = MAX_TOKEN - 1;
+    }
+    memcpy(token, begin, length);
+    token[length] = '\0';
+
+    char *stop;
+    *value = strtod(token, &stop);
+    return begin + (stop - token);
+}
+
+char const *spot_parse_double(char const *begin, char const *end,
+                              double *value) {
+    char const *p = begin;
+    int negative = 0;
+    __UINT64_TYPE__ mantissa = 0;
+    int digits = 0;
+    long exponent = 0;
+
+    if ((p < end) && ((*p == '-') || (*p == '+'))) {
+        negative = (*p == '-');
+        ++p;
+    }
+    char const *const start = p;
+    // integer part
+    for (; (p < end) && ((unsigned char)(*p - '0') < 10); ++p) {
+        if ((digits > 0) || (*p != '0')) {
+            mantissa = 10 * mantissa + (__UINT64_TYPE__)(*p - '0');
+            digits++;
+        }
+    }
+    // fractional part
+    if ((p < end) && (*p == '.')) {
+        ++p;
+        for (; (p < end) && ((unsigned char)(*p - '0') < 10); ++p) {
+            if ((digits > 0) || (*p != '0')) {
+                mantissa = 10 * mantissa + (__UINT64_TYPE__)(*p - '0');
+                digits++;
+            }
+            exponent--;
+        }
+    }
+    if ((p == start) || ((p == start + 1) && (*start == '.')) ||
+        ((p < end) && ((*p == 'x') || (*p == 'X')))) {
+        // no digit (nan, inf... or no number at all) or hexadecimal
+        return slow_parse(begin, end, value);
+    }
+    // exponent
+    if ((p < end) && ((*p == 'e') || (*p == 'E'))) {
+        char const *e = p + 1;
+        int eneg = 0;
+        long ev = 0;
+        if ((e < end) && ((*e == '-') || (*e == '+'))) {
+            eneg = (*e == '-');
+            ++e;
+        }
+        if ((e < end) && ((unsigned char)(*e - '0') < 10)) {
+            for (; (e < end) && ((unsigned char)(*e - '0') < 10); ++e) {
+                if (ev < 100000) {
+                    ev = 10 * ev + (*e - '0');
+                }
+            }
+            exponent += eneg ? -ev : ev;
+            p = e;
+        }
+    }
+
+    // Clinger's fast path: both the mantissa and the power of 10 are exact
+    // so the correctly rounded operation gives the correctly rounded result
+    if (FAST_PATH && (digits <= 19) &&
+        (mantissa <= ((__UINT64_TYPE__)1 << 53)) && (exponent >= -22) &&
+        (exponent <= 22)) {
+        double x = (double)mantissa;
+        x = (exponent < 0) ? x / POW10[-exponent] : x * POW10[exponent];
+        *value = negative ? -x : x;
+        return p;
+    }
+#if WIDE_PATH
+    // longer mantissas (like %.17g outputs) with a small exponent
+    if ((digits <= 19) && (mantissa > 0) && (exponent >= -MAX_POW5) &&
+        (exponent <= MAX_POW5)) {
+        double const x = wide_convert(mantissa, exponent);
+        *value = negative ? -x : x;
+        return p;
+    }
+#endif
+    if ((p < end) && ((*p == ',') || (*p == ';') || (*p == ' ') ||
+                      (*p == '\t') || (*p == '\n') || (*p == '\r'))) {
+        // strtod stops at this terminator: no need to copy the number
+        char *stop;
+        *value = strtod(begin, &stop);
+        return stop;
+    }
+    return slow_parse(begin, end, value);
+}
+
+char const *spot_parse_column(char const *begin, char const *end, int last,
+                              char delimiter, unsigned long column,
+                              double *values, unsigned long capacity,
+                              unsigned long *count) {
+    char const *p = begin;
+    unsigned long n = 0;
+
+    while ((p < end) && (n < capacity)) {
+        // go to the column
+        char const *field = p;
+        unsigned long c = 0;
+        for (; c < column; ++c) {
+            field = scan(field, end, delimiter);
+            if ((field == end) || (*field == '\n')) {
+                break;
+            }
+            field++;
+        }
+        char const *eol = field;
+        if (c == column) {
+            while ((field < end) && ((*field == ' ') || (*field == '\t'))) {
+                field++;
+            }
+            // the number ends at the delimiter (or the newline)
+            char const *fend = scan(field, end, delimiter);
+            double x;
+            char const *stop = spot_parse_double(field, fend, &x);
+            eol = (fend < end && *fend == '\n')
+                      ? fend
+                      : (char const *)memchr(fend, '\n', (size_t)(end - fend));
+            if ((eol == NULL) && !last) {
+                // incomplete line
+                break;
+            }
+            if (stop != field) {
+                values[n++] = x;
+            }
+        } else if ((eol == end) && !last) {
+            break;
+        }
+        if (eol == NULL) {
+            eol = end;
+        }
+        p = (eol < end) ? eol + 1 : end;
+    }
+    *count = n;
+    return p;
+}
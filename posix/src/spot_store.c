@@ -0,0 +1,236 @@
+/**
+ * @file spot_store.c
+ * @brief Implements the file-backed store of Spot instances (POSIX companion
+ * library)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ */
+#include "spot_store.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#define STORE_MAGIC "SPOTSTOR"
+#define STORE_VERSION 1
+// the slots start at the second page
+#define STORE_HEADER_SIZE 4096
+// slots are aligned on cache lines
+#define SLOT_ALIGNMENT 64
+
+/**
+ * @brief First bytes of the file
+ */
+struct StoreHeader {
+    char magic[8];
+    unsigned long version;
+    // check that the file has been created by the same build
+    unsigned long spot_size;
+    unsigned long slots;
+    unsigned long max_excess;
+    unsigned long slot_size;
+    unsigned long generation;
+};
+
+/**
+ * @brief Beginning of a slot (it is followed by the excess ring)
+ */
+struct Slot {
+    /// session of the last access (0 = free slot)
+    unsigned long generation;
+    struct Spot spot;
+};
+
+static struct Slot *slot_at(struct SpotStore const *store,
+                            unsigned long index) {
+    return (struct Slot *)(store->map + STORE_HEADER_SIZE +
+                           index * store->slot_size);
+}
+
+static double *slot_excesses(struct Slot *slot) {
+    return (double *)(slot + 1);
+}
+
+/**
+ * @brief Map the whole file and fill the store
+ *
+ * @param store store instance
+ * @param fd file descriptor (it can be closed afterwards)
+ * @param size size of the file
+ * @return 0 or -errno
+ */
+static int store_map(struct SpotStore *store, int fd, unsigned long size) {
+    void *map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (map == MAP_FAILED) {
+        return -errno;
+    }
+    store->map = (unsigned char *)map;
+    store->size = size;
+    return 0;
+}
+
+int spot_store_create(struct SpotStore *store, char const *path,
+                      unsigned long slots, unsigned long max_excess) {
+    unsigned long slot_size = sizeof(struct Slot) + max_excess * sizeof(double);
+    slot_size = (slot_size + SLOT_ALIGNMENT - 1) & ~(SLOT_ALIGNMENT - 1UL);
+    if ((max_excess > (~0UL / 2) / sizeof(double)) ||
+        (slots > (~0UL - STORE_HEADER_SIZE) / slot_size)) {
+        return -EOVERFLOW;
+    }
+    unsigned long const size = STORE_HEADER_SIZE + slots * slot_size;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        return -errno;
+    }
+    // the slots are holes until they are written
+    int status = (ftruncate(fd, (off_t)size) < 0) ? -errno : 0;
+    if (status == 0) {
+        status = store_map(store, fd, size);
+    }
+    close(fd);
+    if (status < 0) {
+        return status;
+    }
+
+    struct StoreHeader *header = (struct StoreHeader *)store->map;
+    memcpy(header->magic, STORE_MAGIC, sizeof(header->magic));
+    header->version = STORE_VERSION;
+    header->spot_size = sizeof(struct Spot);
+    header->slots = slots;
+    header->max_excess = max_excess;
+    header->slot_size = slot_size;
+    header->generation = 1;
+
+    store->slots = slots;
+    store->max_excess = max_excess;
+    store->slot_size = slot_size;
+    store->generation = 1;
+    return 0;
+}
+
+int spot_store_open(struct SpotStore *store, char const *path) {
+    struct stat st;
+    int fd = open(path, O_RDWR);
+    if (fd < 0) {
+        return -errno;
+    }
+    int status = (fstat(fd, &st) < 0) ? -errno : 0;
+    if ((status == 0) && (st.st_size < STORE_HEADER_SIZE)) {
+        status = -EINVAL;
+    }
+    if (status == 0) {
+        status = store_map(store, fd, (unsigned long)st.st_size);
+    }
+    close(fd);
+    if (status < 0) {
+        return status;
+    }
+
+    struct StoreHeader *header = (struct StoreHeader *)store->map;
+    if (memcmp(header->magic, STORE_MAGIC, sizeof(header->magic)) ||
+        (header->version != STORE_VERSION) ||
+        (header->spot_size != sizeof(struct Spot)) ||
+        (header->slot_size < sizeof(struct Slot) +
+                                 header->max_excess * sizeof(double)) ||
+        ((store->size - STORE_HEADER_SIZE) / header->slot_size !=
+         header->slots)) {
+        spot_store_close(store);
+        return -EINVAL;
+    }
+
+    // the slots are updated lazily (see spot_store_get)
+    header->generation++;
+    store->slots = header->slots;
+    store->max_excess = header->max_excess;
+    store->slot_size = header->slot_size;
+    store->generation = header->generation;
+    return 0;
+}
+
+int spot_store_init(struct SpotStore *store, unsigned long index, double q,
+                    int low, int discard_anomalies, double level) {
+    struct Spot spot;
+    if (index >= store->slots) {
+        return -ERANGE;
+    }
+    int status =
+        spot_init(&spot, q, low, discard_anomalies, level, store->max_excess);
+    if (status < 0) {
+        return status;
+    }
+    // the excesses live in the slot, not in the heap
+    xfree(spot.tail.peaks.container.data);
+
+    struct Slot *slot = slot_at(store, index);
+    slot->spot = spot;
+    slot->spot.tail.peaks.container.data = slot_excesses(slot);
+    slot->generation = store->generation;
+    return 0;
+}
+
+/**
+ * @brief Check the fields of a slot that bound the memory accesses of the
+ * libspot API, so that a torn slot cannot write out of its excess ring
+ *
+ * @param store store instance
+ * @param spot detector of the slot
+ * @return 1 if the slot can be used, 0 otherwise
+ */
+static int slot_is_valid(struct SpotStore const *store,
+                         struct Spot const *spot) {
+    struct Ubend const *excesses = &(spot->tail.peaks.container);
+    return (excesses->capacity == store->max_excess) &&
+           (excesses->cursor < excesses->capacity) &&
+           ((excesses->filled == 0) || (excesses->filled == 1)) &&
+           ((spot->low == 0) || (spot->low == 1)) &&
+           ((spot->discard_anomalies == 0) ||
+            (spot->discard_anomalies == 1)) &&
+           (spot->__up_down == (spot->low ? -1.0 : 1.0));
+}
+
+struct Spot *spot_store_get(struct SpotStore *store, unsigned long index) {
+    if (index >= store->slots) {
+        return NULL;
+    }
+    struct Slot *slot = slot_at(store, index);
+    if (slot->generation == 0) {
+        return NULL;
+    }
+    if (slot->generation != store->generation) {
+        // first access since the opening: the pointers come from a former
+        // process (an unfinished chunked fit is dropped)
+        struct Spot *spot = &(slot->spot);
+        if (!slot_is_valid(store, spot)) {
+            return NULL;
+        }
+        spot->tail.peaks.container.data = slot_excesses(slot);
+        spot->candidates.cursor = 0;
+        spot->candidates.capacity = 0;
+        spot->candidates.filled = 0;
+        spot->candidates.data = 0x0;
+        slot->generation = store->generation;
+    }
+    return &(slot->spot);
+}
+
+int spot_store_sync(struct SpotStore *store, int wait) {
+    if (msync(store->map, store->size, wait ? MS_SYNC : MS_ASYNC) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+void spot_store_close(struct SpotStore *store) {
+    if (store->map) {
+        munmap(store->map, store->size);
+    }
+    store->map = NULL;
+    store->size = 0;
+    store->slots = 0;
+}
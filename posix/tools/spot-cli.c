@@ -0,0 +1,405 @@
+/**
+ * @file spot-cli.c
+ * @brief Command-line detector over files and pipes
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ * The first values fit the model, the next ones are streamed through the
+ * detector. Anomalies are written as CSV rows (index, value, threshold,
+ * probability) and the throughput is reported on stderr.
+ */
+#include "spot.h"
+#include "spot_parse.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+// size of the reads on pipes
+#define READ_SIZE (1 << 20)
+// number of values passed at once to the detector
+#define BATCH_SIZE 4096
+
+static char const *usage =
+    "Usage: spot-cli [OPTION]... [FILE]\n"
+    "Fit a detector on the first values of FILE (or stdin) and stream the\n"
+    "next ones through it. Anomalies are written to stdout as CSV rows\n"
+    "(index,value,threshold,probability).\n"
+    "\n"
+    "  -f FORMAT  input format: csv (default) or bin (little-endian doubles)\n"
+    "  -c COLUMN  CSV column to read (default: 0)\n"
+    "  -d DELIM   CSV delimiter (default: ',')\n"
+    "  -n SIZE    number of values to fit (default: 10000)\n"
+    "  -q Q       anomaly probability (default: 1e-4)\n"
+    "  -l LEVEL   excess level (default: 0.98)\n"
+    "  -m MAX     max excess (default: 200)\n"
+    "  -r TOL     recalibration tolerance of the excess threshold\n"
+    "  -L         flag low values (lower tail)\n"
+    "  -k         keep the anomalies in the model\n"
+    "  -h         print this help\n";
+
+/**
+ * @brief State of the run
+ */
+struct Cli {
+    struct Spot spot;
+    /// number of values to fit
+    unsigned long fit_size;
+    /// index of the next value
+    unsigned long index;
+    /// number of anomalies
+    unsigned long anomalies;
+    /// CSV column
+    unsigned long column;
+    /// CSV delimiter
+    char delimiter;
+    /// values not passed to the detector yet
+    double batch[BATCH_SIZE];
+    unsigned long batched;
+};
+
+static void print_error(char const *context, int status) {
+    char buffer[256];
+    if (status < 0) {
+        status = -status;
+    }
+    if (status >= ERR_MEMORY_ALLOCATION_FAILED) {
+        libspot_error(status, buffer, sizeof(buffer));
+    } else {
+        strncpy(buffer, strerror(status), sizeof(buffer) - 1);
+        buffer[sizeof(buffer) - 1] = '\0';
+    }
+    fprintf(stderr, "spot-cli: %s: %s\n", context, buffer);
+}
+
+/**
+ * @brief Step a value that may change the model and report it if it is an
+ * anomaly
+ */
+static void step(struct Cli *cli, double x) {
+    struct Spot *spot = &(cli->spot);
+    double const threshold = spot->anomaly_threshold;
+    int const result = spot_step(spot, x);
+    // without discard, the anomalies are also excesses
+    if ((result == ANOMALY) ||
+        ((result == EXCESS) && (spot->__up_down * (x - threshold) > 0))) {
+        cli->anomalies++;
+        printf("%lu,%.17g,%.17g,%.17g\n", cli->index, x, threshold,
+               spot_probability(spot, x));
+    }
+}
+
+/**
+ * @brief Pass values to the detector (the fit first)
+ *
+ * @return 0 or a negative error code (failed fit)
+ */
+static int process(struct Cli *cli, double const *values, unsigned long size) {
+    struct Spot *spot = &(cli->spot);
+    unsigned long i = 0;
+
+    if (cli->index < cli->fit_size) {
+        i = cli->fit_size - cli->index;
+        if (i > size) {
+            i = size;
+        }
+        spot_fit_feed(spot, values, i);
+        cli->index += i;
+        if (cli->index == cli->fit_size) {
+            int status = spot_fit_end(spot);
+            if (status < 0) {
+                return status;
+            }
+        }
+    }
+
+    // without recalibration, a normal value (the test of spot_step_batch)
+    // only increments the count of the detector: the runs of normal values
+    // are counted at once and the others are stepped one by one
+    int const inline_normal = is_nan(spot->rebase_tolerance);
+    while (i < size) {
+        if (inline_normal) {
+            double const excess = spot->excess_threshold;
+            double const anomaly = spot->anomaly_threshold;
+            unsigned long j = i;
+            while ((j < size) &&
+                   (spot->__up_down * (values[j] - excess) < 0) &&
+                   !(spot->discard_anomalies &&
+                     (spot->__up_down * (values[j] - anomaly) > 0))) {
+                j++;
+            }
+            spot->n += j - i;
+            cli->index += j - i;
+            i = j;
+            if (i == size) {
+                break;
+            }
+        }
+        step(cli, values[i]);
+        cli->index++;
+        i++;
+    }
+    return 0;
+}
+
+static int flush_batch(struct Cli *cli) {
+    int status = process(cli, cli->batch, cli->batched);
+    cli->batched = 0;
+    return status;
+}
+
+/**
+ * @brief Parse the complete lines of a CSV chunk
+ *
+ * @param cli state
+ * @param begin beginning of the chunk
+ * @param end end of the chunk
+ * @param last 1 if it is the end of the input (the last line may not end
+ * with a newline)
+ * @param[out] next first byte that has not been parsed
+ * @return 0 or a negative error code
+ */
+static int parse_csv(struct Cli *cli, char const *begin, char const *end,
+                     int last, char const **next) {
+    char const *p = begin;
+    for (;;) {
+        unsigned long count;
+        p = spot_parse_column(p, end, last, cli->delimiter, cli->column,
+                              cli->batch + cli->batched,
+                              BATCH_SIZE - cli->batched, &count);
+        cli->batched += count;
+        if (cli->batched < BATCH_SIZE) {
+            break;
+        }
+        int status = flush_batch(cli);
+        if (status < 0) {
+            return status;
+        }
+    }
+    *next = p;
+    return 0;
+}
+
+/**
+ * @brief Convert little-endian doubles to values
+ */
+static int parse_bin(struct Cli *cli, char const *begin, char const *end,
+                     char const **next) {
+    unsigned long const size = (unsigned long)(end - begin) / sizeof(double);
+#if __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    for (unsigned long i = 0; i < size; ++i) {
+        unsigned char const *b = (unsigned char const *)begin + 8 * i;
+        unsigned char *x = (unsigned char *)(cli->batch + cli->batched);
+        for (int j = 0; j < 8; ++j) {
+            x[j] = b[7 - j];
+        }
+        if (++cli->batched == BATCH_SIZE) {
+            int status = flush_batch(cli);
+            if (status < 0) {
+                return status;
+            }
+        }
+    }
+    int status = 0;
+#else
+    // the values are used in place (the buffers are aligned)
+    int status = flush_batch(cli);
+    if (status == 0) {
+        status = process(cli, (double const *)begin, size);
+    }
+#endif
+    *next = begin + size * sizeof(double);
+    return status;
+}
+
+static int parse(struct Cli *cli, int binary, char const *begin,
+                 char const *end, int last, char const **next) {
+    if (binary) {
+        return parse_bin(cli, begin, end, next);
+    }
+    return parse_csv(cli, begin, end, last, next);
+}
+
+/**
+ * @brief Read the input: a regular file is mapped, a pipe is read by large
+ * chunks
+ *
+ * @return 0 or a negative error code
+ */
+static int run(struct Cli *cli, int fd, int binary) {
+    struct stat st;
+    char const *next;
+    int status;
+
+    if ((fstat(fd, &st) == 0) && S_ISREG(st.st_mode) && (st.st_size > 0)) {
+        size_t const size = (size_t)st.st_size;
+        void *map = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map != MAP_FAILED) {
+            madvise(map, size, MADV_SEQUENTIAL);
+            status = parse(cli, binary, map, (char const *)map + size, 1,
+                           &next);
+            munmap(map, size);
+            return status;
+        }
+    }
+
+    // double buffer to keep the alignment of the binary values
+    double *buffer = malloc(READ_SIZE);
+    if (buffer == NULL) {
+        return -ENOMEM;
+    }
+    char *data = (char *)buffer;
+    size_t pending = 0;
+    for (;;) {
+        ssize_t r = read(fd, data + pending, READ_SIZE - pending);
+        if (r < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            status = -errno;
+            break;
+        }
+        pending += (size_t)r;
+        status = parse(cli, binary, data, data + pending, r == 0, &next);
+        if ((status < 0) || (r == 0)) {
+            break;
+        }
+        // move the incomplete line (or value) at the beginning
+        pending -= (size_t)(next - data);
+        memmove(data, next, pending);
+        if (pending == READ_SIZE) {
+            // a line longer than the buffer is dropped
+            pending = 0;
+        }
+    }
+    free(buffer);
+    return status;
+}
+
+int main(int argc, char *argv[]) {
+    static struct Cli cli;
+    double q = 1e-4;
+    double level = 0.98;
+    double tolerance = -1.0;
+    unsigned long max_excess = 200;
+    int low = 0;
+    int discard_anomalies = 1;
+    int binary = 0;
+    int opt;
+
+    cli.fit_size = 10000;
+    cli.delimiter = ',';
+    while ((opt = getopt(argc, argv, "f:c:d:n:q:l:m:r:Lkh")) != -1) {
+        switch (opt) {
+        case 'f':
+            if (strcmp(optarg, "bin") == 0) {
+                binary = 1;
+            } else if (strcmp(optarg, "csv") != 0) {
+                fprintf(stderr, "spot-cli: unknown format '%s'\n", optarg);
+                return 2;
+            }
+            break;
+        case 'c':
+            cli.column = strtoul(optarg, NULL, 10);
+            break;
+        case 'd':
+            cli.delimiter = optarg[0];
+            break;
+        case 'n':
+            cli.fit_size = strtoul(optarg, NULL, 10);
+            break;
+        case 'q':
+            q = strtod(optarg, NULL);
+            break;
+        case 'l':
+            level = strtod(optarg, NULL);
+            break;
+        case 'm':
+            max_excess = strtoul(optarg, NULL, 10);
+            break;
+        case 'r':
+            tolerance = strtod(optarg, NULL);
+            break;
+        case 'L':
+            low = 1;
+            break;
+        case 'k':
+            discard_anomalies = 0;
+            break;
+        case 'h':
+            fputs(usage, stdout);
+            return 0;
+        default:
+            fputs(usage, stderr);
+            return 2;
+        }
+    }
+
+    if (cli.fit_size == 0) {
+        fprintf(stderr, "spot-cli: the fit needs at least one value\n");
+        return 2;
+    }
+
+    int fd = STDIN_FILENO;
+    if (optind < argc) {
+        fd = open(argv[optind], O_RDONLY);
+        if (fd < 0) {
+            print_error(argv[optind], -errno);
+            return 1;
+        }
+    }
+
+    set_allocators(malloc, free);
+    int status =
+        spot_init(&cli.spot, q, low, discard_anomalies, level, max_excess);
+    if (status == 0) {
+        spot_set_rebase_tolerance(&cli.spot, tolerance);
+        status = spot_fit_begin(&cli.spot, 4 * max_excess);
+    }
+    if (status < 0) {
+        print_error("init", status);
+        return 1;
+    }
+
+    // large output buffer
+    setvbuf(stdout, NULL, _IOFBF, 1 << 16);
+    puts("index,value,threshold,probability");
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    status = run(&cli, fd, binary);
+    if (status == 0) {
+        status = flush_batch(&cli);
+    }
+    if ((status == 0) && (cli.index < cli.fit_size)) {
+        // not enough data: fit with what we have
+        status = spot_fit_end(&cli.spot);
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    fflush(stdout);
+
+    if (status < 0) {
+        print_error("run", status);
+    } else {
+        double const elapsed = (double)(end.tv_sec - start.tv_sec) +
+                               1e-9 * (double)(end.tv_nsec - start.tv_nsec);
+        fprintf(stderr,
+                "spot-cli: %lu rows (%lu fitted), %lu anomalies, %.3f s, "
+                "%.0f rows/s\n",
+                cli.index, (cli.index < cli.fit_size) ? cli.index : cli.fit_size,
+                cli.anomalies, elapsed, (double)cli.index / elapsed);
+    }
+
+    spot_free(&cli.spot);
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return (status < 0) ? 1 : 0;
+}
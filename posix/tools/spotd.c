@@ -0,0 +1,877 @@
+/**
+ * @file spotd.c
+ * @brief Multi-stream detector daemon (Linux)
+ * @author Alban Siffer (alban.siffer@irisa.fr)
+ * @version 2.0b4
+ * @date jeu. 17 juil. 2025 08:08:51 UTC
+ * @copyright GNU Lesser General Public License v3.0
+ *
+ * Records are lines "series value" read from stdin or from the clients of a
+ * UNIX socket. A detector is created for every series and fitted with its
+ * first values (warm-up). Anomalies are written as lines
+ * "series value threshold probability" to stdout or to the clients of an
+ * output UNIX socket.
+ *
+ * The series are sharded by hash between worker threads (one per core): a
+ * single I/O thread (epoll) parses the records and passes them to the
+ * workers through single-producer single-consumer rings, so the detectors
+ * are stepped without any lock. Every worker keeps its detectors in a
+ * SpotMap (see spot_map.h), optionally under a memory cap. The names of the
+ * series whose detectors are dropped by the cap are forgotten as well.
+ */
+#define _GNU_SOURCE
+#include "spot.h"
+#include "spot_map.h"
+#include "spot_parse.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// records per worker ring (power of 2)
+#define QUEUE_SIZE 16384
+// output lines per worker ring (power of 2)
+#define OUTPUT_SIZE 1024
+// evicted series per worker ring (power of 2)
+#define EVICTED_SIZE 1024
+// bytes of the series names that are written (output lines)
+#define NAME_SIZE 48
+// initial number of slots of the series table (power of 2)
+#define SERIES_SIZE 1024
+// size of an output line
+#define LINE_SIZE 160
+// size of the line buffer of a client
+#define CLIENT_BUFFER (1 << 16)
+// maximum number of output clients
+#define MAX_SUBSCRIBERS 64
+#define MAX_EVENTS 64
+
+static char const *usage =
+    "Usage: spotd [OPTION]...\n"
+    "Run a detector per series over records 'series value' (one per line)\n"
+    "read from stdin or from a UNIX socket. Anomalies are written as\n"
+    "'series value threshold probability' lines.\n"
+    "\n"
+    "  -s PATH    input UNIX socket (default: stdin)\n"
+    "  -o PATH    output UNIX socket (default: stdout)\n"
+    "  -t COUNT   number of worker threads (default: number of cores)\n"
+    "  -n SIZE    number of values of the warm-up fit (default: 1000)\n"
+    "  -q Q       anomaly probability (default: 1e-4)\n"
+    "  -l LEVEL   excess level (default: 0.98)\n"
+    "  -m MAX     max excess (default: 200)\n"
+    "  -L         flag low values (lower tail)\n"
+    "  -M MIB     memory cap of the detectors (default: no limit)\n"
+    "  -S PATH    spill the evicted detectors to PATH.<worker>\n"
+    "  -T COUNT   tiered mode: keep only COUNT excess rings per worker in\n"
+    "             memory, the others live in the spill files (needs -S)\n"
+    "  -h         print this help\n";
+
+/**
+ * @brief Record passed from the I/O thread to a worker
+ */
+struct Record {
+    __UINT64_TYPE__ key;
+    double value;
+    // name of the series (owned by the series table)
+    char const *name;
+};
+
+/**
+ * @brief Series dropped by the memory cap of a worker
+ */
+struct Eviction {
+    __UINT64_TYPE__ key;
+    // position of the record whose step has evicted the series
+    unsigned long position;
+};
+
+/**
+ * @brief Worker thread: it owns its series and the consumer side of its
+ * input ring and the producer side of its output rings
+ */
+struct Worker {
+    pthread_t thread;
+    struct SpotMap map;
+    // input ring (head: consumer, tail: producer)
+    unsigned long head;
+    char pad0[64];
+    unsigned long tail;
+    char pad1[64];
+    struct Record records[QUEUE_SIZE];
+    // output ring (head: consumer, tail: producer)
+    unsigned long out_head;
+    char pad2[64];
+    unsigned long out_tail;
+    char pad3[64];
+    char lines[OUTPUT_SIZE][LINE_SIZE];
+    // evicted series (head: consumer, tail: producer)
+    unsigned long evicted_head;
+    char pad4[64];
+    unsigned long evicted_tail;
+    char pad5[64];
+    struct Eviction evicted[EVICTED_SIZE];
+    // sleep/wake-up protocol
+    int sleeping;
+    int stop;
+    int efd;
+    // wakes the I/O thread up when anomalies are available
+    int out_efd;
+};
+
+/**
+ * @brief Input client
+ */
+struct Client {
+    int fd;
+    unsigned long used;
+    char buffer[CLIENT_BUFFER];
+};
+
+// tags of the epoll events that are not clients
+static struct Client LISTENER;
+static struct Client SUBSCRIBER;
+static struct Client SIGNALS;
+static struct Client OUTPUT;
+
+static __UINT64_TYPE__ hash(char const *name, unsigned long length) {
+    // FNV-1a
+    __UINT64_TYPE__ h = 0xcbf29ce484222325ULL;
+    for (unsigned long i = 0; i < length; ++i) {
+        h ^= (unsigned char)name[i];
+        h *= 0x100000001b3ULL;
+    }
+    // the high bits of FNV-1a are poorly mixed for short names (murmur3
+    // finalizer)
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+// Series --------------------------------------------------------------------
+
+// step between the ids of colliding names (see series_get)
+#define SERIES_STEP 0x9e3779b97f4a7c15ULL
+
+/**
+ * @brief Series name and the id of its detector
+ */
+struct Series {
+    __UINT64_TYPE__ id;
+    unsigned long length;
+    // position of its last record in the input ring of its worker
+    unsigned long last;
+    // NUL-terminated (NULL for an empty slot)
+    char *name;
+};
+
+/**
+ * @brief Series seen by the daemon (I/O thread only), by detector id. A name
+ * is kept as long as its detector lives in its worker (see series_forget),
+ * so that two names with the same hash never share a detector
+ */
+struct SeriesTable {
+    struct Series *slots;
+    unsigned long capacity;
+    unsigned long size;
+};
+
+/**
+ * @brief Return the slot of an id (or the empty slot where it goes)
+ */
+static struct Series *series_slot(struct SeriesTable *table,
+                                  __UINT64_TYPE__ id) {
+    unsigned long const mask = table->capacity - 1;
+    unsigned long i = (unsigned long)id & mask;
+    while (table->slots[i].name && (table->slots[i].id != id)) {
+        i = (i + 1) & mask;
+    }
+    return table->slots + i;
+}
+
+/**
+ * @brief Double the capacity of the table
+ *
+ * @return 0 or -1 if the allocation failed
+ */
+static int series_grow(struct SeriesTable *table) {
+    struct SeriesTable grown = {NULL, 2 * table->capacity, table->size};
+    grown.slots = calloc(grown.capacity, sizeof(struct Series));
+    if (grown.slots == NULL) {
+        return -1;
+    }
+    for (unsigned long i = 0; i < table->capacity; ++i) {
+        if (table->slots[i].name) {
+            *series_slot(&grown, table->slots[i].id) = table->slots[i];
+        }
+    }
+    free(table->slots);
+    *table = grown;
+    return 0;
+}
+
+/**
+ * @brief Return the series of a name (it is added at its first occurrence)
+ *
+ * @details The id of a series is the hash of its name. When this id is
+ * already taken by another name, the next ids of the sequence
+ * hash + k * (golden ratio) are tried, so the ids remain well mixed (the
+ * high bits select the worker, the low bits the slot of its map).
+ *
+ * @return the series or NULL if the allocation failed
+ */
+static struct Series *series_get(struct SeriesTable *table, char const *name,
+                                 unsigned long length) {
+    if ((2 * (table->size + 1) > table->capacity) &&
+        (series_grow(table) < 0)) {
+        return NULL;
+    }
+    __UINT64_TYPE__ id = hash(name, length);
+    for (;;) {
+        struct Series *s = series_slot(table, id);
+        if (s->name == NULL) {
+            s->name = malloc(length + 1);
+            if (s->name == NULL) {
+                return NULL;
+            }
+            memcpy(s->name, name, length);
+            s->name[length] = '\0';
+            s->length = length;
+            s->id = id;
+            table->size++;
+            return s;
+        }
+        if ((s->length == length) && (memcmp(s->name, name, length) == 0)) {
+            return s;
+        }
+        // collision with another name
+        id += SERIES_STEP;
+    }
+}
+
+/**
+ * @brief Remove a series whose detector has been dropped by its worker
+ *
+ * @details The series is kept when one of its records has been pushed
+ * after the evicting one (its detector is created again), or when the next
+ * id of its sequence is taken (series_get would not find the names of the
+ * sequence beyond a hole).
+ *
+ * @param key id of the detector
+ * @param position position of the evicting record in the input ring
+ */
+static void series_forget(struct SeriesTable *table, __UINT64_TYPE__ key,
+                          unsigned long position) {
+    struct Series *s = series_slot(table, key);
+    if ((s->name == NULL) || (s->last > position) ||
+        series_slot(table, key + SERIES_STEP)->name) {
+        return;
+    }
+    free(s->name);
+    // backward shift: the next series of the probe sequence fill the hole
+    // when it is between their slot and their home slot
+    unsigned long const mask = table->capacity - 1;
+    unsigned long hole = (unsigned long)(s - table->slots);
+    for (unsigned long i = (hole + 1) & mask; table->slots[i].name;
+         i = (i + 1) & mask) {
+        unsigned long const home = (unsigned long)table->slots[i].id & mask;
+        if (((i - home) & mask) >= ((i - hole) & mask)) {
+            table->slots[hole] = table->slots[i];
+            hole = i;
+        }
+    }
+    table->slots[hole].name = NULL;
+    table->size--;
+}
+
+static void series_free(struct SeriesTable *table) {
+    for (unsigned long i = 0; i < table->capacity; ++i) {
+        free(table->slots[i].name);
+    }
+    free(table->slots);
+    table->slots = NULL;
+    table->capacity = 0;
+    table->size = 0;
+}
+
+// Worker --------------------------------------------------------------------
+
+static void wake(int efd) {
+    __UINT64_TYPE__ one = 1;
+    if (write(efd, &one, sizeof(one)) < 0) {
+        // the counter is already non-zero
+    }
+}
+
+/**
+ * @brief Queue an output line (the worker waits while the ring is full)
+ */
+static void emit(struct Worker *w, struct Record const *record,
+                 double threshold) {
+    char line[LINE_SIZE];
+    snprintf(line, LINE_SIZE, "%.*s %.17g %.17g %.17g\n", NAME_SIZE - 1,
+             record->name, record->value, threshold,
+             spot_probability(spot_map_get(&(w->map), record->key),
+                              record->value));
+
+    unsigned long const tail = w->out_tail;
+    while (tail - __atomic_load_n(&(w->out_head), __ATOMIC_ACQUIRE) >=
+           OUTPUT_SIZE) {
+        wake(w->out_efd);
+        sched_yield();
+    }
+    memcpy(w->lines[tail & (OUTPUT_SIZE - 1)], line, LINE_SIZE);
+    __atomic_store_n(&(w->out_tail), tail + 1, __ATOMIC_RELEASE);
+}
+
+/**
+ * @brief Report a dropped series to the I/O thread (the worker waits while
+ * the ring is full)
+ */
+static void evict(struct Worker *w, unsigned long position) {
+    unsigned long const tail = w->evicted_tail;
+    while (tail - __atomic_load_n(&(w->evicted_head), __ATOMIC_ACQUIRE) >=
+           EVICTED_SIZE) {
+        wake(w->out_efd);
+        sched_yield();
+    }
+    struct Eviction *e = w->evicted + (tail & (EVICTED_SIZE - 1));
+    e->key = w->map.evicted;
+    e->position = position;
+    __atomic_store_n(&(w->evicted_tail), tail + 1, __ATOMIC_RELEASE);
+}
+
+static void process(struct Worker *w, unsigned long position) {
+    struct Record const *record = w->records + (position & (QUEUE_SIZE - 1));
+    unsigned long const evictions = w->map.evictions;
+    double threshold;
+    if (spot_map_step(&(w->map), record->key, record->value, &threshold) ==
+        ANOMALY) {
+        emit(w, record, threshold);
+    }
+    if ((w->map.evictions != evictions) && (w->map.spill_fd < 0)) {
+        // the detector has been dropped, not spilled
+        evict(w, position);
+    }
+}
+
+static void *worker_run(void *arg) {
+    struct Worker *w = (struct Worker *)arg;
+    for (;;) {
+        unsigned long const tail =
+            __atomic_load_n(&(w->tail), __ATOMIC_ACQUIRE);
+        unsigned long head = w->head;
+        if (head == tail) {
+            // sleep until the I/O thread pushes records
+            __atomic_store_n(&(w->sleeping), 1, __ATOMIC_SEQ_CST);
+            if (__atomic_load_n(&(w->tail), __ATOMIC_SEQ_CST) == head) {
+                if (__atomic_load_n(&(w->stop), __ATOMIC_ACQUIRE)) {
+                    break;
+                }
+                __UINT64_TYPE__ count;
+                if (read(w->efd, &count, sizeof(count)) < 0) {
+                    // interrupted: check again
+                }
+            }
+            __atomic_store_n(&(w->sleeping), 0, __ATOMIC_RELAXED);
+            continue;
+        }
+
+        unsigned long const out_tail = w->out_tail;
+        unsigned long const evicted_tail = w->evicted_tail;
+        for (; head != tail; ++head) {
+            process(w, head);
+        }
+        __atomic_store_n(&(w->head), head, __ATOMIC_RELEASE);
+        if ((w->out_tail != out_tail) || (w->evicted_tail != evicted_tail)) {
+            wake(w->out_efd);
+        }
+    }
+    return NULL;
+}
+
+// Output --------------------------------------------------------------------
+
+/**
+ * @brief Output clients (the output is stdout when there is no socket)
+ */
+struct Output {
+    int socket;
+    int subscribers[MAX_SUBSCRIBERS];
+    int count;
+    unsigned long dropped;
+};
+
+static void broadcast(struct Output *out, char const *line) {
+    size_t const length = strlen(line);
+    if (out->socket < 0) {
+        fputs(line, stdout);
+        return;
+    }
+    for (int i = 0; i < out->count; ++i) {
+        ssize_t const w = send(out->subscribers[i], line, length, MSG_NOSIGNAL);
+        if ((w < 0) && ((errno == EAGAIN) || (errno == EWOULDBLOCK))) {
+            // slow subscriber: the whole line is dropped
+            out->dropped++;
+        } else if (w != (ssize_t)length) {
+            // disconnected, or only the beginning of the line has been sent:
+            // the next lines would not be framed
+            if (w >= 0) {
+                out->dropped++;
+            }
+            close(out->subscribers[i]);
+            out->subscribers[i--] = out->subscribers[--out->count];
+        }
+    }
+}
+
+/**
+ * @brief Write the output lines of the workers and forget the series they
+ * have dropped
+ */
+static void drain(struct Worker *workers, int count, struct Output *out,
+                  struct SeriesTable *table) {
+    for (int i = 0; i < count; ++i) {
+        struct Worker *w = workers + i;
+        unsigned long const tail =
+            __atomic_load_n(&(w->out_tail), __ATOMIC_ACQUIRE);
+        unsigned long head = w->out_head;
+        for (; head != tail; ++head) {
+            broadcast(out, w->lines[head & (OUTPUT_SIZE - 1)]);
+        }
+        __atomic_store_n(&(w->out_head), head, __ATOMIC_RELEASE);
+
+        unsigned long const evicted_tail =
+            __atomic_load_n(&(w->evicted_tail), __ATOMIC_ACQUIRE);
+        head = w->evicted_head;
+        for (; head != evicted_tail; ++head) {
+            struct Eviction const *e =
+                w->evicted + (head & (EVICTED_SIZE - 1));
+            series_forget(table, e->key, e->position);
+        }
+        __atomic_store_n(&(w->evicted_head), head, __ATOMIC_RELEASE);
+    }
+    if (out->socket < 0) {
+        fflush(stdout);
+    }
+}
+
+// Input ---------------------------------------------------------------------
+
+/**
+ * @brief Parse a line "series value" and route it to its worker
+ *
+ * @return the worker that has received the record, -1 otherwise
+ */
+static int dispatch(struct Worker *workers, int count, struct Output *out,
+                    struct SeriesTable *table, char const *line,
+                    char const *end) {
+    char const *name = line;
+    while ((name < end) && ((*name == ' ') || (*name == '\t'))) {
+        name++;
+    }
+    char const *sep = name;
+    while ((sep < end) && (*sep != ' ') && (*sep != '\t')) {
+        sep++;
+    }
+    char const *v = sep;
+    while ((v < end) && ((*v == ' ') || (*v == '\t'))) {
+        v++;
+    }
+    double value;
+    if ((sep == name) || (spot_parse_double(v, end, &value) == v)) {
+        // malformed line
+        return -1;
+    }
+
+    struct Series *series =
+        series_get(table, name, (unsigned long)(sep - name));
+    if (series == NULL) {
+        return -1;
+    }
+    __UINT64_TYPE__ const key = series->id;
+    // the high bits select the worker, the low bits the slot of its map
+    struct Worker *w = workers + ((key >> 32) % (__UINT64_TYPE__)count);
+
+    unsigned long const tail = w->tail;
+    while (tail - __atomic_load_n(&(w->head), __ATOMIC_ACQUIRE) >=
+           QUEUE_SIZE) {
+        // full: let the worker consume (and consume its output)
+        wake(w->efd);
+        drain(workers, count, out, table);
+        sched_yield();
+    }
+    struct Record *r = w->records + (tail & (QUEUE_SIZE - 1));
+    r->key = key;
+    r->value = value;
+    r->name = series->name;
+    series->last = tail;
+    __atomic_store_n(&(w->tail), tail + 1, __ATOMIC_SEQ_CST);
+    return (int)(w - workers);
+}
+
+static void wake_workers(struct Worker *workers, int count,
+                         unsigned char const *pushed) {
+    for (int i = 0; i < count; ++i) {
+        if (pushed[i] && __atomic_load_n(&(workers[i].sleeping),
+                                         __ATOMIC_SEQ_CST)) {
+            wake(workers[i].efd);
+        }
+    }
+}
+
+/**
+ * @brief Read the available data of a client and dispatch its complete
+ * lines
+ *
+ * @return 0 if the client is still connected, -1 otherwise
+ */
+static int client_read(struct Client *c, struct Worker *workers, int count,
+                       struct Output *out, struct SeriesTable *table,
+                       unsigned char *pushed) {
+    ssize_t r = read(c->fd, c->buffer + c->used, CLIENT_BUFFER - c->used);
+    if ((r < 0) && ((errno == EAGAIN) || (errno == EINTR))) {
+        return 0;
+    }
+    int const closed = (r <= 0);
+    if (r > 0) {
+        c->used += (unsigned long)r;
+    }
+
+    char const *p = c->buffer;
+    char const *end = c->buffer + c->used;
+    for (;;) {
+        char const *eol = memchr(p, '\n', (size_t)(end - p));
+        if (eol == NULL) {
+            if (closed && (p < end)) {
+                // last line without newline
+                eol = end;
+            } else {
+                break;
+            }
+        }
+        int const i = dispatch(workers, count, out, table, p, eol);
+        if (i >= 0) {
+            pushed[i] = 1;
+        }
+        p = (eol < end) ? eol + 1 : end;
+    }
+    c->used = (unsigned long)(end - p);
+    memmove(c->buffer, p, c->used);
+    if (c->used == CLIENT_BUFFER) {
+        // a line longer than the buffer is dropped
+        c->used = 0;
+    }
+    return closed ? -1 : 0;
+}
+
+static int listen_unix(char const *path) {
+    struct sockaddr_un addr;
+    if (strlen(path) >= sizeof(addr.sun_path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, path);
+    unlink(path);
+    if ((bind(fd, (struct sockaddr *)&addr, sizeof(addr)) < 0) ||
+        (listen(fd, 128) < 0)) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int watch(int epfd, int fd, void *ptr) {
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.ptr = ptr;
+    return epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+static struct Client *client_new(int fd) {
+    struct Client *c = malloc(sizeof(struct Client));
+    if (c) {
+        c->fd = fd;
+        c->used = 0;
+    }
+    return c;
+}
+
+// Main ----------------------------------------------------------------------
+
+int main(int argc, char *argv[]) {
+    double q = 1e-4;
+    double level = 0.98;
+    unsigned long max_excess = 200;
+    unsigned long warmup = 1000;
+    unsigned long memory = 0;
+    int low = 0;
+    char const *input = NULL;
+    char const *output = NULL;
+    char const *spill = NULL;
+    unsigned long tiered = 0;
+    long threads = sysconf(_SC_NPROCESSORS_ONLN);
+    int opt;
+
+    while ((opt = getopt(argc, argv, "s:o:t:n:q:l:m:LM:S:T:h")) != -1) {
+        switch (opt) {
+        case 's':
+            input = optarg;
+            break;
+        case 'o':
+            output = optarg;
+            break;
+        case 't':
+            threads = strtol(optarg, NULL, 10);
+            break;
+        case 'n':
+            warmup = strtoul(optarg, NULL, 10);
+            break;
+        case 'q':
+            q = strtod(optarg, NULL);
+            break;
+        case 'l':
+            level = strtod(optarg, NULL);
+            break;
+        case 'm':
+            max_excess = strtoul(optarg, NULL, 10);
+            break;
+        case 'L':
+            low = 1;
+            break;
+        case 'M':
+            memory = strtoul(optarg, NULL, 10) << 20;
+            break;
+        case 'S':
+            spill = optarg;
+            break;
+        case 'T':
+            tiered = strtoul(optarg, NULL, 10);
+            break;
+        case 'h':
+            fputs(usage, stdout);
+            return 0;
+        default:
+            fputs(usage, stderr);
+            return 2;
+        }
+    }
+    if ((threads < 1) || (warmup == 0) || (tiered && (spill == NULL))) {
+        fputs(usage, stderr);
+        return 2;
+    }
+    set_allocators(malloc, free);
+    // the signals are handled by the I/O thread only
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    int const epfd = epoll_create1(EPOLL_CLOEXEC);
+    int const sfd = signalfd(-1, &signals, SFD_CLOEXEC);
+    int const out_efd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if ((epfd < 0) || (sfd < 0) || (out_efd < 0)) {
+        perror("spotd");
+        return 1;
+    }
+    watch(epfd, sfd, &SIGNALS);
+    watch(epfd, out_efd, &OUTPUT);
+
+    struct Output out = {-1, {0}, 0, 0};
+    if (output) {
+        out.socket = listen_unix(output);
+        if ((out.socket < 0) || (watch(epfd, out.socket, &SUBSCRIBER) < 0)) {
+            perror(output);
+            return 1;
+        }
+    }
+
+    int listener = -1;
+    int inputs = 0;
+    if (input) {
+        listener = listen_unix(input);
+        if ((listener < 0) || (watch(epfd, listener, &LISTENER) < 0)) {
+            perror(input);
+            return 1;
+        }
+    }
+
+    int const count = (int)threads;
+    struct Worker *workers = calloc((size_t)count, sizeof(struct Worker));
+    unsigned char *pushed = calloc((size_t)count, 1);
+    struct SeriesTable table = {NULL, SERIES_SIZE, 0};
+    table.slots = calloc(SERIES_SIZE, sizeof(struct Series));
+    if ((workers == NULL) || (pushed == NULL) || (table.slots == NULL)) {
+        perror("spotd");
+        return 1;
+    }
+    for (int i = 0; i < count; ++i) {
+        struct Worker *w = workers + i;
+        // the memory cap is split between the workers
+        int status = spot_map_init(&(w->map), q, low, 1, level, max_excess,
+                                   warmup, memory / (unsigned long)count);
+        if ((status == 0) && spill) {
+            char path[4096];
+            snprintf(path, sizeof(path), "%s.%d", spill, i);
+            status = tiered ? spot_map_tier(&(w->map), path, tiered)
+                            : spot_map_spill(&(w->map), path);
+        }
+        if (status < 0) {
+            char buffer[256];
+            if (-status >= ERR_MEMORY_ALLOCATION_FAILED) {
+                libspot_error(-status, buffer, sizeof(buffer));
+            } else {
+                snprintf(buffer, sizeof(buffer), "%s", strerror(-status));
+            }
+            fprintf(stderr, "spotd: %s\n", buffer);
+            return 2;
+        }
+        w->efd = eventfd(0, EFD_CLOEXEC);
+        w->out_efd = out_efd;
+        if ((w->efd < 0) ||
+            (pthread_create(&(w->thread), NULL, worker_run, w) != 0)) {
+            perror("spotd");
+            return 1;
+        }
+    }
+
+    // stdin is the input when there is no socket
+    struct Client *in = NULL;
+    if (listener < 0) {
+        in = client_new(STDIN_FILENO);
+        if (in == NULL) {
+            perror("spotd");
+            return 1;
+        }
+        if (watch(epfd, STDIN_FILENO, in) < 0) {
+            // regular file: read it at once
+            while (client_read(in, workers, count, &out, &table, pushed) ==
+                   0) {
+                wake_workers(workers, count, pushed);
+                memset(pushed, 0, (size_t)count);
+                drain(workers, count, &out, &table);
+            }
+            wake_workers(workers, count, pushed);
+            free(in);
+            in = NULL;
+        } else {
+            inputs = 1;
+        }
+    }
+
+    struct epoll_event events[MAX_EVENTS];
+    int running = (listener >= 0) || (inputs > 0);
+    while (running) {
+        int const n = epoll_wait(epfd, events, MAX_EVENTS, -1);
+        if ((n < 0) && (errno != EINTR)) {
+            perror("spotd");
+            break;
+        }
+        memset(pushed, 0, (size_t)count);
+        for (int i = 0; i < n; ++i) {
+            struct Client *c = (struct Client *)events[i].data.ptr;
+            if (c == &SIGNALS) {
+                running = 0;
+            } else if (c == &OUTPUT) {
+                __UINT64_TYPE__ value;
+                if (read(out_efd, &value, sizeof(value)) < 0) {
+                    // nothing to read
+                }
+            } else if (c == &LISTENER) {
+                int fd;
+                while ((fd = accept4(listener, NULL, NULL,
+                                     SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    struct Client *client = client_new(fd);
+                    if ((client == NULL) || (watch(epfd, fd, client) < 0)) {
+                        close(fd);
+                        free(client);
+                    }
+                }
+            } else if (c == &SUBSCRIBER) {
+                int fd;
+                while ((fd = accept4(out.socket, NULL, NULL,
+                                     SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    if (out.count < MAX_SUBSCRIBERS) {
+                        out.subscribers[out.count++] = fd;
+                    } else {
+                        close(fd);
+                    }
+                }
+            } else if (client_read(c, workers, count, &out, &table,
+                                   pushed) < 0) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, c->fd, NULL);
+                if (c == in) {
+                    // end of stdin
+                    running = 0;
+                } else {
+                    close(c->fd);
+                }
+                free(c);
+            }
+        }
+        wake_workers(workers, count, pushed);
+        drain(workers, count, &out, &table);
+    }
+
+    // the workers process the remaining records before stopping
+    for (int i = 0; i < count; ++i) {
+        __atomic_store_n(&(workers[i].stop), 1, __ATOMIC_SEQ_CST);
+        wake(workers[i].efd);
+    }
+    for (int i = 0; i < count; ++i) {
+        while (pthread_tryjoin_np(workers[i].thread, NULL) == EBUSY) {
+            // the workers may wait for room in their output rings
+            drain(workers, count, &out, &table);
+            sched_yield();
+        }
+    }
+    drain(workers, count, &out, &table);
+
+    unsigned long series = 0;
+    unsigned long evictions = 0;
+    for (int i = 0; i < count; ++i) {
+        series += spot_map_size(&(workers[i].map));
+        evictions += workers[i].map.evictions;
+        spot_map_free(&(workers[i].map));
+        close(workers[i].efd);
+    }
+    fprintf(stderr,
+            "spotd: %lu series, %lu names, %lu evictions, %lu dropped "
+            "output lines\n",
+            series, table.size, evictions, out.dropped);
+
+    free(workers);
+    free(pushed);
+    series_free(&table);
+    if (input) {
+        unlink(input);
+    }
+    if (output) {
+        for (int i = 0; i < out.count; ++i) {
+            close(out.subscribers[i]);
+        }
+        unlink(output);
+    }
+    return 0;
+}
@@ -0,0 +1,65 @@
+"""Throughput of the python module on threads (not part of the tests: the
+timings depend on the machine and on its load).
+
+    python benchmark.py [threads]
+"""
+
+import os
+import sys
+import threading
+import time
+
+import numpy as np
+from libspot import Spot, SpotPool  # pylint: disable=E0611
+
+
+def spot_threads(count: int, X: np.ndarray) -> float:
+    """Step one detector per thread (step_many runs without the GIL)"""
+    spots = [Spot(1e-4, level=0.99) for _ in range(count)]
+    for i, s in enumerate(spots):
+        s.fit(X[i, :20_000])
+    threads = [
+        threading.Thread(target=s.step_many, args=(X[i, 20_000:],))
+        for i, s in enumerate(spots)
+    ]
+    start = time.perf_counter()
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    return time.perf_counter() - start
+
+
+def pool_threads(count: int, X: np.ndarray) -> float:
+    """Step a SpotPool of 4 * count detectors on count native threads"""
+    rows = np.repeat(X[:count], 4, axis=0)
+    pool = SpotPool(len(rows), 1e-4, level=0.99, threads=count)
+    pool.fit(rows[:, :20_000])
+    start = time.perf_counter()
+    pool.step(rows[:, 20_000:])
+    return time.perf_counter() - start
+
+
+def main():
+    workers = int(sys.argv[1]) if len(sys.argv) > 1 else os.cpu_count() or 1
+    X = np.random.standard_normal((workers, 1_000_000))
+    values = X.shape[1] - 20_000
+
+    print("threads | Spot.step_many (Mv/s) | SpotPool.step (Mv/s)")
+    print("--------|-----------------------|---------------------")
+    counts = sorted(c for c in {1, 2, 4, workers} if c <= workers)
+    spot_times = {c: min(spot_threads(c, X) for _ in range(3)) for c in counts}
+    pool_times = {c: min(pool_threads(c, X) for _ in range(3)) for c in counts}
+    for count in counts:
+        many = spot_times[count]
+        many_pool = pool_times[count]
+        # throughput and speedup relative to a single thread
+        speedup = count * spot_times[1] / many
+        spot = f"{count * values / many / 1e6:.1f} (x{speedup:.2f})"
+        speedup = count * pool_times[1] / many_pool
+        pool = f"{4 * count * values / many_pool / 1e6:.1f} (x{speedup:.2f})"
+        print(f"{count:>7} | {spot:>21} | {pool:>20}")
+
+
+if __name__ == "__main__":
+    main()
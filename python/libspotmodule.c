@@ -1,10 +1,17 @@
 #include "../dist/spot.h"
 #include <stdlib.h>
+#include <string.h>
 
 #define PY_SSIZE_T_CLEAN
 #include <Python.h>
 #include <structmember.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#endif
+
 #define STR(x) STR_(x)
 #define STR_(x) #x
 
@@ -13,11 +20,104 @@
 #define SPOT_INIT_LEVEL 0.98
 #define SPOT_INIT_MAX_EXCESS 500
 
+// the buffer protocol belongs to the limited API since 3.11 (the older
+// targets copy the data)
+#if !defined(Py_LIMITED_API) || (Py_LIMITED_API >= 0x030B0000)
+#define HAS_BUFFER_PROTOCOL 1
+#else
+#define HAS_BUFFER_PROTOCOL 0
+#endif
+
+// number of results narrowed at once by step_many
+#define STEP_MANY_CHUNK 1024
+
+// maximum number of threads of a SpotPool
+#define SPOT_POOL_MAX_THREADS 256
+
+//
+// Per-object lock
+//
+
+// The detectors are not thread-safe and some methods release the GIL (which
+// does not exist at all on free-threaded builds), so every object holding
+// detectors owns a lock, taken by the methods that touch them.
+#ifdef Py_GIL_DISABLED
+
+// PyMutex is a single byte and detaches the thread while it waits
+typedef struct {
+    PyMutex mutex;
+} ObjectLock;
+
+static int object_lock_init(ObjectLock *lock) {
+    lock->mutex = (PyMutex){0};
+    return 0;
+}
+
+static void object_lock(ObjectLock *lock) { PyMutex_Lock(&lock->mutex); }
+
+static void object_unlock(ObjectLock *lock) { PyMutex_Unlock(&lock->mutex); }
+
+static void object_lock_free(ObjectLock *lock) { (void)lock; }
+
+#else
+
+typedef struct {
+    PyThread_type_lock handle;
+} ObjectLock;
+
+static int object_lock_init(ObjectLock *lock) {
+    lock->handle = PyThread_allocate_lock();
+    if (lock->handle == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    return 0;
+}
+
+static void object_lock(ObjectLock *lock) {
+    if (!PyThread_acquire_lock(lock->handle, NOWAIT_LOCK)) {
+        // the owner may wait for the GIL (after a step_many for instance)
+        Py_BEGIN_ALLOW_THREADS
+        PyThread_acquire_lock(lock->handle, WAIT_LOCK);
+        Py_END_ALLOW_THREADS
+    }
+}
+
+static void object_unlock(ObjectLock *lock) {
+    PyThread_release_lock(lock->handle);
+}
+
+static void object_lock_free(ObjectLock *lock) {
+    if (lock->handle != NULL) {
+        PyThread_free_lock(lock->handle);
+        lock->handle = NULL;
+    }
+}
+
+#endif
+
+/**
+ * @brief Allocate an instance of a type whose lock lies at the given offset
+ */
+static PyObject *locked_new(PyTypeObject *type, size_t lock_offset) {
+    allocfunc tp_alloc = (allocfunc)PyType_GetSlot(type, Py_tp_alloc);
+    PyObject *self = tp_alloc(type, 0);
+    if (self == NULL) {
+        return NULL;
+    }
+    if (object_lock_init((ObjectLock *)((char *)self + lock_offset)) < 0) {
+        Py_DECREF(self);
+        return NULL;
+    }
+    return self;
+}
+
 // define a wrapper around the raw Spot structure
 // clang-format off
 typedef struct {
     PyObject_HEAD
     struct Spot _spot;
+    ObjectLock lock;
 } Spot;
 
 // clang-format on
@@ -38,6 +138,345 @@ static PyObject *to_python_list(double *buffer, unsigned long size) {
     return list;
 }
 
+//
+// Input data (buffer of float64 or sequence of floats)
+//
+
+typedef struct {
+    double const *data;
+    unsigned long size;
+    // 1 or 2 (rows x cols, row-major)
+    int ndim;
+    unsigned long rows;
+    unsigned long cols;
+    // copy of a sequence (NULL for a buffer)
+    double *copy;
+#if HAS_BUFFER_PROTOCOL
+    Py_buffer view;
+    int has_view;
+#endif
+} Doubles;
+
+// ids of series (buffer of int64 or sequence of ints)
+typedef struct {
+    long long const *data;
+    unsigned long size;
+    long long *copy;
+#if HAS_BUFFER_PROTOCOL
+    Py_buffer view;
+    int has_view;
+#endif
+} Ids;
+
+#if HAS_BUFFER_PROTOCOL
+/**
+ * @brief Check the format of a buffer (native item of one of the types)
+ */
+static int has_format(Py_buffer const *view, Py_ssize_t itemsize,
+                      char const *types) {
+    char const *f = view->format;
+    if ((view->itemsize != itemsize) || (f == NULL)) {
+        return 0;
+    }
+    if ((f[0] == '@') || (f[0] == '=')) {
+        f++;
+    }
+    return (f[0] != '\0') && (f[1] == '\0') && (strchr(types, f[0]) != NULL);
+}
+
+/**
+ * @brief Get a C-contiguous buffer of the given format
+ *
+ * @return 1 if the buffer is available, 0 otherwise (no python exception)
+ */
+static int get_view(PyObject *obj, Py_buffer *view, Py_ssize_t itemsize,
+                    char const *types) {
+    if (!PyObject_CheckBuffer(obj)) {
+        return 0;
+    }
+    if (PyObject_GetBuffer(obj, view, PyBUF_C_CONTIGUOUS | PyBUF_FORMAT) <
+        0) {
+        // strided buffers: they are converted
+        PyErr_Clear();
+        return 0;
+    }
+    if ((view->ndim < 1) || !has_format(view, itemsize, types)) {
+        PyBuffer_Release(view);
+        return 0;
+    }
+    return 1;
+}
+#endif
+
+/**
+ * @brief Copy a flat sequence of floats
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int copy_floats(PyObject *seq, double *x, Py_ssize_t size) {
+    for (Py_ssize_t i = 0; i < size; i++) {
+        // https://docs.python.org/3/c-api/float.html#c.PyFloat_AsDouble
+        PyObject *item = PySequence_GetItem(seq, i);
+        x[i] = (item == NULL) ? -1.0 : PyFloat_AsDouble(item);
+        Py_XDECREF(item);
+        if ((x[i] == -1.0) && PyErr_Occurred()) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Copy a sequence of sequences of floats (rows of the same length)
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int copy_rows(PyObject *seq, Doubles *d) {
+    for (unsigned long r = 0; r < d->rows; r++) {
+        PyObject *item = PySequence_GetItem(seq, (Py_ssize_t)r);
+        PyObject *row = (item == NULL)
+                            ? NULL
+                            : PySequence_Fast(item, "rows must be sequences");
+        Py_XDECREF(item);
+        if (row == NULL) {
+            return -1;
+        }
+        Py_ssize_t const size = PySequence_Size(row);
+        if (r == 0) {
+            d->cols = (unsigned long)((size > 0) ? size : 0);
+            d->size = d->rows * d->cols;
+            d->copy = malloc((d->size ? d->size : 1) * sizeof(double));
+            if (d->copy == NULL) {
+                Py_DECREF(row);
+                PyErr_NoMemory();
+                return -1;
+            }
+        }
+        if ((size < 0) || ((unsigned long)size != d->cols)) {
+            Py_DECREF(row);
+            if (!PyErr_Occurred()) {
+                PyErr_SetString(PyExc_ValueError,
+                                "rows must have the same length");
+            }
+            return -1;
+        }
+        int status = copy_floats(row, d->copy + r * d->cols, size);
+        Py_DECREF(row);
+        if (status < 0) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the values of a python object (no copy for a contiguous
+ * buffer of float64 like numpy arrays, array.array('d') or memoryviews)
+ *
+ * Buffers can have 2 dimensions (and sequences can hold rows).
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int doubles_get(PyObject *obj, Doubles *d) {
+    d->data = NULL;
+    d->size = 0;
+    d->ndim = 1;
+    d->rows = 1;
+    d->cols = 0;
+    d->copy = NULL;
+#if HAS_BUFFER_PROTOCOL
+    d->has_view = get_view(obj, &(d->view), sizeof(double), "d");
+    if (d->has_view && (d->view.ndim <= 2)) {
+        d->data = (double const *)d->view.buf;
+        d->size = (unsigned long)(d->view.len / sizeof(double));
+        d->ndim = d->view.ndim;
+        d->rows = (d->ndim == 2) ? (unsigned long)d->view.shape[0] : 1;
+        d->cols = (d->ndim == 2) ? (unsigned long)d->view.shape[1] : d->size;
+        return 0;
+    }
+    if (d->has_view) {
+        PyBuffer_Release(&(d->view));
+        d->has_view = 0;
+    }
+#endif
+
+    PyObject *seq = PySequence_Fast(obj, "cannot turn arg into sequence");
+    if (seq == NULL) {
+        return -1;
+    }
+    Py_ssize_t const size = PySequence_Size(seq);
+    if (size < 0) {
+        Py_DECREF(seq);
+        return -1;
+    }
+    // nested sequences are the rows of a 2-D array
+    PyObject *first = (size > 0) ? PySequence_GetItem(seq, 0) : NULL;
+    int const nested = (first != NULL) && PySequence_Check(first);
+    Py_XDECREF(first);
+
+    int status;
+    if (nested) {
+        d->ndim = 2;
+        d->rows = (unsigned long)size;
+        status = copy_rows(seq, d);
+    } else {
+        d->size = (unsigned long)size;
+        d->cols = d->size;
+        // allocate a new raw buffer (at least one value)
+        d->copy = malloc((size ? size : 1) * sizeof(double));
+        if (d->copy == NULL) {
+            PyErr_NoMemory();
+            status = -1;
+        } else {
+            status = copy_floats(seq, d->copy, size);
+        }
+    }
+    Py_DECREF(seq);
+    if (status < 0) {
+        free(d->copy);
+        d->copy = NULL;
+        return -1;
+    }
+    d->data = d->copy;
+    return 0;
+}
+
+static void doubles_release(Doubles *d) {
+#if HAS_BUFFER_PROTOCOL
+    if (d->has_view) {
+        PyBuffer_Release(&(d->view));
+        d->has_view = 0;
+    }
+#endif
+    free(d->copy);
+    d->copy = NULL;
+}
+
+/**
+ * @brief Same as doubles_get but the data must have 1 dimension
+ */
+static int doubles_get_1d(PyObject *obj, Doubles *d) {
+    if (doubles_get(obj, d) < 0) {
+        return -1;
+    }
+    if (d->ndim != 1) {
+        doubles_release(d);
+        PyErr_SetString(PyExc_ValueError, "expected a 1-D array");
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Get the ids of a python object (no copy for a contiguous buffer of
+ * int64)
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int ids_get(PyObject *obj, Ids *d) {
+    d->data = NULL;
+    d->size = 0;
+    d->copy = NULL;
+#if HAS_BUFFER_PROTOCOL
+    d->has_view = get_view(obj, &(d->view), sizeof(long long), "lqLQ");
+    if (d->has_view && (d->view.ndim == 1)) {
+        d->data = (long long const *)d->view.buf;
+        d->size = (unsigned long)(d->view.len / sizeof(long long));
+        return 0;
+    }
+    if (d->has_view) {
+        PyBuffer_Release(&(d->view));
+        d->has_view = 0;
+    }
+#endif
+
+    PyObject *seq = PySequence_Fast(obj, "cannot turn arg into sequence");
+    if (seq == NULL) {
+        return -1;
+    }
+    Py_ssize_t const size = PySequence_Size(seq);
+    d->copy = (size < 0) ? NULL : malloc((size ? size : 1) * sizeof(long long));
+    if (d->copy == NULL) {
+        Py_DECREF(seq);
+        if (!PyErr_Occurred()) {
+            PyErr_NoMemory();
+        }
+        return -1;
+    }
+    for (Py_ssize_t i = 0; i < size; i++) {
+        PyObject *item = PySequence_GetItem(seq, i);
+        d->copy[i] = (item == NULL) ? -1 : PyLong_AsLongLong(item);
+        Py_XDECREF(item);
+        if ((d->copy[i] == -1) && PyErr_Occurred()) {
+            Py_DECREF(seq);
+            free(d->copy);
+            d->copy = NULL;
+            return -1;
+        }
+    }
+    Py_DECREF(seq);
+    d->data = d->copy;
+    d->size = (unsigned long)size;
+    return 0;
+}
+
+static void ids_release(Ids *d) {
+#if HAS_BUFFER_PROTOCOL
+    if (d->has_view) {
+        PyBuffer_Release(&(d->view));
+        d->has_view = 0;
+    }
+#endif
+    free(d->copy);
+    d->copy = NULL;
+}
+
+//
+// Results (int8)
+//
+
+/**
+ * @brief Step a buffer of values and narrow the results to int8 (the errors,
+ * i.e. NaN values, become -1). It does not need the GIL.
+ */
+static void step_into(struct Spot *spot, double const *data,
+                      unsigned long size, signed char *out) {
+    int results[STEP_MANY_CHUNK];
+    for (unsigned long i = 0; i < size; i += STEP_MANY_CHUNK) {
+        unsigned long n = size - i;
+        if (n > STEP_MANY_CHUNK) {
+            n = STEP_MANY_CHUNK;
+        }
+        // libspot API call
+        spot_step_batch(spot, data + i, n, results);
+        for (unsigned long j = 0; j < n; j++) {
+            out[i + j] = (signed char)((results[j] < 0) ? -1 : results[j]);
+        }
+    }
+}
+
+/**
+ * @brief Return a typed memoryview (format, shape) over a bytearray. It
+ * steals the reference to the bytearray.
+ */
+static PyObject *typed_view(PyObject *bytes, char const *format,
+                            unsigned long rows, unsigned long cols,
+                            int ndim) {
+    PyObject *view = PyMemoryView_FromObject(bytes);
+    Py_DECREF(bytes);
+    if (view == NULL) {
+        return NULL;
+    }
+    PyObject *typed;
+    if (ndim == 2) {
+        typed = PyObject_CallMethod(view, "cast", "s(kk)", format, rows, cols);
+    } else {
+        typed = PyObject_CallMethod(view, "cast", "s", format);
+    }
+    Py_DECREF(view);
+    return typed;
+}
+
 static PyObject *excesses(struct Ubend *ubend) {
     unsigned long size = ubend->cursor;
     if (ubend->filled) {
@@ -72,6 +511,53 @@ static PyObject *Tail_as_dict(struct Tail *tail) {
                          tail->sigma, "peaks", peaks);
 }
 
+//
+// Raw bytes (snapshots)
+//
+
+typedef struct {
+    char *data;
+    Py_ssize_t size;
+#if HAS_BUFFER_PROTOCOL
+    Py_buffer view;
+#else
+    // copy of the object
+    PyObject *copy;
+#endif
+} Bytes;
+
+/**
+ * @brief Get the bytes of a python object: any contiguous buffer (bytes,
+ * bytearray, memoryview, shared_memory.buf...) without copy, the older
+ * targets copy it
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int bytes_get(PyObject *obj, Bytes *b) {
+#if HAS_BUFFER_PROTOCOL
+    if (PyObject_GetBuffer(obj, &b->view, PyBUF_SIMPLE) < 0) {
+        return -1;
+    }
+    b->data = (char *)b->view.buf;
+    b->size = b->view.len;
+    return 0;
+#else
+    b->copy = PyBytes_FromObject(obj);
+    if (b->copy == NULL) {
+        return -1;
+    }
+    return PyBytes_AsStringAndSize(b->copy, &b->data, &b->size);
+#endif
+}
+
+static void bytes_release(Bytes *b) {
+#if HAS_BUFFER_PROTOCOL
+    PyBuffer_Release(&b->view);
+#else
+    Py_DECREF(b->copy);
+#endif
+}
+
 //
 // Spot object
 //
@@ -112,8 +598,10 @@ static int Spot_init(Spot *self, PyObject *args, PyObject *kwds) {
         return -1;
 
     // libspot API call
+    object_lock(&self->lock);
     int result = spot_init(&(self->_spot), q, low, discard_anomalies, level,
                            max_excess);
+    object_unlock(&self->lock);
     if (result < 0) {
         char buffer[256];
         libspot_error(-result, buffer, 256);
@@ -125,32 +613,30 @@ static int Spot_init(Spot *self, PyObject *args, PyObject *kwds) {
 PyDoc_STRVAR(Spot_fit_doc,
              "fit($self, data)\n--\n\n"
              "Compute the first excess and anomaly thresholds based "
-             "on training data");
+             "on training data (contiguous float64 buffers like numpy "
+             "arrays are not copied)");
 
 static PyObject *Spot_fit(Spot *self, PyObject *data) {
-    PyObject *seq = PySequence_Fast(data, "cannot turn arg into sequence");
-    if (seq == NULL) {
+    Doubles x;
+    if (doubles_get_1d(data, &x) < 0) {
         return NULL;
     }
 
-    unsigned long size = (unsigned long)PyList_Size(seq);
-
-    // allocate a new raw buffer to pass to the fit method
-    double *x = malloc(size * sizeof(double));
-    for (unsigned long i = 0; i < size; i++) {
-        // https://docs.python.org/3/c-api/float.html#c.PyFloat_AsDouble
-        x[i] = PyFloat_AsDouble(PyList_GetItem(seq, i));
-    }
+    int result;
+    object_lock(&self->lock);
+    Py_BEGIN_ALLOW_THREADS
     // libspot API call
-    int result = spot_fit(&(self->_spot), x, size);
-    // free the buffer
-    free(x);
-    // check result
+    result = spot_fit(&(self->_spot), x.data, x.size);
+    Py_END_ALLOW_THREADS
+    object_unlock(&self->lock);
+    doubles_release(&x);
 
+    // check result
     if (result < 0) {
         char buffer[256];
         libspot_error(-result, buffer, 256);
         PyErr_SetString(PyExc_RuntimeError, buffer);
+        return NULL;
     }
     Py_RETURN_NONE;
 }
@@ -162,11 +648,43 @@ static PyObject *Spot_step(Spot *self, PyObject *x) {
     double z = PyFloat_AsDouble(x);
 
     // libspot API call
+    object_lock(&self->lock);
     int result = spot_step(&(self->_spot), z);
+    object_unlock(&self->lock);
 
     return PyLong_FromLong(result);
 }
 
+PyDoc_STRVAR(
+    Spot_step_many_doc,
+    "step_many($self, data)\n--\n\n"
+    "Fit-predict steps over a buffer of values. It returns the results as "
+    "a memoryview of int8 (numpy.asarray gives an int8 array), -1 for the "
+    "NaN values");
+
+static PyObject *Spot_step_many(Spot *self, PyObject *data) {
+    Doubles x;
+    if (doubles_get_1d(data, &x) < 0) {
+        return NULL;
+    }
+
+    PyObject *bytes = PyByteArray_FromStringAndSize(NULL, x.size);
+    if (bytes == NULL) {
+        doubles_release(&x);
+        return NULL;
+    }
+    signed char *out = (signed char *)PyByteArray_AsString(bytes);
+
+    object_lock(&self->lock);
+    Py_BEGIN_ALLOW_THREADS
+    step_into(&(self->_spot), x.data, x.size, out);
+    Py_END_ALLOW_THREADS
+    object_unlock(&self->lock);
+    doubles_release(&x);
+
+    return typed_view(bytes, "b", 1, x.size, 1);
+}
+
 PyDoc_STRVAR(Spot_quantile_doc, "quantile($self, q)\n--\n\n"
                                 "Compute the value zq such that P(X>zq) = q");
 
@@ -174,7 +692,9 @@ static PyObject *Spot_quantile(Spot *self, PyObject *x) {
     double q = PyFloat_AsDouble(x);
 
     // libspot API call
+    object_lock(&self->lock);
     double z = spot_quantile(&(self->_spot), q);
+    object_unlock(&self->lock);
 
     return PyFloat_FromDouble(z);
 }
@@ -187,7 +707,9 @@ static PyObject *Spot_probability(Spot *self, PyObject *x) {
     double z = PyFloat_AsDouble(x);
 
     // libspot API call
+    object_lock(&self->lock);
     double q = spot_probability(&(self->_spot), z);
+    object_unlock(&self->lock);
 
     return PyFloat_FromDouble(q);
 }
@@ -197,30 +719,162 @@ PyDoc_STRVAR(Spot_raw_doc, "raw($self)\n--\n\n"
 
 static PyObject *Spot_raw(Spot *self) {
     const char *buffer = (char *)(&self->_spot);
+    object_lock(&self->lock);
     PyObject *bytearray =
         PyByteArray_FromStringAndSize(buffer, sizeof(struct Spot));
+    object_unlock(&self->lock);
     return bytearray;
 }
 
-// static PyObject *Spot_fromraw(void *null, char *buffer, unsigned long size)
-// {
-//     // TODO: the problem with (de)serialization is that we need to store
-//     // the excesses.
-//     Spot spot;
-//     PyObject *q_fake = PyFloat_FromDouble(1e-8);
-//     /* Call the class object. */
-//     PyObject *obj = PyObject_CallObject((PyObject *)&spot, q_fake);
-//     Spot *s = (Spot *)obj;
-//     Py_DECREF(q_fake);
-//     memcpy(&(s->_spot), buffer, size);
-//     return obj;
-// }
+PyDoc_STRVAR(Spot_serialize_doc,
+             "serialize($self)\n--\n\n"
+             "Return a snapshot of the detector (portable binary format)");
+
+static PyObject *Spot_serialize(Spot *self) {
+    object_lock(&self->lock);
+    unsigned long size = spot_serialized_size(&(self->_spot));
+    PyObject *bytes = PyBytes_FromStringAndSize(NULL, size);
+    if (bytes != NULL) {
+        // libspot API call
+        spot_serialize(&(self->_spot), PyBytes_AsString(bytes), size);
+    }
+    object_unlock(&self->lock);
+    return bytes;
+}
+
+PyDoc_STRVAR(Spot_serialize_into_doc,
+             "serialize_into($self, buffer)\n--\n\n"
+             "Write the snapshot into a writable buffer (a bytearray, the "
+             "buf of a multiprocessing.shared_memory block...) and return "
+             "its size");
+
+static PyObject *Spot_serialize_into(Spot *self, PyObject *buffer) {
+#if HAS_BUFFER_PROTOCOL
+    Py_buffer view;
+    if (PyObject_GetBuffer(buffer, &view, PyBUF_WRITABLE) < 0) {
+        return NULL;
+    }
+    object_lock(&self->lock);
+    unsigned long size = spot_serialized_size(&(self->_spot));
+    // libspot API call
+    int result = spot_serialize(&(self->_spot), view.buf,
+                                (unsigned long)view.len);
+    object_unlock(&self->lock);
+    PyBuffer_Release(&view);
+#else
+    // no buffer API: the snapshot is copied into buffer[:size]
+    PyObject *bytes = Spot_serialize(self);
+    if (bytes == NULL) {
+        return NULL;
+    }
+    unsigned long size = (unsigned long)PyBytes_Size(bytes);
+    Py_ssize_t const capacity = PyObject_Size(buffer);
+    int result = 0;
+    if (capacity < 0) {
+        result = -1;
+    } else if ((unsigned long)capacity < size) {
+        result = -ERR_BUFFER_TOO_SMALL;
+    } else {
+        PyObject *end = PyLong_FromUnsignedLong(size);
+        PyObject *slice = (end == NULL) ? NULL : PySlice_New(NULL, end, NULL);
+        Py_XDECREF(end);
+        if ((slice == NULL) || (PyObject_SetItem(buffer, slice, bytes) < 0)) {
+            result = -1;
+        }
+        Py_XDECREF(slice);
+    }
+    Py_DECREF(bytes);
+#endif
+
+    if (result < 0) {
+        if (!PyErr_Occurred()) {
+            PyErr_Format(PyExc_ValueError,
+                         "the buffer is too small (the snapshot takes %lu "
+                         "bytes)",
+                         size);
+        }
+        return NULL;
+    }
+    return PyLong_FromUnsignedLong(size);
+}
+
+/**
+ * @brief Replace the detector by a snapshot (see serialize)
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int Spot_restore(Spot *self, PyObject *data) {
+    Bytes b;
+    if (bytes_get(data, &b) < 0) {
+        return -1;
+    }
+    struct Spot restored;
+    // libspot API call
+    int result = spot_deserialize(&restored, b.data, (unsigned long)b.size);
+    bytes_release(&b);
+    if (result < 0) {
+        char msg[256];
+        libspot_error(-result, msg, 256);
+        PyErr_SetString(PyExc_ValueError, msg);
+        return -1;
+    }
+
+    object_lock(&self->lock);
+    spot_free(&(self->_spot));
+    self->_spot = restored;
+    object_unlock(&self->lock);
+    return 0;
+}
+
+PyDoc_STRVAR(Spot_fromraw_doc,
+             "fromraw($type, data)\n--\n\n"
+             "Restore a detector from a snapshot (see serialize) without "
+             "refitting it. The snapshot may be any buffer (bytes, "
+             "the buf of a multiprocessing.shared_memory block...)");
+
+static PyObject *Spot_fromraw(PyObject *type, PyObject *data) {
+    // build a placeholder instance that is replaced by the snapshot
+    PyObject *obj = PyObject_CallFunction(type, "d", 1e-8);
+    if (obj == NULL) {
+        return NULL;
+    }
+    if (Spot_restore((Spot *)obj, data) < 0) {
+        Py_DECREF(obj);
+        return NULL;
+    }
+    return obj;
+}
+
+PyDoc_STRVAR(Spot_reduce_doc, "__reduce__($self)\n--\n\n"
+                              "Pickle support (the state is the snapshot)");
+
+static PyObject *Spot_reduce(Spot *self) {
+    PyObject *state = Spot_serialize(self);
+    if (state == NULL) {
+        return NULL;
+    }
+    return Py_BuildValue("O(d)N", (PyObject *)Py_TYPE((PyObject *)self),
+                         self->_spot.q, state);
+}
+
+PyDoc_STRVAR(Spot_setstate_doc, "__setstate__($self, state)\n--\n\n"
+                                "Restore the snapshot of a pickle");
+
+static PyObject *Spot_setstate(Spot *self, PyObject *state) {
+    if (Spot_restore(self, state) < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
 
 PyDoc_STRVAR(Spot_excess_doc, "excess($self)\n--\n\n"
                               "Return the stored excesses");
 
 static PyObject *Spot_excesses(Spot *self) {
-    return excesses(&self->_spot.tail.peaks.container);
+    object_lock(&self->lock);
+    PyObject *list = excesses(&self->_spot.tail.peaks.container);
+    object_unlock(&self->lock);
+    return list;
 }
 
 PyDoc_STRVAR(
@@ -231,19 +885,33 @@ PyDoc_STRVAR(
 static PyObject *Spot_as_dict(Spot *self) {
 
     struct Spot *spot = &(self->_spot);
+    object_lock(&self->lock);
     PyObject *tail = Tail_as_dict(&(spot->tail));
-    return Py_BuildValue(
+    PyObject *dict = Py_BuildValue(
         "{sdsdsisisdsdsksksN}", "q", spot->q, "level", spot->level,
         "discard_anomalies", spot->discard_anomalies, "low", spot->low,
         "anomaly_threshold", spot->anomaly_threshold, "excess_threshold",
         spot->excess_threshold, "Nt", spot->Nt, "n", spot->n, "tail", tail);
+    object_unlock(&self->lock);
+    return dict;
+}
+
+static PyObject *Spot_new(PyTypeObject *type, PyObject *args,
+                          PyObject *kwds) {
+    (void)args;
+    (void)kwds;
+    return locked_new(type, offsetof(Spot, lock));
 }
 
 static void Spot_dealloc(Spot *self) {
+    PyTypeObject *type = Py_TYPE((PyObject *)self);
     // free internal structure
     // libspot API call
     spot_free(&(self->_spot));
-    // Py_TYPE(self)->tp_free((PyObject *)self);
+    object_lock_free(&self->lock);
+    freefunc tp_free = (freefunc)PyType_GetSlot(type, Py_tp_free);
+    tp_free(self);
+    Py_DECREF(type);
 }
 
 static const PyMemberDef Spot_members[] = {
@@ -267,10 +935,19 @@ static const PyMemberDef Spot_members[] = {
 static const PyMethodDef Spot_methods[] = {
     {"fit", (PyCFunction)Spot_fit, METH_O, Spot_fit_doc},
     {"step", (PyCFunction)Spot_step, METH_O, Spot_step_doc},
+    {"step_many", (PyCFunction)Spot_step_many, METH_O, Spot_step_many_doc},
     {"quantile", (PyCFunction)Spot_quantile, METH_O, Spot_quantile_doc},
     {"probability", (PyCFunction)Spot_probability, METH_O,
      Spot_probability_doc},
     {"raw", (PyCFunction)Spot_raw, METH_NOARGS, Spot_raw_doc},
+    {"serialize", (PyCFunction)Spot_serialize, METH_NOARGS,
+     Spot_serialize_doc},
+    {"serialize_into", (PyCFunction)Spot_serialize_into, METH_O,
+     Spot_serialize_into_doc},
+    {"fromraw", (PyCFunction)Spot_fromraw, METH_O | METH_CLASS,
+     Spot_fromraw_doc},
+    {"__reduce__", (PyCFunction)Spot_reduce, METH_NOARGS, Spot_reduce_doc},
+    {"__setstate__", (PyCFunction)Spot_setstate, METH_O, Spot_setstate_doc},
     {"excesses", (PyCFunction)Spot_excesses, METH_NOARGS, Spot_excess_doc},
     {"as_dict", (PyCFunction)Spot_as_dict, METH_NOARGS, Spot_as_dict_doc},
     {NULL} /* Sentinel */
@@ -282,11 +959,11 @@ static const PyMethodDef Spot_methods[] = {
 // https://doc.qt.io/qtforpython-6/developer/limited_api.html#future-versions-of-the-limited-api
 
 static PyType_Slot SpotType_slots[] = {
+    {Py_tp_new, (void *)Spot_new},
     {Py_tp_dealloc, (void *)Spot_dealloc},
     {Py_tp_members, (void *)Spot_members},
     {Py_tp_methods, (void *)Spot_methods},
     {Py_tp_init, (void *)Spot_init},
-    {Py_tp_dealloc, (void *)Spot_dealloc},
     {Py_tp_doc, (void *)Spot_init_doc},
     {0, NULL},
 };
@@ -315,49 +992,611 @@ static PyType_Spec SpotType_spec = {
 // };
 // clang-format on
 
-static PyModuleDef libspotmodule = {
-    PyModuleDef_HEAD_INIT,
-    .m_name = "libspot",
-    .m_doc = "Born to flag outliers, from python :)",
-    .m_size = -1,
-};
+//
+// SpotPool object
+//
 
-PyMODINIT_FUNC PyInit_libspot(void) {
-    PyObject *SpotType = PyType_FromSpec(&SpotType_spec);
-    if (PyType_Ready((PyTypeObject *)SpotType) < 0) {
+// clang-format off
+typedef struct {
+    PyObject_HEAD
+    struct Spot *spots;
+    unsigned long size;
+    unsigned long threads;
+    // held while the detectors are used (concurrent calls wait)
+    ObjectLock lock;
+} SpotPool;
+// clang-format on
+
+/**
+ * @brief Values of ids grouped by detector: the positions of the values of
+ * the detector i are order[offsets[i]], ..., order[offsets[i + 1] - 1] (in
+ * their original order). The values and the results are gathered in the
+ * same order.
+ */
+typedef struct {
+    unsigned long *offsets;
+    unsigned long *order;
+    double *values;
+    signed char *results;
+} PoolGroups;
+
+/**
+ * @brief Work of a thread: the detectors [begin, end) of the pool
+ */
+typedef struct PoolTask {
+    void (*run)(struct PoolTask *);
+    struct Spot *spots;
+    unsigned long begin;
+    unsigned long end;
+    // one row per detector, or the values of the ids
+    Doubles const *x;
+    signed char *results;
+    // positions of the values grouped by detector (see pool_group_ids)
+    PoolGroups const *groups;
+    // first error
+    int status;
+} PoolTask;
+
+static void pool_fit_rows(PoolTask *t) {
+    for (unsigned long i = t->begin; i < t->end; i++) {
+        // libspot API call
+        int result =
+            spot_fit(&(t->spots[i]), t->x->data + i * t->x->cols, t->x->cols);
+        if ((result < 0) && (t->status == 0)) {
+            t->status = result;
+        }
+    }
+}
+
+static void pool_step_rows(PoolTask *t) {
+    unsigned long const cols = t->x->cols;
+    for (unsigned long i = t->begin; i < t->end; i++) {
+        step_into(&(t->spots[i]), t->x->data + i * cols, cols,
+                  t->results + i * cols);
+    }
+}
+
+static void pool_step_ids(PoolTask *t) {
+    PoolGroups const *g = t->groups;
+    unsigned long const first = g->offsets[t->begin];
+    unsigned long const last = g->offsets[t->end];
+    for (unsigned long k = first; k < last; k++) {
+        g->values[k] = t->x->data[g->order[k]];
+    }
+    // a single batch per detector
+    for (unsigned long i = t->begin; i < t->end; i++) {
+        unsigned long const k = g->offsets[i];
+        if (g->offsets[i + 1] > k) {
+            step_into(&(t->spots[i]), g->values + k, g->offsets[i + 1] - k,
+                      g->results + k);
+        }
+    }
+    for (unsigned long k = first; k < last; k++) {
+        t->results[g->order[k]] = g->results[k];
+    }
+}
+
+static void pool_groups_free(PoolGroups *g) {
+    free(g->offsets);
+    free(g->order);
+    free(g->values);
+    free(g->results);
+}
+
+/**
+ * @brief Group the positions of the values by detector with a counting sort
+ * (the ids must be valid)
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int pool_group_ids(PoolGroups *g, Ids const *ids, unsigned long size) {
+    unsigned long const n = ids->size ? ids->size : 1;
+    g->offsets = calloc(size + 1, sizeof(unsigned long));
+    g->order = malloc(n * sizeof(unsigned long));
+    g->values = malloc(n * sizeof(double));
+    g->results = malloc(n);
+    if ((g->offsets == NULL) || (g->order == NULL) || (g->values == NULL) ||
+        (g->results == NULL)) {
+        pool_groups_free(g);
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (unsigned long j = 0; j < ids->size; j++) {
+        g->offsets[ids->data[j] + 1]++;
+    }
+    for (unsigned long i = 0; i < size; i++) {
+        g->offsets[i + 1] += g->offsets[i];
+    }
+    // offsets[i] is the cursor of the detector i (it ends at offsets[i + 1])
+    for (unsigned long j = 0; j < ids->size; j++) {
+        g->order[g->offsets[ids->data[j]]++] = j;
+    }
+    // so they are shifted back once filled
+    for (unsigned long i = size; i > 0; i--) {
+        g->offsets[i] = g->offsets[i - 1];
+    }
+    g->offsets[0] = 0;
+    return 0;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI pool_thread(LPVOID arg) {
+    PoolTask *t = (PoolTask *)arg;
+    t->run(t);
+    return 0;
+}
+#else
+static void *pool_thread(void *arg) {
+    PoolTask *t = (PoolTask *)arg;
+    t->run(t);
+    return NULL;
+}
+#endif
+
+/**
+ * @brief Run the tasks on native threads (the first one in the calling
+ * thread) and wait for them. It does not need the GIL.
+ *
+ * @return the first error of the tasks (0 if none)
+ */
+static int pool_run(PoolTask *tasks, unsigned long count) {
+#ifdef _WIN32
+    HANDLE handles[SPOT_POOL_MAX_THREADS];
+#else
+    pthread_t handles[SPOT_POOL_MAX_THREADS];
+#endif
+    int started[SPOT_POOL_MAX_THREADS];
+
+    for (unsigned long i = 1; i < count; i++) {
+#ifdef _WIN32
+        handles[i] = CreateThread(NULL, 0, pool_thread, &tasks[i], 0, NULL);
+        started[i] = (handles[i] != NULL);
+#else
+        started[i] =
+            (pthread_create(&handles[i], NULL, pool_thread, &tasks[i]) == 0);
+#endif
+        if (!started[i]) {
+            // no more thread: the task runs in the calling thread
+            tasks[i].run(&tasks[i]);
+        }
+    }
+    tasks[0].run(&tasks[0]);
+
+    int status = tasks[0].status;
+    for (unsigned long i = 1; i < count; i++) {
+        if (started[i]) {
+#ifdef _WIN32
+            WaitForSingleObject(handles[i], INFINITE);
+            CloseHandle(handles[i]);
+#else
+            pthread_join(handles[i], NULL);
+#endif
+        }
+        if (status == 0) {
+            status = tasks[i].status;
+        }
+    }
+    return status;
+}
+
+/**
+ * @brief Split the detectors of the pool between the threads and run the
+ * work without the GIL. The caller holds the lock of the pool.
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int SpotPool_run(SpotPool *self, void (*run)(PoolTask *),
+                        Doubles const *x, PoolGroups const *groups,
+                        signed char *results) {
+    if (self->spots == NULL) {
+        PyErr_SetString(PyExc_RuntimeError, "the pool is not initialized");
+        return -1;
+    }
+
+    PoolTask tasks[SPOT_POOL_MAX_THREADS];
+    unsigned long count = self->threads;
+    if (count > self->size) {
+        count = self->size;
+    }
+    for (unsigned long i = 0; i < count; i++) {
+        tasks[i].run = run;
+        tasks[i].spots = self->spots;
+        tasks[i].begin = (unsigned long)((unsigned long long)self->size * i /
+                                         count);
+        tasks[i].end = (unsigned long)((unsigned long long)self->size *
+                                       (i + 1) / count);
+        tasks[i].x = x;
+        tasks[i].groups = groups;
+        tasks[i].results = results;
+        tasks[i].status = 0;
+    }
+
+    int status;
+    Py_BEGIN_ALLOW_THREADS
+    status = pool_run(tasks, count);
+    Py_END_ALLOW_THREADS
+
+    if (status < 0) {
+        char buffer[256];
+        libspot_error(-status, buffer, 256);
+        PyErr_SetString(PyExc_RuntimeError, buffer);
+        return -1;
+    }
+    return 0;
+}
+
+static void SpotPool_clear(SpotPool *self) {
+    if (self->spots != NULL) {
+        for (unsigned long i = 0; i < self->size; i++) {
+            // libspot API call
+            spot_free(&(self->spots[i]));
+        }
+        free(self->spots);
+        self->spots = NULL;
+    }
+    self->size = 0;
+}
+
+/**
+ * @brief Replace the detectors of the pool
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int SpotPool_setup(SpotPool *self, unsigned long n, double q, int low,
+                          int discard_anomalies, double level,
+                          unsigned long max_excess) {
+    SpotPool_clear(self);
+    self->spots = malloc(n * sizeof(struct Spot));
+    if (self->spots == NULL) {
+        PyErr_NoMemory();
+        return -1;
+    }
+    for (unsigned long i = 0; i < n; i++) {
+        // libspot API call
+        int result = spot_init(&(self->spots[i]), q, low, discard_anomalies,
+                               level, max_excess);
+        if (result < 0) {
+            self->size = i;
+            SpotPool_clear(self);
+            char buffer[256];
+            libspot_error(-result, buffer, 256);
+            PyErr_SetString(PyExc_RuntimeError, buffer);
+            return -1;
+        }
+    }
+    self->size = n;
+    return 0;
+}
+
+// clang-format off
+PyDoc_STRVAR(
+    SpotPool_init_doc,
+    "SpotPool(n, q, low = " STR(SPOT_INIT_LOW)
+    ", discard_anomalies = " STR(SPOT_INIT_DISCARD_ANOMALIES)
+    ", level = " STR(SPOT_INIT_LEVEL)
+    ", max_excess = " STR(SPOT_INIT_MAX_EXCESS) ", threads = 0)\n--\n\n"
+    "Pool of n detectors stepped by native threads (one per CPU by default)");
+// clang-format on
+
+static int SpotPool_init(SpotPool *self, PyObject *args, PyObject *kwds) {
+    static char *kwlist[] = {"n",          "q",       "low",
+                             "discard_anomalies", "level", "max_excess",
+                             "threads",    NULL};
+    unsigned long n;
+    double q;
+    int low = SPOT_INIT_LOW;
+    int discard_anomalies = SPOT_INIT_DISCARD_ANOMALIES;
+    double level = SPOT_INIT_LEVEL;
+    unsigned long max_excess = SPOT_INIT_MAX_EXCESS;
+    unsigned long threads = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "kd|$iidkk", kwlist, &n, &q,
+                                     &low, &discard_anomalies, &level,
+                                     &max_excess, &threads))
+        return -1;
+
+    if (n == 0) {
+        PyErr_SetString(PyExc_ValueError, "the pool needs a detector");
+        return -1;
+    }
+    if (threads == 0) {
+        // one thread per CPU
+        PyObject *os = PyImport_ImportModule("os");
+        PyObject *cpus =
+            (os == NULL) ? NULL : PyObject_CallMethod(os, "cpu_count", NULL);
+        Py_XDECREF(os);
+        if (cpus == NULL) {
+            return -1;
+        }
+        threads = (cpus == Py_None) ? 1 : PyLong_AsUnsignedLong(cpus);
+        Py_DECREF(cpus);
+        if (PyErr_Occurred()) {
+            return -1;
+        }
+    }
+    if (threads > SPOT_POOL_MAX_THREADS) {
+        threads = SPOT_POOL_MAX_THREADS;
+    }
+
+    object_lock(&self->lock);
+    int status = SpotPool_setup(self, n, q, low, discard_anomalies, level,
+                                max_excess);
+    if (status == 0) {
+        self->threads = threads;
+    }
+    object_unlock(&self->lock);
+    return status;
+}
+
+/**
+ * @brief Check that a 2-D array has one row per detector (the pool lock must
+ * be held, as the size changes with __init__)
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int SpotPool_check_rows(SpotPool *self, Doubles const *x) {
+    if ((x->ndim != 2) || (x->rows != self->size)) {
+        PyErr_Format(PyExc_ValueError,
+                     "expected a 2-D array with %lu rows (one per detector)",
+                     self->size);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * @brief Check the detector ids (the pool lock must be held)
+ *
+ * @return 0 on success, -1 with a python exception set
+ */
+static int SpotPool_check_ids(SpotPool *self, Ids const *ids) {
+    for (unsigned long j = 0; j < ids->size; j++) {
+        if ((ids->data[j] < 0) ||
+            ((unsigned long long)ids->data[j] >= self->size)) {
+            PyErr_Format(PyExc_IndexError, "invalid detector id %lld",
+                         ids->data[j]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+PyDoc_STRVAR(SpotPool_fit_doc,
+             "fit($self, data)\n--\n\n"
+             "Fit every detector with its row of a 2-D array (series x "
+             "time)");
+
+static PyObject *SpotPool_fit(SpotPool *self, PyObject *data) {
+    Doubles x;
+    if (doubles_get(data, &x) < 0) {
+        return NULL;
+    }
+    object_lock(&self->lock);
+    int status = SpotPool_check_rows(self, &x);
+    if (status == 0) {
+        status = SpotPool_run(self, pool_fit_rows, &x, NULL, NULL);
+    }
+    object_unlock(&self->lock);
+    doubles_release(&x);
+    if (status < 0) {
+        return NULL;
+    }
+    Py_RETURN_NONE;
+}
+
+PyDoc_STRVAR(
+    SpotPool_step_doc,
+    "step($self, data, values=None)\n--\n\n"
+    "Fit-predict steps. Either data is a 2-D array (series x time), or data "
+    "holds the ids of the detectors (int64) and values the values. It "
+    "returns the results as a memoryview of int8 with the shape of the "
+    "values (-1 for the NaN values)");
+
+static PyObject *SpotPool_step(SpotPool *self, PyObject *args) {
+    PyObject *data;
+    PyObject *values = Py_None;
+    if (!PyArg_ParseTuple(args, "O|O", &data, &values)) {
+        return NULL;
+    }
+
+    Doubles x;
+    Ids ids;
+    int const by_id = (values != Py_None);
+    if (by_id) {
+        if (ids_get(data, &ids) < 0) {
+            return NULL;
+        }
+        if (doubles_get_1d(values, &x) < 0) {
+            ids_release(&ids);
+            return NULL;
+        }
+        if (ids.size != x.size) {
+            PyErr_SetString(PyExc_ValueError,
+                            "ids and values must have the same length");
+            ids_release(&ids);
+            doubles_release(&x);
+            return NULL;
+        }
+    } else if (doubles_get(data, &x) < 0) {
         return NULL;
     }
 
-    PyObject *m = PyModule_Create(&libspotmodule);
-    if (m == NULL) {
+    PyObject *bytes = PyByteArray_FromStringAndSize(NULL, x.size);
+    int status = -1;
+    if (bytes != NULL) {
+        signed char *out = (signed char *)PyByteArray_AsString(bytes);
+        // the ids and the shape are checked against the current size
+        object_lock(&self->lock);
+        status = by_id ? SpotPool_check_ids(self, &ids)
+                       : SpotPool_check_rows(self, &x);
+        if ((status == 0) && by_id) {
+            PoolGroups groups;
+            status = pool_group_ids(&groups, &ids, self->size);
+            if (status == 0) {
+                status = SpotPool_run(self, pool_step_ids, &x, &groups, out);
+                pool_groups_free(&groups);
+            }
+        } else if (status == 0) {
+            status = SpotPool_run(self, pool_step_rows, &x, NULL, out);
+        }
+        object_unlock(&self->lock);
+    }
+    doubles_release(&x);
+    if (by_id) {
+        ids_release(&ids);
+    }
+    if (status < 0) {
+        Py_XDECREF(bytes);
+        return NULL;
+    }
+    return typed_view(bytes, "b", x.rows, x.cols, by_id ? 1 : 2);
+}
+
+PyDoc_STRVAR(SpotPool_anomaly_thresholds_doc,
+             "anomaly_thresholds($self)\n--\n\n"
+             "Return the anomaly thresholds of the detectors as a "
+             "memoryview of float64");
+
+static PyObject *SpotPool_anomaly_thresholds(SpotPool *self) {
+    object_lock(&self->lock);
+    unsigned long const size = self->size;
+    PyObject *bytes =
+        PyByteArray_FromStringAndSize(NULL, size * sizeof(double));
+    if (bytes != NULL) {
+        double *out = (double *)PyByteArray_AsString(bytes);
+        for (unsigned long i = 0; i < size; i++) {
+            out[i] = self->spots[i].anomaly_threshold;
+        }
+    }
+    object_unlock(&self->lock);
+    if (bytes == NULL) {
         return NULL;
     }
+    return typed_view(bytes, "d", 1, size, 1);
+}
+
+static Py_ssize_t SpotPool_len(SpotPool *self) {
+    return (Py_ssize_t)self->size;
+}
+
+static PyObject *SpotPool_new(PyTypeObject *type, PyObject *args,
+                              PyObject *kwds) {
+    (void)args;
+    (void)kwds;
+    return locked_new(type, offsetof(SpotPool, lock));
+}
+
+static void SpotPool_dealloc(SpotPool *self) {
+    PyTypeObject *type = Py_TYPE((PyObject *)self);
+    SpotPool_clear(self);
+    object_lock_free(&self->lock);
+    freefunc tp_free = (freefunc)PyType_GetSlot(type, Py_tp_free);
+    tp_free(self);
+    Py_DECREF(type);
+}
+
+static const PyMemberDef SpotPool_members[] = {
+    {"threads", T_ULONG, offsetof(SpotPool, threads), READONLY,
+     "Number of threads"},
+    {NULL} /* Sentinel */
+};
+
+static const PyMethodDef SpotPool_methods[] = {
+    {"fit", (PyCFunction)SpotPool_fit, METH_O, SpotPool_fit_doc},
+    {"step", (PyCFunction)SpotPool_step, METH_VARARGS, SpotPool_step_doc},
+    {"anomaly_thresholds", (PyCFunction)SpotPool_anomaly_thresholds,
+     METH_NOARGS, SpotPool_anomaly_thresholds_doc},
+    {NULL} /* Sentinel */
+};
+
+static PyType_Slot SpotPoolType_slots[] = {
+    {Py_tp_new, (void *)SpotPool_new},
+    {Py_tp_dealloc, (void *)SpotPool_dealloc},
+    {Py_tp_members, (void *)SpotPool_members},
+    {Py_tp_methods, (void *)SpotPool_methods},
+    {Py_tp_init, (void *)SpotPool_init},
+    {Py_sq_length, (void *)SpotPool_len},
+    {Py_tp_doc, (void *)SpotPool_init_doc},
+    {0, NULL},
+};
+
+static PyType_Spec SpotPoolType_spec = {
+    .name = "libspot.SpotPool",
+    .basicsize = sizeof(SpotPool),
+    .itemsize = 0,
+    .flags = Py_TPFLAGS_DEFAULT | Py_TPFLAGS_BASETYPE,
+    .slots = SpotPoolType_slots,
+};
 
-    Py_INCREF(SpotType);
+/**
+ * @brief Fill a module object (multi-phase initialization, so the module
+ * can declare that it does not need the GIL)
+ */
+static int libspot_exec(PyObject *m) {
+    // set default allocators: once, since the detectors of other module
+    // objects (sub-interpreters) may be running
+    // libspot API call
+    static int allocators_ready = 0;
+    if (!allocators_ready) {
+        set_allocators(malloc, free);
+        allocators_ready = 1;
+    }
 
     // inject __version__
     char buffer[64];
     libspot_version(buffer, 64);
     if (PyModule_AddStringConstant(m, "__version__", buffer) < 0) {
-        return NULL;
+        return -1;
     }
 
     // add global constants
     if (PyModule_AddIntConstant(m, "NORMAL", NORMAL) < 0) {
-        return NULL;
+        return -1;
     }
     if (PyModule_AddIntConstant(m, "EXCESS", EXCESS) < 0) {
-        return NULL;
+        return -1;
     }
     if (PyModule_AddIntConstant(m, "ANOMALY", ANOMALY) < 0) {
-        return NULL;
+        return -1;
     }
 
     // add Spot object
-    PyModule_AddObject(m, "Spot", SpotType);
+    PyObject *SpotType = PyType_FromSpec(&SpotType_spec);
+    if (SpotType == NULL) {
+        return -1;
+    }
+    if (PyModule_AddObject(m, "Spot", SpotType) < 0) {
+        Py_DECREF(SpotType);
+        return -1;
+    }
 
-    // set default allocators
-    // libspot API call
-    set_allocators(malloc, free);
-    return m;
+    // add SpotPool object
+    PyObject *SpotPoolType = PyType_FromSpec(&SpotPoolType_spec);
+    if (SpotPoolType == NULL) {
+        return -1;
+    }
+    if (PyModule_AddObject(m, "SpotPool", SpotPoolType) < 0) {
+        Py_DECREF(SpotPoolType);
+        return -1;
+    }
+    return 0;
 }
+
+static PyModuleDef_Slot libspot_slots[] = {
+    {Py_mod_exec, (void *)libspot_exec},
+#ifdef Py_mod_gil
+    // free-threaded builds: the objects lock themselves
+    {Py_mod_gil, Py_MOD_GIL_NOT_USED},
+#endif
+    {0, NULL},
+};
+
+static PyModuleDef libspotmodule = {
+    PyModuleDef_HEAD_INIT,
+    .m_name = "libspot",
+    .m_doc = "Born to flag outliers, from python :)",
+    .m_size = 0,
+    .m_slots = libspot_slots,
+};
+
+PyMODINIT_FUNC PyInit_libspot(void) { return PyModuleDef_Init(&libspotmodule); }
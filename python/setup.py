@@ -1,6 +1,7 @@
 import ctypes
 import os
 import sys
+import sysconfig
 from pathlib import Path
 
 from setuptools import Extension, setup
@@ -16,15 +17,31 @@ SOURCES = [SRC_DIR / f for f in os.listdir(SRC_DIR) if f.endswith(".c")] + [
 ]
 
 C99_ARG = r"/std:c99" if sys.platform == "win32" else r"-std=c99"
+# SpotPool threads (native threads on windows)
+THREAD_ARGS = [] if sys.platform == "win32" else ["-pthread"]
+
+
+# The buffer protocol (zero-copy numpy inputs) belongs to the Limited API
+# since 3.11. Older interpreters get a 3.6 wheel that copies the inputs.
+# Free-threaded interpreters (3.13t) do not support the Limited API: they get
+# a regular wheel.
+FREE_THREADED = bool(sysconfig.get_config_var("Py_GIL_DISABLED"))
+if FREE_THREADED:
+    LIMITED_API = None
+elif sys.version_info >= (3, 11):
+    LIMITED_API = ("cp311", "0x030B0000")
+else:
+    LIMITED_API = ("cp36", "0x03060000")
 
 
 class bdist_wheel_abi3(bdist_wheel):
     def get_tag(self):
         python, abi, plat = super().get_tag()
 
-        if python.startswith("cp"):
-            # on CPython, our wheels are abi3 and compatible back to 3.6
-            return "cp36", "abi3", plat
+        if python.startswith("cp") and LIMITED_API is not None:
+            # on CPython, our wheels are abi3 and compatible with the later
+            # versions
+            return LIMITED_API[0], "abi3", plat
 
         return python, abi, plat
 
@@ -44,10 +61,10 @@ def get_version() -> str:
     return makefile[i:j].replace("VERSION", "").replace("=", "").strip()
 
 
-define_macros = [
-    ("VERSION", f'"{get_version()}"'),
-    ("Py_LIMITED_API", "0x03060000"),  # macro to use Python Limited API (here >=cp36)
-]
+define_macros = [("VERSION", f'"{get_version()}"')]
+if LIMITED_API is not None:
+    # macro to use Python Limited API
+    define_macros += [("Py_LIMITED_API", LIMITED_API[1])]
 
 # windows specific
 if sys.platform == "win32":
@@ -76,8 +93,9 @@ lib = Extension(
     include_dirs=list(map(str, INCLUDE_DIRS)),
     sources=list(map(str, SOURCES)),
     extra_compile_args=[C99_ARG],
+    extra_link_args=THREAD_ARGS,
     define_macros=define_macros,  # type: ignore
-    py_limited_api=True,
+    py_limited_api=LIMITED_API is not None,
 )
 
 # other parameters are defined in pyproject.toml
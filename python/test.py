@@ -1,12 +1,15 @@
 import inspect
+import pickle
 import struct
 import tempfile
+import threading
+from multiprocessing import shared_memory
 from unittest import TestCase
 
 import libspot  # type:ignore
 import matplotlib.pyplot as plt
 import numpy as np
-from libspot import Spot  # pylint: disable=E0611
+from libspot import Spot, SpotPool  # pylint: disable=E0611
 
 
 class Test(TestCase):
@@ -27,7 +30,14 @@ class Test(TestCase):
         UBEND_FLAT_PACKING_FORMAT = "LLdiP"
         PEAKS_FLAT_PACKING_FORMAT = "dddd" + UBEND_FLAT_PACKING_FORMAT
         TAIL_FLAT_PACKING_FORMAT = "dd" + PEAKS_FLAT_PACKING_FORMAT
-        SPOT_FLAT_PACKING_FORMAT = "ddiidddLL" + TAIL_FLAT_PACKING_FORMAT
+        P2_FLAT_PACKING_FORMAT = "20dL"
+        SPOT_FLAT_PACKING_FORMAT = (
+            "ddiidddLL"
+            + TAIL_FLAT_PACKING_FORMAT
+            + "d"
+            + P2_FLAT_PACKING_FORMAT
+            + UBEND_FLAT_PACKING_FORMAT
+        )
         s = Spot(1e-6)
         X = np.random.standard_normal(10_000)
         s.fit(X)
@@ -54,6 +64,185 @@ class Test(TestCase):
     #     s.fit(X)
     # print(s.dump())
 
+    def test_serialize(self):
+        s = Spot(1e-4, level=0.99, max_excess=500)
+        X = np.random.standard_normal(100_000)
+        s.fit(X[:50_000])
+        for x in X[50_000:60_000]:
+            s.step(x)
+        data = s.serialize()
+        assert data[:4] == b"SPOT"
+
+        r = Spot.fromraw(data)
+        assert r.n == s.n
+        assert r.Nt == s.Nt
+        assert r.anomaly_threshold == s.anomaly_threshold
+        assert sorted(r.excesses()) == sorted(s.excesses())
+        for x in X[60_000:]:
+            assert r.step(x) == s.step(x)
+
+        with self.assertRaises(ValueError):
+            Spot.fromraw(data[:-8])
+
+    def test_pickle(self):
+        s = Spot(1e-4, level=0.99, max_excess=500)
+        X = np.random.standard_normal(60_000)
+        s.fit(X[:50_000])
+        r = pickle.loads(pickle.dumps(s))
+        assert type(r) is Spot
+        assert r.n == s.n
+        assert r.anomaly_threshold == s.anomaly_threshold
+        assert sorted(r.excesses()) == sorted(s.excesses())
+        assert r.step_many(X[50_000:]).tolist() == s.step_many(X[50_000:]).tolist()
+
+    def test_shared_memory(self):
+        s = Spot(1e-4, level=0.99)
+        s.fit(np.random.standard_normal(50_000))
+        size = len(s.serialize())
+        with self.assertRaises(ValueError):
+            s.serialize_into(bytearray(size - 1))
+
+        shm = shared_memory.SharedMemory(create=True, size=size)
+        try:
+            # shm.buf may be larger than the snapshot
+            assert s.serialize_into(shm.buf) == size
+            r = Spot.fromraw(shm.buf)
+            assert r.serialize() == s.serialize()
+        finally:
+            shm.close()
+            shm.unlink()
+
+    def test_step_many(self):
+        X = np.random.standard_normal(100_000)
+        s = Spot(1e-4, level=0.99)
+        r = Spot(1e-4, level=0.99)
+        # buffer (no copy) and list inputs
+        s.fit(X[:50_000])
+        r.fit(X[:50_000].tolist())
+        assert s.anomaly_threshold == r.anomaly_threshold
+
+        X[60_000] = np.nan
+        results = np.asarray(s.step_many(X[50_000:]))
+        assert results.dtype == np.int8
+        assert results.size == 50_000
+        expected = [r.step(x) for x in X[50_000:]]
+        expected[10_000] = -1
+        assert results.tolist() == expected
+        assert s.n == r.n
+        assert s.anomaly_threshold == r.anomaly_threshold
+
+        # strided arrays and other sequences are copied
+        assert len(s.step_many(X[::2])) == 50_000
+        results = s.step_many([0.0, 100.0]).tolist()
+        assert results == [libspot.NORMAL, libspot.ANOMALY]
+        with self.assertRaises(TypeError):
+            s.step_many(["a"])
+
+    def test_pool(self):
+        n = 20
+        X = np.random.standard_normal((n, 40_000))
+        pool = SpotPool(n, 1e-4, level=0.99, threads=4)
+        assert len(pool) == n
+        assert pool.threads == 4
+        pool.fit(X[:, :20_000])
+        results = np.asarray(pool.step(X[:, 20_000:]))
+        assert results.dtype == np.int8
+        assert results.shape == (n, 20_000)
+
+        thresholds = np.asarray(pool.anomaly_thresholds())
+        spots = {}
+        for i in range(0, n, 7):
+            s = Spot(1e-4, level=0.99)
+            s.fit(X[i, :20_000])
+            assert results[i].tolist() == [s.step(x) for x in X[i, 20_000:]]
+            assert thresholds[i] == s.anomaly_threshold
+            spots[i] = s
+
+        # (ids, values) form: the values of a series keep their order
+        ids = np.random.randint(0, n, size=10_000)
+        values = np.random.standard_normal(10_000)
+        values[::100] = 10.0
+        results = np.asarray(pool.step(ids, values))
+        assert results.shape == (10_000,)
+        for i, s in spots.items():
+            steps = [s.step(x) for x in values[ids == i]]
+            assert results[ids == i].tolist() == steps
+        with self.assertRaises(IndexError):
+            pool.step([n], [0.0])
+        with self.assertRaises(ValueError):
+            pool.step([0, 1], [0.0])
+        with self.assertRaises(ValueError):
+            pool.step(X[:2])
+
+    def test_shared_pool_resize(self):
+        # __init__ changes the number of detectors: the ids and the shapes
+        # are checked under the lock of the pool
+        n = 20
+        pool = SpotPool(n, 1e-4, level=0.99, threads=2)
+        ids = np.full(1_000, n - 1)
+        values = np.random.standard_normal(1_000)
+        rows = np.random.standard_normal((n, 50))
+
+        def resize():
+            for k in range(200):
+                pool.__init__(2 if k % 2 == 0 else n, 1e-4, level=0.99)
+
+        def step():
+            for _ in range(200):
+                try:
+                    pool.step(ids, values)
+                    pool.step(rows)
+                except (IndexError, ValueError):
+                    pass
+
+        threads = [threading.Thread(target=resize)]
+        threads += [threading.Thread(target=step) for _ in range(2)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert len(pool) == n
+
+    def test_shared_spot(self):
+        # concurrent steps on the same detector are serialized by its lock
+        s = Spot(1e-4, level=0.99)
+        s.fit(np.random.standard_normal(10_000))
+        n = s.n
+
+        def work():
+            for _ in range(5_000):
+                s.step(0.0)
+            s.step_many(np.zeros(5_000))
+
+        threads = [threading.Thread(target=work) for _ in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        assert s.n == n + 4 * 10_000
+
+    def test_shared_spot_fit(self):
+        # fit replaces the tail that step_many is stepping on another thread
+        # (both run without the GIL): the lock serializes them
+        s = Spot(1e-4, level=0.99, discard_anomalies=False)
+        training = np.random.standard_normal(10_000)
+        s.fit(training)
+
+        def work():
+            for _ in range(20):
+                s.fit(training)
+                s.step_many(np.random.standard_normal(5_000))
+
+        threads = [threading.Thread(target=work) for _ in range(4)]
+        for t in threads:
+            t.start()
+        for t in threads:
+            t.join()
+        # the last step_many follows a fit
+        assert (s.n - len(training)) % 5_000 == 0
+        assert s.n <= len(training) + 4 * 5_000
+        assert s.excess_threshold < s.anomaly_threshold
+
     def test_excesses(self):
         max_excess = 800
         s = Spot(1e-6, level=0.98, max_excess=max_excess)
@@ -9,9 +9,9 @@
  */
 #include "brent.h"
 
-double const BRENT_DEFAULT_EPSILON = 2.0e-8;
+LIBSPOT_INTERNAL double const BRENT_DEFAULT_EPSILON = 2.0e-8;
 
-unsigned long const BRENT_ITMAX = 200;
+LIBSPOT_INTERNAL unsigned long const BRENT_ITMAX = 200;
 
 // fabs is reserved on windows
 static double _fabs(double a) {
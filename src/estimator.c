@@ -24,11 +24,21 @@ static double grimshaw_w(double x, void *peaks_as_void) {
     unsigned long Nt_local = peaks_size(peaks);
     double u = 0.0;
     double v = 0.0;
+    double s[PEAKS_BLOCK];
+    double logs[PEAKS_BLOCK];
 
-    for (unsigned long i = 0; i < Nt_local; ++i) {
-        double s = 1. + x * peaks->container.data[i];
-        u += 1 / s;
-        v += xlog(s);
+    for (unsigned long i = 0; i < Nt_local; i += PEAKS_BLOCK) {
+        unsigned long const n =
+            (Nt_local - i < PEAKS_BLOCK) ? (Nt_local - i) : PEAKS_BLOCK;
+        for (unsigned long j = 0; j < n; ++j) {
+            s[j] = 1. + x * peaks->container.data[i + j];
+        }
+        xlog_batch(s, logs, n);
+        // same order as the scalar sums
+        for (unsigned long j = 0; j < n; ++j) {
+            u += 1 / s[j];
+            v += logs[j];
+        }
     }
     return (u / Nt_local) * (1.0 + v / Nt_local) - 1.0;
 }
@@ -36,8 +46,17 @@ static double grimshaw_w(double x, void *peaks_as_void) {
 static double grimshaw_v(double x, struct Peaks const *peaks) {
     double v = 0.0;
     unsigned long Nt_local = peaks_size(peaks);
-    for (unsigned long i = 0; i < Nt_local; ++i) {
-        v += xlog(1.0 + x * peaks->container.data[i]);
+    double logs[PEAKS_BLOCK];
+    for (unsigned long i = 0; i < Nt_local; i += PEAKS_BLOCK) {
+        unsigned long const n =
+            (Nt_local - i < PEAKS_BLOCK) ? (Nt_local - i) : PEAKS_BLOCK;
+        for (unsigned long j = 0; j < n; ++j) {
+            logs[j] = 1.0 + x * peaks->container.data[i + j];
+        }
+        xlog_batch(logs, logs, n);
+        for (unsigned long j = 0; j < n; ++j) {
+            v += logs[j];
+        }
     }
     return 1.0 + v / Nt_local;
 }
@@ -1,21 +1,13 @@
 
 #include "p2.h"
 
-// See aakinshin.net/posts/p2-quantile-estimator/
-struct P2 {
-    double q[5];
-    double n[5];
-    double np[5];
-    double dn[5];
-};
-
 static void swap(double *a, double *b) {
     double temp = *a;
     *a = *b;
     *b = temp;
 }
 
-void sort5(double a[5]) {
+LIBSPOT_INTERNAL void sort5(double a[5]) {
     if (a[1] < a[0]) // Compare 1st and 2nd element #1
         swap(&a[0], &a[1]);
     if (a[3] < a[2]) // Compare 3rd and 4th element #2
@@ -66,7 +58,7 @@ void sort5(double a[5]) {
     }
 }
 
-static void init_p2(struct P2 *p2, double p) {
+void p2_init(struct P2 *p2, double p) {
     for (unsigned i = 0; i < 5; i++) {
         p2->q[i] = 0.0;
         p2->n[i] = (double)i;
@@ -83,6 +75,8 @@ static void init_p2(struct P2 *p2, double p) {
     p2->dn[2] = p;
     p2->dn[3] = (p + 1) / 2;
     p2->dn[4] = 1;
+
+    p2->count = 0;
 }
 
 static double sign(double d) {
@@ -95,12 +89,12 @@ static double sign(double d) {
     return 0.0;
 }
 
-static double linear(struct P2 *p2, unsigned int i, int d) {
+static double linear(struct P2 const *p2, unsigned int i, int d) {
     return p2->q[i] +
            d * (p2->q[i + d] - p2->q[i]) / (p2->n[i + d] - p2->n[i]);
 }
 
-static double parabolic(struct P2 *p2, unsigned int i, int d) {
+static double parabolic(struct P2 const *p2, unsigned int i, int d) {
     return p2->q[i] +
            (d / (p2->n[i + 1] - p2->n[i - 1])) *
                ((p2->n[i] - p2->n[i - 1] + d) * (p2->q[i + 1] - p2->q[i]) /
@@ -109,65 +103,86 @@ static double parabolic(struct P2 *p2, unsigned int i, int d) {
                     (p2->n[i] - p2->n[i - 1]));
 }
 
-static double quantile(struct P2 *p2, double const *x, unsigned long size) {
-    unsigned int k;
+/**
+ * @brief Insert a new value into the P2 estimator
+ *
+ * Instead of searching the cell of x (q[k] <= x < q[k + 1]) and looping from
+ * k + 1, we use the fact that the markers are sorted: the positions to
+ * increment are exactly those such that x <= q[i]. So the update is a masked
+ * add over the 5 markers, without data-dependent branches.
+ */
+static void update(struct P2 *p2, double x) {
     unsigned int i;
-    // double d = 0.0;
     double qp;
 
-    if (size < 5) {
-        return 0.0;
+    if (x < p2->q[0]) {
+        p2->q[0] = x;
+        return;
     }
-    // init q with the 5 first values
+    if (x > p2->q[4]) {
+        p2->q[4] = x;
+        return;
+    }
+
     for (i = 0; i < 5; i++) {
-        p2->q[i] = x[i];
+        p2->n[i] += (double)(x <= p2->q[i]);
+        p2->np[i] += p2->dn[i];
     }
 
-    sort5(p2->q);
-    // now treat the other values
-    for (unsigned long j = 5; j < size; j++) {
-        double xj = x[j];
-        if (xj < p2->q[0]) {
-            // k = 0;
-            p2->q[0] = xj;
-        } else if (xj > p2->q[4]) {
-            // k = 3;
-            p2->q[4] = xj;
-        } else {
-            k = 0;
-            while (xj > p2->q[k]) {
-                k++;
-            }
-            k--;
-            // here q[k] < x < q[k + 1]
-            for (i = k + 1; i < 5; i++) {
-                p2->n[i] += 1.0;
-            }
-            for (i = 0; i < 5; i++) {
-                p2->np[i] += p2->dn[i];
+    // update other markers
+    for (i = 1; i < 4; i++) {
+        double d = p2->np[i] - p2->n[i];
+        if ((d >= 1 && (p2->n[i + 1] - p2->n[i]) > 1) ||
+            (d <= -1 && (p2->n[i - 1] - p2->n[i]) < -1)) {
+            d = sign(d);
+            qp = parabolic(p2, i, (int)d);
+            if (!(p2->q[i - 1] < qp && qp < p2->q[i + 1])) {
+                qp = linear(p2, i, (int)d);
             }
+            p2->q[i] = qp;
+            p2->n[i] += d;
+        }
+    }
+}
 
-            // update other markers
-            for (i = 1; i < 4; i++) {
-                double d = p2->np[i] - p2->n[i];
-                if ((d >= 1 && (p2->n[i + 1] - p2->n[i]) > 1) ||
-                    (d <= -1 && (p2->n[i - 1] - p2->n[i]) < -1)) {
-                    d = sign(d);
-                    qp = parabolic(p2, i, (int)d);
-                    if (!(p2->q[i - 1] < qp && qp < p2->q[i + 1])) {
-                        qp = linear(p2, i, (int)d);
-                    }
-                    p2->q[i] = qp;
-                    p2->n[i] += d;
-                }
-            }
+void p2_feed(struct P2 *p2, double const *data, unsigned long size) {
+    unsigned long j = 0;
+    // init q with the 5 first values
+    for (; (j < size) && (p2->count < 5); j++) {
+        p2->q[p2->count++] = data[j];
+        if (p2->count == 5) {
+            sort5(p2->q);
         }
     }
+    // now treat the other values
+    p2->count += size - j;
+    for (; j < size; j++) {
+        update(p2, data[j]);
+    }
+}
+
+void p2_push(struct P2 *p2, double x) { p2_feed(p2, &x, 1); }
+
+void p2_scale(struct P2 *p2, double factor) {
+    for (unsigned int i = 0; i < 5; i++) {
+        p2->n[i] *= factor;
+        p2->np[i] *= factor;
+    }
+}
+
+double p2_value(struct P2 const *p2) {
+    if (p2->count < 5) {
+        return _NAN;
+    }
     return p2->q[2];
 }
 
 double p2_quantile(double p, double const *data, unsigned long size) {
     struct P2 p2;
-    init_p2(&p2, p);
-    return quantile(&p2, data, size);
+    if (size < 5) {
+        return 0.0;
+    }
+    p2_init(&p2, p);
+    p2_feed(&p2, data, size);
+    return p2_value(&p2);
 }
@@ -42,7 +42,7 @@ static unsigned long peaks_update_stats(struct Peaks *peaks) {
         // value = *iterator;
         double value = peaks->container.data[i];
         peaks->e += value;
-        peaks->e2 = value * value;
+        peaks->e2 += value * value;
         if (is_nan(peaks->min) || (value < peaks->min)) {
             peaks->min = value;
         }
@@ -88,6 +88,17 @@ void peaks_push(struct Peaks *peaks, double x) {
     }
 }
 
+void peaks_shift(struct Peaks *peaks, double delta) {
+    struct Ubend *container = &(peaks->container);
+    unsigned long const size = ubend_size(container);
+    for (unsigned long i = 0; i < size; ++i) {
+        container->data[i] -= delta;
+    }
+    // only the positive peaks remain
+    ubend_filter(container, 0.0);
+    peaks_update_stats(peaks);
+}
+
 double peaks_mean(struct Peaks const *peaks) {
     return peaks->e / (double)peaks_size(peaks);
 }
@@ -108,8 +119,17 @@ double log_likelihood(struct Peaks const *peaks, double gamma, double sigma) {
     double r = -Nt * xlog(sigma);
     const double c = 1. + 1. / gamma;
     const double x = gamma / sigma;
-    for (unsigned long i = 0; i < Nt_local; ++i) {
-        r += -c * xlog(1 + x * peaks->container.data[i]);
+    double logs[PEAKS_BLOCK];
+    for (unsigned long i = 0; i < Nt_local; i += PEAKS_BLOCK) {
+        unsigned long const n =
+            (Nt_local - i < PEAKS_BLOCK) ? (Nt_local - i) : PEAKS_BLOCK;
+        for (unsigned long j = 0; j < n; ++j) {
+            logs[j] = 1 + x * peaks->container.data[i + j];
+        }
+        xlog_batch(logs, logs, n);
+        for (unsigned long j = 0; j < n; ++j) {
+            r += -c * logs[j];
+        }
     }
     return r;
 }
@@ -21,6 +21,17 @@
 static const char *version = VERSION;
 static const char *license = LICENSE;
 
+// number of data processed at once during a chunked fit: they remain in
+// cache between the update of the threshold estimate and the scan of the
+// candidates
+static unsigned long const FIT_BLOCK_SIZE = 1024;
+
+// first word of a snapshot: "SPOT" followed by the format version
+static __UINT32_TYPE__ const SNAPSHOT_MAGIC = 0x544f5053;
+static __UINT32_TYPE__ const SNAPSHOT_VERSION = 1;
+// number of words before the excesses (see spot_serialize)
+static unsigned long const SNAPSHOT_HEADER_WORDS = 35;
+
 int spot_init(struct Spot *spot, double q, int low, int discard_anomalies,
               double level, unsigned long max_excess) {
     if ((level < 0.) || (level >= 1.)) {
@@ -59,6 +70,21 @@ int spot_init(struct Spot *spot, double q, int low, int discard_anomalies,
     spot->anomaly_threshold = _NAN;
     spot->excess_threshold = _NAN;
 
+    // no recalibration by default
+    spot->rebase_tolerance = _NAN;
+    if (spot->low) {
+        p2_init(&(spot->tracker), 1. - level);
+    } else {
+        p2_init(&(spot->tracker), level);
+    }
+
+    // no chunked fit in progress (nothing is allocated)
+    spot->candidates.cursor = 0;
+    spot->candidates.capacity = 0;
+    spot->candidates.last_erased_data = _NAN;
+    spot->candidates.filled = 0;
+    spot->candidates.data = 0x0;
+
     return 0;
 }
 
@@ -73,42 +99,262 @@ void spot_free(struct Spot *spot) {
     spot->excess_threshold = _NAN;
     spot->Nt = 0;
     spot->n = 0;
+    spot->rebase_tolerance = _NAN;
     // free tail
     tail_free(&(spot->tail));
+    // free the candidates of an unfinished chunked fit
+    if (spot->candidates.data) {
+        ubend_free(&(spot->candidates));
+    }
 }
 
 int spot_fit(struct Spot *spot, double const *data, unsigned long size) {
-    // total number of excesses
+    // the data are read once: a bounded buffer keeps the candidate excesses
+    // (see spot_fit_begin)
+    unsigned long candidates = 4 * spot->tail.peaks.container.capacity;
+    if (candidates > size) {
+        candidates = (size > 0) ? size : 1;
+    }
+
+    int status = spot_fit_begin(spot, candidates);
+    if (status < 0) {
+        return status;
+    }
+    spot_fit_feed(spot, data, size);
+    return spot_fit_end(spot);
+}
+
+/**
+ * @brief Update the online estimate of the excess threshold and move the
+ * excess threshold when it has drifted beyond the tolerance
+ *
+ * @param spot Spot instance
+ * @param x new value
+ * @retval 1 the excess threshold has been moved (the tail must be refitted)
+ * @retval 0 otherwise
+ */
+static int spot_rebase(struct Spot *spot, double x) {
+    // the tracker forgets the data that the tail has forgotten, i.e. older
+    // than max_excess excesses (max_excess / (1 - level) data)
+    double const memory =
+        (double)spot->tail.peaks.container.capacity / (1. - spot->level);
+    if (spot->tracker.np[4] > memory) {
+        p2_scale(&(spot->tracker), 0.5);
+    }
+    p2_push(&(spot->tracker), x);
+    double const t = p2_value(&(spot->tracker));
+    double const delta = spot->__up_down * (t - spot->excess_threshold);
+    if (!(delta > spot->rebase_tolerance) &&
+        !(-delta > spot->rebase_tolerance)) {
+        // also the case when t or the threshold is NaN
+        return 0;
+    }
+
+    // the stored excesses are relative to the former threshold
+    tail_shift(&(spot->tail), delta);
+    spot->excess_threshold = t;
+    // by definition of the new threshold, P(X>t) = 1 - level
+    spot->Nt = (unsigned long)((1. - spot->level) * (double)spot->n);
+    return 1;
+}
+
+/**
+ * @brief Return the size of the sample of the evicted candidates (even)
+ *
+ * @param candidates capacity of the candidate buffer
+ * @return the size of the sample
+ */
+static unsigned long spot_fit_sample_size(unsigned long candidates) {
+    return candidates + (candidates & 1);
+}
+
+int spot_fit_begin(struct Spot *spot, unsigned long candidates) {
     spot->Nt = 0;
-    spot->n = size;
+    spot->n = 0;
 
-    // compute excess threshold
-    double et;
     if (spot->low) {
         // take the low quantile (1 - level)
-        et = p2_quantile(1. - spot->level, data, size);
+        p2_init(&(spot->tracker), 1. - spot->level);
     } else {
-        et = p2_quantile(spot->level, data, size);
+        p2_init(&(spot->tracker), spot->level);
+    }
+
+    if (spot->candidates.data) {
+        ubend_free(&(spot->candidates));
+    }
+    // the same allocation also holds the sample of the evicted candidates
+    // (see spot_fit_evict), right after the ring
+    if (ubend_init(&(spot->candidates),
+                   candidates + spot_fit_sample_size(candidates)) < 0) {
+        return -ERR_MEMORY_ALLOCATION_FAILED;
+    }
+    spot->candidates.capacity = candidates;
+    return 0;
+}
+
+/**
+ * @brief Return the weight of the evicted candidates sample, i.e. the
+ * sampling period of the evicted candidates (a power of 2)
+ *
+ * @param evicted number of evicted candidates
+ * @param sample_size size of the sample
+ * @return the weight of every sampled candidate
+ */
+static unsigned long spot_fit_sample_weight(unsigned long evicted,
+                                            unsigned long sample_size) {
+    unsigned long weight = 1;
+    while (evicted / weight >= sample_size) {
+        weight <<= 1;
+    }
+    return weight;
+}
+
+/**
+ * @brief Store an evicted candidate in the sample of the evicted candidates
+ *
+ * @details Every evicted candidate is kept until the sample is full. Then
+ * every other sampled candidate is dropped and the sampling period is
+ * doubled, so that the sample remains uniform over time. At the end of the
+ * fit, the excesses of the sample (over the final excess threshold) are
+ * scaled to estimate the number of evicted excesses, so that Nt does not
+ * depend on the drift of the estimate of the excess threshold during the
+ * fit. Nt counts the evicted candidates until the end of the fit.
+ *
+ * @param spot Spot instance
+ * @param x evicted candidate
+ */
+static void spot_fit_evict(struct Spot *spot, double x) {
+    struct Ubend const *candidates = &(spot->candidates);
+    unsigned long const size = spot_fit_sample_size(candidates->capacity);
+    double *sample = candidates->data + candidates->capacity;
+    unsigned long const evicted = spot->Nt++;
+    unsigned long const weight = spot_fit_sample_weight(evicted, size);
+
+    if (evicted % weight) {
+        return;
     }
+    // the sample is full: keep the even positions
+    if ((weight > 1) && (evicted / weight == size / 2)) {
+        for (unsigned long k = 0; k < size / 2; ++k) {
+            sample[k] = sample[2 * k];
+        }
+    }
+    sample[evicted / weight] = x;
+}
+
+/**
+ * @brief Return the lowest excess (relative to the current estimate of the
+ * excess threshold) that can become a real excess at the end of the fit
+ *
+ * @details We use the distance between the estimate of the excess threshold
+ * and the next P2 marker within the tail. For an exponential tail, the guard
+ * is then the quantile that delimits twice as many data as the tail.
+ *
+ * @param spot Spot instance
+ * @return the guard (NaN when the estimate is not available yet)
+ */
+static double spot_fit_guard(struct Spot const *spot) {
+    double const *q = spot->tracker.q;
+    if (spot->tracker.count < 5) {
+        return _NAN;
+    }
+    if (spot->low) {
+        return q[1] - q[2];
+    }
+    return q[2] - q[3];
+}
+
+int spot_fit_feed(struct Spot *spot, double const *data, unsigned long size) {
+    struct Ubend *candidates = &(spot->candidates);
+    if (!candidates->data) {
+        return -ERR_FIT_NOT_STARTED;
+    }
+
+    for (unsigned long i = 0; i < size; i += FIT_BLOCK_SIZE) {
+        unsigned long const end =
+            (size - i > FIT_BLOCK_SIZE) ? (i + FIT_BLOCK_SIZE) : size;
+        p2_feed(&(spot->tracker), data + i, end - i);
+
+        // the candidates are stored as __up_down * x, so the values that
+        // cannot become excesses are below the bound (NaN without estimate)
+        double const bound = spot->__up_down * p2_value(&(spot->tracker)) +
+                             spot_fit_guard(spot);
+        int filtered = 0;
+        for (unsigned long j = i; j < end; ++j) {
+            double const x = spot->__up_down * data[j];
+            // all the data are kept until the buffer is full. Then only the
+            // candidates are kept: the buffer is filtered (once per block)
+            // when a new candidate would evict an older one
+            if (spot->n + j >= candidates->capacity) {
+                if (x <= bound) {
+                    continue;
+                }
+                if (candidates->filled && !filtered) {
+                    ubend_filter(candidates, bound);
+                    filtered = 1;
+                }
+            }
+            int const evict = candidates->filled;
+            double const erased = ubend_push(candidates, x);
+            if (evict) {
+                spot_fit_evict(spot, erased);
+            }
+        }
+    }
+    spot->n += size;
+    return 0;
+}
+
+int spot_fit_end(struct Spot *spot) {
+    struct Ubend *candidates = &(spot->candidates);
+    if (!candidates->data) {
+        return -ERR_FIT_NOT_STARTED;
+    }
+
+    double const et = p2_value(&(spot->tracker));
     if (is_nan(et)) {
+        ubend_free(candidates);
         return -ERR_EXCESS_THRESHOLD_IS_NAN;
     }
     // here we know that et is not NaN
     spot->excess_threshold = et;
 
-    // fill the tail
-    for (unsigned long i = 0; i < size; ++i) {
-        // positive excess
-        double excess = spot->__up_down * (data[i] - et);
+    // estimate the evicted excesses with their sample
+    unsigned long const evicted = spot->Nt;
+    spot->Nt = 0;
+    if (evicted > 0) {
+        unsigned long const size = spot_fit_sample_size(candidates->capacity);
+        unsigned long const weight =
+            spot_fit_sample_weight(evicted - 1, size);
+        unsigned long const sampled = (evicted - 1) / weight + 1;
+        double const *sample = candidates->data + candidates->capacity;
+        unsigned long excesses = 0;
+        for (unsigned long k = 0; k < sampled; ++k) {
+            excesses += (sample[k] - spot->__up_down * et > 0);
+        }
+        spot->Nt = (unsigned long)(0.5 + (double)excesses * (double)evicted /
+                                             (double)sampled);
+    }
+
+    // fill the tail with the candidates (from the oldest)
+    unsigned long const kept = ubend_size(candidates);
+    unsigned long j = candidates->filled ? candidates->cursor : 0;
+    for (unsigned long i = 0; i < kept; ++i, ++j) {
+        if (j == kept) {
+            j = 0;
+        }
+        // positive excess (the candidates are stored as __up_down * x)
+        double excess = candidates->data[j] - spot->__up_down * et;
         if (excess > 0) {
             // it is a real excess
             spot->Nt++;
             tail_push(&(spot->tail), excess);
         }
     }
+    ubend_free(candidates);
 
-    // fit with the pushed data
-    tail_fit(&(spot->tail));
+    // fit with the pushed data (no anomaly has been discarded yet)
+    tail_fit(&(spot->tail), 0);
 
     // compute a first anomaly threshold
     spot->anomaly_threshold = spot_quantile(spot, spot->q);
@@ -132,20 +378,236 @@ int spot_step(struct Spot *spot, double x) {
     // increment number of data (without the anomalies)
     spot->n++;
 
+    int rebased = 0;
+    if (!is_nan(spot->rebase_tolerance)) {
+        rebased = spot_rebase(spot, x);
+    }
+
     double ex = spot->__up_down * (x - spot->excess_threshold);
     if (ex >= 0.0) {
         // increment number of excesses
         spot->Nt++;
         tail_push(&(spot->tail), ex);
-        tail_fit(&(spot->tail));
+        tail_fit(&(spot->tail), spot->discard_anomalies);
         // update threshold
         spot->anomaly_threshold = spot_quantile(spot, spot->q);
         return EXCESS;
     }
 
+    if (rebased && (peaks_size(&(spot->tail.peaks)) > 0)) {
+        tail_fit(&(spot->tail), spot->discard_anomalies);
+        spot->anomaly_threshold = spot_quantile(spot, spot->q);
+    }
+
     return NORMAL;
 }
 
+unsigned long spot_step_batch(struct Spot *spot, double const *data,
+                              unsigned long size, int *results) {
+    unsigned long anomalies = 0;
+    // with the recalibration, every value updates the threshold tracker
+    int const inline_normal = is_nan(spot->rebase_tolerance);
+
+    for (unsigned long i = 0; i < size; ++i) {
+        double const x = data[i];
+        int result;
+        // same tests as spot_step (false when x or the thresholds are NaN)
+        if (inline_normal &&
+            (spot->__up_down * (x - spot->excess_threshold) < 0) &&
+            !(spot->discard_anomalies &&
+              (spot->__up_down * (x - spot->anomaly_threshold) > 0))) {
+            spot->n++;
+            result = NORMAL;
+        } else {
+            result = spot_step(spot, x);
+            anomalies += (result == ANOMALY);
+        }
+        if (results) {
+            results[i] = result;
+        }
+    }
+    return anomalies;
+}
+
+void spot_set_rebase_tolerance(struct Spot *spot, double tolerance) {
+    if (tolerance < 0.) {
+        spot->rebase_tolerance = _NAN;
+    } else {
+        spot->rebase_tolerance = tolerance;
+    }
+}
+
+// Snapshot ------------------------------------------------------------------
+
+typedef union {
+    double d;
+    __UINT64_TYPE__ i;
+} word;
+
+/**
+ * @brief Write a 64-bit word (little-endian)
+ *
+ * @param p output buffer
+ * @param v value
+ * @return the position after the word
+ */
+static unsigned char *put_u64(unsigned char *p, __UINT64_TYPE__ v) {
+    for (int k = 0; k < 8; ++k) {
+        p[k] = (unsigned char)(v >> (8 * k));
+    }
+    return p + 8;
+}
+
+static unsigned char *put_double(unsigned char *p, double x) {
+    word w;
+    w.d = x;
+    return put_u64(p, w.i);
+}
+
+/**
+ * @brief Read a 64-bit word (little-endian)
+ *
+ * @param p input buffer (it is moved after the word)
+ * @return the value
+ */
+static __UINT64_TYPE__ get_u64(unsigned char const **p) {
+    __UINT64_TYPE__ v = 0;
+    for (int k = 0; k < 8; ++k) {
+        v |= (__UINT64_TYPE__)((*p)[k]) << (8 * k);
+    }
+    *p += 8;
+    return v;
+}
+
+static double get_double(unsigned char const **p) {
+    word w;
+    w.i = get_u64(p);
+    return w.d;
+}
+
+unsigned long spot_serialized_size(struct Spot const *spot) {
+    return 8 * (SNAPSHOT_HEADER_WORDS + peaks_size(&(spot->tail.peaks)));
+}
+
+int spot_serialize(struct Spot const *spot, void *buffer, unsigned long size) {
+    struct Ubend const *container = &(spot->tail.peaks.container);
+    struct P2 const *tracker = &(spot->tracker);
+    unsigned long const count = ubend_size(container);
+    if (size < spot_serialized_size(spot)) {
+        return -ERR_BUFFER_TOO_SMALL;
+    }
+
+    unsigned char *p = (unsigned char *)buffer;
+    p = put_u64(p, SNAPSHOT_MAGIC |
+                       ((__UINT64_TYPE__)SNAPSHOT_VERSION << 32));
+    // parameters
+    p = put_double(p, spot->q);
+    p = put_double(p, spot->level);
+    p = put_u64(p, (__UINT64_TYPE__)(spot->low) |
+                       ((__UINT64_TYPE__)(spot->discard_anomalies) << 1));
+    // state
+    p = put_double(p, spot->anomaly_threshold);
+    p = put_double(p, spot->excess_threshold);
+    p = put_u64(p, spot->Nt);
+    p = put_u64(p, spot->n);
+    p = put_double(p, spot->rebase_tolerance);
+    p = put_double(p, spot->tail.gamma);
+    p = put_double(p, spot->tail.sigma);
+    for (int i = 0; i < 5; ++i) {
+        p = put_double(p, tracker->q[i]);
+        p = put_double(p, tracker->n[i]);
+        p = put_double(p, tracker->np[i]);
+        p = put_double(p, tracker->dn[i]);
+    }
+    p = put_u64(p, tracker->count);
+    // excesses (from the oldest)
+    p = put_u64(p, container->capacity);
+    p = put_u64(p, count);
+    p = put_double(p, container->last_erased_data);
+    unsigned long j = container->filled ? container->cursor : 0;
+    for (unsigned long i = 0; i < count; ++i, ++j) {
+        if (j == count) {
+            j = 0;
+        }
+        p = put_double(p, container->data[j]);
+    }
+    return 0;
+}
+
+int spot_deserialize(struct Spot *spot, void const *buffer,
+                     unsigned long size) {
+    unsigned char const *p = (unsigned char const *)buffer;
+    if (size < 8 * SNAPSHOT_HEADER_WORDS) {
+        return -ERR_BUFFER_TOO_SMALL;
+    }
+
+    __UINT64_TYPE__ const header = get_u64(&p);
+    if (((header & 0xffffffff) != SNAPSHOT_MAGIC) ||
+        ((header >> 32) != SNAPSHOT_VERSION)) {
+        return -ERR_INVALID_SNAPSHOT;
+    }
+
+    double const q = get_double(&p);
+    double const level = get_double(&p);
+    __UINT64_TYPE__ const flags = get_u64(&p);
+    double const anomaly_threshold = get_double(&p);
+    double const excess_threshold = get_double(&p);
+    __UINT64_TYPE__ const Nt = get_u64(&p);
+    __UINT64_TYPE__ const n = get_u64(&p);
+    double const rebase_tolerance = get_double(&p);
+    double const gamma = get_double(&p);
+    double const sigma = get_double(&p);
+    struct P2 tracker;
+    for (int i = 0; i < 5; ++i) {
+        tracker.q[i] = get_double(&p);
+        tracker.n[i] = get_double(&p);
+        tracker.np[i] = get_double(&p);
+        tracker.dn[i] = get_double(&p);
+    }
+    __UINT64_TYPE__ const tracker_count = get_u64(&p);
+    __UINT64_TYPE__ const capacity = get_u64(&p);
+    __UINT64_TYPE__ const count = get_u64(&p);
+    double const last_erased_data = get_double(&p);
+
+    // the counters must fit in an unsigned long (32 bits on some hosts)
+    if ((flags > 3) || ((unsigned long)Nt != Nt) || ((unsigned long)n != n) ||
+        ((unsigned long)tracker_count != tracker_count) ||
+        ((unsigned long)capacity != capacity) || (count > capacity)) {
+        return -ERR_INVALID_SNAPSHOT;
+    }
+    if ((size - 8 * SNAPSHOT_HEADER_WORDS) / 8 < count) {
+        return -ERR_BUFFER_TOO_SMALL;
+    }
+
+    int status = spot_init(spot, q, (int)(flags & 1), (int)(flags >> 1), level,
+                           (unsigned long)capacity);
+    if (status < 0) {
+        return status;
+    }
+
+    // copy the excesses back (it also recomputes the stats of the peaks)
+    for (unsigned long i = 0; i < count; ++i) {
+        double const excess = get_double(&p);
+        if (!(excess >= 0.)) {
+            spot_free(spot);
+            return -ERR_INVALID_SNAPSHOT;
+        }
+        tail_push(&(spot->tail), excess);
+    }
+    spot->tail.peaks.container.last_erased_data = last_erased_data;
+
+    spot->anomaly_threshold = anomaly_threshold;
+    spot->excess_threshold = excess_threshold;
+    spot->Nt = (unsigned long)Nt;
+    spot->n = (unsigned long)n;
+    spot->rebase_tolerance = rebase_tolerance;
+    spot->tail.gamma = gamma;
+    spot->tail.sigma = sigma;
+    tracker.count = (unsigned long)tracker_count;
+    spot->tracker = tracker;
+    return 0;
+}
+
 double spot_quantile(struct Spot const *spot, double q) {
     double s = (double)(spot->Nt) / (double)(spot->n);
     return spot->excess_threshold +
@@ -158,6 +620,133 @@ double spot_probability(struct Spot const *spot, double z) {
                             spot->__up_down * (z - spot->excess_threshold));
 }
 
+/**
+ * @brief Batch version of tail_probability over the values z (the output
+ * buffer holds the intermediate results)
+ */
+static void probability_batch(double up_down, double et, double s,
+                              double gamma, double sigma, double const *z,
+                              unsigned long size, double *probabilities) {
+    if (gamma == 0.0) {
+        for (unsigned long i = 0; i < size; ++i) {
+            double const d = up_down * (z[i] - et);
+            probabilities[i] = -d / sigma;
+        }
+        xexp_batch(probabilities, probabilities, size);
+    } else {
+        double const ratio = gamma / sigma;
+        for (unsigned long i = 0; i < size; ++i) {
+            double const d = up_down * (z[i] - et);
+            probabilities[i] = 1.0 + d * ratio;
+        }
+        xpow_batch(probabilities, -1.0 / gamma, probabilities, size);
+    }
+    for (unsigned long i = 0; i < size; ++i) {
+        probabilities[i] *= s;
+    }
+}
+
+/**
+ * @brief Batch version of tail_quantile over the probabilities q (the output
+ * buffer holds the intermediate results)
+ */
+static void quantile_batch(double up_down, double et, double s, double gamma,
+                           double sigma, double const *q, unsigned long size,
+                           double *quantiles) {
+    for (unsigned long i = 0; i < size; ++i) {
+        quantiles[i] = q[i] / s;
+    }
+    if (gamma == 0.0) {
+        xlog_batch(quantiles, quantiles, size);
+        for (unsigned long i = 0; i < size; ++i) {
+            quantiles[i] = et + up_down * (-sigma * quantiles[i]);
+        }
+    } else {
+        double const scale = sigma / gamma;
+        xpow_batch(quantiles, -gamma, quantiles, size);
+        for (unsigned long i = 0; i < size; ++i) {
+            quantiles[i] = et + up_down * (scale * (quantiles[i] - 1));
+        }
+    }
+}
+
+void spot_quantile_batch(struct Spot const *spot, double const *q,
+                         unsigned long size, double *quantiles) {
+    double s = (double)(spot->Nt) / (double)(spot->n);
+    quantile_batch(spot->__up_down, spot->excess_threshold, s,
+                   spot->tail.gamma, spot->tail.sigma, q, size, quantiles);
+}
+
+void spot_probability_batch(struct Spot const *spot, double const *z,
+                            unsigned long size, double *probabilities) {
+    double s = (double)(spot->Nt) / (double)(spot->n);
+    probability_batch(spot->__up_down, spot->excess_threshold, s,
+                      spot->tail.gamma, spot->tail.sigma, z, size,
+                      probabilities);
+}
+
+// Frozen model --------------------------------------------------------------
+
+int spot_freeze(struct Spot const *spot, struct SpotFrozen *frozen) {
+    if (is_nan(spot->excess_threshold)) {
+        return -ERR_EXCESS_THRESHOLD_IS_NAN;
+    }
+    if (is_nan(spot->anomaly_threshold)) {
+        return -ERR_ANOMALY_THRESHOLD_IS_NAN;
+    }
+    frozen->q = spot->q;
+    frozen->__up_down = spot->__up_down;
+    frozen->anomaly_threshold = spot->anomaly_threshold;
+    frozen->excess_threshold = spot->excess_threshold;
+    frozen->s = (double)(spot->Nt) / (double)(spot->n);
+    frozen->gamma = spot->tail.gamma;
+    frozen->sigma = spot->tail.sigma;
+    frozen->discard_anomalies = spot->discard_anomalies;
+    return 0;
+}
+
+unsigned long spot_frozen_classify(struct SpotFrozen const *frozen,
+                                   double const *data, unsigned long size,
+                                   int *results) {
+    double const up_down = frozen->__up_down;
+    double const at = frozen->anomaly_threshold;
+    double const et = frozen->excess_threshold;
+    // like spot_step, a Spot that keeps the anomalies returns EXCESS
+    int const discard = frozen->discard_anomalies;
+    unsigned long anomalies = 0;
+
+    for (unsigned long i = 0; i < size; ++i) {
+        double const x = data[i];
+        // the anomaly threshold is beyond the excess threshold, so
+        // NORMAL = 0, EXCESS = 1 and ANOMALY = 2 (branchless)
+        int const result =
+            (up_down * (x - et) >= 0) + discard * (up_down * (x - at) > 0);
+        anomalies += (result == ANOMALY);
+        results[i] = is_nan(x) ? -ERR_DATA_IS_NAN : result;
+    }
+    return anomalies;
+}
+
+void spot_frozen_probability(struct SpotFrozen const *frozen,
+                             double const *data, unsigned long size,
+                             double *probabilities) {
+    probability_batch(frozen->__up_down, frozen->excess_threshold, frozen->s,
+                      frozen->gamma, frozen->sigma, data, size,
+                      probabilities);
+}
+
+double spot_frozen_quantile(struct SpotFrozen const *frozen, double q) {
+    // see tail_quantile
+    double const r = q / frozen->s;
+    double d;
+    if (frozen->gamma == 0.0) {
+        d = -frozen->sigma * xlog(r);
+    } else {
+        d = (frozen->sigma / frozen->gamma) * (xpow(r, -frozen->gamma) - 1);
+    }
+    return frozen->excess_threshold + frozen->__up_down * d;
+}
+
 // Extra functions -----------------------------------------------------------
 
 void set_allocators(malloc_fn m, free_fn f) { internal_set_allocators(m, f); }
@@ -197,10 +786,14 @@ static const char *errors[] = {
     "The excess threshold has not been initialized", // ERR_EXCESS_THRESHOLD_IS_NAN
     "The anomaly threshold has not been initialized", // ERR_ANOMALY_THRESHOLD_IS_NAN
     "The input data is NaN",                          // ERR_DATA_IS_NAN
+    "No chunked fit is in progress (spot_fit_begin has not been called)", // ERR_FIT_NOT_STARTED
+    "The buffer is too small",                        // ERR_BUFFER_TOO_SMALL
+    "The buffer is not a valid Spot snapshot",        // ERR_INVALID_SNAPSHOT
 }; // clang-format on
 
 void libspot_error(enum LibspotError err, char *buffer, unsigned long size) {
-    if ((err >= ERR_MEMORY_ALLOCATION_FAILED) && (err <= ERR_DATA_IS_NAN)) {
+    if ((err >= ERR_MEMORY_ALLOCATION_FAILED) &&
+        (err <= ERR_INVALID_SNAPSHOT)) {
         int index = err - ERR_MEMORY_ALLOCATION_FAILED;
         strncpy(buffer, errors[index], size);
     }
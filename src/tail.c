@@ -11,9 +11,10 @@
 
 typedef double (*estimator)(struct Peaks const *, double *, double *);
 
-estimator ESTIMATORS[] = {mom_estimator, grimshaw_estimator};
+LIBSPOT_INTERNAL estimator ESTIMATORS[] = {mom_estimator, grimshaw_estimator};
 
-unsigned int const NB_ESTIMATORS = sizeof(ESTIMATORS) / sizeof(estimator);
+LIBSPOT_INTERNAL unsigned int const NB_ESTIMATORS =
+    sizeof(ESTIMATORS) / sizeof(estimator);
 
 int tail_init(struct Tail *tail, unsigned long size) {
     tail->gamma = _NAN;
@@ -33,6 +34,10 @@ void tail_push(struct Tail *tail, double x) {
     peaks_push(&(tail->peaks), x);
 }
 
+void tail_shift(struct Tail *tail, double delta) {
+    peaks_shift(&(tail->peaks), delta);
+}
+
 double tail_probability(struct Tail const *tail, double s, double d) {
     // d = zq - t
     if (tail->gamma == 0.0) {
@@ -51,7 +56,7 @@ double tail_quantile(struct Tail const *tail, double s, double q) {
     return (tail->sigma / tail->gamma) * (xpow(r, -tail->gamma) - 1);
 }
 
-double tail_fit(struct Tail *tail) {
+double tail_fit(struct Tail *tail, int truncated) {
     struct Peaks const *peaks = &(tail->peaks);
     double tmp_gamma = _NAN;
     double tmp_sigma = _NAN;
@@ -59,6 +64,10 @@ double tail_fit(struct Tail *tail) {
     double max_llhood = _NAN;
 
     for (unsigned int i = 0; i < NB_ESTIMATORS; ++i) {
+        if (truncated && (ESTIMATORS[i] == mom_estimator)) {
+            // the moments of truncated peaks underestimate the tail
+            continue;
+        }
         // compare estimators based on their log likelihood
         double llhood = ESTIMATORS[i](peaks, &tmp_gamma, &tmp_sigma);
         if (is_nan(max_llhood) || (llhood > max_llhood)) {
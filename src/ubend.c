@@ -28,6 +28,7 @@ void ubend_free(struct Ubend *ubend) {
     ubend->last_erased_data = _NAN;
     if (ubend->data) {
         xfree(ubend->data);
+        ubend->data = 0x0;
     }
 }
 
@@ -59,3 +60,41 @@ double ubend_push(struct Ubend *ubend, double x) {
 
     return ubend->last_erased_data;
 }
+
+static void reverse(double *data, unsigned long i, unsigned long j) {
+    while (i + 1 < j) {
+        double tmp = data[i];
+        data[i++] = data[--j];
+        data[j] = tmp;
+    }
+}
+
+unsigned long ubend_filter(struct Ubend *ubend, double bound) {
+    unsigned long const size = ubend_size(ubend);
+    unsigned long k = 0;
+
+    // when the container is filled, the oldest value is at the cursor. We
+    // rotate the data (in place) so that it starts at index 0
+    if (ubend->filled && ubend->cursor > 0) {
+        reverse(ubend->data, 0, ubend->cursor);
+        reverse(ubend->data, ubend->cursor, size);
+        reverse(ubend->data, 0, size);
+    }
+
+    for (unsigned long i = 0; i < size; ++i) {
+        if (ubend->data[i] > bound) {
+            ubend->data[k++] = ubend->data[i];
+        }
+    }
+
+    if (k == ubend->capacity) {
+        ubend->cursor = 0;
+        ubend->filled = 1;
+    } else {
+        ubend->cursor = k;
+        ubend->filled = 0;
+        // nothing will be erased at the next push
+        ubend->last_erased_data = _NAN;
+    }
+    return k;
+}
@@ -9,9 +9,11 @@
  */
 #include "xmath.h"
 
+#ifndef LIBSPOT_MATH_LIBM
 static double const LOG2 = 0x1.62e42fefa39efp-1;
-double const _NAN = 0.0 / 0.0;
-double const _INFINITY = +1.0 / 0.0;
+#endif
+LIBSPOT_INTERNAL double const _NAN = 0.0 / 0.0;
+LIBSPOT_INTERNAL double const _INFINITY = +1.0 / 0.0;
 
 // static const double pow2[] = {
 //     0x1.0p+0,  0x1.0p+1,  0x1.0p+2,  0x1.0p+3,  0x1.0p+4,  0x1.0p+5,
@@ -266,7 +268,9 @@ void internal_set_float_utils(ldexp_fn l, frexp_fn f) {
 
 int is_nan(double x) { return x != x; }
 
-static double _log_cf_11(double z) {
+#ifndef LIBSPOT_MATH_LIBM
+
+static inline double _log_cf_11(double z) {
     double x = z - 1;
     double xx = x + 2;
     double x2 = x * x;
@@ -305,7 +309,7 @@ static double _log_cf_11(double z) {
             xx);
 }
 
-double _exp_cf_6(double z) {
+static inline double _exp_cf_6(double z) {
     double z2 = z * z;
 
     return 2 * z /
@@ -368,6 +372,152 @@ double xlog(double x) {
 
 double xpow(double a, double x) { return xexp(x * xlog(a)); }
 
+#endif // LIBSPOT_MATH_LIBM
+
+// Batch kernels -------------------------------------------------------------
+//
+// They compute the same values as xlog/xexp/xpow but without calls nor
+// branches in the main loops (frexp/ldexp are done on the bits), so that the
+// compiler can vectorize them. The values that need the special cases of
+// xlog (zero, negative, subnormal, infinite or NaN) are computed again by the
+// scalar function. With the libm backend, they are plain loops over the
+// libm functions.
+
+#if defined(LIBSPOT_MATH_LIBM)
+
+#if defined(LIBSPOT_MATH_LIBMVEC)
+// libmvec backend (make MATH=libmvec): the vector variants of the glibc are
+// declared so that the compiler vectorizes the loops below (-fopenmp-simd).
+// They are a few ulps away from the scalar functions.
+#pragma omp declare simd notinbranch
+double log(double);
+#pragma omp declare simd notinbranch
+double exp(double);
+#pragma omp declare simd notinbranch
+double pow(double, double);
+#endif
+
+void xlog_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = log(x[i]);
+    }
+}
+
+void xexp_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = exp(x[i]);
+    }
+}
+
+void xpow_batch(double const *a, double x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = pow(a[i], x);
+    }
+}
+
+#elif (__SIZEOF_DOUBLE__ == 8) && !defined(USE_CUSTOM_FLOAT_UTILS)
+
+/// @brief Number of values of the blocks of the batch kernels (stack arrays)
+#define XMATH_BLOCK 64
+
+void xlog_batch(double const *x, double *out, unsigned long size) {
+    double m[XMATH_BLOCK];
+    double e[XMATH_BLOCK];
+    for (unsigned long start = 0; start < size; start += XMATH_BLOCK) {
+        unsigned long const n =
+            (size - start < XMATH_BLOCK) ? size - start : XMATH_BLOCK;
+        double const *v = x + start;
+        // frexp on the bits: x = m * 2^e with 0.5 <= m < 1 (normal numbers)
+        for (unsigned long i = 0; i < n; ++i) {
+            double_cast c = {v[i]};
+            int const exponent = (int)((c.i >> 52) & 0x7ff) - 0x3fe;
+            c.i = (c.i & 0x800fffffffffffffull) | 0x3fe0000000000000ull;
+            // like xlog, x is passed directly when 1/4 <= x < 1
+            int const direct = (exponent == 0) | (exponent == -1);
+            m[i] = direct ? v[i] : c.d;
+            e[i] = direct ? 0. : (double)exponent;
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            m[i] = _log_cf_11(m[i]) + LOG2 * e[i];
+        }
+        // zero, negative, subnormal, infinite or NaN
+        for (unsigned long i = 0; i < n; ++i) {
+            double_cast const c = {v[i]};
+            __UINT64_TYPE__ const biased = (c.i >> 52) & 0x7ff;
+            if ((c.i >> 63) || (biased == 0) || (biased == 0x7ff)) {
+                m[i] = xlog(v[i]);
+            }
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            out[start + i] = m[i];
+        }
+    }
+}
+
+void xexp_batch(double const *x, double *out, unsigned long size) {
+    double r[XMATH_BLOCK];
+    double p1[XMATH_BLOCK];
+    double p2[XMATH_BLOCK];
+    for (unsigned long start = 0; start < size; start += XMATH_BLOCK) {
+        unsigned long const n =
+            (size - start < XMATH_BLOCK) ? size - start : XMATH_BLOCK;
+        double const *v = x + start;
+        // range reduction: |x| = r + k * log(2) with 0 <= r < log(2)
+        for (unsigned long i = 0; i < n; ++i) {
+            double a = (v[i] < 0) ? -v[i] : v[i];
+            // exp(1000) is already infinite (NaN is restored at the end)
+            a = (a <= 1000.) ? a : 1000.;
+            int const k = (a > LOG2) ? (int)(a / LOG2) : 0;
+            r[i] = a - LOG2 * (double)k;
+            // ldexp on the bits: 2^k in two exact factors (k < 2046)
+            int const k1 = k >> 1;
+            double_cast const f1 = {.i = (__UINT64_TYPE__)(0x3ff + k1) << 52};
+            double_cast const f2 = {.i = (__UINT64_TYPE__)(0x3ff + k - k1)
+                                         << 52};
+            p1[i] = f1.d;
+            p2[i] = f2.d;
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            r[i] = _exp_cf_6(r[i]) * p1[i] * p2[i];
+            // every inverse is computed (a conditional division cannot be
+            // vectorized)
+            p1[i] = 1.0 / r[i];
+        }
+        for (unsigned long i = 0; i < n; ++i) {
+            double const result = (v[i] < 0) ? p1[i] : r[i];
+            out[start + i] = (v[i] == v[i]) ? result : v[i];
+        }
+    }
+}
+
+#else
+
+void xlog_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = xlog(x[i]);
+    }
+}
+
+void xexp_batch(double const *x, double *out, unsigned long size) {
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] = xexp(x[i]);
+    }
+}
+
+#endif
+
+#ifndef LIBSPOT_MATH_LIBM
+
+void xpow_batch(double const *a, double x, double *out, unsigned long size) {
+    xlog_batch(a, out, size);
+    for (unsigned long i = 0; i < size; ++i) {
+        out[i] *= x;
+    }
+    xexp_batch(out, out, size);
+}
+
+#endif
+
 double xmin(double a, double b) {
     if (is_nan(a) || is_nan(b)) {
         return _NAN;
@@ -0,0 +1,170 @@
+#include "spot_file.h"
+#include "unity.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// keeps below the pipe capacity (64 KiB)
+static double initial_data[5000];
+
+static unsigned long const SIZE = sizeof(initial_data) / sizeof(double);
+
+static char path[] = "/tmp/spot_file_test_XXXXXX";
+
+static double const q = 1e-4;
+static double const level = 0.98;
+static unsigned long const max_excess = 200;
+
+void fill_uniform(void) {
+    for (unsigned long i = 0; i < SIZE; ++i) {
+        initial_data[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+void write_data(char const *content, size_t bytes) {
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    TEST_ASSERT_EQUAL_UINT64(bytes, fwrite(content, 1, bytes, f));
+    fclose(f);
+}
+
+void test_spot_fit_file(void) {
+    struct Spot reference;
+    struct Spot Spot;
+    fill_uniform();
+    write_data((char const *)initial_data, sizeof(initial_data));
+
+    for (int low = 0; low < 2; ++low) {
+        int ko = spot_init(&reference, q, low, 1, level, max_excess);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        ko = spot_fit(&reference, initial_data, SIZE);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+
+        ko = spot_init(&Spot, q, low, 1, level, max_excess);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        ko = spot_fit_file(&Spot, path);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+
+        TEST_ASSERT_EQUAL_UINT64(reference.n, Spot.n);
+        TEST_ASSERT_EQUAL_UINT64(reference.Nt, Spot.Nt);
+        TEST_ASSERT_EQUAL_DOUBLE(reference.excess_threshold,
+                                 Spot.excess_threshold);
+        TEST_ASSERT_EQUAL_DOUBLE(reference.anomaly_threshold,
+                                 Spot.anomaly_threshold);
+        spot_free(&Spot);
+        spot_free(&reference);
+    }
+}
+
+void test_spot_fit_file_pipe(void) {
+    struct Spot reference;
+    struct Spot Spot;
+    int fds[2];
+    char fd_path[64];
+    fill_uniform();
+
+    int ko = spot_init(&reference, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&reference, initial_data, SIZE);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    TEST_ASSERT_EQUAL_INT64(sizeof(initial_data),
+                            write(fds[1], initial_data, sizeof(initial_data)));
+    close(fds[1]);
+    snprintf(fd_path, sizeof(fd_path), "/dev/fd/%d", fds[0]);
+
+    ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit_file(&Spot, fd_path);
+    close(fds[0]);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    TEST_ASSERT_NULL(Spot.candidates.data);
+    TEST_ASSERT_EQUAL_UINT64(reference.n, Spot.n);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12, reference.excess_threshold,
+                              Spot.excess_threshold);
+    TEST_ASSERT_DOUBLE_WITHIN(0.05 * reference.anomaly_threshold,
+                              reference.anomaly_threshold,
+                              Spot.anomaly_threshold);
+    spot_free(&Spot);
+    spot_free(&reference);
+}
+
+void test_spot_fit_file_pipe_truncated(void) {
+    struct Spot Spot;
+    int fds[2];
+    char fd_path[64];
+    fill_uniform();
+
+    int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&Spot, initial_data, SIZE / 2);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    struct Spot const fitted = Spot;
+
+    // the stream ends with an incomplete double: the Spot is not refitted
+    TEST_ASSERT_EQUAL_INT(0, pipe(fds));
+    TEST_ASSERT_EQUAL_INT64(sizeof(initial_data) - 5,
+                            write(fds[1], initial_data,
+                                  sizeof(initial_data) - 5));
+    close(fds[1]);
+    snprintf(fd_path, sizeof(fd_path), "/dev/fd/%d", fds[0]);
+
+    ko = spot_fit_file(&Spot, fd_path);
+    close(fds[0]);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, ko);
+    TEST_ASSERT_NULL(Spot.candidates.data);
+    TEST_ASSERT_EQUAL_UINT64(fitted.n, Spot.n);
+    TEST_ASSERT_EQUAL_UINT64(fitted.Nt, Spot.Nt);
+    TEST_ASSERT_EQUAL_MEMORY(&(fitted.tracker), &(Spot.tracker),
+                             sizeof(struct P2));
+    TEST_ASSERT_EQUAL_DOUBLE(fitted.excess_threshold, Spot.excess_threshold);
+    TEST_ASSERT_EQUAL_DOUBLE(fitted.anomaly_threshold,
+                             Spot.anomaly_threshold);
+    TEST_ASSERT_EQUAL_UINT64(peaks_size(&(fitted.tail.peaks)),
+                             peaks_size(&(Spot.tail.peaks)));
+    spot_free(&Spot);
+}
+
+void test_spot_fit_file_errors(void) {
+    struct Spot Spot;
+    int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+
+    ko = spot_fit_file(&Spot, "/this/file/does/not/exist");
+    TEST_ASSERT_EQUAL_INT(-ENOENT, ko);
+
+    // truncated double
+    write_data("0123456789", 10);
+    ko = spot_fit_file(&Spot, path);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, ko);
+
+    spot_free(&Spot);
+}
+
+void setUp(void) {
+    srand(0);
+    set_allocators(malloc, free);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_spot_fit_file);
+    RUN_TEST(test_spot_fit_file_pipe);
+    RUN_TEST(test_spot_fit_file_pipe_truncated);
+    RUN_TEST(test_spot_fit_file_errors);
+    int status = UNITY_END();
+
+    unlink(path);
+    return status;
+}
@@ -0,0 +1,208 @@
+#include "spot_log.h"
+#include "unity.h"
+#include <errno.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static double initial_data[60000];
+
+static unsigned long const SIZE = sizeof(initial_data) / sizeof(double);
+
+static char snapshot[] = "/tmp/spot_log_snapshot_XXXXXX";
+static char path[] = "/tmp/spot_log_test_XXXXXX";
+
+static double const q = 1e-4;
+static double const level = 0.98;
+static unsigned long const max_excess = 200;
+
+void fill_drift(void) {
+    // uniform data with a slow drift (it moves the excess threshold)
+    for (unsigned long i = 0; i < SIZE; ++i) {
+        initial_data[i] =
+            (double)rand() / (double)RAND_MAX + (double)i / (double)SIZE;
+    }
+}
+
+static unsigned long file_size(char const *p) {
+    struct stat st;
+    TEST_ASSERT_EQUAL_INT(0, stat(p, &st));
+    return (unsigned long)st.st_size;
+}
+
+void assert_same_state(struct Spot const *expected, struct Spot const *spot) {
+    TEST_ASSERT_EQUAL_UINT64(expected->n, spot->n);
+    TEST_ASSERT_EQUAL_UINT64(expected->Nt, spot->Nt);
+    TEST_ASSERT_EQUAL_DOUBLE(expected->excess_threshold,
+                             spot->excess_threshold);
+    TEST_ASSERT_EQUAL_DOUBLE(expected->anomaly_threshold,
+                             spot->anomaly_threshold);
+    TEST_ASSERT_EQUAL_DOUBLE(expected->tail.gamma, spot->tail.gamma);
+    TEST_ASSERT_EQUAL_DOUBLE(expected->tail.sigma, spot->tail.sigma);
+    TEST_ASSERT_EQUAL_UINT64(peaks_size(&(expected->tail.peaks)),
+                             peaks_size(&(spot->tail.peaks)));
+    TEST_ASSERT_EQUAL_MEMORY(&(expected->tracker), &(spot->tracker),
+                             sizeof(struct P2));
+}
+
+void test_spot_log_restore(void) {
+    struct SpotLog log;
+    struct Spot Spot;
+    struct Spot restored;
+    unsigned long const start = 10000;
+    fill_drift();
+
+    int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&Spot, initial_data, start);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    spot_set_rebase_tolerance(&Spot, 0.01);
+
+    ko = spot_log_open(&log, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_log_checkpoint(&log, &Spot, snapshot);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+
+    unsigned long excesses = 0;
+    for (unsigned long i = start; i < SIZE - 10000; ++i) {
+        ko = spot_log_step(&log, &Spot, initial_data[i]);
+        TEST_ASSERT_TRUE(ko >= 0);
+        excesses += (ko == EXCESS);
+        if (i == 30000) {
+            ko = spot_log_checkpoint(&log, &Spot, snapshot);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            excesses = 0;
+        }
+    }
+    ko = spot_log_close(&log, &Spot);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    // the log is made of the records of the excesses (and of the
+    // recalibrations), not of the data
+    TEST_ASSERT_TRUE(file_size(path) < 8 + 8 * (10 * excesses + 24));
+
+    ko = spot_log_restore(&restored, snapshot, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    assert_same_state(&Spot, &restored);
+
+    // both instances behave the same
+    for (unsigned long i = SIZE - 10000; i < SIZE; ++i) {
+        TEST_ASSERT_EQUAL_INT(spot_step(&Spot, initial_data[i]),
+                              spot_step(&restored, initial_data[i]));
+    }
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9 * Spot.anomaly_threshold,
+                              Spot.anomaly_threshold,
+                              restored.anomaly_threshold);
+    spot_free(&restored);
+    spot_free(&Spot);
+}
+
+void test_spot_log_interrupted(void) {
+    struct Spot restored;
+
+    // remove the end of the last record (the last flush)
+    unsigned long const size = file_size(path);
+    TEST_ASSERT_EQUAL_INT(0, truncate(path, size - 3));
+    int ko = spot_log_restore(&restored, snapshot, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    spot_free(&restored);
+
+    // the log without the checkpoint restores the snapshot
+    unlink(path);
+    ko = spot_log_restore(&restored, snapshot, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    spot_free(&restored);
+
+    // not a log
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    fputs("this is not a log", f);
+    fclose(f);
+    struct SpotLog log;
+    TEST_ASSERT_EQUAL_INT(-EINVAL, spot_log_open(&log, path));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, spot_log_restore(&restored, snapshot, path));
+}
+
+void test_spot_log_write_error(void) {
+    struct SpotLog log;
+    struct Spot Spot;
+    struct Spot restored;
+    struct rlimit limit;
+    unsigned long const start = 10000;
+    fill_drift();
+
+    int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&Spot, initial_data, start);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    unlink(path);
+    ko = spot_log_open(&log, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_log_checkpoint(&log, &Spot, snapshot);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    for (unsigned long i = start; i < start + 1000; ++i) {
+        ko = spot_log_step(&log, &Spot, initial_data[i]);
+        TEST_ASSERT_TRUE(ko >= 0);
+    }
+
+    // the file cannot grow by more than 100 bytes: partial write
+    TEST_ASSERT_EQUAL_INT(0, getrlimit(RLIMIT_FSIZE, &limit));
+    rlim_t const max = limit.rlim_cur;
+    unsigned long const size = file_size(path);
+    limit.rlim_cur = size + 100;
+    signal(SIGXFSZ, SIG_IGN);
+    TEST_ASSERT_EQUAL_INT(0, setrlimit(RLIMIT_FSIZE, &limit));
+    ko = spot_log_flush(&log, &Spot, 0);
+    limit.rlim_cur = max;
+    TEST_ASSERT_EQUAL_INT(0, setrlimit(RLIMIT_FSIZE, &limit));
+    signal(SIGXFSZ, SIG_DFL);
+    TEST_ASSERT_EQUAL_INT(-EFBIG, ko);
+    // the partial write has been removed
+    TEST_ASSERT_EQUAL_UINT64(size, file_size(path));
+
+    // the records are written again
+    for (unsigned long i = start + 1000; i < start + 2000; ++i) {
+        ko = spot_log_step(&log, &Spot, initial_data[i]);
+        TEST_ASSERT_TRUE(ko >= 0);
+    }
+    ko = spot_log_close(&log, &Spot);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_log_restore(&restored, snapshot, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    assert_same_state(&Spot, &restored);
+    spot_free(&restored);
+    spot_free(&Spot);
+}
+
+void setUp(void) {
+    srand(0);
+    set_allocators(malloc, free);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    int fd = mkstemp(snapshot);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+    fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_spot_log_restore);
+    RUN_TEST(test_spot_log_interrupted);
+    RUN_TEST(test_spot_log_write_error);
+    int status = UNITY_END();
+
+    unlink(snapshot);
+    unlink(path);
+    return status;
+}
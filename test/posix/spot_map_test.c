@@ -0,0 +1,269 @@
+#include "spot_map.h"
+#include "unity.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#define SERIES 10
+
+static double data[SERIES][5000];
+
+static unsigned long const SIZE = sizeof(data[0]) / sizeof(double);
+
+static char path[] = "/tmp/spot_map_test_XXXXXX";
+
+static double const q = 1e-3;
+static double const level = 0.98;
+static unsigned long const max_excess = 100;
+static unsigned long const warmup = 1000;
+
+void fill_uniform(void) {
+    for (unsigned long s = 0; s < SERIES; ++s) {
+        for (unsigned long i = 0; i < SIZE; ++i) {
+            data[s][i] = (double)rand() / (double)RAND_MAX;
+        }
+    }
+}
+
+/**
+ * @brief Step the series in turn through the map and through reference
+ * detectors
+ */
+void check_series(struct SpotMap *map) {
+    struct Spot reference[SERIES];
+    for (unsigned long s = 0; s < SERIES; ++s) {
+        TEST_ASSERT_EQUAL_INT(
+            0, spot_init(&reference[s], q, 0, 1, level, map->max_excess));
+        TEST_ASSERT_EQUAL_INT(0,
+                              spot_fit(&reference[s], data[s], map->warmup));
+    }
+
+    for (unsigned long i = 0; i < SIZE; ++i) {
+        for (unsigned long s = 0; s < SERIES; ++s) {
+            double threshold;
+            // sparse ids
+            int status = spot_map_step(map, s << 40, data[s][i], &threshold);
+            if (i < map->warmup) {
+                TEST_ASSERT_EQUAL_INT(SPOT_MAP_WARMUP, status);
+                TEST_ASSERT_TRUE(threshold != threshold);
+            } else {
+                TEST_ASSERT_EQUAL_DOUBLE(reference[s].anomaly_threshold,
+                                         threshold);
+                TEST_ASSERT_EQUAL_INT(spot_step(&reference[s], data[s][i]),
+                                      status);
+            }
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(SERIES, spot_map_size(map));
+
+    for (unsigned long s = 0; s < SERIES; ++s) {
+        spot_free(&reference[s]);
+    }
+}
+
+void test_spot_map_init(void) {
+    struct SpotMap map;
+    TEST_ASSERT_EQUAL_INT(-ERR_Q_OUT_OF_BOUNDS,
+                          spot_map_init(&map, 0.5, 0, 1, level, max_excess,
+                                        warmup, 0));
+    TEST_ASSERT_EQUAL_INT(
+        -EINVAL, spot_map_init(&map, q, 0, 1, level, max_excess, 0, 0));
+    TEST_ASSERT_EQUAL_INT(
+        -EINVAL, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 64));
+
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 0));
+    TEST_ASSERT_EQUAL_UINT64(0, map.entry_size % 64);
+    TEST_ASSERT_EQUAL_INT(-ERR_DATA_IS_NAN,
+                          spot_map_step(&map, 1, 0. / 0., NULL));
+    TEST_ASSERT_EQUAL_UINT64(0, spot_map_size(&map));
+    TEST_ASSERT_EQUAL_INT(-ENOENT, spot_map_remove(&map, 1));
+    spot_map_free(&map);
+}
+
+void test_spot_map_step(void) {
+    struct SpotMap map;
+    fill_uniform();
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 0));
+    check_series(&map);
+    TEST_ASSERT_EQUAL_UINT64(0, map.evictions);
+
+    struct Spot *spot = spot_map_get(&map, 3UL << 40);
+    TEST_ASSERT_NOT_NULL(spot);
+    TEST_ASSERT_TRUE(spot->anomaly_threshold > spot->excess_threshold);
+    TEST_ASSERT_NULL(spot_map_get(&map, 3));
+
+    // a removed series warms up again
+    TEST_ASSERT_EQUAL_INT(0, spot_map_remove(&map, 3UL << 40));
+    TEST_ASSERT_NULL(spot_map_get(&map, 3UL << 40));
+    TEST_ASSERT_EQUAL_UINT64(SERIES - 1, spot_map_size(&map));
+    TEST_ASSERT_EQUAL_INT(SPOT_MAP_WARMUP,
+                          spot_map_step(&map, 3UL << 40, 0.5, NULL));
+    spot_map_free(&map);
+}
+
+void test_spot_map_evict(void) {
+    struct SpotMap map;
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 0));
+    unsigned long const memory = 2 * map.entry_size;
+    spot_map_free(&map);
+
+    // without spill file, the evicted series start over
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, memory));
+    TEST_ASSERT_EQUAL_UINT64(2, map.max_entries);
+    for (unsigned long i = 0; i < 2 * warmup; ++i) {
+        for (__UINT64_TYPE__ id = 0; id < 3; ++id) {
+            TEST_ASSERT_EQUAL_INT(SPOT_MAP_WARMUP,
+                                  spot_map_step(&map, id, data[0][i], NULL));
+        }
+    }
+    TEST_ASSERT_EQUAL_UINT64(2, spot_map_size(&map));
+    TEST_ASSERT_EQUAL_UINT64(2 * 3 * warmup - 2, map.evictions);
+    // the last value (series 2) has evicted the least recently used series
+    TEST_ASSERT_EQUAL_UINT64(0, map.evicted);
+    spot_map_free(&map);
+}
+
+void test_spot_map_spill(void) {
+    struct SpotMap map;
+    fill_uniform();
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 0));
+    unsigned long const memory = 3 * map.entry_size;
+    spot_map_free(&map);
+
+    // the evicted series are read back from the spill file
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, memory));
+    TEST_ASSERT_EQUAL_INT(0, spot_map_spill(&map, path));
+    TEST_ASSERT_EQUAL_INT(-EBUSY, spot_map_spill(&map, path));
+    check_series(&map);
+    TEST_ASSERT_EQUAL_UINT64(3, map.table.size);
+    TEST_ASSERT_EQUAL_UINT64(SERIES - 3, map.spilled.size);
+    // a slot is released after the eviction that makes room for its series
+    TEST_ASSERT_TRUE(map.spill_slots <= SERIES - 2);
+    TEST_ASSERT_EQUAL_UINT64(map.spill_slots - map.spilled.size,
+                             map.spill_free_count);
+    TEST_ASSERT_TRUE(map.evictions > SIZE);
+
+    // a spilled series can be removed
+    TEST_ASSERT_NULL(spot_map_get(&map, 0));
+    TEST_ASSERT_EQUAL_INT(0, spot_map_remove(&map, 0));
+    TEST_ASSERT_EQUAL_UINT64(SERIES - 1, spot_map_size(&map));
+    TEST_ASSERT_EQUAL_UINT64(map.spill_slots - map.spilled.size,
+                             map.spill_free_count);
+    spot_map_free(&map);
+}
+
+void test_spot_map_tier(void) {
+    struct SpotMap map;
+    fill_uniform();
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 0));
+    unsigned long const memory = 6 * map.entry_size;
+    spot_map_free(&map);
+
+    // only the Spot structures are resident (at most 6 * entry_size of them)
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, memory));
+    TEST_ASSERT_EQUAL_INT(-EINVAL, spot_map_tier(&map, path, 0));
+    TEST_ASSERT_EQUAL_INT(0, spot_map_tier(&map, path, 2));
+    TEST_ASSERT_EQUAL_INT(-EBUSY, spot_map_tier(&map, path, 2));
+    TEST_ASSERT_EQUAL_INT(-EBUSY, spot_map_spill(&map, path));
+    TEST_ASSERT_TRUE(10 * map.entry_size < map.slot_size);
+    TEST_ASSERT_TRUE(map.max_entries > SERIES);
+
+    check_series(&map);
+    TEST_ASSERT_EQUAL_UINT64(0, map.evictions);
+    TEST_ASSERT_EQUAL_UINT64(SERIES, map.spill_slots);
+    // the rings are read back for the excesses only
+    TEST_ASSERT_TRUE(map.reads > 0);
+    TEST_ASSERT_TRUE(map.reads < SERIES * (SIZE - warmup) / 10);
+
+    TEST_ASSERT_EQUAL_INT(0, spot_map_remove(&map, 0));
+    TEST_ASSERT_EQUAL_UINT64(1, map.spill_free_count);
+    spot_map_free(&map);
+
+    // the Spot structures are also evicted under the memory cap (the cap
+    // must hold a whole entry at the initialization)
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, 100, 0));
+    TEST_ASSERT_EQUAL_INT(0, spot_map_tier(&map, path, 4));
+    unsigned long const headers = 3 * map.entry_size;
+    spot_map_free(&map);
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, 100, headers));
+    TEST_ASSERT_EQUAL_INT(0, spot_map_tier(&map, path, 4));
+    TEST_ASSERT_EQUAL_UINT64(3, map.max_entries);
+    check_series(&map);
+    TEST_ASSERT_EQUAL_UINT64(3, map.table.size);
+    TEST_ASSERT_EQUAL_UINT64(SERIES - 3, map.spilled.size);
+    TEST_ASSERT_EQUAL_UINT64(SERIES, map.spill_slots);
+    spot_map_free(&map);
+}
+
+void test_spot_map_tier_threshold(void) {
+    struct SpotMap map;
+    struct Spot reference;
+    fill_uniform();
+    TEST_ASSERT_EQUAL_INT(
+        0, spot_map_init(&map, q, 0, 1, level, max_excess, warmup, 0));
+    // a single cached ring: the ring of a series is detached when the other
+    // one gets an excess
+    TEST_ASSERT_EQUAL_INT(0, spot_map_tier(&map, path, 1));
+    TEST_ASSERT_EQUAL_INT(0,
+                          spot_init(&reference, q, 0, 1, level, max_excess));
+    TEST_ASSERT_EQUAL_INT(0, spot_fit(&reference, data[0], warmup));
+
+    for (unsigned long i = 0; i < warmup; ++i) {
+        spot_map_step(&map, 0, data[0][i], NULL);
+        spot_map_step(&map, 1, data[1][i], NULL);
+    }
+    // excess of the series 1
+    spot_map_step(&map, 1, 1.0, NULL);
+
+    // a value equal to the excess threshold is an excess (see spot_step):
+    // the ring must be read back
+    struct Spot const *spot = spot_map_get(&map, 0);
+    TEST_ASSERT_NOT_NULL(spot);
+    double const x = spot->excess_threshold;
+    TEST_ASSERT_EQUAL_INT(EXCESS, spot_step(&reference, x));
+    TEST_ASSERT_EQUAL_INT(EXCESS, spot_map_step(&map, 0, x, NULL));
+    spot = spot_map_get(&map, 0);
+    TEST_ASSERT_EQUAL_UINT64(reference.Nt, spot->Nt);
+    TEST_ASSERT_EQUAL_DOUBLE(reference.anomaly_threshold,
+                             spot->anomaly_threshold);
+
+    spot_free(&reference);
+    spot_map_free(&map);
+}
+
+void setUp(void) {
+    srand(0);
+    set_allocators(malloc, free);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_spot_map_init);
+    RUN_TEST(test_spot_map_step);
+    RUN_TEST(test_spot_map_evict);
+    RUN_TEST(test_spot_map_spill);
+    RUN_TEST(test_spot_map_tier);
+    RUN_TEST(test_spot_map_tier_threshold);
+    int status = UNITY_END();
+
+    unlink(path);
+    return status;
+}
@@ -0,0 +1,132 @@
+#include "spot_parse.h"
+#include "unity.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+static double values[64];
+
+static unsigned long const CAPACITY = sizeof(values) / sizeof(double);
+
+void assert_same_as_strtod(char const *text) {
+    double x;
+    char *stop;
+    double const expected = strtod(text, &stop);
+    char const *end = spot_parse_double(text, text + strlen(text), &x);
+    TEST_ASSERT_EQUAL_PTR(stop, end);
+    if (stop != text) {
+        // bitwise comparison
+        TEST_ASSERT_EQUAL_MEMORY(&expected, &x, sizeof(double));
+    }
+}
+
+void test_spot_parse_double(void) {
+    char const *texts[] = {"0",
+                           "-0",
+                           "+1.5",
+                           "3.14159265358979",
+                           "0.1",
+                           "-0.000123",
+                           "12345678901234567",
+                           "1234567890123456789",
+                           "123456789012345678901234567890",
+                           "9007199254740993",
+                           "1e22",
+                           "1e23",
+                           "1.7976931348623157e308",
+                           "4.9e-324",
+                           "2.5E-3",
+                           "1e",
+                           "1e+",
+                           ".5",
+                           "5.",
+                           ".",
+                           "-",
+                           "nan",
+                           "-inf",
+                           "0x1p3",
+                           "abc",
+                           ""};
+    for (unsigned long i = 0; i < sizeof(texts) / sizeof(char *); ++i) {
+        assert_same_as_strtod(texts[i]);
+    }
+
+    // random numbers with different precisions
+    char buffer[64];
+    for (int i = 0; i < 100000; ++i) {
+        double const x = (double)rand() / (double)RAND_MAX *
+                         ((rand() % 2) ? 1e-3 : 1e6) * ((rand() % 2) ? 1 : -1);
+        snprintf(buffer, sizeof(buffer), "%.*g", 1 + rand() % 17, x);
+        assert_same_as_strtod(buffer);
+    }
+
+    // long mantissas and exponents (exact 128-bit path)
+    for (int i = 0; i < 100000; ++i) {
+        double const x = (double)rand() / (double)RAND_MAX;
+        snprintf(buffer, sizeof(buffer), "%.*fe%d", 10 + rand() % 9, x,
+                 rand() % 61 - 30);
+        assert_same_as_strtod(buffer);
+    }
+
+    // the text is not null-terminated
+    double x;
+    char const *text = "12.5678";
+    char const *end = spot_parse_double(text, text + 4, &x);
+    TEST_ASSERT_EQUAL_PTR(text + 4, end);
+    TEST_ASSERT_EQUAL_DOUBLE(12.5, x);
+}
+
+void test_spot_parse_column(void) {
+    char const *text = "time,value\n"
+                       "1700000000,1.5\n"
+                       "1700000001, -2e-3,extra\n"
+                       "1700000002\n"
+                       "# comment\n"
+                       "1700000003,4";
+    char const *end = text + strlen(text);
+    unsigned long count;
+
+    // the last line is incomplete
+    char const *next =
+        spot_parse_column(text, end, 0, ',', 1, values, CAPACITY, &count);
+    TEST_ASSERT_EQUAL_UINT64(2, count);
+    TEST_ASSERT_EQUAL_DOUBLE(1.5, values[0]);
+    TEST_ASSERT_EQUAL_DOUBLE(-2e-3, values[1]);
+    TEST_ASSERT_EQUAL_STRING("1700000003,4", next);
+
+    // end of the input
+    next = spot_parse_column(text, end, 1, ',', 1, values, CAPACITY, &count);
+    TEST_ASSERT_EQUAL_UINT64(3, count);
+    TEST_ASSERT_EQUAL_DOUBLE(4.0, values[2]);
+    TEST_ASSERT_EQUAL_PTR(end, next);
+
+    // first column
+    next = spot_parse_column(text, end, 1, ',', 0, values, CAPACITY, &count);
+    TEST_ASSERT_EQUAL_UINT64(4, count);
+    TEST_ASSERT_EQUAL_DOUBLE(1700000002.0, values[2]);
+
+    // full output
+    next = spot_parse_column(text, end, 1, ',', 0, values, 1, &count);
+    TEST_ASSERT_EQUAL_UINT64(1, count);
+    TEST_ASSERT_EQUAL_STRING_LEN("1700000001, -2e-3", next, 17);
+
+    // line protocol
+    text = "cpu.load 0.25\nmem.used 1024\n";
+    end = text + strlen(text);
+    next = spot_parse_column(text, end, 0, ' ', 1, values, CAPACITY, &count);
+    TEST_ASSERT_EQUAL_UINT64(2, count);
+    TEST_ASSERT_EQUAL_DOUBLE(0.25, values[0]);
+    TEST_ASSERT_EQUAL_DOUBLE(1024.0, values[1]);
+    TEST_ASSERT_EQUAL_PTR(end, next);
+}
+
+void setUp(void) { srand(0); }
+
+void tearDown(void) {}
+
+int main(void) {
+    UNITY_BEGIN();
+    RUN_TEST(test_spot_parse_double);
+    RUN_TEST(test_spot_parse_column);
+    return UNITY_END();
+}
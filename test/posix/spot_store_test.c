@@ -0,0 +1,157 @@
+#include "spot_store.h"
+#include "unity.h"
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+static double initial_data[20000];
+
+static unsigned long const SIZE = sizeof(initial_data) / sizeof(double);
+
+static char path[] = "/tmp/spot_store_test_XXXXXX";
+
+static double const q = 1e-4;
+static double const level = 0.98;
+static unsigned long const max_excess = 100;
+static unsigned long const slots = 100000;
+
+void fill_uniform(void) {
+    for (unsigned long i = 0; i < SIZE; ++i) {
+        initial_data[i] = (double)rand() / (double)RAND_MAX;
+    }
+}
+
+void test_spot_store_create(void) {
+    struct SpotStore store;
+    int ko = spot_store_create(&store, path, slots, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    TEST_ASSERT_EQUAL_UINT64(slots, store.slots);
+    TEST_ASSERT_EQUAL_UINT64(0, store.slot_size % 64);
+
+    TEST_ASSERT_NULL(spot_store_get(&store, 0));
+    TEST_ASSERT_NULL(spot_store_get(&store, slots));
+    TEST_ASSERT_EQUAL_INT(-ERANGE,
+                          spot_store_init(&store, slots, q, 0, 1, level));
+    TEST_ASSERT_EQUAL_INT(-ERR_Q_OUT_OF_BOUNDS,
+                          spot_store_init(&store, 0, 0.5, 0, 1, level));
+    spot_store_close(&store);
+}
+
+void test_spot_store_reopen(void) {
+    struct SpotStore store;
+    struct Spot reference;
+    unsigned long const half = SIZE / 2;
+    unsigned long const index = slots - 1;
+    fill_uniform();
+
+    int ko = spot_init(&reference, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&reference, initial_data, half);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+
+    ko = spot_store_create(&store, path, slots, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_store_init(&store, index, q, 0, 1, level);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    struct Spot *spot = spot_store_get(&store, index);
+    TEST_ASSERT_NOT_NULL(spot);
+    ko = spot_fit(spot, initial_data, half);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    TEST_ASSERT_EQUAL_DOUBLE(reference.anomaly_threshold,
+                             spot->anomaly_threshold);
+    TEST_ASSERT_EQUAL_INT(0, spot_store_sync(&store, 1));
+    spot_store_close(&store);
+
+    // the detector is used in place after the reopening
+    ko = spot_store_open(&store, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    TEST_ASSERT_EQUAL_UINT64(2, store.generation);
+    TEST_ASSERT_NULL(spot_store_get(&store, 0));
+    spot = spot_store_get(&store, index);
+    TEST_ASSERT_NOT_NULL(spot);
+    TEST_ASSERT_EQUAL_UINT64(reference.n, spot->n);
+    TEST_ASSERT_EQUAL_UINT64(reference.Nt, spot->Nt);
+    for (unsigned long i = half; i < SIZE; ++i) {
+        TEST_ASSERT_EQUAL_INT(spot_step(&reference, initial_data[i]),
+                              spot_step(spot, initial_data[i]));
+    }
+    TEST_ASSERT_EQUAL_DOUBLE(reference.anomaly_threshold,
+                             spot->anomaly_threshold);
+    spot_store_close(&store);
+    spot_free(&reference);
+}
+
+void test_spot_store_torn(void) {
+    struct SpotStore store;
+    fill_uniform();
+
+    int ko = spot_store_create(&store, path, slots, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    for (unsigned long index = 0; index < 4; ++index) {
+        ko = spot_store_init(&store, index, q, 0, 1, level);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        struct Spot *spot = spot_store_get(&store, index);
+        TEST_ASSERT_NOT_NULL(spot);
+        ko = spot_fit(spot, initial_data, SIZE);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+    }
+    // simulate slots torn by a crash
+    spot_store_get(&store, 1)->tail.peaks.container.cursor = max_excess + 3;
+    spot_store_get(&store, 2)->tail.peaks.container.capacity = 2 * max_excess;
+    spot_store_get(&store, 3)->low = 7;
+    spot_store_close(&store);
+
+    ko = spot_store_open(&store, path);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    TEST_ASSERT_NOT_NULL(spot_store_get(&store, 0));
+    for (unsigned long index = 1; index < 4; ++index) {
+        TEST_ASSERT_NULL(spot_store_get(&store, index));
+    }
+    // a rejected slot can be initialized again
+    ko = spot_store_init(&store, 1, q, 0, 1, level);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    struct Spot *spot = spot_store_get(&store, 1);
+    TEST_ASSERT_NOT_NULL(spot);
+    ko = spot_fit(spot, initial_data, SIZE);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    spot_store_close(&store);
+}
+
+void test_spot_store_invalid(void) {
+    struct SpotStore store;
+    FILE *f = fopen(path, "wb");
+    TEST_ASSERT_NOT_NULL(f);
+    for (int i = 0; i < 8192; ++i) {
+        fputc('x', f);
+    }
+    fclose(f);
+    TEST_ASSERT_EQUAL_INT(-EINVAL, spot_store_open(&store, path));
+    TEST_ASSERT_EQUAL_INT(-ENOENT,
+                          spot_store_open(&store, "/this/file/does/not/exist"));
+}
+
+void setUp(void) {
+    srand(0);
+    set_allocators(malloc, free);
+}
+
+void tearDown(void) {}
+
+int main(void) {
+    int fd = mkstemp(path);
+    if (fd < 0) {
+        return 1;
+    }
+    close(fd);
+
+    UNITY_BEGIN();
+    RUN_TEST(test_spot_store_create);
+    RUN_TEST(test_spot_store_reopen);
+    RUN_TEST(test_spot_store_torn);
+    RUN_TEST(test_spot_store_invalid);
+    int status = UNITY_END();
+
+    unlink(path);
+    return status;
+}
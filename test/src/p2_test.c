@@ -11,7 +11,6 @@ static char buffer[256];
 void sort5(double arr[5]);
 
 double const PI = 0x1.921fb54442d18p+1;
-double const _NAN = 0.0 / 0.0;
 double const DMAX = RAND_MAX;
 
 static double DATA[SIZE];
@@ -164,6 +163,31 @@ void test_p2_gauss(void) {
     TEST_MESSAGE(buffer);
 }
 
+void test_p2_feed(void) {
+    struct P2 p2;
+    unsigned long const chunk = 37;
+
+    srand(SEEDS[0]);
+    fill_rgauss();
+
+    for (size_t j = 0; j < Q; j++) {
+        p2_init(&p2, PROBABILITIES[j]);
+        TEST_ASSERT_DOUBLE_IS_NAN(p2_value(&p2));
+        // the first values are pushed one by one, then by chunks
+        for (unsigned long i = 0; i < 3; i++) {
+            p2_push(&p2, DATA[i]);
+        }
+        for (unsigned long i = 3; i < SIZE; i += chunk) {
+            unsigned long size = (i + chunk < SIZE) ? chunk : SIZE - i;
+            p2_feed(&p2, DATA + i, size);
+        }
+        TEST_ASSERT_EQUAL_UINT64(SIZE, p2.count);
+        // same estimate as the one-shot computation
+        TEST_ASSERT_EQUAL_DOUBLE(p2_quantile(PROBABILITIES[j], DATA, SIZE),
+                                 p2_value(&p2));
+    }
+}
+
 void setUp(void) { srand(0); }
 
 void tearDown(void) {}
@@ -173,5 +197,6 @@ int main(void) {
     RUN_TEST(test_sort5);
     RUN_TEST(test_p2_unif);
     RUN_TEST(test_p2_gauss);
+    RUN_TEST(test_p2_feed);
     return UNITY_END();
 }
\ No newline at end of file
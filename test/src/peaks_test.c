@@ -270,6 +270,75 @@ void test_peaks_free(void) {
     TEST_ASSERT_DOUBLE_IS_NAN(Peaks.max);
 }
 
+void test_peaks_shift(void) {
+    unsigned long const size = 10;
+    struct Peaks Peaks;
+    peaks_init(&Peaks, size);
+
+    for (unsigned long i = 1; i <= size; i++) {
+        peaks_push(&Peaks, (double)i);
+    }
+    // 1, 2 and 3 are removed
+    peaks_shift(&Peaks, 3.0);
+    TEST_ASSERT_EQUAL_UINT64(7, peaks_size(&Peaks));
+    TEST_ASSERT_EQUAL_DOUBLE(1.0, Peaks.min);
+    TEST_ASSERT_EQUAL_DOUBLE(7.0, Peaks.max);
+    TEST_ASSERT_EQUAL_DOUBLE(4.0, peaks_mean(&Peaks));
+    TEST_ASSERT_EQUAL_DOUBLE(4.0, peaks_var(&Peaks));
+
+    // nothing is removed
+    peaks_shift(&Peaks, -1.0);
+    TEST_ASSERT_EQUAL_UINT64(7, peaks_size(&Peaks));
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, Peaks.min);
+    TEST_ASSERT_EQUAL_DOUBLE(8.0, Peaks.max);
+    TEST_ASSERT_EQUAL_DOUBLE(5.0, peaks_mean(&Peaks));
+    TEST_ASSERT_EQUAL_DOUBLE(4.0, peaks_var(&Peaks));
+
+    peaks_free(&Peaks);
+}
+
+void test_peaks_moments(void) {
+    unsigned long const size = 5;
+    struct Peaks Peaks;
+    peaks_init(&Peaks, size);
+
+    // every push erases the min, so the moments are recomputed from the
+    // container (6, 7, 8, 9, 10 at the end)
+    for (unsigned long i = 1; i <= 2 * size; i++) {
+        peaks_push(&Peaks, (double)i);
+    }
+    TEST_ASSERT_EQUAL_DOUBLE(40.0, Peaks.e);
+    TEST_ASSERT_EQUAL_DOUBLE(330.0, Peaks.e2);
+    TEST_ASSERT_EQUAL_DOUBLE(6.0, Peaks.min);
+    TEST_ASSERT_EQUAL_DOUBLE(10.0, Peaks.max);
+    TEST_ASSERT_EQUAL_DOUBLE(8.0, peaks_mean(&Peaks));
+    TEST_ASSERT_EQUAL_DOUBLE(2.0, peaks_var(&Peaks));
+
+    peaks_free(&Peaks);
+}
+
+void test_peaks_log_likelihood_blocks(void) {
+    // the excesses are processed by blocks: same result as the scalar sum
+    unsigned long const sizes[] = {1, PEAKS_BLOCK - 1, PEAKS_BLOCK,
+                                   PEAKS_BLOCK + 1, 3 * PEAKS_BLOCK + 5};
+    double const gamma = -0.2;
+    double const sigma = 1.5;
+    struct Peaks Peaks;
+    for (unsigned long k = 0; k < sizeof(sizes) / sizeof(sizes[0]); k++) {
+        peaks_init(&Peaks, sizes[k]);
+        for (unsigned long i = 0; i < sizes[k]; i++) {
+            peaks_push(&Peaks, 0.05 * (double)(i % 97));
+        }
+        double expected = -(double)sizes[k] * xlog(sigma);
+        for (unsigned long i = 0; i < sizes[k]; i++) {
+            expected += -(1. + 1. / gamma) *
+                        xlog(1 + (gamma / sigma) * Peaks.container.data[i]);
+        }
+        TEST_ASSERT_TRUE(expected == log_likelihood(&Peaks, gamma, sigma));
+        peaks_free(&Peaks);
+    }
+}
+
 void setUp(void) { internal_set_allocators(malloc, free); }
 
 void tearDown(void) {}
@@ -282,6 +351,9 @@ int main(void) {
     RUN_TEST(test_peaks_var);
     RUN_TEST(test_peaks_size);
     RUN_TEST(test_peaks_log_likelihood);
+    RUN_TEST(test_peaks_log_likelihood_blocks);
     RUN_TEST(test_peaks_free);
+    RUN_TEST(test_peaks_shift);
+    RUN_TEST(test_peaks_moments);
     return UNITY_END();
 }
\ No newline at end of file
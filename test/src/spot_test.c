@@ -21,6 +21,16 @@ static double const MAX_RAND = (double)RAND_MAX;
 
 static unsigned long const SIZE = sizeof(initial_data) / sizeof(double);
 
+// the batch scores are the scalar ones, except with the libmvec backend (its
+// vector functions are a few ulps away from the scalar ones)
+#ifdef LIBSPOT_MATH_LIBMVEC
+#define TEST_ASSERT_SAME_SCORE(expected, actual)                               \
+    TEST_ASSERT_DOUBLE_WITHIN(1e-12 * fabs(expected), expected, actual)
+#else
+#define TEST_ASSERT_SAME_SCORE(expected, actual)                               \
+    TEST_ASSERT_TRUE((expected) == (actual))
+#endif
+
 double urand(void) { return (double)rand() / MAX_RAND; }
 
 void fill_uniform(void) {
@@ -41,6 +51,8 @@ void fill_lognormal(void) {
     }
 }
 
+double erand(void) { return -log((1.0 + (double)rand()) / (2.0 + MAX_RAND)); }
+
 static int cmp_double(void const *a, void const *b) {
     double *ad = (double *)a;
     double *bd = (double *)b;
@@ -172,6 +184,274 @@ void test_spot_step(void) {
                               normal);
 }
 
+/**
+ * @brief Fill the data with a trend (non-stationary training data)
+ */
+void fill_trend(double drift) {
+    for (unsigned long i = 0; i < SIZE; ++i) {
+        initial_data[i] = invnorm(urand()) + drift * (double)i / (double)SIZE;
+    }
+}
+
+/**
+ * @brief Number of data beyond the excess threshold of a fitted detector
+ */
+unsigned long count_excesses(struct Spot const *spot) {
+    unsigned long excesses = 0;
+    for (unsigned long i = 0; i < SIZE; ++i) {
+        excesses +=
+            (spot->__up_down * (initial_data[i] - spot->excess_threshold) > 0);
+    }
+    return excesses;
+}
+
+void test_spot_fit_chunks(void) {
+    struct Spot exact;
+    struct Spot Spot;
+    fill_gaussian();
+
+    double const q = 1e-5;
+    double const level = 0.995;
+    unsigned long const max_excess = Nt;
+    unsigned long const chunk = 4099;
+    unsigned long const candidates[] = {0, 2 * max_excess + 100};
+
+    for (int low = 0; low < 2; ++low) {
+        int ko = spot_init(&exact, q, low, 1, level, max_excess);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        TEST_ASSERT_EQUAL_INT(-ERR_FIT_NOT_STARTED,
+                              spot_fit_feed(&exact, initial_data, SIZE));
+        TEST_ASSERT_EQUAL_INT(-ERR_FIT_NOT_STARTED, spot_fit_end(&exact));
+
+        // the candidate buffer can store all the data: the fit is exact
+        ko = spot_fit_begin(&exact, SIZE);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        for (unsigned long i = 0; i < SIZE; i += chunk) {
+            unsigned long size = (i + chunk < SIZE) ? chunk : SIZE - i;
+            ko = spot_fit_feed(&exact, initial_data + i, size);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+        }
+        ko = spot_fit_end(&exact);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        TEST_ASSERT_NULL(exact.candidates.data);
+        TEST_ASSERT_EQUAL_UINT64(SIZE, exact.n);
+        TEST_ASSERT_EQUAL_UINT64(count_excesses(&exact), exact.Nt);
+
+        // spot_fit (0) and a smaller buffer keep only the last candidates:
+        // the tail is the same but Nt is estimated
+        for (int k = 0; k < 2; ++k) {
+            ko = spot_init(&Spot, q, low, 1, level, max_excess);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            if (candidates[k] == 0) {
+                ko = spot_fit(&Spot, initial_data, SIZE);
+                TEST_ASSERT_EQUAL_INT(0, ko);
+            } else {
+                ko = spot_fit_begin(&Spot, candidates[k]);
+                TEST_ASSERT_EQUAL_INT(0, ko);
+                for (unsigned long i = 0; i < SIZE; i += chunk) {
+                    unsigned long size = (i + chunk < SIZE) ? chunk : SIZE - i;
+                    ko = spot_fit_feed(&Spot, initial_data + i, size);
+                    TEST_ASSERT_EQUAL_INT(0, ko);
+                }
+                ko = spot_fit_end(&Spot);
+                TEST_ASSERT_EQUAL_INT(0, ko);
+            }
+            TEST_ASSERT_NULL(Spot.candidates.data);
+            TEST_ASSERT_EQUAL_UINT64(exact.n, Spot.n);
+            TEST_ASSERT_EQUAL_DOUBLE(exact.excess_threshold,
+                                     Spot.excess_threshold);
+            TEST_ASSERT_EQUAL_UINT64(max_excess,
+                                     peaks_size(&(Spot.tail.peaks)));
+            TEST_ASSERT_UINT64_WITHIN(exact.Nt / 20, exact.Nt, Spot.Nt);
+            TEST_ASSERT_DOUBLE_WITHIN(0.05 * exact.anomaly_threshold,
+                                      exact.anomaly_threshold,
+                                      Spot.anomaly_threshold);
+            spot_free(&Spot);
+        }
+        spot_free(&exact);
+    }
+}
+
+void test_spot_fit_chunks_trend(void) {
+    struct Spot Spot;
+    unsigned long const chunk = 4099;
+    double const drifts[] = {-5.0, -1.0, 1.0, 5.0};
+
+    for (int low = 0; low < 2; ++low) {
+        for (int k = 0; k < 4; ++k) {
+            fill_trend(drifts[k]);
+            // the buffer can hold all the data: the candidates are not
+            // filtered, so Nt is exact even if the threshold drifts
+            int ko = spot_init(&Spot, 1e-4, low, 1, 0.98, 200);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            ko = spot_fit_begin(&Spot, SIZE);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            for (unsigned long i = 0; i < SIZE; i += chunk) {
+                unsigned long size = (i + chunk < SIZE) ? chunk : SIZE - i;
+                ko = spot_fit_feed(&Spot, initial_data + i, size);
+                TEST_ASSERT_EQUAL_INT(0, ko);
+            }
+            ko = spot_fit_end(&Spot);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            TEST_ASSERT_EQUAL_UINT64(count_excesses(&Spot), Spot.Nt);
+            spot_free(&Spot);
+
+            // the buffer keeps the last candidates: the evicted excesses are
+            // estimated with a sample of the evicted candidates
+            ko = spot_init(&Spot, 1e-4, low, 1, 0.98, 200);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            ko = spot_fit_begin(&Spot, 4 * 200);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            for (unsigned long i = 0; i < SIZE; i += chunk) {
+                unsigned long size = (i + chunk < SIZE) ? chunk : SIZE - i;
+                ko = spot_fit_feed(&Spot, initial_data + i, size);
+                TEST_ASSERT_EQUAL_INT(0, ko);
+            }
+            ko = spot_fit_end(&Spot);
+            TEST_ASSERT_EQUAL_INT(0, ko);
+            unsigned long const excesses = count_excesses(&Spot);
+            TEST_ASSERT_UINT64_WITHIN(excesses * 3 / 20, excesses, Spot.Nt);
+            spot_free(&Spot);
+        }
+    }
+}
+
+void test_spot_step_batch(void) {
+    struct Spot reference;
+    struct Spot Spot;
+    static int results[100000];
+    fill_gaussian();
+
+    double const q = 1e-4;
+    double const level = 0.99;
+    unsigned long const max_excess = 500;
+    unsigned long const n = sizeof(results) / sizeof(int);
+
+    for (int low = 0; low < 2; ++low) {
+        int ko = spot_init(&reference, q, low, 1, level, max_excess);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        ko = spot_fit(&reference, initial_data, SIZE - n);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        ko = spot_init(&Spot, q, low, 1, level, max_excess);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        ko = spot_fit(&Spot, initial_data, SIZE - n);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+
+        // some anomalies and a NaN
+        initial_data[SIZE - n + 10] = (low ? -1.0 : 1.0) * 100.0;
+        initial_data[SIZE - n + 20] = _NAN;
+
+        unsigned long anomalies = spot_step_batch(
+            &Spot, initial_data + SIZE - n, n / 2, results);
+        anomalies += spot_step_batch(&Spot, initial_data + SIZE - n / 2,
+                                     n / 2, NULL);
+        TEST_ASSERT_TRUE(anomalies >= 1);
+
+        unsigned long expected = 0;
+        for (unsigned long i = 0; i < n; ++i) {
+            int const r = spot_step(&reference, initial_data[SIZE - n + i]);
+            expected += (r == ANOMALY);
+            if (i < n / 2) {
+                TEST_ASSERT_EQUAL_INT(r, results[i]);
+            }
+        }
+        TEST_ASSERT_EQUAL_INT(-ERR_DATA_IS_NAN, results[20]);
+        TEST_ASSERT_EQUAL_UINT64(expected, anomalies);
+        TEST_ASSERT_EQUAL_UINT64(reference.n, Spot.n);
+        TEST_ASSERT_EQUAL_UINT64(reference.Nt, Spot.Nt);
+        TEST_ASSERT_EQUAL_DOUBLE(reference.anomaly_threshold,
+                                 Spot.anomaly_threshold);
+        spot_free(&Spot);
+        spot_free(&reference);
+    }
+}
+
+void test_spot_rebase(void) {
+    struct Spot Spot;
+    fill_gaussian();
+
+    double const q = 1e-4;
+    double const level = 0.99;
+    unsigned long const max_excess = 500;
+    // drift of the stream mean (over SIZE steps)
+    double const drift = 1.0;
+    unsigned long excesses[2] = {0, 0};
+
+    for (int k = 0; k < 2; ++k) {
+        int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        TEST_ASSERT_DOUBLE_IS_NAN(Spot.rebase_tolerance);
+        ko = spot_fit(&Spot, initial_data, SIZE);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        double const t0 = Spot.excess_threshold;
+        if (k == 1) {
+            spot_set_rebase_tolerance(&Spot, 0.05);
+            TEST_ASSERT_EQUAL_DOUBLE(0.05, Spot.rebase_tolerance);
+        }
+
+        srand(1);
+        for (unsigned long i = 0; i < SIZE; ++i) {
+            double x = invnorm(urand()) + drift * (double)i / (double)SIZE;
+            if (spot_step(&Spot, x) == EXCESS) {
+                excesses[k]++;
+            }
+        }
+        if (k == 1) {
+            // the threshold has followed the drift (with some lag)
+            TEST_ASSERT_DOUBLE_WITHIN(drift / 2, t0 + drift,
+                                      Spot.excess_threshold);
+        } else {
+            TEST_ASSERT_EQUAL_DOUBLE(t0, Spot.excess_threshold);
+        }
+        spot_free(&Spot);
+    }
+
+    sprintf(buffer, "excesses: %lu (fixed) vs %lu (rebased)", excesses[0],
+            excesses[1]);
+    TEST_MESSAGE(buffer);
+    // without recalibration, the tail is flooded
+    TEST_ASSERT_GREATER_THAN_UINT64((unsigned long)(3 * (1 - level) * SIZE),
+                                    excesses[0]);
+    // otherwise the excess rate remains close to 1 - level
+    TEST_ASSERT_LESS_THAN_UINT64((unsigned long)(2 * (1 - level) * SIZE),
+                                 excesses[1]);
+}
+
+void test_spot_stationary_rate(void) {
+    struct Spot Spot;
+    // Exp(1) stream: the true anomaly rate is q
+    double const q = 1e-3;
+    double const level = 0.98;
+    unsigned long const max_excess = 200;
+    unsigned long const fit_size = 20000;
+    unsigned long const steps = 10 * SIZE;
+    unsigned long anomalies = 0;
+
+    for (unsigned long i = 0; i < fit_size; ++i) {
+        initial_data[i] = erand();
+    }
+    int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&Spot, initial_data, fit_size);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+
+    for (unsigned long i = 0; i < steps; ++i) {
+        if (spot_step(&Spot, erand()) == ANOMALY) {
+            anomalies++;
+        }
+    }
+    double const rate = (double)anomalies / (double)steps;
+    sprintf(buffer, "rate=%.2e zq=%.3f gamma=%.3f sigma=%.3f", rate,
+            Spot.anomaly_threshold, Spot.tail.gamma, Spot.tail.sigma);
+    TEST_MESSAGE(buffer);
+    // the discarded anomalies truncate the peaks, so the rate is above q,
+    // but the refits must not shrink the tail step after step
+    TEST_ASSERT_MESSAGE(rate < 6 * q, buffer);
+    TEST_ASSERT_MESSAGE(Spot.tail.sigma > 0.4, buffer);
+    TEST_ASSERT_MESSAGE(Spot.anomaly_threshold > 5.0, buffer);
+    spot_free(&Spot);
+}
+
 static double const probabilities[] = {
     1e-06,   2.0e-06, 3.0e-06, 4.0e-06, 5.0e-06, 6.0e-06, 7.0e-06,
     8.0e-06, 9.0e-06, 1.0e-05, 2.0e-05, 3.0e-05, 4.0e-05, 5.0e-05,
@@ -308,6 +588,186 @@ void test_spot_probability(void) {
     }
 }
 
+void test_spot_batch(void) {
+    struct Spot spot;
+    static double q[1000];
+    static double values[1000];
+    unsigned long const n = sizeof(q) / sizeof(double);
+
+    for (int low = 0; low < 2; ++low) {
+        TEST_ASSERT_EQUAL_INT(0, spot_init(&spot, 1e-3, low, 1, 0.98, 500));
+        fill_gaussian();
+        TEST_ASSERT_EQUAL_INT(0, spot_fit(&spot, initial_data, 50000));
+        for (unsigned long i = 0; i < n; ++i) {
+            q[i] = 1e-7 + 1e-2 * (double)i / (double)n;
+        }
+
+        // the exponential tail takes the other branch
+        double const gamma = spot.tail.gamma;
+        for (int k = 0; k < 2; ++k) {
+            spot.tail.gamma = k ? 0.0 : gamma;
+            spot_quantile_batch(&spot, q, n, values);
+            for (unsigned long i = 0; i < n; ++i) {
+                TEST_ASSERT_SAME_SCORE(spot_quantile(&spot, q[i]), values[i]);
+            }
+            // round trip (in place)
+            spot_probability_batch(&spot, values, n, values);
+            for (unsigned long i = 0; i < n; ++i) {
+                TEST_ASSERT_SAME_SCORE(
+                    spot_probability(&spot, spot_quantile(&spot, q[i])),
+                    values[i]);
+                TEST_ASSERT_DOUBLE_WITHIN(1e-6 * q[i], q[i], values[i]);
+            }
+        }
+        spot_free(&spot);
+    }
+}
+
+void test_spot_freeze(void) {
+    struct Spot spot;
+    struct SpotFrozen frozen;
+    static double probabilities[1000];
+    static int results[1000];
+    unsigned long const n = sizeof(results) / sizeof(int);
+
+    for (int k = 0; k < 4; ++k) {
+        int const low = k & 1;
+        int const discard = k >> 1;
+        int ko = spot_init(&spot, 1e-3, low, discard, 0.98, 500);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        // not fitted
+        TEST_ASSERT_EQUAL_INT(-ERR_EXCESS_THRESHOLD_IS_NAN,
+                              spot_freeze(&spot, &frozen));
+
+        fill_gaussian();
+        ko = spot_fit(&spot, initial_data, 50000);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        ko = spot_freeze(&spot, &frozen);
+        TEST_ASSERT_EQUAL_INT(0, ko);
+        TEST_ASSERT_TRUE(sizeof(struct SpotFrozen) <= 64);
+
+        // same scores as the detector
+        TEST_ASSERT_EQUAL_DOUBLE(spot_quantile(&spot, 1e-4),
+                                 spot_frozen_quantile(&frozen, 1e-4));
+        double const *data = initial_data + 50000;
+        spot_frozen_probability(&frozen, data, n, probabilities);
+        for (unsigned long i = 0; i < n; ++i) {
+            TEST_ASSERT_EQUAL_DOUBLE(spot_probability(&spot, data[i]),
+                                     probabilities[i]);
+        }
+
+        // same decisions as the detector (without learning)
+        initial_data[50000] = 0. / 0.;
+        // the thresholds themselves: an excess (see spot_step)
+        initial_data[50001] = frozen.excess_threshold;
+        initial_data[50002] = frozen.anomaly_threshold;
+        // beyond the anomaly threshold: an excess if the anomalies are kept
+        initial_data[50003] = frozen.anomaly_threshold + frozen.__up_down;
+        unsigned long anomalies =
+            spot_frozen_classify(&frozen, data, n, results);
+        unsigned long expected = 0;
+        TEST_ASSERT_EQUAL_INT(-ERR_DATA_IS_NAN, results[0]);
+        TEST_ASSERT_EQUAL_INT(EXCESS, results[1]);
+        TEST_ASSERT_EQUAL_INT(EXCESS, results[2]);
+        TEST_ASSERT_EQUAL_INT(discard ? ANOMALY : EXCESS, results[3]);
+        for (unsigned long i = 1; i < n; ++i) {
+            double const x = low ? -data[i] : data[i];
+            double const et = low ? -frozen.excess_threshold
+                                  : frozen.excess_threshold;
+            double const at = low ? -frozen.anomaly_threshold
+                                  : frozen.anomaly_threshold;
+            int const result = (discard && (x > at)) ? ANOMALY
+                               : (x >= et)           ? EXCESS
+                                                     : NORMAL;
+            TEST_ASSERT_EQUAL_INT(result, results[i]);
+            expected += (result == ANOMALY);
+        }
+        TEST_ASSERT_EQUAL_UINT64(expected, anomalies);
+        // the detector gives the same decisions
+        TEST_ASSERT_EQUAL_INT(results[3], spot_step(&spot, data[3]));
+        TEST_ASSERT_EQUAL_INT(results[1], spot_step(&spot, data[1]));
+        spot_free(&spot);
+    }
+}
+
+void test_spot_serialize(void) {
+    struct Spot Spot;
+    struct Spot restored;
+    fill_gaussian();
+
+    double const q = 1e-4;
+    double const level = 0.99;
+    unsigned long const max_excess = 500;
+    unsigned long const half = SIZE / 2;
+
+    int ko = spot_init(&Spot, q, 0, 1, level, max_excess);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    ko = spot_fit(&Spot, initial_data, half);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+    spot_set_rebase_tolerance(&Spot, 0.01);
+    // the tail is filled and the cursor is somewhere in the middle
+    for (unsigned long i = half; i < half + 10007; ++i) {
+        spot_step(&Spot, initial_data[i]);
+    }
+
+    unsigned long const size = spot_serialized_size(&Spot);
+    TEST_ASSERT_EQUAL_UINT64(8 * (35 + max_excess), size);
+    unsigned char *buffer = malloc(size);
+    TEST_ASSERT_EQUAL_INT(-ERR_BUFFER_TOO_SMALL,
+                          spot_serialize(&Spot, buffer, size - 1));
+    TEST_ASSERT_EQUAL_INT(0, spot_serialize(&Spot, buffer, size));
+    // magic number
+    TEST_ASSERT_EQUAL_MEMORY("SPOT", buffer, 4);
+
+    TEST_ASSERT_EQUAL_INT(-ERR_BUFFER_TOO_SMALL,
+                          spot_deserialize(&restored, buffer, size - 8));
+    ko = spot_deserialize(&restored, buffer, size);
+    TEST_ASSERT_EQUAL_INT(0, ko);
+
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.q, restored.q);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.level, restored.level);
+    TEST_ASSERT_EQUAL_INT(Spot.low, restored.low);
+    TEST_ASSERT_EQUAL_INT(Spot.discard_anomalies, restored.discard_anomalies);
+    TEST_ASSERT_EQUAL_UINT64(Spot.n, restored.n);
+    TEST_ASSERT_EQUAL_UINT64(Spot.Nt, restored.Nt);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.excess_threshold, restored.excess_threshold);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.anomaly_threshold,
+                             restored.anomaly_threshold);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.tail.gamma, restored.tail.gamma);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.tail.sigma, restored.tail.sigma);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.rebase_tolerance, restored.rebase_tolerance);
+    TEST_ASSERT_EQUAL_MEMORY(&(Spot.tracker), &(restored.tracker),
+                             sizeof(struct P2));
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.tail.peaks.min, restored.tail.peaks.min);
+    TEST_ASSERT_EQUAL_DOUBLE(Spot.tail.peaks.max, restored.tail.peaks.max);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9 * Spot.tail.peaks.e, Spot.tail.peaks.e,
+                              restored.tail.peaks.e);
+
+    // both instances behave the same
+    for (unsigned long i = half + 10007; i < SIZE; ++i) {
+        TEST_ASSERT_EQUAL_INT(spot_step(&Spot, initial_data[i]),
+                              spot_step(&restored, initial_data[i]));
+    }
+    TEST_ASSERT_EQUAL_UINT64(Spot.Nt, restored.Nt);
+    TEST_ASSERT_DOUBLE_WITHIN(1e-9 * Spot.anomaly_threshold,
+                              Spot.anomaly_threshold,
+                              restored.anomaly_threshold);
+    spot_free(&restored);
+
+    // corrupted snapshots
+    buffer[0] = 'X';
+    TEST_ASSERT_EQUAL_INT(-ERR_INVALID_SNAPSHOT,
+                          spot_deserialize(&restored, buffer, size));
+    buffer[0] = 'S';
+    // negative excess
+    buffer[size - 1] = 0xbf;
+    TEST_ASSERT_EQUAL_INT(-ERR_INVALID_SNAPSHOT,
+                          spot_deserialize(&restored, buffer, size));
+
+    free(buffer);
+    spot_free(&Spot);
+}
+
 void benchmark_spot(void) {
     struct Spot spot;
 
@@ -368,7 +828,7 @@ void test_error_msg(void) {
     unsigned long const size = 256;
     char buffer[size];
     for (enum LibspotError err = ERR_MEMORY_ALLOCATION_FAILED;
-         err <= ERR_DATA_IS_NAN; ++err) {
+         err <= ERR_INVALID_SNAPSHOT; ++err) {
         libspot_error(err, buffer, size);
         printf("%s\n", buffer);
     }
@@ -401,8 +861,16 @@ int main(void) {
     RUN_TEST(test_spot_init);
     RUN_TEST(test_spot_fit);
     RUN_TEST(test_spot_step);
+    RUN_TEST(test_spot_fit_chunks);
+    RUN_TEST(test_spot_fit_chunks_trend);
+    RUN_TEST(test_spot_step_batch);
+    RUN_TEST(test_spot_rebase);
+    RUN_TEST(test_spot_stationary_rate);
     RUN_TEST(test_spot_quantile);
     RUN_TEST(test_spot_probability);
+    RUN_TEST(test_spot_serialize);
+    RUN_TEST(test_spot_batch);
+    RUN_TEST(test_spot_freeze);
     RUN_TEST(benchmark_spot);
     RUN_TEST(test_error_msg);
     RUN_TEST(test_libspot_version);
@@ -41,7 +41,7 @@ void test_tail_fit(void) {
             tail_push(&Tail, R->data[i]);
         }
 
-        double llhood = tail_fit(&Tail);
+        double llhood = tail_fit(&Tail, 0);
         sprintf(buffer,
                 "gamma=%.6f (%.6f), sigma=%.6f (%.6f), L=%.3f (%.3f) (%s)",
                 Tail.gamma, R->gamma, Tail.sigma, R->sigma, llhood, R->llhood,
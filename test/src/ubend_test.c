@@ -57,6 +57,41 @@ void test_ubend_free(void) {
     TEST_ASSERT_DOUBLE_IS_NAN(Ubend.last_erased_data);
 }
 
+void test_ubend_filter(void) {
+    unsigned long const capacity = 6;
+    struct Ubend Ubend;
+    ubend_init(&Ubend, capacity);
+
+    // 8 pushes: data = [7, 8, 3, 4, 5, 6] and cursor = 2
+    for (unsigned long i = 1; i <= 8; ++i) {
+        ubend_push(&Ubend, (double)i);
+    }
+    // now the insertion order is -1, 4, 5, 0, 7, 0
+    Ubend.data[1] = 0.0;
+    Ubend.data[2] = -1.0;
+    Ubend.data[5] = 0.0;
+
+    TEST_ASSERT_EQUAL_UINT(3, ubend_filter(&Ubend, 2.0));
+    TEST_ASSERT_EQUAL_UINT(3, ubend_size(&Ubend));
+    TEST_ASSERT_EQUAL_INT(0, Ubend.filled);
+    TEST_ASSERT_DOUBLE_IS_NAN(Ubend.last_erased_data);
+    double const expected[] = {4.0, 5.0, 7.0};
+    TEST_ASSERT_EQUAL_DOUBLE_ARRAY(expected, Ubend.data, 3);
+
+    // the order is kept: the oldest value is erased first
+    for (unsigned long i = 0; i < 3; ++i) {
+        TEST_ASSERT_DOUBLE_IS_NAN(ubend_push(&Ubend, 10.0));
+    }
+    TEST_ASSERT_EQUAL_DOUBLE(4.0, ubend_push(&Ubend, 10.0));
+
+    // nothing removed (the container remains filled)
+    TEST_ASSERT_EQUAL_UINT(capacity, ubend_filter(&Ubend, 0.0));
+    TEST_ASSERT_EQUAL_INT(1, Ubend.filled);
+    TEST_ASSERT_EQUAL_DOUBLE(5.0, ubend_push(&Ubend, 10.0));
+
+    ubend_free(&Ubend);
+}
+
 void setUp(void) { internal_set_allocators(malloc, free); }
 
 void tearDown(void) {}
@@ -67,5 +102,6 @@ int main(void) {
     RUN_TEST(test_ubend_push);
     RUN_TEST(test_ubend_size);
     RUN_TEST(test_ubend_free);
+    RUN_TEST(test_ubend_filter);
     return UNITY_END();
 }
\ No newline at end of file
@@ -474,6 +474,63 @@ void test_xpow(void) {
     }
 }
 
+// the batch kernels give the scalar values, except with the libmvec backend
+// (its vector functions are a few ulps away from the scalar ones)
+static int same_value(double expected, double actual) {
+    if (is_nan(expected) || is_nan(actual)) {
+        return is_nan(expected) && is_nan(actual);
+    }
+#ifdef LIBSPOT_MATH_LIBMVEC
+    double const d = expected - actual;
+    double const m = expected < 0 ? -expected : expected;
+    return (expected == actual) || ((d < 0 ? -d : d) <= 1e-14 * m);
+#else
+    return expected == actual;
+#endif
+}
+
+void test_xmath_batch(void) {
+    double x[600];
+    double out[600];
+    unsigned long const n = sizeof(x) / sizeof(double);
+    for (unsigned long i = 0; i < n; ++i) {
+        // wide range of magnitudes, both signs
+        x[i] = (i % 2 ? -1. : 1.) * xpow(1.5, (double)i / 8. - 40.);
+    }
+    // special cases
+    x[0] = 0.;
+    x[1] = _NAN;
+    x[2] = 4.9e-324;
+    x[3] = 1.;
+    x[4] = 0.5;
+    x[5] = 709.9;
+    x[7] = -745.2;
+
+    xlog_batch(x, out, n);
+    for (unsigned long i = 0; i < n; ++i) {
+        double const expected = xlog(x[i]);
+        TEST_ASSERT_TRUE(same_value(expected, out[i]));
+    }
+    xexp_batch(x, out, n);
+    for (unsigned long i = 0; i < n; ++i) {
+        double const expected = xexp(x[i]);
+        TEST_ASSERT_TRUE(same_value(expected, out[i]));
+    }
+    // in place
+    for (unsigned long i = 0; i < n; ++i) {
+        x[i] = x[i] < 0 ? -x[i] : x[i];
+    }
+    x[0] = 2.;
+    for (unsigned long i = 0; i < n; ++i) {
+        out[i] = x[i];
+    }
+    xpow_batch(out, -0.3, out, n);
+    for (unsigned long i = 0; i < n; ++i) {
+        double const expected = xpow(x[i], -0.3);
+        TEST_ASSERT_TRUE(same_value(expected, out[i]));
+    }
+}
+
 void test_xmin(void) {
     TEST_ASSERT_EQUAL_DOUBLE(1, xmin(1, 2));
     TEST_ASSERT_EQUAL_DOUBLE(1, xmin(2, 1));
@@ -508,5 +565,6 @@ int main(void) {
     RUN_TEST(test_xmin);
     RUN_TEST(test_is_nan);
     RUN_TEST(test_xpow);
+    RUN_TEST(test_xmath_batch);
     return UNITY_END();
 }
\ No newline at end of file
@@ -0,0 +1,75 @@
+#!/bin/sh
+# Scripted tests of spot-cli: a CSV or binary input goes in, the anomaly
+# rows and the number of fitted values are checked.
+#
+# Usage: spot-cli_test.sh DIST_DIR
+
+SPOT_CLI="${1:-dist}/spot-cli"
+NAME="test/tools/spot-cli_test.sh"
+. "$(dirname "$0")/unity.sh"
+
+# rows "index,value" (exponential values): an outlier in the fit (row 100)
+# and three after it
+rows() {
+    awk -v size="$1" 'BEGIN {
+        srand(5);
+        for (i = 0; i < size; i++) {
+            value = -log(1.0 - rand());
+            if ((i == 100) || (i == 6000) || (i == 12000) || (i == 18000)) {
+                value = 100;
+            }
+            printf "%d,%.6f\n", i, value;
+        }
+    }'
+}
+
+# check_rows OUTPUT STDERR FITTED: the anomaly rows are the outliers after
+# the fit (and a few others at the rate q), the fit counts FITTED values
+check_rows() {
+    awk -F ',' '
+        NR == 1 { header = ($0 == "index,value,threshold,probability") }
+        NR > 1 && NF != 4 { bad++ }
+        NR > 1 && $2 == 100 { outliers = outliers " " $1 }
+        NR > 1 && $1 == 100 { bad++ }
+        END { exit !(header && (bad == 0) &&
+                     (outliers == " 6000 12000 18000")) }' "$1" &&
+        grep -q "(${3} fitted), $(($(wc -l < "$1") - 1)) anomalies" "$2"
+}
+
+# same_rows OUTPUT REFERENCE
+same_rows() {
+    [ -s "$2" ] && cmp -s "$1" "$2"
+}
+
+test_spot_cli_csv() {
+    rows 20000 > "$TMP/rows.csv"
+    "$SPOT_CLI" -c 1 -n 5000 "$TMP/rows.csv" > "$TMP/csv" 2> "$TMP/csv.err"
+    report test_spot_cli_csv check_rows "$TMP/csv" "$TMP/csv.err" 5000
+}
+
+# the pipes are read by chunks: same rows as the mapped file
+test_spot_cli_pipe() {
+    rows 20000 | "$SPOT_CLI" -c 1 -n 5000 > "$TMP/pipe" 2> "$TMP/pipe.err"
+    report test_spot_cli_pipe same_rows "$TMP/pipe" "$TMP/csv"
+}
+
+test_spot_cli_bin() {
+    rows 20000 | cut -d ',' -f 2 |
+        perl -ne 'print pack("d<", $_)' > "$TMP/rows.bin"
+    "$SPOT_CLI" -f bin -n 5000 "$TMP/rows.bin" > "$TMP/bin" 2> "$TMP/bin.err"
+    report test_spot_cli_bin same_rows "$TMP/bin" "$TMP/csv"
+}
+
+# fewer values than the fit size: the fit uses them all
+test_spot_cli_short() {
+    rows 500 | "$SPOT_CLI" -c 1 -n 5000 > "$TMP/short" 2> "$TMP/short.err"
+    report test_spot_cli_short grep -q "500 rows (500 fitted), 0 anomalies" \
+        "$TMP/short.err"
+}
+
+test_spot_cli_csv
+test_spot_cli_pipe
+test_spot_cli_bin
+test_spot_cli_short
+
+report_end
@@ -0,0 +1,75 @@
+#!/bin/sh
+# Scripted tests of spotd: records are piped through stdin and the anomaly
+# lines are checked.
+#
+# Usage: spotd_test.sh DIST_DIR
+
+SPOTD="${1:-dist}/spotd"
+NAME="test/tools/spotd_test.sh"
+. "$(dirname "$0")/unity.sh"
+
+# records of the series a, b and c (exponential values), one outlier in the
+# warm-up of b and one after the warm-up of a
+records() {
+    awk 'BEGIN {
+        srand(7);
+        for (i = 0; i < 1500; i++) {
+            for (s = 0; s < 3; s++) {
+                name = substr("abc", s + 1, 1);
+                value = -log(1.0 - rand());
+                if ((s == 1) && (i == 10)) { value = 1000; }
+                if ((s == 0) && (i == 1200)) { value = 1000; }
+                printf "%s %.6f\n", name, value;
+            }
+        }
+    }'
+}
+
+# anomaly lines "series value threshold probability" of a spotd output
+check_anomalies() {
+    awk '
+        NF != 4 { bad++ }
+        $2 == 1000 && $1 == "a" && $3 < 1000 && $4 < 1e-4 { a++ }
+        $2 == 1000 && $1 != "a" { bad++ }
+        END { exit !((a == 1) && (bad == 0)) }' "$1"
+}
+
+test_spotd_file() {
+    records > "$TMP/records"
+    "$SPOTD" -t 2 -n 1000 < "$TMP/records" > "$TMP/file" 2> "$TMP/file.err"
+    report test_spotd_file check_anomalies "$TMP/file"
+}
+
+test_spotd_pipe() {
+    records | "$SPOTD" -t 2 -n 1000 > "$TMP/pipe" 2> "$TMP/pipe.err"
+    report test_spotd_pipe check_anomalies "$TMP/pipe"
+}
+
+# stats "series names evictions" printed by spotd at exit
+stats() {
+    sed -n 's/^spotd: \([0-9]*\) series, \([0-9]*\) names, \([0-9]*\) evictions.*/\1 \2 \3/p' "$1"
+}
+
+# the names of the dropped series are forgotten: the series table does not
+# grow with the churn of the series under a memory cap
+check_churn() {
+    set -- $(stats "$1")
+    [ "$#" -eq 3 ] && [ "$1" -eq "$2" ] && [ "$1" -lt 5000 ] && [ "$3" -gt 0 ]
+}
+
+test_spotd_churn() {
+    awk 'BEGIN {
+        srand(11);
+        for (s = 0; s < 5000; s++) {
+            for (i = 0; i < 12; i++) {
+                printf "series.%d %.6f\n", s, rand();
+            }
+        }
+    }' | "$SPOTD" -t 1 -n 10 -M 1 > "$TMP/churn" 2> "$TMP/churn.err"
+    report test_spotd_churn check_churn "$TMP/churn.err"
+}
+
+test_spotd_file
+test_spotd_pipe
+test_spotd_churn
+report_end
@@ -0,0 +1,28 @@
+# Helpers of the scripted tests (sourced): every test prints a line
+# file:line:name:PASS|FAIL like the Unity tests.
+
+TMP=$(mktemp -d)
+trap 'rm -rf "$TMP"' EXIT
+TESTS=0
+FAILURES=0
+
+# report TEST CONDITION... (the line is the one of the test function)
+report() {
+    test=$1
+    shift
+    line=$(grep -n "^$test()" "$0" | cut -d ':' -f 1)
+    TESTS=$((TESTS + 1))
+    if "$@"; then
+        echo "$NAME:$line:$test:PASS"
+    else
+        echo "$NAME:$line:$test:FAIL"
+        FAILURES=$((FAILURES + 1))
+    fi
+}
+
+# print the summary, the exit status is the one of the tests
+report_end() {
+    echo "-----------------------"
+    echo "$TESTS Tests $FAILURES Failures 0 Ignored"
+    [ "$FAILURES" -eq 0 ]
+}
@@ -1,4 +1,4 @@
-import { wasmBinary } from "./binary.ts";
+import { wasmBinary, wasmSimdBinary } from "./binary.ts";
 
 export interface Libspot {
   spot_size: () => number;
@@ -12,6 +12,25 @@ export interface Libspot {
   ) => number;
   spot_fit: (ptr: number, arrayPtr: number, size: number) => number;
   spot_step: (ptr: number, x: number) => number;
+  spot_step_batch: (
+    ptr: number,
+    arrayPtr: number,
+    size: number,
+    outPtr: number
+  ) => number;
+  spot_step_many: (
+    ptr: number,
+    arrayPtr: number,
+    size: number,
+    outPtr: number
+  ) => number;
+  spots_step_ids: (
+    spotsPtr: number,
+    idsPtr: number,
+    arrayPtr: number,
+    size: number,
+    outPtr: number
+  ) => number;
   spot_quantile: (ptr: number, q: number) => number;
   spot_probability: (ptr: number, z: number) => number;
   spot_free: (ptr: number) => void;
@@ -30,8 +49,21 @@ type LibspotExports = Libspot & {
   memory: WebAssembly.Memory;
 };
 
+// smallest module using a 128-bit SIMD instruction (i8x16.popcnt): it is
+// valid only on the runtimes that support SIMD
+const simdProbe = new Uint8Array([
+  0, 97, 115, 109, 1, 0, 0, 0, 1, 5, 1, 96, 0, 1, 123, 3, 2, 1, 0, 10, 10, 1,
+  8, 0, 65, 0, 253, 15, 253, 98, 11,
+]);
+
+/**
+ * Whether the SIMD build of the library is loaded (the scalar one otherwise)
+ */
+export const simd = WebAssembly.validate(simdProbe);
+
 const loadWASM = async (imports = {}): Promise<LibspotExports> => {
-  const { instance } = await WebAssembly.instantiate(wasmBinary.buffer, {
+  const binary = simd ? wasmSimdBinary : wasmBinary;
+  const { instance } = await WebAssembly.instantiate(binary.buffer, {
     ...imports,
   });
   // @ts-ignore
@@ -53,6 +85,9 @@ export const {
   spot_quantile,
   spot_size,
   spot_step,
+  spot_step_batch,
+  spot_step_many,
+  spots_step_ids,
   libspot_error,
   malloc,
   free,
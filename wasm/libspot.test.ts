@@ -5,7 +5,10 @@ import {
   spot_size,
   libspotError,
   EXCESS,
+  ANOMALY,
+  SpotWorkerPool,
 } from "./libspot.ts";
+import { malloc, free, memory } from "./libspot.core.ts";
 import * as fs from "fs";
 
 test("sizeof(Spot)", () => {
@@ -19,8 +22,10 @@ test("sizeof(Spot)", () => {
   // So      Ubend: 4 + 4 + 8 + 4 + 4 = 24
   //         Peaks: 8 + 8 + 8 + 8 + 24 = 56
   //          Tail: 8 + 8 + 56 = 72
-  //          Spot: 8 + 8 + 4 + 4 + 8 + 8 + 8 + 4 + 4 + 72 = 56 + 72 = 128
-  expect(spot_size()).toBe(128);
+  //            P2: 4 * 5 * 8 + 4 = 164
+  //          Spot: 8 + 8 + 4 + 4 + 8 + 8 + 8 + 4 + 4 + 72 + 8 + 164 + 24
+  //              = 56 + 72 + 172 (+ 4 padding) + 24 = 328
+  expect(spot_size()).toBe(328);
 });
 
 test("Spot(1e-6)", () => {
@@ -54,6 +59,122 @@ test("Spot.fit", () => {
   }
 });
 
+test("Spot.stepMany", () => {
+  const config = { q: 1e-4, level: 0.99 };
+  const s = new Spot(config);
+  const r = new Spot(config);
+  const data = Float64Array.from({ length: 60000 }, () => Math.random());
+  // views with an offset are accepted
+  expect(s.fit(data.subarray(0, 20000))).toBe(0);
+  expect(r.fit(data.slice(0, 20000))).toBe(0);
+  expect(s.anomaly_threshold()).toBe(r.anomaly_threshold());
+
+  data[30000] = NaN;
+  const results = s.stepMany(data.subarray(20000));
+  expect(results).toBeInstanceOf(Int8Array);
+  expect(results.length).toBe(40000);
+  for (let i = 0; i < results.length; i++) {
+    const x = data[20000 + i];
+    expect(results[i]).toBe(Number.isNaN(x) ? -1 : r.step(x));
+  }
+  expect(s.anomaly_threshold()).toBe(r.anomaly_threshold());
+  expect(s.stepMany(Float64Array.of(1e6))[0]).toBe(ANOMALY);
+});
+
+test("allocator stress", () => {
+  // deterministic pseudo-random sequence (LCG)
+  let seed = 1;
+  const next = (n: number) => {
+    seed = (seed * 1103515245 + 12345) % 2147483648;
+    return seed % n;
+  };
+  const slots = new Array<number>(4096).fill(0);
+  const sizes = new Array<number>(4096).fill(0);
+  const round = () => {
+    seed = 1;
+    for (let k = 0; k < 200000; k++) {
+      const i = next(slots.length);
+      if (slots[i] > 0) {
+        // the block has not been overwritten by another one
+        const heap = new Uint8Array(memory.buffer);
+        expect(heap[slots[i]]).toBe(i & 0xff);
+        expect(heap[slots[i] + sizes[i] - 1]).toBe(i & 0xff);
+        free(slots[i]);
+        slots[i] = 0;
+      } else {
+        sizes[i] = 1 + (next(8) === 0 ? next(60000) : next(300));
+        slots[i] = malloc(sizes[i]);
+        expect(slots[i] % 8).toBe(0);
+        new Uint8Array(memory.buffer).fill(
+          i & 0xff,
+          slots[i],
+          slots[i] + sizes[i]
+        );
+      }
+    }
+    slots.forEach((ptr, i) => {
+      free(ptr);
+      slots[i] = 0;
+    });
+  };
+
+  let start = performance.now();
+  round();
+  console.log(`malloc/free: ${(performance.now() - start).toFixed(1)} ms`);
+  // the freed blocks are merged and reused: the memory does not grow
+  const size = memory.buffer.byteLength;
+  round();
+  expect(memory.buffer.byteLength).toBe(size);
+
+  // detectors of various sizes created and released
+  const train = Float64Array.from({ length: 5000 }, () => Math.random());
+  start = performance.now();
+  for (let i = 0; i < 2000; i++) {
+    const s = new Spot({ q: 1e-3, level: 0.9, maxExcess: 100 + (i % 7) * 50 });
+    s.fit(train);
+    s.free();
+  }
+  console.log(`2000 detectors: ${(performance.now() - start).toFixed(1)} ms`);
+  expect(memory.buffer.byteLength).toBe(size);
+});
+
+test("SpotWorkerPool", async () => {
+  const n = 10;
+  const config = { q: 1e-4, level: 0.99 };
+  // small rings: the batches wrap around
+  const pool = await SpotWorkerPool.create(n, config, {
+    workers: 3,
+    capacity: 1024,
+  });
+  expect(pool.threads).toBe(3);
+  const spots = Array.from({ length: n }, () => new Spot(config));
+  for (let id = 0; id < n; id++) {
+    const train = Float64Array.from({ length: 5000 }, () => Math.random());
+    await pool.fit(id, train);
+    spots[id]!.fit(train);
+  }
+
+  const size = 20000;
+  const ids = Int32Array.from({ length: size }, () =>
+    Math.floor(Math.random() * n)
+  );
+  const values = Float64Array.from({ length: size }, () => Math.random());
+  values[123] = NaN;
+  const results = await pool.step(ids, values);
+  expect(results.length).toBe(size);
+  for (let i = 0; i < size; i++) {
+    const x = values[i]!;
+    expect(results[i]).toBe(Number.isNaN(x) ? -1 : spots[ids[i]!]!.step(x));
+  }
+  const thresholds = await pool.anomalyThresholds();
+  spots.forEach((s, id) => {
+    expect(thresholds[id]).toBe(s.anomaly_threshold());
+  });
+
+  await expect(pool.step(Int32Array.of(n), Float64Array.of(0))).rejects.toThrow();
+  pool.terminate();
+});
+
 const range = (start: number, stop: number, step: number = 1) =>
   Array.from({ length: (stop - start) / step + 1 }, (_, i) => start + i * step);
 
@@ -61,7 +182,7 @@ test("libspotError()", () => {
   const errors = range(1000, 1010)
     .map(libspotError)
     .map((msg, index) => {
-      if (index > 5) {
+      if (index > 8) {
         expect(msg).toBe("");
       } else {
         expect(msg).not.toBe("");
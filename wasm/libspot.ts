@@ -9,6 +9,7 @@ import {
   spot_quantile,
   spot_size,
   spot_step,
+  spot_step_many,
   libspot_version,
   memory,
 } from "./libspot.core.ts";
@@ -20,24 +21,55 @@ export const ANOMALY = 2;
 let heap8 = new Uint8Array(memory.buffer);
 
 /**
- * Wrapper around malloc to check if the requested memory fits the webassembly memory
+ * View over the webassembly memory. The allocator grows the memory on demand
+ * (which detaches the previous buffer), so the view is rebuilt when needed.
+ * @returns
+ */
+const heap = (): Uint8Array => {
+  if (heap8.buffer !== memory.buffer) {
+    heap8 = new Uint8Array(memory.buffer); // reinitialize the view
+  }
+  return heap8;
+};
+
+/**
+ * Wrapper around malloc that fails loudly
  * @param size Size in bytes to allocate
  * @returns
  */
 const malloc = (size: number): number => {
   const ptr = _malloc(size);
   if (ptr <= 0) {
-    return ptr;
-  }
-  if (ptr + size > memory.buffer.byteLength) {
-    // grow memory if needed
-    const pages = Math.ceil(size / 65536); // 64 KiB per page
-    memory.grow(pages);
-    heap8 = new Uint8Array(memory.buffer); // reinitialize the view
+    throw new Error(`cannot allocate ${size} bytes`);
   }
   return ptr;
 };
 
+/**
+ * Persistent region of the linear memory that receives the arrays passed to
+ * the library (and its outputs). It only grows, so the calls do not allocate.
+ */
+const scratch = { ptr: 0, size: 0 };
+
+/**
+ * Return the address of a scratch region of at least `size` bytes (malloc
+ * aligns it on 8 bytes, for Float64Array views)
+ * @param size Size in bytes
+ * @returns
+ */
+const reserve = (size: number): number => {
+  if (size > scratch.size) {
+    const capacity = Math.max(size, 2 * scratch.size, 4096);
+    if (scratch.ptr > 0) {
+      free(scratch.ptr);
+      scratch.ptr = scratch.size = 0;
+    }
+    scratch.ptr = malloc(capacity);
+    scratch.size = capacity;
+  }
+  return scratch.ptr;
+};
+
 const stringify = (raw: ArrayBuffer) => {
   return new TextDecoder("utf-8").decode(raw).replace(/\0/g, "");
 };
@@ -45,9 +77,9 @@ const stringify = (raw: ArrayBuffer) => {
 export const libspotError = (code: number): string => {
   const size = 256;
   const ptr = malloc(size);
-  heap8.fill(0, ptr, ptr + size); // fill with zeros
+  heap().fill(0, ptr, ptr + size); // fill with zeros
   libspot_error(code, ptr, size);
-  const msg = stringify(heap8.slice(ptr, ptr + size).buffer as ArrayBuffer);
+  const msg = stringify(heap().slice(ptr, ptr + size).buffer as ArrayBuffer);
   free(ptr);
   return msg;
 };
@@ -60,7 +92,7 @@ export const libspotVersion = (): string => {
   const size = 24;
   let ptr = malloc(size);
   libspot_version(ptr, size);
-  const version = stringify(heap8.slice(ptr, ptr + size).buffer as ArrayBuffer);
+  const version = stringify(heap().slice(ptr, ptr + size).buffer as ArrayBuffer);
   free(ptr);
   return version;
 };
@@ -136,7 +168,7 @@ export class Spot {
     maxExcess = 500,
   }: SpotConfig) {
     this.ptr = malloc(spot_size());
-    freg.register(this, this.ptr); // kind of destructor
+    freg.register(this, this.ptr, this); // kind of destructor
     const code = spot_init(
       this.ptr,
       q,
@@ -151,17 +183,30 @@ export class Spot {
   }
 
   anomaly_threshold() {
-    const buffer = heap8.slice(this.ptr + 32, this.ptr + 40).reverse().buffer;
+    const buffer = heap().slice(this.ptr + 32, this.ptr + 40).reverse().buffer;
     const view = new DataView(buffer);
     return view.getFloat64(0);
   }
 
   excess_threshold() {
-    const buffer = heap8.slice(this.ptr + 40, this.ptr + 48).reverse().buffer;
+    const buffer = heap().slice(this.ptr + 40, this.ptr + 48).reverse().buffer;
     const view = new DataView(buffer);
     return view.getFloat64(0);
   }
 
+  /**
+   * Release the memory of the detector now (instead of waiting for the
+   * garbage collector). The object must not be used afterwards.
+   */
+  free() {
+    if (this.ptr > 0) {
+      freg.unregister(this);
+      spot_free(this.ptr);
+      free(this.ptr);
+      this.ptr = 0;
+    }
+  }
+
   /**
    *
    * @param data Input data
@@ -169,18 +214,15 @@ export class Spot {
    * @throws {Error} When the fit has failed. It generally happens when either the anomaly or excess threshold is NaN.
    */
   fit(data: Float64Array) {
-    // reserve heap
-    const arrayPtr = malloc(data.length * data.BYTES_PER_ELEMENT);
-    // copy array (converted to bytes) to the heap
-    heap8.set(new Uint8Array(data.buffer), arrayPtr);
+    // copy array to the scratch region
+    const arrayPtr = reserve(data.byteLength);
+    new Float64Array(memory.buffer, arrayPtr, data.length).set(data);
 
     // call the function
     const code = spot_fit(this.ptr, arrayPtr, data.length);
     if (code < 0) {
       throw new Error(libspotError(-code));
     }
-    // release heap
-    free(arrayPtr);
     return code;
   }
 
@@ -198,6 +240,23 @@ export class Spot {
     return code;
   }
 
+  /**
+   * Fit-predict steps over an array, in a single call to the library
+   *
+   * @param data new incoming data
+   * @returns {Int8Array} 0: NORMAL, 1: EXCESS, 2: ANOMALY for every value
+   * (-1 for NaN)
+   */
+  stepMany(data: Float64Array): Int8Array {
+    const n = data.length;
+    // values then results
+    const arrayPtr = reserve(9 * n);
+    const outPtr = arrayPtr + 8 * n;
+    new Float64Array(memory.buffer, arrayPtr, n).set(data);
+    spot_step_many(this.ptr, arrayPtr, n, outPtr);
+    return new Int8Array(memory.buffer, outPtr, n).slice();
+  }
+
   /**
    * Compute the value zq such that P(X>zq) = q
    *
@@ -222,4 +281,6 @@ export class Spot {
 // console.log("HEAP8", heap8);
 
 export default Spot;
-export { spot_size } from "./libspot.core.ts";
+export { spot_size, simd } from "./libspot.core.ts";
+export { SpotWorkerPool } from "./pool.ts";
+export type { SpotWorkerPoolOptions } from "./pool.ts";
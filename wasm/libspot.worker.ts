@@ -0,0 +1,134 @@
+// Worker of a SpotWorkerPool (see pool.ts). It owns its own instance of the
+// library and a shard of the detectors, and steps the values that the main
+// thread writes into a SharedArrayBuffer ring.
+import {
+  free,
+  malloc,
+  memory,
+  spot_fit,
+  spot_init,
+  spot_size,
+  spots_step_ids,
+} from "./libspot.core.ts";
+import type { PoolReply, PoolRequest } from "./pool.ts";
+import { HEAD, TAIL } from "./pool.ts";
+
+declare const self: Worker;
+
+// detectors of the shard (contiguous array of struct Spot)
+let spots = 0;
+let count = 0;
+const stride = spot_size();
+
+// ring shared with the main thread
+let ctrl = new Int32Array(0);
+let ids = new Int32Array(0);
+let values = new Float64Array(0);
+let results = new Int8Array(0);
+
+// scratch region of the webassembly memory (it only grows)
+const scratch = { ptr: 0, size: 0 };
+
+const reserve = (size: number): number => {
+  if (size > scratch.size) {
+    const capacity = Math.max(size, 2 * scratch.size, 4096);
+    if (scratch.ptr > 0) {
+      free(scratch.ptr);
+      scratch.ptr = scratch.size = 0;
+    }
+    scratch.ptr = malloc(capacity);
+    if (scratch.ptr <= 0) {
+      throw new Error("cannot allocate the scratch memory");
+    }
+    scratch.size = capacity;
+  }
+  return scratch.ptr;
+};
+
+/**
+ * Step the ring entries [begin, end) (contiguous slots)
+ */
+const stepSlots = (begin: number, end: number) => {
+  const n = end - begin;
+  if (n <= 0) {
+    return;
+  }
+  // values, ids then results
+  const ptr = reserve(13 * n);
+  new Float64Array(memory.buffer, ptr, n).set(values.subarray(begin, end));
+  new Int32Array(memory.buffer, ptr + 8 * n, n).set(ids.subarray(begin, end));
+  spots_step_ids(spots, ptr + 8 * n, ptr, n, ptr + 12 * n);
+  results.set(new Int8Array(memory.buffer, ptr + 12 * n, n), begin);
+};
+
+const handle = (msg: PoolRequest): PoolReply => {
+  switch (msg.op) {
+    case "init": {
+      count = msg.count;
+      spots = malloc(Math.max(count, 1) * stride);
+      if (spots <= 0) {
+        return { op: "init", code: -1 };
+      }
+      const c = msg.config;
+      for (let k = 0; k < count; k++) {
+        const code = spot_init(
+          spots + k * stride,
+          c.q,
+          c.low ?? 0,
+          c.discardAnomalies ?? 1,
+          c.level ?? 0.98,
+          c.maxExcess ?? 500
+        );
+        if (code < 0) {
+          return { op: "init", code };
+        }
+      }
+      ctrl = new Int32Array(msg.channel, 0, 2);
+      const capacity = msg.capacity;
+      values = new Float64Array(msg.channel, 8, capacity);
+      ids = new Int32Array(msg.channel, 8 + 8 * capacity, capacity);
+      results = new Int8Array(msg.channel, 8 + 12 * capacity, capacity);
+      return { op: "init", code: 0 };
+    }
+    case "fit": {
+      const data = new Float64Array(msg.data);
+      const ptr = reserve(data.byteLength);
+      new Float64Array(memory.buffer, ptr, data.length).set(data);
+      const code = spot_fit(spots + msg.local * stride, ptr, data.length);
+      return { op: "fit", code };
+    }
+    case "step": {
+      // the entries published by the main thread
+      const head = Atomics.load(ctrl, HEAD);
+      const tail = Atomics.load(ctrl, TAIL);
+      const mask = values.length - 1;
+      const n = (head - tail) | 0;
+      const begin = tail & mask;
+      const end = Math.min(begin + n, values.length);
+      stepSlots(begin, end);
+      stepSlots(0, n - (end - begin));
+      Atomics.store(ctrl, TAIL, head);
+      return { op: "step", tail: head };
+    }
+    case "thresholds": {
+      const out = new Float64Array(count);
+      for (let k = 0; k < count; k++) {
+        // offset of anomaly_threshold in struct Spot
+        out[k] = new Float64Array(memory.buffer, spots + k * stride + 32, 1)[0]!;
+      }
+      return { op: "thresholds", thresholds: out };
+    }
+  }
+};
+
+self.onmessage = (event: MessageEvent<PoolRequest>) => {
+  let reply: PoolReply;
+  try {
+    reply = handle(event.data);
+  } catch (e) {
+    reply = { op: "error", message: String(e) };
+  }
+  self.postMessage(reply);
+};
+
+self.postMessage({ op: "ready" } satisfies PoolReply);
@@ -3,80 +3,254 @@
 // Define NULL pointer
 #define NULL ((void *)0x0)
 
-// Structure representing a memory block in the heap
+// ========================================================================== //
+// Allocator
+// ========================================================================== //
+//
+// Boundary-tag allocator with segregated free lists. The heap is a sequence
+// of contiguous blocks starting at __heap_base. Every block starts with its
+// size and the size of the previous block, so that a freed block is merged
+// with its free neighbours in constant time. The free blocks are kept in
+// lists by size class (powers of two), the allocated ones are split when
+// they are larger than needed. The linear memory grows on demand.
+
+// Size of a webassembly page
+#define PAGE_SIZE 65536
+// Alignment of the returned pointers (doubles)
+#define ALIGNMENT 8
+// Number of size classes: [16, 32), [32, 64)... (the last one is unbounded)
+#define NB_CLASSES 27
+
+// Header of a block
 typedef struct block {
-    __SIZE_TYPE__ size; // Size of the memory block
-    struct block *next; // Pointer to the next block in the list
-    int free;           // Flag indicating if the block is free (1) or used (0)
+    // size of the block (header included), the lowest bit flags used blocks
+    __SIZE_TYPE__ size;
+    // size of the previous block (0 for the first one)
+    __SIZE_TYPE__ prev_size;
 } block_t;
 
-// Size of the block metadata
-#define BLOCK_SIZE sizeof(block_t)
+// Free block: the links of its list lie in the payload
+typedef struct free_block {
+    block_t header;
+    struct free_block *next;
+    struct free_block *prev;
+} free_block_t;
+
+#define ALIGN(x) (((x) + ALIGNMENT - 1) & ~(__SIZE_TYPE__)(ALIGNMENT - 1))
+#define HEADER_SIZE ALIGN(sizeof(block_t))
+#define MIN_BLOCK_SIZE ALIGN(sizeof(free_block_t))
+#define USED ((__SIZE_TYPE__)1)
 
 // WebAssembly heap base symbol
 extern char __heap_base;
-// Pointer to the current end of the heap
-static char *heap_end = &__heap_base;
+// First block and end of the heap (set by the first allocation)
+static char *heap_start = NULL;
+static char *heap_end = NULL;
+// Block at the end of the heap
+static block_t *last = NULL;
+// Free lists
+static free_block_t *bins[NB_CLASSES];
 
-// Returns the size of the Spot structure
-__SIZE_TYPE__ spot_size(void) { return sizeof(struct Spot); }
+static __SIZE_TYPE__ block_size(block_t const *b) { return b->size & ~USED; }
+
+static int block_used(block_t const *b) { return (b->size & USED) != 0; }
+
+static block_t *block_next(block_t *b) {
+    return (block_t *)((char *)b + block_size(b));
+}
 
-// Simple sbrk implementation to extend the heap
-void *sbrk(int increment) {
-    char *prev = heap_end;
-    heap_end += increment;
-    return (void *)prev;
+static block_t *block_prev(block_t *b) {
+    return (block_t *)((char *)b - b->prev_size);
 }
 
-// Head of the linked list of memory blocks
-static block_t *head = NULL;
+// Tell the next block (if any) about the size of b
+static void block_link(block_t *b) {
+    if (b != last) {
+        block_next(b)->prev_size = block_size(b);
+    }
+}
 
-// Simple malloc implementation using a linked list of blocks
-void *malloc(unsigned long size) {
-    block_t *curr = head;
-    block_t *prev = NULL;
-
-    // Align requested size to the word boundary
-    size = (size + sizeof(void *) - 1) & ~(sizeof(void *) - 1);
-
-    // First-fit search for a free block
-    while (curr) {
-        if (curr->free && curr->size >= size) {
-            curr->free = 0;
-            return (
-                void *)(curr +
-                        1); // Return pointer to memory after block metadata
+static unsigned int size_class(__SIZE_TYPE__ size) {
+    unsigned int c = 0;
+    while ((c < NB_CLASSES - 1) && (size >> (c + 5))) {
+        c++;
+    }
+    return c;
+}
+
+static void bin_insert(block_t *b) {
+    free_block_t *f = (free_block_t *)b;
+    unsigned int const c = size_class(block_size(b));
+    f->prev = NULL;
+    f->next = bins[c];
+    if (bins[c]) {
+        bins[c]->prev = f;
+    }
+    bins[c] = f;
+}
+
+static void bin_remove(block_t *b) {
+    free_block_t *f = (free_block_t *)b;
+    if (f->prev) {
+        f->prev->next = f->next;
+    } else {
+        bins[size_class(block_size(b))] = f->next;
+    }
+    if (f->next) {
+        f->next->prev = f->prev;
+    }
+}
+
+// Extend the heap by size bytes (growing the linear memory if needed)
+static char *heap_extend(__SIZE_TYPE__ size) {
+    if (heap_start == NULL) {
+        heap_start = (char *)ALIGN((__SIZE_TYPE__)&__heap_base);
+        heap_end = heap_start;
+    }
+    __SIZE_TYPE__ const end = (__SIZE_TYPE__)heap_end;
+    __SIZE_TYPE__ const capacity = __builtin_wasm_memory_size(0) * PAGE_SIZE;
+    if (end + size < end) {
+        // beyond the address space
+        return NULL;
+    }
+    if (end + size > capacity) {
+        __SIZE_TYPE__ const missing = end + size - capacity;
+        __SIZE_TYPE__ const pages = (missing + PAGE_SIZE - 1) / PAGE_SIZE;
+        if (__builtin_wasm_memory_grow(0, pages) == (__SIZE_TYPE__)-1) {
+            return NULL;
         }
-        prev = curr;
-        curr = curr->next;
     }
+    char *const prev = heap_end;
+    heap_end += size;
+    return prev;
+}
 
-    // No suitable block found, allocate a new one using sbrk
-    block_t *new_block = (block_t *)sbrk(BLOCK_SIZE + size);
-    if (new_block == (void *)-1)
+// Mark a free block (out of the lists) as used and give back its tail
+static void *block_use(block_t *b, __SIZE_TYPE__ size) {
+    __SIZE_TYPE__ const rest = block_size(b) - size;
+    if (rest >= MIN_BLOCK_SIZE) {
+        block_t *r = (block_t *)((char *)b + size);
+        r->size = rest;
+        r->prev_size = size;
+        if (b == last) {
+            last = r;
+        }
+        block_link(r);
+        bin_insert(r);
+        b->size = size;
+    }
+    b->size |= USED;
+    return (char *)b + HEADER_SIZE;
+}
+
+// Segregated-fit malloc: first fit in the lists of the size class of the
+// request and the larger ones, then extension of the heap
+void *malloc(unsigned long size) {
+    if (size > ((__SIZE_TYPE__)-1) / 2) {
         return NULL;
+    }
+    __SIZE_TYPE__ need = ALIGN(size + HEADER_SIZE);
+    if (need < MIN_BLOCK_SIZE) {
+        need = MIN_BLOCK_SIZE;
+    }
 
-    new_block->size = size;
-    new_block->free = 0;
-    new_block->next = NULL;
+    for (unsigned int c = size_class(need); c < NB_CLASSES; c++) {
+        for (free_block_t *f = bins[c]; f; f = f->next) {
+            if (block_size(&f->header) >= need) {
+                bin_remove(&f->header);
+                return block_use(&f->header, need);
+            }
+        }
+    }
 
-    if (prev)
-        prev->next = new_block;
-    else
-        head = new_block;
+    // the free block at the end of the heap is extended
+    if (last && !block_used(last)) {
+        if (heap_extend(need - block_size(last)) == NULL) {
+            return NULL;
+        }
+        bin_remove(last);
+        last->size = need;
+        return block_use(last, need);
+    }
 
-    // Return pointer to memory after block metadata
-    return (void *)(new_block + 1);
+    block_t *b = (block_t *)heap_extend(need);
+    if (b == NULL) {
+        return NULL;
+    }
+    b->size = need;
+    b->prev_size = last ? block_size(last) : 0;
+    last = b;
+    return block_use(b, need);
 }
 
-// Simple free implementation: marks the block as free
+// Release a block and merge it with its free neighbours
 void free(void *ptr) {
-    if (!ptr)
+    if (!ptr) {
         return;
+    }
+    block_t *b = (block_t *)((char *)ptr - HEADER_SIZE);
+    b->size &= ~USED;
 
-    block_t *block =
-        (block_t *)ptr - 1; // Get block metadata from user pointer
-    block->free = 1;
+    if (b != last) {
+        block_t *next = block_next(b);
+        if (!block_used(next)) {
+            bin_remove(next);
+            if (next == last) {
+                last = b;
+            }
+            b->size += block_size(next);
+        }
+    }
+    if ((char *)b != heap_start) {
+        block_t *prev = block_prev(b);
+        if (!block_used(prev)) {
+            bin_remove(prev);
+            if (b == last) {
+                last = prev;
+            }
+            prev->size += block_size(b);
+            b = prev;
+        }
+    }
+    block_link(b);
+    bin_insert(b);
+}
+
+// Returns the size of the Spot structure
+__SIZE_TYPE__ spot_size(void) { return sizeof(struct Spot); }
+
+// Number of results narrowed at once by spot_step_many
+#define STEP_MANY_CHUNK 256
+
+// Fit-predict steps over a buffer (see spot_step_batch). The results are
+// narrowed to bytes (-1 for the NaN values) so that javascript gets them as
+// an Int8Array. Returns the number of anomalies.
+unsigned long spot_step_many(struct Spot *spot, double const *data,
+                             unsigned long size, signed char *results) {
+    int chunk[STEP_MANY_CHUNK];
+    unsigned long anomalies = 0;
+    for (unsigned long i = 0; i < size; i += STEP_MANY_CHUNK) {
+        unsigned long n = size - i;
+        if (n > STEP_MANY_CHUNK) {
+            n = STEP_MANY_CHUNK;
+        }
+        anomalies += spot_step_batch(spot, data + i, n, chunk);
+        for (unsigned long j = 0; j < n; j++) {
+            results[i + j] = (signed char)((chunk[j] < 0) ? -1 : chunk[j]);
+        }
+    }
+    return anomalies;
+}
+
+// Fit-predict steps of values tagged with the index of their detector in an
+// array of detectors (results as in spot_step_many). The values of a given
+// detector are processed in order.
+void spots_step_ids(struct Spot *spots, int const *ids, double const *data,
+                    unsigned long size, signed char *results) {
+    for (unsigned long i = 0; i < size; i++) {
+        int const r = spot_step(&spots[ids[i]], data[i]);
+        results[i] = (signed char)((r < 0) ? -1 : r);
+    }
 }
 
 // Initializes libspot with the defined malloc and free functions
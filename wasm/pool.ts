@@ -0,0 +1,352 @@
+import type { SpotConfig } from "./libspot.ts";
+
+// Ring indices of the control words (Int32Array): the main thread publishes
+// entries by moving HEAD, the worker consumes them by moving TAIL
+export const HEAD = 0;
+export const TAIL = 1;
+
+// Messages between the pool and its workers (every request gets one reply,
+// in order). The batches themselves never go through messages: they are
+// written to the rings.
+export type PoolRequest =
+  | {
+      op: "init";
+      count: number;
+      config: SpotConfig;
+      channel: SharedArrayBuffer;
+      capacity: number;
+    }
+  | { op: "fit"; local: number; data: SharedArrayBuffer }
+  | { op: "step" }
+  | { op: "thresholds" };
+
+export type PoolReply =
+  | { op: "ready" }
+  | { op: "init"; code: number }
+  | { op: "fit"; code: number }
+  | { op: "step"; tail: number }
+  | { op: "thresholds"; thresholds: Float64Array }
+  | { op: "error"; message: string };
+
+/**
+ * Options of a SpotWorkerPool
+ */
+export interface SpotWorkerPoolOptions {
+  /**
+   * Number of workers (navigator.hardwareConcurrency by default)
+   */
+  workers?: number;
+  /**
+   * Number of values of the ring of a worker (rounded up to a power of 2)
+   */
+  capacity?: number;
+  /**
+   * Location of the worker script (libspot.worker.js next to the module by
+   * default)
+   */
+  workerUrl?: string | URL;
+}
+
+/**
+ * Ring shared with a worker (SharedArrayBuffer)
+ *
+ *   0                   8           8 + 8c        8 + 12c       8 + 13c
+ *   +---------+---------+-----------+-------------+-------------+
+ *   |  HEAD   |  TAIL   |  values   |  local ids  |  results    |
+ *   +---------+---------+-----------+-------------+-------------+
+ */
+class Channel {
+  readonly buffer: SharedArrayBuffer;
+  readonly ctrl: Int32Array;
+  readonly values: Float64Array;
+  readonly ids: Int32Array;
+  readonly results: Int8Array;
+  // output position of the values of every slot
+  readonly positions: Int32Array;
+  readonly mask: number;
+  // entries published (main-thread copy of HEAD)
+  head = 0;
+
+  constructor(capacity: number) {
+    this.buffer = new SharedArrayBuffer(8 + 13 * capacity);
+    this.ctrl = new Int32Array(this.buffer, 0, 2);
+    this.values = new Float64Array(this.buffer, 8, capacity);
+    this.ids = new Int32Array(this.buffer, 8 + 8 * capacity, capacity);
+    this.results = new Int8Array(this.buffer, 8 + 12 * capacity, capacity);
+    this.positions = new Int32Array(capacity);
+    this.mask = capacity - 1;
+  }
+}
+
+const defaultWorkerUrl = () =>
+  new URL(
+    import.meta.url.endsWith(".ts")
+      ? "./libspot.worker.ts"
+      : "./libspot.worker.js",
+    import.meta.url
+  );
+
+/**
+ * Pool of detectors sharded across workers. Detector `id` lives in worker
+ * `id % workers`, so the values of a series are always processed in order
+ * by the same worker. The batches go through SharedArrayBuffer rings
+ * (no structured clone) and the workers step them in parallel.
+ */
+export class SpotWorkerPool {
+  readonly size: number;
+  private readonly workers: Worker[];
+  private readonly channels: Channel[];
+  // resolvers of the pending requests of every worker (FIFO)
+  private readonly pending: ((reply: PoolReply) => void)[][];
+  // the calls are run one after the other (they share the rings)
+  private queue: Promise<unknown> = Promise.resolve();
+
+  private constructor(size: number, workers: Worker[], capacity: number) {
+    this.size = size;
+    this.workers = workers;
+    this.channels = workers.map(() => new Channel(capacity));
+    this.pending = workers.map(() => []);
+    workers.forEach((worker, w) => {
+      worker.onmessage = (event: MessageEvent<PoolReply>) => {
+        this.pending[w]!.shift()?.(event.data);
+      };
+    });
+  }
+
+  /**
+   * Start the workers and initialize the detectors
+   *
+   * @param size Number of detectors
+   * @param config Configuration of the detectors
+   * @param options Workers options
+   */
+  static async create(
+    size: number,
+    config: SpotConfig,
+    options: SpotWorkerPoolOptions = {}
+  ): Promise<SpotWorkerPool> {
+    if (typeof SharedArrayBuffer === "undefined") {
+      throw new Error(
+        "SharedArrayBuffer is not available (cross-origin isolation is required in browsers)"
+      );
+    }
+    if (!Number.isInteger(size) || size < 1) {
+      throw new RangeError("the pool needs a detector");
+    }
+    const cpus =
+      typeof navigator !== "undefined" ? navigator.hardwareConcurrency : 1;
+    const count = Math.max(1, Math.min(size, options.workers ?? cpus ?? 1));
+    const capacity =
+      2 ** Math.ceil(Math.log2(Math.max(options.capacity ?? 65536, 2)));
+    const url = options.workerUrl ?? defaultWorkerUrl();
+    const workers = Array.from(
+      { length: count },
+      () => new Worker(url, { type: "module" })
+    );
+    const pool = new SpotWorkerPool(size, workers, capacity);
+    // the workers say when their module is loaded
+    await Promise.all(workers.map((_, w) => pool.reply(w)));
+    const replies = await Promise.all(
+      workers.map((_, w) =>
+        pool.request(w, {
+          op: "init",
+          count: Math.ceil((size - w) / count),
+          config,
+          channel: pool.channels[w]!.buffer,
+          capacity,
+        })
+      )
+    );
+    for (const reply of replies) {
+      if (reply.op === "init" && reply.code < 0) {
+        pool.terminate();
+        throw new Error(`cannot initialize the detectors (${reply.code})`);
+      }
+    }
+    return pool;
+  }
+
+  /**
+   * Number of workers
+   */
+  get threads() {
+    return this.workers.length;
+  }
+
+  private reply(w: number): Promise<PoolReply> {
+    return new Promise((resolve) => this.pending[w]!.push(resolve));
+  }
+
+  private request(w: number, msg: PoolRequest): Promise<PoolReply> {
+    const reply = this.reply(w).then((r) => {
+      if (r.op === "error") {
+        throw new Error(r.message);
+      }
+      return r;
+    });
+    this.workers[w]!.postMessage(msg);
+    return reply;
+  }
+
+  private serialize<T>(run: () => Promise<T>): Promise<T> {
+    const result = this.queue.then(run);
+    this.queue = result.catch(() => undefined);
+    return result;
+  }
+
+  private check(id: number) {
+    if (!Number.isInteger(id) || id < 0 || id >= this.size) {
+      throw new RangeError(`invalid detector id ${id}`);
+    }
+  }
+
+  /**
+   * Fit a detector
+   *
+   * @param id Index of the detector
+   * @param data Training data
+   */
+  fit(id: number, data: Float64Array): Promise<void> {
+    return this.serialize(async () => {
+      this.check(id);
+      const shared = new SharedArrayBuffer(data.byteLength);
+      new Float64Array(shared).set(data);
+      const w = id % this.workers.length;
+      const reply = await this.request(w, {
+        op: "fit",
+        local: Math.floor(id / this.workers.length),
+        data: shared,
+      });
+      if (reply.op === "fit" && reply.code < 0) {
+        throw new Error(`fit of detector ${id} failed (${reply.code})`);
+      }
+    });
+  }
+
+  /**
+   * Fit-predict steps of values tagged with the index of their detector
+   *
+   * @param ids Index of the detector of every value
+   * @param values Values
+   * @returns 0: NORMAL, 1: EXCESS, 2: ANOMALY for every value (-1 for NaN)
+   */
+  step(ids: Int32Array, values: Float64Array): Promise<Int8Array> {
+    return this.serialize(async () => {
+      if (ids.length !== values.length) {
+        throw new RangeError("ids and values must have the same length");
+      }
+      ids.forEach((id) => this.check(id));
+      // positions of the values grouped by worker (counting sort, in order)
+      const workers = this.workers.length;
+      const offsets = new Int32Array(workers + 1);
+      ids.forEach((id) => {
+        const w = (id % workers) + 1;
+        offsets[w] = offsets[w]! + 1;
+      });
+      for (let w = 0; w < workers; w++) {
+        offsets[w + 1] = offsets[w + 1]! + offsets[w]!;
+      }
+      const cursors = offsets.slice(0, workers);
+      const positions = new Int32Array(ids.length);
+      ids.forEach((id, i) => {
+        const w = id % workers;
+        positions[cursors[w]!] = i;
+        cursors[w] = cursors[w]! + 1;
+      });
+      const out = new Int8Array(values.length);
+      await Promise.all(
+        this.workers.map((_, w) =>
+          this.stream(
+            w,
+            positions.subarray(offsets[w], offsets[w + 1]),
+            ids,
+            values,
+            out
+          )
+        )
+      );
+      return out;
+    });
+  }
+
+  /**
+   * Push the values of the shard of a worker (at the given positions) into
+   * its ring (as long as there is room) and collect the results
+   */
+  private async stream(
+    w: number,
+    positions: Int32Array,
+    ids: Int32Array,
+    values: Float64Array,
+    out: Int8Array
+  ) {
+    const workers = this.workers.length;
+    const ch = this.channels[w]!;
+    const capacity = ch.mask + 1;
+    const inflight: Promise<PoolReply>[] = [];
+    let read = ch.head;
+
+    const collect = (reply: PoolReply) => {
+      if (reply.op !== "step") {
+        return;
+      }
+      for (; read !== reply.tail; read = (read + 1) | 0) {
+        const slot = read & ch.mask;
+        out[ch.positions[slot]!] = ch.results[slot]!;
+      }
+    };
+
+    let k = 0;
+    while (k < positions.length) {
+      // publish as many values of the shard as the ring can hold
+      const start = ch.head;
+      for (; k < positions.length && ((ch.head - read) | 0) < capacity; k++) {
+        const i = positions[k]!;
+        const slot = ch.head & ch.mask;
+        ch.ids[slot] = Math.floor(ids[i]! / workers);
+        ch.values[slot] = values[i]!;
+        ch.positions[slot] = i;
+        ch.head = (ch.head + 1) | 0;
+      }
+      if (ch.head !== start) {
+        Atomics.store(ch.ctrl, HEAD, ch.head);
+        inflight.push(this.request(w, { op: "step" }));
+      }
+      if (k < positions.length) {
+        // the ring is full: wait for the oldest batch
+        collect(await inflight.shift()!);
+      }
+    }
+    for (const reply of await Promise.all(inflight)) {
+      collect(reply);
+    }
+  }
+
+  /**
+   * Anomaly thresholds of all the detectors
+   */
+  anomalyThresholds(): Promise<Float64Array> {
+    return this.serialize(async () => {
+      const out = new Float64Array(this.size);
+      const workers = this.workers.length;
+      const replies = await Promise.all(
+        this.workers.map((_, w) => this.request(w, { op: "thresholds" }))
+      );
+      replies.forEach((reply, w) => {
+        if (reply.op === "thresholds") {
+          reply.thresholds.forEach((z, k) => {
+            out[k * workers + w] = z;
+          });
+        }
+      });
+      return out;
+    });
+  }
+
+  /**
+   * Stop the workers (the pool must not be used afterwards)
+   */
+  terminate() {
+    this.workers.forEach((worker) => worker.terminate());
+  }
+}